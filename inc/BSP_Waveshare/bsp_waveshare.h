@@ -132,6 +132,52 @@ uint8_t wsBoard_UART_Get_Interrupt_Index(LPC_USART_T*USARTx);
  */
 void wsBoard_SSP_Init(LPC_SSP_T *pSSP);
 
+/*
+ * GPDMA channel map. The board drivers use fixed channels:
+ *   0	AT45D DataFlash SSP receive		(AT45D_CFG_DMA_CH_RX, at45d_cfg.h)
+ *   1	AT45D DataFlash SSP transmit	(AT45D_CFG_DMA_CH_TX, at45d_cfg.h)
+ *   2	SD card SSP receive				(SD_DMA_CH_RX, sdcard.h)
+ *   3	SD card SSP transmit			(SD_DMA_CH_TX, sdcard.h)
+ *   4	K9F1G NAND flash page read		(K9F1G_DMA_CH, lpc_nandflash_k9f1g.h)
+ * They are reserved in the LPCOpen channel allocator when the GPDMA is
+ * initialized (wsBoard_Init()), so Chip_GPDMA_GetFreeChannel() only hands
+ * out channels 5 to 7. Do not call Chip_GPDMA_Init() again afterwards: it
+ * frees all channels.
+ */
+#define WSBOARD_DMA_CH_RESERVED		5
+
+/**
+ * @brief	GPDMA channel interrupt handler
+ * @param	ch	: Channel with a pending terminal count or error interrupt
+ * @return	Nothing
+ * @note	The handler must clear the interrupt flags of the channel.
+ */
+typedef void (*wsBoard_DMA_Handler_t)(uint8_t ch);
+
+/**
+ * @brief	Initialize the GPDMA controller and install a channel interrupt handler
+ * @param	ch		: GPDMA channel (0 to GPDMA_NUMBER_CHANNELS-1)
+ * @param	handler	: Called from DMA_IRQHandler() for this channel
+ * @return	Nothing
+ * @note	The GPDMA controller and its interrupt are enabled and the board
+ *          channels reserved on the first call (or by wsBoard_Init()).
+ *          Drivers sharing the GPDMA must use different channels.
+ */
+void wsBoard_DMA_Init(uint8_t ch, wsBoard_DMA_Handler_t handler);
+
+/**
+ * @brief	GPDMA interrupt of a channel without a handler
+ * @param	ch	: Channel with a pending terminal count or error interrupt
+ * @return	Nothing
+ * @note	DMA_IRQHandler() is defined by the board support package. Weak
+ *          function: override it to handle the channels that the application
+ *          allocates itself, for example with
+ *          Chip_GPDMA_Interrupt(LPC_GPDMA, ch), and move the body of an
+ *          existing application DMA_IRQHandler() here. The default clears the
+ *          interrupt flags of the channel.
+ */
+void wsBoard_DMA_IRQHook(uint8_t ch);
+
 /**
  * @brief	Sets up wsBoard specific I2C interface
  * @param	id	: I2C peripheral ID (I2C0, I2C1 or I2C2)
@@ -440,6 +486,17 @@ STATIC INLINE uint8_t wsBoard_NANDFLash_ReadByte(void)
 	return *((volatile uint8_t *) (EMC_ADDRESS_CS1));
 }
 
+/**
+ * @brief	Read 4 data bytes from Nand Flash
+ * @return	Bytes read from NAND FLASH (first byte in bits 0..7)
+ * @note	The EMC splits the word access into 4 byte accesses of the 8-bit
+ *          bus, all of them in the data window of the NAND flash.
+ */
+STATIC INLINE uint32_t wsBoard_NANDFLash_ReadWord(void)
+{
+	return *((volatile uint32_t *) (EMC_ADDRESS_CS1));
+}
+
 /**
  * @brief	Initializes USB device mode pins per board design
  * @param	port	: USB port to be enabled
@@ -103,6 +103,20 @@ void lpc_nandflash_erase_block(uint32_t block);
  */
 uint32_t lpc_nandflash_write_page(uint32_t block, uint32_t page, uint8_t *data, uint32_t size);
 
+/**
+ * @brief	Write part of a page to NAND FLASH
+ * @param	block	: block index
+ * @param	page	: page index
+ * @param	ofs		: offset in page (K9F1G_SPARE_START_ADDR and up for the spare area)
+ * @param	data	: pointer to buffer to write
+ * @param	size	: the number of written bytes
+ * @return	The number of written bytes
+ * @note	After returning from this function, read the status to get the result.
+ * Used to program bytes of a page that has already been programmed (partial
+ * page program), e.g. a bad block marker.
+ */
+uint32_t lpc_nandflash_write_ofs(uint32_t block, uint32_t page, uint32_t ofs, uint8_t *data, uint32_t size);
+
 /**
  * @brief	Start reading data from NAND FLASH
  * @param	block	: block index
@@ -117,9 +131,39 @@ void lpc_nandflash_read_start(uint32_t block, uint32_t page, uint32_t ofs);
  * @param	data	: pointer to buffer to read
  * @param	size	: the number of read bytes
  * @return	Nothing
+ * @note	Reads 4 bytes per EMC word access once data is word aligned.
  */
 void lpc_nandflash_read_data(uint8_t *data, uint32_t size);
 
+/**
+ * @brief	Start reading data from NAND FLASH with the GPDMA
+ * @param	data	: pointer to buffer to read
+ * @param	size	: the number of read bytes
+ * @return	Nothing
+ * @note	Returns while the transfer runs if data and size are word
+ * aligned, otherwise reads with lpc_nandflash_read_data(). The CPU may do
+ * other work (but not access the NAND FLASH) until
+ * lpc_nandflash_read_data_wait() returns.
+ */
+void lpc_nandflash_read_data_start(uint8_t *data, uint32_t size);
+
+/**
+ * @brief	Wait for the end of lpc_nandflash_read_data_start()
+ * @return	Nothing
+ */
+void lpc_nandflash_read_data_wait(void);
+
+/**
+ * @brief	Read the main area of consecutive pages from NAND FLASH
+ * @param	block	: block index of the first page
+ * @param	page	: page index of the first page
+ * @param	n		: the number of pages (may continue into the next blocks)
+ * @param	data	: pointer to buffer to read (n * page size bytes)
+ * @return	The number of pages read (less than n if the flash timed out)
+ * @note	Raw data, without bad block or ECC checks.
+ */
+uint32_t lpc_nandflash_read_pages(uint32_t block, uint32_t page, uint32_t n, uint8_t *data);
+
 /**
  * @}
  */
@@ -100,6 +100,14 @@ typedef struct {
 
 } K9F1G_ID_T;
 
+/*
+ * @brief GPDMA channel of lpc_nandflash_read_data_start()
+ * Memory to memory transfers from the data window of the NAND flash; the
+ * channel must not be used by another driver (see the SD card and AT45D
+ * channels). Undefine it to read with the CPU only.
+ */
+#define K9F1G_DMA_CH                 4
+
 /*
  * @brief NAND FLASH status
  */
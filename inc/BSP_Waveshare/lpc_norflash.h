@@ -43,6 +43,15 @@ extern "C" {
  * @{
  */
 
+/**
+ * @brief	NOR Flash programming statistics (see lpc_norflash_program())
+ */
+typedef struct {
+	UNS_32  sectors_erased;			/*!< Sectors erased */
+	UNS_32  words_written;			/*!< Words programmed */
+	UNS_32  words_skipped;			/*!< Words that already held the data */
+} lpc_norflash_prog_stat_t;
+
 /**
  * @brief	Initialize flash
  * @return	Nothing
@@ -110,6 +119,21 @@ void lpc_norflash_write_word(UNS_32 addr, UNS_16 data);
  */
 UNS_32 lpc_norflash_write_buffer(UNS_32 addr, UNS_16 *data, UNS_32 size);
 
+/**
+ * @brief	Program a buffer, erasing and writing only what differs
+ * @param	addr	: Address
+ * @param	data	: Pointer to data to write
+ * @param	size	: The number of bytes
+ * @param	stat	: Pointer to statistics to update, or NULL
+ * @return	true if the flash holds the data, false on a timeout or verify error
+ * @note	addr must be word-aligned and size even. The flash is compared
+ * with the data sector by sector: a sector is only erased if a bit has to
+ * change from 0 to 1, and only the words that differ are programmed and read
+ * back. An erased sector is erased as a whole, so the part of it outside the
+ * buffer reads 0xFFFF afterwards.
+ */
+bool lpc_norflash_program(UNS_32 addr, const UNS_16 *data, UNS_32 size, lpc_norflash_prog_stat_t *stat);
+
 /**
  * @brief	Read data from flash
  * @param	addr	: Address
@@ -90,6 +90,12 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+	// Calculate CRC_A in software instead of with the MFRC522 CRC coprocessor.
+	// Saves the FIFO transfer and DivIrqReg polling over SPI for every frame.
+#ifndef MFRC522_SOFTWARE_CRC
+#define MFRC522_SOFTWARE_CRC	0
+#endif
+
 
 	// MFRC522 registers. Described in chapter 9 of the datasheet.
 	// When using SPI all addresses are shifted one bit left in the "SPI address uint8_t" (section 8.1.2.3)
@@ -39,6 +39,30 @@ DRESULT disk_write (BYTE, const BYTE*, DWORD, BYTE);
 DRESULT disk_ioctl (BYTE, BYTE, void*);
 
 
+/* Physical drives, one per volume (diskio.c dispatches to the drivers below) */
+#define DRV_MCI		0	/* SD card on the MCI interface (fs_mci.c) */
+#define DRV_NAND	1	/* On-board K9F1G NAND flash (fs_nand.c) */
+#define DRV_NOR		2	/* On-board SST39VF320 NOR flash (fs_nor.c) */
+
+DSTATUS mci_disk_initialize (void);
+DSTATUS mci_disk_status (void);
+DRESULT mci_disk_read (BYTE*, DWORD, BYTE);
+DRESULT mci_disk_write (const BYTE*, DWORD, BYTE);
+DRESULT mci_disk_ioctl (BYTE, void*);
+
+DSTATUS nand_disk_initialize (void);
+DSTATUS nand_disk_status (void);
+DRESULT nand_disk_read (BYTE*, DWORD, BYTE);
+DRESULT nand_disk_write (const BYTE*, DWORD, BYTE);
+DRESULT nand_disk_ioctl (BYTE, void*);
+
+DSTATUS nor_disk_initialize (void);
+DSTATUS nor_disk_status (void);
+DRESULT nor_disk_read (BYTE*, DWORD, BYTE);
+DRESULT nor_disk_write (const BYTE*, DWORD, BYTE);
+DRESULT nor_disk_ioctl (BYTE, void*);
+
+
 /* Disk Status Bits (DSTATUS) */
 #define STA_NOINIT		0x01	/* Drive not initialized */
 #define STA_NODISK		0x02	/* No medium in the drive */
@@ -266,6 +266,7 @@ int ff_cre_syncobj (BYTE, _SYNC_t*);/* Create a sync object */
 int ff_req_grant (_SYNC_t);			/* Lock sync object */
 void ff_rel_grant (_SYNC_t);		/* Unlock sync object */
 int ff_del_syncobj (_SYNC_t);		/* Delete a sync object */
+void ff_timerproc (void);			/* Time tick of _FS_TIMEOUT (syscall.c) */
 #endif
 
 
@@ -0,0 +1,56 @@
+/*------------------------------------------------------------------------/
+/  Fast seek helper: cached cluster link map tables (CLMT) for FatFs
+/-------------------------------------------------------------------------/
+/
+/  Files opened with clmt_open() are read-only and get a cluster link map
+/  table, so that f_lseek() and f_read() find the cluster of any file offset
+/  without following the FAT chain from the start of the file (_USE_FASTSEEK).
+/
+/  The tables are kept in CLMT_SLOTS fixed size slots of a pool in SDRAM.
+/  A table stays cached after clmt_close() and is used again when the same
+/  file (same start cluster and size) is opened, until its slot is needed
+/  for another file (least recently used first).
+/
+/  A file that is recreated or truncated can get the same start cluster and
+/  size again. Change files on such a volume with clmt_open_write(),
+/  clmt_truncate(), clmt_unlink() and clmt_rename(), which drop the cached
+/  table of the file, or call clmt_flush() after changing them with the
+/  FatFs functions.
+/
+/-------------------------------------------------------------------------*/
+
+#ifndef _FF_CLMT_DEFINED
+#define _FF_CLMT_DEFINED
+
+#include <FatFs/ff.h>
+#include <gfx/sdram_HY57V281620_X2.h>
+
+#if !_USE_FASTSEEK
+#error "ff_clmt requires _USE_FASTSEEK 1 (ffconf.h)"
+#endif
+
+/* Number of cached tables (maximum number of files opened with clmt_open()
+/  at the same time) */
+#define CLMT_SLOTS			8
+
+/* Size of each table in DWORDs. A table of n DWORDs maps a file of up to
+/  (n - 2) / 2 fragments; a file with more fragments is opened in normal
+/  seek mode. */
+#define CLMT_SLOT_SIZE		1024
+
+/* Address of the table pool (CLMT_SLOTS * CLMT_SLOT_SIZE * 4 bytes, word
+/  aligned), 0 = static array in internal RAM. The SDRAM must have been
+/  initialized (SDRAMInit()) before the first clmt_open(). */
+#define CLMT_POOL_ADDR		(SDRAM_BASE_ADDR + 0x00780000)
+
+FRESULT clmt_open (FIL* fp, const TCHAR* path);	/* Open a file read-only in fast seek mode */
+FRESULT clmt_close (FIL* fp);						/* Close a file opened with clmt_open() */
+void clmt_flush (void);								/* Drop all cached tables of closed files */
+#if !_FS_READONLY
+FRESULT clmt_open_write (FIL* fp, const TCHAR* path, BYTE mode);	/* f_open() for writing */
+FRESULT clmt_truncate (FIL* fp);									/* f_truncate() */
+FRESULT clmt_unlink (const TCHAR* path);							/* f_unlink() */
+FRESULT clmt_rename (const TCHAR* path_old, const TCHAR* path_new);	/* f_rename() */
+#endif
+
+#endif
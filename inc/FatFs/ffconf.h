@@ -48,7 +48,7 @@
 /* To enable f_forward function, set _USE_FORWARD to 1 and set _FS_TINY to 1. */
 
 
-#define	_USE_FASTSEEK	0	/* 0:Disable or 1:Enable */
+#define	_USE_FASTSEEK	1	/* 0:Disable or 1:Enable */
 /* To enable fast seek feature, set _USE_FASTSEEK to 1. */
 
 
@@ -125,8 +125,9 @@
 / Physical Drive Configurations
 /----------------------------------------------------------------------------*/
 
-#define _VOLUMES	1
+#define _VOLUMES	3
 /* Number of volumes (logical drives) to be used. */
+/* 0: SD card (MCI), 1: K9F1G NAND flash, 2: SST39VF320 NOR flash (see diskio.h) */
 
 
 #define	_MAX_SS		512		/* 512, 1024, 2048 or 4096 */
@@ -170,9 +171,11 @@
 /* A header file that defines sync object types on the O/S, such as
 /  windows.h, ucos_ii.h and semphr.h, must be included prior to ff.h. */
 
-#define _FS_REENTRANT	0		/* 0:Disable or 1:Enable */
+#define _FS_REENTRANT	1		/* 0:Disable or 1:Enable */
 #define _FS_TIMEOUT		1000	/* Timeout period in unit of time ticks */
-#define	_SYNC_t			HANDLE	/* O/S dependent type of sync object. e.g. HANDLE, OS_EVENT*, ID and etc.. */
+#define	_SYNC_t			volatile DWORD*	/* O/S dependent type of sync object. e.g. HANDLE, OS_EVENT*, ID and etc.. */
+/* No O/S: the sync objects are lock words in syscall.c and a time tick is one
+/  call of ff_timerproc() (1ms, from SysTick_Handler). */
 
 /* The _FS_REENTRANT option switches the reentrancy (thread safe) of the FatFs module.
 /
@@ -182,7 +185,7 @@
 /      function must be added to the project. */
 
 
-#define	_FS_LOCK	0	/* 0:Disable or >=1:Enable */
+#define	_FS_LOCK	4	/* 0:Disable or >=1:Enable */
 /* To enable file lock control feature, set _FS_LOCK to 1 or greater.
    The value defines how many files can be opened simultaneously. */
 
@@ -0,0 +1,85 @@
+/*
+ * @brief On-board NAND and NOR flash drives, ChaN FAT FS configuration file
+ */
+
+#ifndef __FSFLASH_CFG_H_
+#define __FSFLASH_CFG_H_
+
+#include <string.h>
+#include "ffconf.h"
+#include "diskio.h"
+#include "BSP_Waveshare/bsp_waveshare.h"
+#include "gfx/sdram_HY57V281620_X2.h"
+
+/**
+ * @def		FSNAND_START_BLOCK
+ * @brief	First K9F1G block of the NAND drive (DRV_NAND)
+ */
+#define FSNAND_START_BLOCK              0
+
+/**
+ * @def		FSNAND_BLOCK_COUNT
+ * @brief	Number of K9F1G blocks (128 KB, 256 sectors each) used by the NAND drive
+ */
+#define FSNAND_BLOCK_COUNT              K9F1G_BLOCK_COUNT
+
+/**
+ * @def		FSNAND_RESERVE_BLOCKS
+ * @brief	Number of blocks of the NAND drive not counted in its capacity
+ * They are the spare blocks of the flash translation layer (nand_ftl.c):
+ * factory and grown bad blocks (at most 20 on a K9F1G) and the free blocks
+ * needed by the garbage collection.
+ */
+#define FSNAND_RESERVE_BLOCKS           24
+
+/**
+ * @def		FSNAND_GC_FREE_BLOCKS
+ * @brief	Number of free blocks below which a write runs the garbage collection
+ */
+#define FSNAND_GC_FREE_BLOCKS           2
+
+/**
+ * @def		FSNAND_IDLE_FREE_BLOCKS
+ * @brief	Number of free blocks below which nand_ftl_gc() collects a block
+ */
+#define FSNAND_IDLE_FREE_BLOCKS         8
+
+/**
+ * @def		FSNAND_WL_DELTA
+ * @brief	Erase count difference that makes nand_ftl_gc() move a cold block
+ * A block holding data that is never rewritten is moved when it has been
+ * erased FSNAND_WL_DELTA times less than the most worn block, so that it
+ * takes its share of the writes (static wear leveling).
+ */
+#define FSNAND_WL_DELTA                 256
+
+/**
+ * @def		FSNAND_MAP_ADDR
+ * @brief	Address of the mapping tables of the flash translation layer
+ * The tables take 8 bytes per logical page and 8 bytes per block, 520 KB
+ * with the default settings. The SDRAM must have been initialized
+ * (SDRAMInit()) before disk_initialize().
+ */
+#define FSNAND_MAP_ADDR                 (SDRAM_BASE_ADDR + 0x00800000)
+
+/**
+ * @def		FSNAND_MAP_SIZE
+ * @brief	Size of the mapping tables at FSNAND_MAP_ADDR in bytes
+ */
+#define FSNAND_MAP_SIZE                 \
+	((FSNAND_BLOCK_COUNT - FSNAND_RESERVE_BLOCKS) * (K9F1G_PAGES_PER_BLOCK * 8 + 8))
+
+/**
+ * @def		FSNOR_START_SECTOR
+ * @brief	First SST39VF320 sector (4 KB) of the NOR drive (DRV_NOR)
+ * The NOR flash below this sector is not used by the file system.
+ */
+#define FSNOR_START_SECTOR              512
+
+/**
+ * @def		FSNOR_SECTOR_COUNT
+ * @brief	Number of SST39VF320 sectors (4 KB, 8 FAT sectors each) of the NOR drive
+ */
+#define FSNOR_SECTOR_COUNT              512
+
+#endif /* ifndef __FSFLASH_CFG_H_ */
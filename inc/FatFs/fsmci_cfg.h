@@ -133,6 +133,39 @@ typedef SDMMC_CARD_T CARD_HANDLE_T;
  */
 #define FSMCI_CardInsertWait(hc)        /* No Card detect yet */
 
+/**
+ * @def		FSMCI_CACHE_SECTORS
+ * @brief	Number of sectors in the sector cache between FatFs and the card
+ * Set to 0 to disable the cache. Single sector reads and writes (FAT,
+ * directory and file data with _FS_TINY=0) are served from the cache; single
+ * sector writes are written back when a line is evicted or on CTRL_SYNC
+ * (f_sync() / f_close()). Must be a multiple of FSMCI_CACHE_WAYS.
+ */
+#define FSMCI_CACHE_SECTORS             32
+
+/**
+ * @def		FSMCI_CACHE_WAYS
+ * @brief	Number of sectors per cache set (least recently used is evicted)
+ */
+#define FSMCI_CACHE_WAYS                4
+
+/**
+ * @def		FSMCI_CACHE_READ_AHEAD
+ * @brief	Number of sectors read in one multi-block transfer on a sequential read miss
+ * Set to 1 to disable read-ahead. May not exceed the number of sets
+ * (FSMCI_CACHE_SECTORS / FSMCI_CACHE_WAYS).
+ */
+#define FSMCI_CACHE_READ_AHEAD          4
+
+/**
+ * @def		FSMCI_CACHE_ADDR
+ * @brief	Address of the cache sector buffers (0 = static array in internal RAM)
+ * The buffers take (FSMCI_CACHE_SECTORS + FSMCI_CACHE_READ_AHEAD) * _MAX_SS
+ * bytes, e.g. (SDRAM_BASE_ADDR + 0x00700000) to place them in the SDRAM.
+ * The address must be word aligned.
+ */
+#define FSMCI_CACHE_ADDR                0
+
 extern CARD_HANDLE_T sdCardInfo;	/**< Type used for SD Card handle */
 extern void rtc_initialize(void);   /**< RTC initialization function */
 
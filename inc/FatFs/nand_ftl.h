@@ -0,0 +1,112 @@
+/*
+ * @brief Flash translation layer of the K9F1G NAND flash
+ *
+ * The NAND drive (fs_nand.c) is a log-structured store of 2 KB logical
+ * pages: a rewritten page is programmed to the next free page of the
+ * active block and the old copy becomes invalid. A table in SDRAM maps each
+ * logical page to its physical page and is rebuilt at mount time from the
+ * tags in the spare areas (logical page, sequence number and erase count,
+ * written with the page data).
+ *
+ * Spare area of a page (64 bytes):
+ *   0      : bad block marker (0xFF: good block)
+ *   8..23  : tag
+ *   24..26 : Hamming ECC of the tag
+ *   32..55 : Hamming ECC of the data, 3 bytes per 256 bytes
+ * The ECC corrects one bit and detects two bits per 256 bytes.
+ *
+ * Blocks with a factory bad block marker, or that fail an erase or program,
+ * are kept out of use. When fewer than FSNAND_GC_FREE_BLOCKS blocks are
+ * free, a write first collects the block with the fewest valid pages. Free
+ * blocks are allocated by lowest erase count.
+ *
+ * Reads of whole pages go straight into the caller's buffer (GPDMA, see
+ * lpc_nandflash_read_data_start()); the ECC of a page is checked while the
+ * next one is streamed.
+ *
+ * The functions are not reentrant; FatFs serializes the accesses to the
+ * NAND volume (_FS_REENTRANT), nand_ftl_gc() must be called from the task
+ * that accesses the volume.
+ */
+
+#ifndef __NAND_FTL_H_
+#define __NAND_FTL_H_
+
+#include "FatFs/fsflash_cfg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief	Number of 512 byte sectors of the NAND drive
+ */
+#define NAND_FTL_SECTOR_COUNT	\
+	((FSNAND_BLOCK_COUNT - FSNAND_RESERVE_BLOCKS) * K9F1G_PAGES_PER_BLOCK * (K9F1G_PAGE_SIZE / 512))
+
+/**
+ * @brief	Statistics of the flash translation layer
+ */
+typedef struct {
+	DWORD	badBlocks;		/*!< Bad blocks (factory and grown) */
+	DWORD	freeBlocks;		/*!< Free blocks */
+	DWORD	maxErase;		/*!< Highest erase count of a block */
+	DWORD	eccCorrected;	/*!< Pages read with corrected bit errors */
+	DWORD	eccFailed;		/*!< Pages read with uncorrectable bit errors */
+	DWORD	collected;		/*!< Blocks collected by the garbage collection */
+} NAND_FTL_STAT;
+
+/**
+ * @brief	Scan the NAND flash and build the mapping table
+ * @return	1 on success, 0 if the flash does not respond or has too many bad blocks
+ */
+int nand_ftl_mount(void);
+
+/**
+ * @brief	Read sectors
+ * @param	buff	: Pointer to the data buffer
+ * @param	sector	: Start sector
+ * @param	count	: Number of sectors
+ * @return	1 on success, 0 on an uncorrectable bit error or flash error
+ * @note	Sectors that have never been written read as 0xFF
+ */
+int nand_ftl_read(BYTE *buff, DWORD sector, UINT count);
+
+/**
+ * @brief	Write sectors
+ * @param	buff	: Pointer to the data
+ * @param	sector	: Start sector
+ * @param	count	: Number of sectors
+ * @return	1 on success, 0 on error
+ * @note	The last written page is held in RAM until another page is
+ * written or nand_ftl_sync() is called
+ */
+int nand_ftl_write(const BYTE *buff, DWORD sector, UINT count);
+
+/**
+ * @brief	Program the page held in RAM
+ * @return	1 on success, 0 on error
+ */
+int nand_ftl_sync(void);
+
+/**
+ * @brief	Background garbage collection and wear leveling step
+ * @return	1 if a block was collected, 0 if there was nothing to do
+ * @note	Collects one block when fewer than FSNAND_IDLE_FREE_BLOCKS blocks
+ * are free or a block is FSNAND_WL_DELTA erase cycles behind. Call it when
+ * the application is idle, so that writes seldom wait for a collection.
+ */
+int nand_ftl_gc(void);
+
+/**
+ * @brief	Get the statistics of the flash translation layer
+ * @param	stat	: Pointer to the statistics to fill
+ * @return	Nothing
+ */
+void nand_ftl_get_stat(NAND_FTL_STAT *stat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __NAND_FTL_H_ */
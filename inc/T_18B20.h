@@ -95,7 +95,7 @@ Bool DS18B20GetTemperature(DS18b20_t*);
 void DS18B20RestoreEEPROMValues(void);
 void DS18B20SaveSRAMValues(void);
 POWERTYPE_t DS18B20GetPWRSupplyStatus(void);
-uint8_t DS18B20CalcAndCompareCRC(uint8_t _crc);
+Bool DS18B20CalcAndCompareCRC(DS18b20_t*);
 Bool DS18B20GetScrachtPadReg(DS18b20_t*);
 
 
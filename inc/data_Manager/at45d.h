@@ -62,6 +62,26 @@
 #ifndef AT45D_CFG_PWR_OF_TWO_PAGE_SIZE
 #error "AT45D_CFG_PWR_OF_TWO_PAGE_SIZE not specified"
 #endif
+#ifndef AT45D_CFG_DOUBLE_BUFFER
+#error "AT45D_CFG_DOUBLE_BUFFER not specified"
+#endif
+#ifndef AT45D_CFG_DMA
+#error "AT45D_CFG_DMA not specified"
+#endif
+#ifndef AT45D_CFG_STATS
+#error "AT45D_CFG_STATS not specified"
+#endif
+#if AT45D_CFG_DMA
+#ifndef AT45D_CFG_DMA_CH_RX
+#error "AT45D_CFG_DMA_CH_RX not specified"
+#endif
+#ifndef AT45D_CFG_DMA_CH_TX
+#error "AT45D_CFG_DMA_CH_TX not specified"
+#endif
+#if (AT45D_CFG_DMA_CH_RX >= AT45D_CFG_DMA_CH_TX)
+#error "AT45D_CFG_DMA_CH_RX must have a higher priority (lower number) than AT45D_CFG_DMA_CH_TX"
+#endif
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -82,9 +102,11 @@ extern "C" {
 #if   (AT45D_CFG_DEVICE == AT45DB011)
 #define AT45D_PAGES             512ul
 #define AT45D_PAGE_SIZE         (256 + (AT45D_CFG_PWR_OF_TWO_PAGE_SIZE==0 ? 8 : 0))
+#define AT45D_SRAM_BUFFERS      1
 #elif (AT45D_CFG_DEVICE == AT45DB021)
 #define AT45D_PAGES             1024ul
 #define AT45D_PAGE_SIZE         (256 + (AT45D_CFG_PWR_OF_TWO_PAGE_SIZE==0 ? 8 : 0))
+#define AT45D_SRAM_BUFFERS      1
 #elif (AT45D_CFG_DEVICE == AT45DB041)
 #define AT45D_PAGES             2048ul
 #define AT45D_PAGE_SIZE         (256 + (AT45D_CFG_PWR_OF_TWO_PAGE_SIZE==0 ? 8 : 0))
@@ -105,6 +127,11 @@ extern "C" {
 #error "Invalid AT45D device specified"
 #endif
 
+/// Number of SRAM buffers (all devices except AT45DB011 and AT45DB021 have two)
+#ifndef AT45D_SRAM_BUFFERS
+#define AT45D_SRAM_BUFFERS      2
+#endif
+
 /// Flash size (in bytes)
 #define AT45D_FLASH_SIZE_BYTES   (AT45D_PAGES*AT45D_PAGE_SIZE)
 
@@ -137,6 +164,29 @@ typedef u16_t at45d_adr_t;
 typedef u32_t at45d_adr_t;
 #endif
 
+/// Function that is called repeatedly while the driver waits for the DataFlash
+typedef void (*at45d_busy_handler_t)(void);
+
+/**
+    Function that is called (from interrupt context) when an asynchronous
+    transfer has finished.
+
+    @param ok   TRUE if the transfer completed, FALSE if a DMA error occurred
+ */
+typedef void (*at45d_callback_t)(bool_t ok);
+
+/// Driver statistics (see at45d_get_stats())
+typedef struct
+{
+    u32_t transactions;     ///< SPI transactions (DataFlash selected)
+    u32_t bytes;            ///< SPI bytes transferred (by CPU and DMA)
+    u32_t bytes_dma;        ///< SPI bytes transferred by DMA
+    u32_t programs;         ///< Page programs started
+    u32_t erases;           ///< Page erases started
+    u32_t waits;            ///< Driver calls that had to wait for a program or erase to finish
+    u32_t busy_polls;       ///< Status register reads that found the DataFlash busy
+} at45d_stats_t;
+
 /* _____GLOBAL VARIABLES_____________________________________________________ */
 
 /* _____GLOBAL FUNCTION DECLARATIONS_________________________________________ */
@@ -219,6 +269,10 @@ void at45d_rd_page_offset(void  *buffer,
 
     The DataFlash has AT45D_PAGES pages.
 
+    The function returns as soon as the page program has been started. If
+    AT45D_CFG_DOUBLE_BUFFER is enabled, the next page write is transferred
+    into the other SRAM buffer without waiting for this program to finish.
+
     @param[in] buffer  Buffer containing data to be written
     @param[in]  page   0 to (AT45D_PAGES-1)
     
@@ -239,6 +293,9 @@ void at45d_wr_page(const void *buffer,
     exceeded, the index will wrap to the start of the page, i.e. only the
     content of the specified page will be written.
 
+    The page is programmed without being erased first, so bits can only be
+    cleared (1 to 0). Call at45d_erase_page() first to write arbitrary data.
+
     @param[in]  buffer              Buffer containing data to be written
     @param[in]  page                0 to (AT45D_PAGES-1)
     @param[in]  start_byte_in_page  Index of first byte to write (0 to
@@ -251,6 +308,58 @@ void at45d_wr_page_offset(const void *buffer,
                           u16_t      start_byte_in_page,                                    
                           u16_t      nr_of_bytes);
 
+#if AT45D_CFG_DMA
+/**
+    Start an asynchronous read of data from DataFlash.
+
+    Waits until the DataFlash is ready (see at45d_set_busy_handler()), sends
+    the read command and returns while the data is moved into the buffer by
+    DMA. The callback is called from the DMA interrupt when the last byte has
+    been received. at45d_ready() returns FALSE until then and the other driver
+    functions wait for the transfer to finish first.
+
+    @param[out] buffer          Buffer to store read data (must stay valid
+                                until the callback)
+    @param[in]  address         0 to AT45D_ADR_MAX
+    @param[in]  nr_of_bytes     Number of bytes to read
+    @param[in]  callback        Function to call when done (may be NULL)
+    
+    @return u16_t               Number of bytes that will be read; 0 if the
+                                address is out of bounds or another
+                                asynchronous transfer is still busy
+ */
+u16_t at45d_rd_async(void            *buffer,
+                     at45d_adr_t      address,
+                     u16_t            nr_of_bytes,
+                     at45d_callback_t callback);
+
+/**
+    Start an asynchronous write of a page to DataFlash.
+
+    Waits until the DataFlash is ready and returns while the page data is
+    moved out of the buffer by DMA. With AT45D_CFG_DOUBLE_BUFFER the data is
+    written to the next SRAM buffer (alternating with at45d_wr_page() and
+    at45d_wr_page_offset()) and the buffer to main memory page program (with
+    erase) is started from the DMA interrupt when the last byte has been sent;
+    otherwise a "main memory page program through buffer 1" command is used
+    and deselecting the DataFlash starts the erase and program. The callback is
+    then called from the DMA interrupt. The buffer may be reused from then on;
+    at45d_ready() reports when the program has finished. With double
+    buffering, a buffer that was not transferred completely is not programmed.
+
+    @param[in] buffer   Buffer containing AT45D_PAGE_SIZE bytes to be written
+                        (must stay valid until the callback)
+    @param[in] page     0 to (AT45D_PAGES-1)
+    @param[in] callback Function to call when done (may be NULL)
+
+    @retval TRUE        Transfer started
+    @retval FALSE       Another asynchronous transfer is still busy
+ */
+bool_t at45d_wr_page_async(const void      *buffer,
+                           u16_t            page,
+                           at45d_callback_t callback);
+#endif
+
 /**
     Erase a page of DataFlash.
     
@@ -270,10 +379,41 @@ void at45d_erase_page(u16_t page);
     operation to finish.
 
    @retval TRUE     DataFlash is ready for next read or write access.
-   @retval FALSE    DataFlash is busy writing.
+   @retval FALSE    DataFlash is busy writing (or an asynchronous transfer is
+                    still busy).
  */
 bool_t at45d_ready(void);
 
+/**
+    Set function to call while the driver waits for the DataFlash.
+
+    Every driver function that has to wait for a previous write or erase to
+    finish polls at45d_ready() and calls the handler between polls, instead of
+    spinning on the status register. The handler may do other work, but must
+    not access the DataFlash.
+
+    @param[in] handler  Function to call, or NULL to busy-wait
+ */
+void at45d_set_busy_handler(at45d_busy_handler_t handler);
+
+#if AT45D_CFG_STATS
+/**
+    Get driver statistics.
+
+    The counters accumulate from at45d_init() or the last call to
+    at45d_reset_stats(). Together with the number of records written, they
+    show how many SPI transactions, bytes, programs and erases an operation
+    costs. The time spent waiting is approximately busy_polls multiplied by
+    the duration of a status register read (plus the busy handler).
+
+    @param[out] stats   Pointer to structure that will be filled in
+ */
+void at45d_get_stats(at45d_stats_t *stats);
+
+/// Reset driver statistics to zero
+void at45d_reset_stats(void);
+#endif
+
 /**
     Read the status register of the DataFlash.
 
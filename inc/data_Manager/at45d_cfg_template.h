@@ -53,5 +53,43 @@
  */
 #define AT45D_CFG_PWR_OF_TWO_PAGE_SIZE    0
 
+/**
+    Use both SRAM buffers of the DataFlash for page writes.
+
+    When enabled, page writes alternate between buffer 1 and buffer 2. The next
+    page is transferred into the idle buffer while the other buffer is still
+    being programmed into main memory, so that the SPI transfer overlaps the
+    program time. Ignored for devices with only one SRAM buffer (AT45DB011 and
+    AT45DB021).
+ */
+#define AT45D_CFG_DOUBLE_BUFFER           1
+
+/**
+    Use the GPDMA for SPI data transfers (1=enabled, 0=disabled).
+
+    When enabled, data blocks are moved between memory and the SSP by two
+    GPDMA channels instead of byte by byte by the CPU, and at45d_rd_async()
+    and at45d_wr_page_async() are available. The channel interrupts are installed
+    with wsBoard_DMA_Init(). The blocking functions wait for these interrupts,
+    so they must not be called with interrupts disabled.
+ */
+#define AT45D_CFG_DMA                     1
+
+/// GPDMA channel for SSP receive (must have a higher priority, i.e. lower number, than transmit)
+#define AT45D_CFG_DMA_CH_RX               0
+
+/// GPDMA channel for SSP transmit
+#define AT45D_CFG_DMA_CH_TX               1
+
+/**
+    Keep driver statistics (1=enabled, 0=disabled).
+
+    When enabled, the driver counts SPI transactions and bytes, page programs,
+    page erases and time spent waiting for the DataFlash (see
+    at45d_get_stats()). Used to measure the Serial Flash traffic of a file
+    system on the target itself.
+ */
+#define AT45D_CFG_STATS                   0
+
 /// @}
 #endif // #ifndef __AT45D_CFG_H__
@@ -0,0 +1,145 @@
+#ifndef __CRC_H__
+#define __CRC_H__
+/* =============================================================================
+
+    Title:          crc.h : CRC calculators
+    Creation Date:  2026-10-17
+
+============================================================================= */
+/** 
+    @ingroup DATA
+    @defgroup CRC crc.h : CRC calculators
+
+    CRC-8, CRC-16 and CRC-32 calculators shared by the drivers and data modules.
+
+    File(s):
+    - data/crc.h
+    - data/crc_cfg_template.h
+    - data/crc.c
+
+    The calculation method is selected at compile time with CRC_CFG_METHOD:
+
+    - CRC_METHOD_BITWISE : 8 shift/XOR iterations per byte, no tables.
+    - CRC_METHOD_TABLE   : one 256-entry table lookup per byte.
+    - CRC_METHOD_SLICE4  : four 256-entry tables per CRC; 4 bytes are folded
+                           in with 4 independent lookups per iteration.
+
+    All methods give bit-identical results. The tables are constant and are
+    placed in Flash.
+
+    Each function takes the current CRC value so that a CRC can be calculated
+    over several blocks of data. No final XOR is applied; the caller passes the
+    initial value of the CRC variant and applies the final XOR (if any).
+
+    Variants:
+
+    | Function               | Polynomial (reflected)  | Used by                    |
+    |------------------------|-------------------------|----------------------------|
+    | crc8_calc()            | 0x4D (0xB2), reflected  | log_fs (init 0xFF)         |
+    | crc8_maxim_calc()      | 0x31 (0x8C), reflected  | DS18B20 / 1-Wire (init 0)  |
+    | crc16_ccitt_calc()     | 0x1021, MSB first       | log_fs (init 0xFFFF), SD   |
+    |                        |                         | card data (init 0)         |
+    | crc16_ccitt_rev_calc() | 0x1021 (0x8408), refl.  | ISO 14443A CRC_A           |
+    |                        |                         | (init 0x6363)              |
+    | crc32_calc()           | 0x04C11DB7 (0xEDB88320) | CRC-32 (init 0xFFFFFFFF,   |
+    |                        |                         | final XOR 0xFFFFFFFF)      |
+ */
+/// @{
+
+/* _____STANDARD INCLUDES____________________________________________________ */
+#include <stddef.h>
+
+/* _____PROJECT INCLUDES_____________________________________________________ */
+#include <defines.h>
+
+// Include project specific config. See "crc_cfg_template.h"
+#include <data_Manager/crc_cfg.h>
+
+// Check that all project specific options have been specified in "crc_cfg.h"
+#ifndef CRC_CFG_METHOD
+#error "CRC_CFG_METHOD not specified"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* _____DEFINITIONS _________________________________________________________ */
+/// @name CRC calculation methods (see CRC_CFG_METHOD)
+//@{
+#define CRC_METHOD_BITWISE  0   ///< Bit by bit (smallest, slowest)
+#define CRC_METHOD_TABLE    1   ///< 256-entry table per CRC
+#define CRC_METHOD_SLICE4   2   ///< 4 x 256-entry tables per CRC (fastest)
+//@}
+
+/* _____TYPE DEFINITIONS_____________________________________________________ */
+
+/* _____GLOBAL VARIABLES_____________________________________________________ */
+
+/* _____GLOBAL FUNCTION DECLARATIONS_________________________________________ */
+/**
+    Calculate CRC-8 (polynomial x^8 + x^6 + x^3 + x^2 + 1, reflected).
+
+    @param crc          Initial value or previous result
+    @param data         Pointer to data
+    @param nr_of_bytes  Number of bytes
+
+    @return u8_t        Updated CRC
+ */
+u8_t crc8_calc(u8_t crc, const void * data, size_t nr_of_bytes);
+
+/**
+    Calculate Dallas/Maxim 1-Wire CRC-8 (polynomial x^8 + x^5 + x^4 + 1,
+    reflected).
+
+    The CRC over data that ends with its own (correct) CRC byte is zero.
+
+    @param crc          Initial value (0) or previous result
+    @param data         Pointer to data
+    @param nr_of_bytes  Number of bytes
+
+    @return u8_t        Updated CRC
+ */
+u8_t crc8_maxim_calc(u8_t crc, const void * data, size_t nr_of_bytes);
+
+/**
+    Calculate CRC-16/CCITT (polynomial x^16 + x^12 + x^5 + 1, MSB first).
+
+    @param crc          Initial value or previous result
+    @param data         Pointer to data
+    @param nr_of_bytes  Number of bytes
+
+    @return u16_t       Updated CRC
+ */
+u16_t crc16_ccitt_calc(u16_t crc, const void * data, size_t nr_of_bytes);
+
+/**
+    Calculate reflected CRC-16/CCITT (polynomial x^16 + x^12 + x^5 + 1, LSB
+    first).
+
+    @param crc          Initial value or previous result
+    @param data         Pointer to data
+    @param nr_of_bytes  Number of bytes
+
+    @return u16_t       Updated CRC
+ */
+u16_t crc16_ccitt_rev_calc(u16_t crc, const void * data, size_t nr_of_bytes);
+
+/**
+    Calculate CRC-32 (IEEE 802.3 polynomial, reflected).
+
+    @param crc          Initial value or previous result
+    @param data         Pointer to data
+    @param nr_of_bytes  Number of bytes
+
+    @return u32_t       Updated CRC
+ */
+u32_t crc32_calc(u32_t crc, const void * data, size_t nr_of_bytes);
+
+/* _____MACROS_______________________________________________________________ */
+
+/// @}
+#ifdef __cplusplus
+}
+#endif
+
+#endif // #ifndef __CRC_H__
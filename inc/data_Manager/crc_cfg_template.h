@@ -0,0 +1,38 @@
+#ifndef __CRC_CFG_H__
+#define __CRC_CFG_H__
+/* =============================================================================
+
+    Title:          crc_cfg.h : CRC calculator configuration
+    Creation Date:  2026-10-17
+
+============================================================================= */
+
+/** 
+    @addtogroup CRC
+ */
+/// @{
+
+/* _____STANDARD INCLUDES____________________________________________________ */
+
+/* _____PROJECT INCLUDES_____________________________________________________ */
+#include "defines.h"
+
+/* _____DEFINITIONS _________________________________________________________ */
+/**
+    Select CRC calculation method.
+
+    - CRC_METHOD_BITWISE : no tables
+    - CRC_METHOD_TABLE   : 256 entries per CRC (256 bytes for CRC-8, 512 bytes
+                           for CRC-16, 1 kB for CRC-32)
+    - CRC_METHOD_SLICE4  : 4 times the TABLE size; fastest for blocks of data
+
+    Tables of unused CRC functions are discarded by the linker when compiled
+    with -fdata-sections and linked with --gc-sections. The method can also be
+    given on the compiler command line (-DCRC_CFG_METHOD=...).
+ */
+#ifndef CRC_CFG_METHOD
+#define CRC_CFG_METHOD      CRC_METHOD_SLICE4
+#endif
+
+/// @}
+#endif // #ifndef __CRC_CFG_H__
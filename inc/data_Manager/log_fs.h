@@ -73,7 +73,15 @@
     overwrite oldest records) when the start of the oldest file is reached. This
     simplified scheme implicitly allows for wear leveling, because each Serial
     Flash page is erased once per pass through the circular buffer.
- 
+
+    A circular file with a limited number of pages (LOG_FS_CFG_MAX_PAGES) wraps
+    inside its own window of pages. With LOG_FS_CFG_WINDOW_ROTATE enabled, the
+    newest file moves its FILE page one page forward each time it wraps (the
+    page with the oldest records is overwritten with a copy of the FILE page
+    and the old FILE page is erased). The page after the old window becomes
+    the last page of the moved window, so that the window travels through the
+    file system one page per wrap.
+
     The file system leverages a characteristic of Serial Flash. When a page is 
     erased, all the data bits are reset to 1. When writing a byte, bits can be 
     cleared (0), but not reset to 1 again. The following 8-bit marker values are
@@ -95,7 +103,31 @@
     number is used to figure out which is the oldest file and which is the 
     newest during log_fs_init().
 
+    If LOG_FS_CFG_PAGE_INDEX is enabled, the marker and rolling number of each
+    page header is kept in a RAM index during log_fs_init(). File and record
+    page searches are then answered from RAM and only the page containing the
+    wanted file info or record is read from Serial Flash.
+
+    If LOG_FS_CFG_CHECKPOINT is also enabled, the file system state and RAM
+    index are written as a CRC protected checkpoint to a reserved page range
+    when a file is created or deleted and after every
+    LOG_FS_CFG_CHECKPOINT_PERIOD record pages. The reserved range is divided
+    into as many checkpoint slots as will fit and the slots are used in turn,
+    so that an interrupted write leaves the previous checkpoint intact and the
+    checkpoint writes are spread over the whole range. During log_fs_init() 
+    the newest valid checkpoint is restored and only the pages written after it
+    are read to roll the index forward.
+
     @image html images/log_fs/log_fs_page_header.png "Page header structure"
+
+    If LOG_FS_CFG_ERASE_CNT is enabled, the page header is followed by a 32-bit
+    erase counter. It is read before a page is erased and written back 
+    incremented directly after the erase, while the rest of the page header is
+    still FREE. It is not covered by the page header CRC. log_fs_stats() 
+    reports the erase count histogram, BAD pages and write amplification. Files
+    are written sequentially and wrap around, so the pages are erased evenly,
+    except when all files have been deleted; a new file is then started at the
+    least erased FREE or deleted page instead of the first FREE page.
  
     After the FILE page, records are stored in RECORD pages. The 16-bit rolling
     RECORD number (in each page header) is used to figure out which is the 
@@ -105,6 +137,15 @@
     LOG_FS_CFG_REC_DATA_SIZE) and an 8-bit CRC.
 
     @image html images/log_fs/log_fs_record.png "Record structure"
+
+    If LOG_FS_CFG_REC_VAR_SIZE is enabled, an 8-bit length follows the RECORD
+    marker and only that many data bytes are stored, followed by the CRC. The
+    records are packed back to back in a page and the length fields chain the
+    records together. LOG_FS_CFG_REC_DATA_SIZE is then the maximum record data
+    size. A new page is started when the next record does not fit. Reading
+    backwards (log_fs_record_rd_previous()) has to follow the chain from the
+    start of the page and is therefore slower than reading forwards.
+    Numeric sensor readings can be packed into short records with varint.h.
  
     @warn_s
     <b>A record will not span across pages</b>, so there may be unused space at
@@ -314,6 +355,53 @@
 #if (LOG_FS_CFG_PAGE_END + LOG_FS_CFG_MAX_PAGES >= 0xffff)
 #error "Arithmetic will overflow. Make value smaller"
 #endif
+#ifndef LOG_FS_CFG_WINDOW_ROTATE
+#error "LOG_FS_CFG_WINDOW_ROTATE not specified"
+#endif
+#ifndef LOG_FS_CFG_REC_TIME_STAMP
+#error "LOG_FS_CFG_REC_TIME_STAMP not specified"
+#endif
+#if LOG_FS_CFG_REC_TIME_STAMP && (LOG_FS_CFG_REC_DATA_SIZE < 6)
+#error "LOG_FS_CFG_REC_DATA_SIZE too small to store record time stamp"
+#endif
+#ifndef LOG_FS_CFG_REC_VAR_SIZE
+#error "LOG_FS_CFG_REC_VAR_SIZE not specified"
+#endif
+#if LOG_FS_CFG_REC_VAR_SIZE && (LOG_FS_CFG_REC_DATA_SIZE > 254)
+#error "LOG_FS_CFG_REC_DATA_SIZE too big for 8-bit record length"
+#endif
+#ifndef LOG_FS_CFG_ERASE_CNT
+#error "LOG_FS_CFG_ERASE_CNT not specified"
+#endif
+#ifndef LOG_FS_CFG_ERASE_ENDURANCE
+#error "LOG_FS_CFG_ERASE_ENDURANCE not specified"
+#endif
+#ifndef LOG_FS_CFG_PAGE_INDEX
+#error "LOG_FS_CFG_PAGE_INDEX not specified"
+#endif
+#ifndef LOG_FS_CFG_CHECKPOINT
+#error "LOG_FS_CFG_CHECKPOINT not specified"
+#endif
+#if LOG_FS_CFG_CHECKPOINT
+#if (LOG_FS_CFG_PAGE_INDEX == 0)
+#error "LOG_FS_CFG_CHECKPOINT requires LOG_FS_CFG_PAGE_INDEX"
+#endif
+#ifndef LOG_FS_CFG_CHECKPOINT_PAGE_START
+#error "LOG_FS_CFG_CHECKPOINT_PAGE_START not specified"
+#endif
+#ifndef LOG_FS_CFG_CHECKPOINT_PAGE_END
+#error "LOG_FS_CFG_CHECKPOINT_PAGE_END not specified"
+#endif
+#ifndef LOG_FS_CFG_CHECKPOINT_PERIOD
+#error "LOG_FS_CFG_CHECKPOINT_PERIOD not specified"
+#endif
+#if (LOG_FS_CFG_CHECKPOINT_PAGE_START > LOG_FS_CFG_CHECKPOINT_PAGE_END)
+#error "LOG_FS_CFG_CHECKPOINT_PAGE_START must not be bigger than LOG_FS_CFG_CHECKPOINT_PAGE_END"
+#endif
+#if (LOG_FS_CFG_CHECKPOINT_PAGE_END >= LOG_FS_CFG_PAGE_START) && (LOG_FS_CFG_CHECKPOINT_PAGE_START <= LOG_FS_CFG_PAGE_END)
+#error "Checkpoint pages must not overlap file system pages"
+#endif
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -327,6 +415,9 @@ extern "C" {
 #define LOG_FS_CFG_TYPE_CIRCULAR    1
 //@}
 
+/// Number of bins in the erase count histogram (see log_fs_stats_t)
+#define LOG_FS_STATS_HIST_BINS      8
+
 /* _____TYPE DEFINITIONS_____________________________________________________ */
 /// Error codes
 typedef enum
@@ -366,6 +457,29 @@ typedef struct
     log_fs_time_stamp_t    time_stamp;  ///< File creation time stamp (date and time)
 } __attribute__((__packed__)) log_fs_file_t;
 
+/// File system statistics (see log_fs_stats())
+typedef struct
+{
+    log_fs_page_t pages_free;       ///< Number of FREE pages
+    log_fs_page_t pages_file;       ///< Number of FILE pages
+    log_fs_page_t pages_record;     ///< Number of RECORD pages
+    log_fs_page_t pages_bad;        ///< Number of BAD pages
+
+    u32_t         erase_min;        ///< Smallest page erase count
+    u32_t         erase_max;        ///< Largest page erase count
+    u32_t         erase_total;      ///< Sum of page erase counts
+    /// Number of pages in each 1/LOG_FS_STATS_HIST_BINS of LOG_FS_CFG_ERASE_ENDURANCE (last bin includes worn out pages)
+    log_fs_page_t erase_hist[LOG_FS_STATS_HIST_BINS];
+    u8_t          wear_pct;         ///< Largest page erase count in percent of LOG_FS_CFG_ERASE_ENDURANCE
+
+    u32_t         rec_bytes;        ///< Record data bytes written
+    u32_t         prg_bytes;        ///< Bytes programmed (records, headers, markers and checkpoints)
+    u32_t         prg_pages;        ///< Page program operations
+    u32_t         erases;           ///< Page erases
+    u32_t         bad_marked;       ///< Pages, records or markers marked as BAD
+    u32_t         wr_amp_x100;      ///< Write amplification x 100 (prg_bytes / rec_bytes)
+} log_fs_stats_t;
+
 /* _____GLOBAL VARIABLES_____________________________________________________ */
 
 /* _____GLOBAL FUNCTION DECLARATIONS_________________________________________ */
@@ -552,12 +666,81 @@ log_fs_err_t log_fs_record_rd_next(void * data, size_t nr_of_bytes);
  */
 log_fs_err_t log_fs_record_rd_previous(void * data, size_t nr_of_bytes);
 
+/**
+    Return the data size of the record that was read last.
+
+    If LOG_FS_CFG_REC_VAR_SIZE is enabled, this is the number of bytes that was
+    written to the record, otherwise it is always LOG_FS_CFG_REC_DATA_SIZE.
+
+    @return size_t                  Record data size (in bytes)
+ */
+size_t log_fs_record_size(void);
+
+#if !LOG_FS_CFG_REC_VAR_SIZE
+/**
+    Seek to a record by index and read it.
+
+    Index 0 is the first (oldest) record of the file. The record page is found
+    by bisecting the record page rolling numbers, so only a few page headers
+    are read, regardless of the size of the file. Reading can continue with
+    log_fs_record_rd_next() or log_fs_record_rd_previous().
+
+    Not available if LOG_FS_CFG_REC_VAR_SIZE is enabled, because the number of
+    records per page is then not fixed.
+
+    @note
+
+    The index counts record slots. A record that failed to write (verify
+    failed) occupies a slot, so the index of subsequent records is one more
+    than the number of records written before them. If the slot is BAD, the
+    next valid record is returned.
+
+    @param index                    Record index (0 = first record)
+    @param data                     Pointer to buffer where record data must be
+                                    copied to
+    @param nr_of_bytes              Number of bytes to copy from record
+        
+    @retval LOG_FS_ERR_NONE         Valid record data found and copied into 
+                                    structure
+    @retval LOG_FS_ERR_NO_RECORD    No record found
+ */
+log_fs_err_t log_fs_record_seek_index(u32_t  index,
+                                      void * data, 
+                                      size_t nr_of_bytes);
+#endif
+
+#if LOG_FS_CFG_REC_TIME_STAMP
+/**
+    Seek to the first record with a time stamp equal to or later than the
+    specified time stamp and read it.
+
+    Records must start with a log_fs_time_stamp_t (see
+    LOG_FS_CFG_REC_TIME_STAMP). The record pages are bisected by the time stamp
+    of the first record in each page; only one page of records is then read
+    sequentially. Reading can continue with log_fs_record_rd_next() or
+    log_fs_record_rd_previous().
+
+    @param time_stamp               Time stamp to seek
+    @param data                     Pointer to buffer where record data must be
+                                    copied to
+    @param nr_of_bytes              Number of bytes to copy from record
+        
+    @retval LOG_FS_ERR_NONE         Valid record data found and copied into 
+                                    structure
+    @retval LOG_FS_ERR_NO_RECORD    No record found (all records are older)
+ */
+log_fs_err_t log_fs_record_seek_time(const log_fs_time_stamp_t * time_stamp,
+                                     void *                      data, 
+                                     size_t                      nr_of_bytes);
+#endif
+
 /**
     Write a record to the file.
     
     A new record is appended to the end of the list of records. The maximum
     number of bytes that can be stored in the record is specified by
-    LOG_FS_CFG_DATA_SIZE.
+    LOG_FS_CFG_DATA_SIZE. If LOG_FS_CFG_REC_VAR_SIZE is enabled, only
+    'nr_of_bytes' data bytes are stored.
 
     @param data                     Pointer to buffer containing data that must
                                     be stored in the record
@@ -569,6 +752,52 @@ log_fs_err_t log_fs_record_rd_previous(void * data, size_t nr_of_bytes);
  */
 log_fs_err_t log_fs_record_wr(const void * data, size_t nr_of_bytes);
 
+/**
+    Write a batch of records to the file.
+
+    The records are appended in order, exactly as if log_fs_record_wr() was
+    called for each one, but all of the records that fit in the current page
+    are written with a single page program instead of one per record.
+    If LOG_FS_CFG_REC_VAR_SIZE is enabled, each record is stored with the
+    maximum length.
+
+    @param recs                     Pointer to an array of records, each 
+                                    LOG_FS_CFG_REC_DATA_SIZE bytes in size
+    @param nr_of_recs               Number of records in the array
+
+    @retval LOG_FS_ERR_NONE         Success
+    @retval LOG_FS_ERR_FULL         File (or file system) is full. Records that
+                                    did not fit were discarded
+    @retval LOG_FS_ERR_WRITE_FAIL   Failed to write one or more records (verify
+                                    failed). If a record page header could not
+                                    be written, the remaining records were 
+                                    discarded
+ */
+log_fs_err_t log_fs_record_wr_batch(const void * recs, size_t nr_of_recs);
+
+#if LOG_FS_CFG_CHECKPOINT
+/**
+    Write a checkpoint of the file system state and RAM index.
+
+    Checkpoints are written automatically, but this function can be called
+    before a planned power down so that the next log_fs_init() does not have
+    to roll forward any pages.
+ */
+void log_fs_checkpoint_wr(void);
+#endif
+
+/**
+    Report file system statistics to predict Serial Flash end of life.
+
+    The page states are counted (from the RAM index if enabled). If 
+    LOG_FS_CFG_ERASE_CNT is enabled, the erase counter of every page is read
+    to fill in the erase count fields, otherwise they are zero. The write
+    statistics (rec_bytes to wr_amp_x100) are counted since log_fs_init().
+
+    @param stats                    Pointer to structure that will be filled in
+ */
+void log_fs_stats(log_fs_stats_t * stats);
+
 /// Report log file system info
 void log_fs_info(void);
 
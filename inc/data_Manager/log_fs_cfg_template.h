@@ -58,5 +58,84 @@
 /// Maximum number of pages allocated to file. 0 means no limit
 #define LOG_FS_CFG_MAX_PAGES        0
 
+/**
+    Move the window of a circular file (1=enabled, 0=disabled).
+
+    Only used if LOG_FS_CFG_TYPE is LOG_FS_CFG_TYPE_CIRCULAR and
+    LOG_FS_CFG_MAX_PAGES is 2 or more. Each time the newest file wraps, its
+    FILE page is moved one page forward, over the oldest records. The window
+    then travels through the whole file system instead of wearing out the
+    same LOG_FS_CFG_MAX_PAGES pages.
+    Costs one extra page write per LOG_FS_CFG_MAX_PAGES record pages and a
+    page sized buffer in RAM. The start page of the moved file changes;
+    log_fs_file_find_last() returns the new one.
+ */
+#define LOG_FS_CFG_WINDOW_ROTATE    1
+
+/**
+    Records start with a time stamp (1=enabled, 0=disabled).
+
+    When enabled, the first bytes of each record's data must be a
+    log_fs_time_stamp_t and records must be written in chronological order.
+    This enables log_fs_record_seek_time().
+ */
+#define LOG_FS_CFG_REC_TIME_STAMP   0
+
+/**
+    Variable-length records (1=enabled, 0=disabled).
+
+    When enabled, each record block stores its data length and only the
+    written bytes are stored on the Serial Flash. Records are packed back to
+    back in a page and LOG_FS_CFG_REC_DATA_SIZE is the maximum record data
+    size (254 bytes or less). log_fs_record_size() returns the length of the
+    record that was read.
+ */
+#define LOG_FS_CFG_REC_VAR_SIZE     0
+
+/**
+    Keep an erase counter in each page header (1=enabled, 0=disabled).
+
+    When enabled, a 32-bit erase counter is stored after each page header and
+    log_fs_stats() reports the erase count histogram. A new file in an empty
+    file system is started at the least erased page. Changes the format on
+    the Serial Flash and costs one extra page program per page erase.
+ */
+#define LOG_FS_CFG_ERASE_CNT        0
+
+/// Rated erase cycles per page (used by log_fs_stats() to report wear)
+#define LOG_FS_CFG_ERASE_ENDURANCE  100000
+
+/**
+    Keep an index of page states in RAM (1=enabled, 0=disabled).
+
+    When enabled, log_fs_init() reads each page header once to build a table
+    of page states (2 bits per page) and rolling numbers (16 bits per page).
+    All subsequent page searches are answered from RAM instead of the Serial
+    Flash. RAM cost is approximately 2.25 bytes per page.
+ */
+#define LOG_FS_CFG_PAGE_INDEX       1
+
+/**
+    Write checkpoints for fast mounting (1=enabled, 0=disabled).
+
+    The file system state and RAM index (LOG_FS_CFG_PAGE_INDEX must be enabled)
+    are periodically written to a reserved page range. log_fs_init() restores
+    the newest valid checkpoint and only reads the page headers that were
+    written after it, instead of indexing the whole file system.
+
+    The reserved range must lie outside LOG_FS_CFG_PAGE_START to
+    LOG_FS_CFG_PAGE_END and must be large enough for two checkpoints.
+ */
+#define LOG_FS_CFG_CHECKPOINT               0
+
+/// First page reserved for checkpoints
+#define LOG_FS_CFG_CHECKPOINT_PAGE_START    0
+
+/// Last page reserved for checkpoints
+#define LOG_FS_CFG_CHECKPOINT_PAGE_END      0
+
+/// Number of record pages written before a new checkpoint is written
+#define LOG_FS_CFG_CHECKPOINT_PERIOD        32
+
 /// @}
 #endif // #ifndef __LOG_FS_CFG_H__
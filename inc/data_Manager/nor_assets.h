@@ -0,0 +1,309 @@
+#ifndef __NOR_ASSETS_H__
+#define __NOR_ASSETS_H__
+/* =============================================================================
+
+    Title:          nor_assets.h : Read-only asset bundle in memory mapped NOR flash
+    Creation Date:  2026-10-17
+
+
+============================================================================= */
+/** 
+    @ingroup DATA
+    @defgroup NOR_ASSETS nor_assets.h : Read-only asset bundle in memory mapped NOR flash
+
+    Fonts, bitmaps, web pages and calibration tables used in place from the
+    SST39VF320 NOR flash.
+
+    File(s):
+    - data/nor_assets.h
+    - data/nor_assets_cfg_template.h
+    - data/nor_assets.c
+    - data/mkassets/mkassets.c (host tool)
+
+    The NOR flash is mapped at EMC_ADDRESS_CS0, so an asset does not have to
+    be copied to RAM before it is used: nor_assets_get() returns a pointer to
+    the data in the flash. The display can blit a bitmap from it and the HTTP
+    server sends web pages from it without a file buffer.
+
+    The bundle is built on the host with 'mkassets' and stored at
+    NOR_ASSETS_CFG_OFFSET in the NOR flash. All fields are little endian:
+
+    | Offset            | Content                                           |
+    |-------------------|---------------------------------------------------|
+    | 0                 | nor_assets_hdr_t                                  |
+    | 20                | nor_asset_t index, count entries, sorted by hash  |
+    | after the index   | zero terminated names                             |
+    | after the names   | data of each asset, starting on a 4 byte boundary |
+
+    The index is sorted by the FNV-1a hash of the name (then by name), so
+    nor_assets_find() is a binary search over the index in the flash.
+
+    Example:
+
+    @code
+    const u8_t * font;
+    u32_t        size;
+
+    if(nor_assets_init())
+    {
+        font = nor_assets_get("font/dejavu16.bin", &size);
+    }
+    @endcode
+
+    A bundle can be programmed from the target (e.g. from a file on the SD
+    card or received over the network) with nor_assets_update_begin(),
+    nor_assets_update_write() and nor_assets_update_end():
+
+    - Each 4 KB sector is compared with the new data and written with
+      lpc_norflash_program(): it is only erased if a bit has to change from
+      0 to 1 and only the words that differ are programmed. Sectors that did
+      not change between two bundles are not erased or programmed at all.
+    - After each sector a flag is programmed in a progress record, in the
+      last sector of the reserved area. If the update is interrupted (reset
+      or power loss), nor_assets_update_begin() with the same bundle size
+      and CRC resumes: nor_assets_update_offset() returns the offset of the
+      first sector that still has to be written.
+    - nor_assets_update_end() checks the CRC-32 of the whole bundle in the
+      NOR flash before the progress record is erased. As long as a progress
+      record exists, nor_assets_init() does not use the bundle.
+
+    Example:
+
+    @code
+    // size and crc of the bundle file, as printed by mkassets
+    if(nor_assets_update_begin(size, crc))
+    {
+        offset = nor_assets_update_offset();
+        f_lseek(&file, offset);
+        while(offset < size)
+        {
+            f_read(&file, buf, sizeof(buf), &len);
+            nor_assets_update_write(offset, buf, len);
+            offset += len;
+        }
+        nor_assets_update_end();
+    }
+    @endcode
+ */
+/// @{
+
+/* _____STANDARD INCLUDES____________________________________________________ */
+#include <stddef.h>
+
+/* _____PROJECT INCLUDES_____________________________________________________ */
+#include <defines.h>
+
+// Include project specific config. See "nor_assets_cfg_template.h"
+#include <data_Manager/nor_assets_cfg.h>
+
+// Check that all project specific options have been specified in "nor_assets_cfg.h"
+#ifndef NOR_ASSETS_CFG_OFFSET
+#error "NOR_ASSETS_CFG_OFFSET not specified"
+#endif
+#ifndef NOR_ASSETS_CFG_MAX_SIZE
+#error "NOR_ASSETS_CFG_MAX_SIZE not specified"
+#endif
+#ifndef NOR_ASSETS_CFG_VERIFY
+#error "NOR_ASSETS_CFG_VERIFY not specified"
+#endif
+#ifndef NOR_ASSETS_CFG_HTTPD
+#error "NOR_ASSETS_CFG_HTTPD not specified"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* _____DEFINITIONS _________________________________________________________ */
+/// Bundle magic number ("NAST")
+#define NOR_ASSETS_MAGIC        0x5453414e
+
+/// Bundle format version
+#define NOR_ASSETS_VERSION      1
+
+/// @name Asset types
+//@{
+#define NOR_ASSET_TYPE_OTHER    0   ///< Unspecified
+#define NOR_ASSET_TYPE_FONT     1   ///< Font
+#define NOR_ASSET_TYPE_BITMAP   2   ///< Bitmap
+#define NOR_ASSET_TYPE_WEB      3   ///< Web page (served by the HTTP server)
+#define NOR_ASSET_TYPE_TABLE    4   ///< Calibration table
+//@}
+
+/* _____TYPE DEFINITIONS_____________________________________________________ */
+/// Statistics of an update (see nor_assets_update_stat())
+typedef struct
+{
+    u32_t sectors_resumed;  ///< Sectors skipped because they were written before an interruption
+    u32_t sectors_erased;   ///< Sectors erased
+    u32_t words_written;    ///< Words programmed
+    u32_t words_skipped;    ///< Words that already held the data
+} nor_assets_update_stat_t;
+
+/// Bundle header
+typedef struct
+{
+    u32_t magic;        ///< NOR_ASSETS_MAGIC
+    u16_t version;      ///< NOR_ASSETS_VERSION
+    u16_t count;        ///< Number of assets in the index
+    u32_t size;         ///< Size of the bundle in bytes (header included)
+    u32_t crc;          ///< CRC-32 of the bundle after the header
+    u32_t hdr_crc;      ///< CRC-32 of the preceding header fields
+} nor_assets_hdr_t;
+
+/// Index entry of an asset
+typedef struct
+{
+    u32_t hash;         ///< FNV-1a hash of the name
+    u32_t name_ofs;     ///< Offset of the zero terminated name in the bundle
+    u32_t data_ofs;     ///< Offset of the data in the bundle (multiple of 4)
+    u32_t size;         ///< Size of the data in bytes
+    u32_t crc;          ///< CRC-32 of the data
+    u16_t type;         ///< NOR_ASSET_TYPE_...
+    u16_t flags;        ///< Type specific flags (web: lwIP FS_FILE_FLAGS_...)
+} nor_asset_t;
+
+/* _____GLOBAL VARIABLES_____________________________________________________ */
+
+/* _____GLOBAL FUNCTION DECLARATIONS_________________________________________ */
+/**
+    Check the bundle in the NOR flash.
+
+    The NOR flash must have been initialised with lpc_norflash_init().
+
+    @retval TRUE    Valid bundle found
+    @retval FALSE   No bundle or corrupt bundle
+ */
+bool_t nor_assets_init(void);
+
+/**
+    Check the CRC of the whole bundle and of each asset.
+
+    @retval TRUE    Bundle is intact
+    @retval FALSE   No bundle or CRC error
+ */
+bool_t nor_assets_verify(void);
+
+/**
+    Get the number of assets in the bundle.
+
+    @return u16_t   Number of assets (0 if there is no valid bundle)
+ */
+u16_t nor_assets_count(void);
+
+/**
+    Get an entry of the index.
+
+    @param index                Index (0 to nor_assets_count()-1)
+
+    @return const nor_asset_t * Pointer to entry in the NOR flash; NULL if 
+                                index is out of range
+ */
+const nor_asset_t * nor_assets_entry(u16_t index);
+
+/**
+    Find an asset by name.
+
+    @param name                 Zero terminated name, e.g. "/index.html"
+
+    @return const nor_asset_t * Pointer to entry in the NOR flash; NULL if not
+                                found
+ */
+const nor_asset_t * nor_assets_find(const char * name);
+
+/**
+    Get the name of an asset.
+
+    @param asset        Pointer to entry
+
+    @return const char* Pointer to zero terminated name in the NOR flash
+ */
+const char * nor_assets_name(const nor_asset_t * asset);
+
+/**
+    Get the data of an asset.
+
+    @param asset        Pointer to entry
+
+    @return const void* Pointer to data in the NOR flash (4 byte aligned)
+ */
+const void * nor_assets_data(const nor_asset_t * asset);
+
+/**
+    Find an asset by name and get its data.
+
+    @param name         Zero terminated name
+    @param size         Pointer to location to store size of data (may be NULL)
+
+    @return const void* Pointer to data in the NOR flash; NULL if not found
+ */
+const void * nor_assets_get(const char * name, u32_t * size);
+
+/**
+    Start or resume an update of the bundle.
+
+    The current bundle can not be used until nor_assets_update_end()
+    succeeds. If an update of a bundle with the same size and CRC was
+    interrupted, it is resumed. Fails while the HTTP server is still sending a
+    web asset (NOR_ASSETS_CFG_HTTPD), so that the NOR flash is not programmed
+    under it; try again later.
+
+    @param size         Size of the new bundle in bytes
+    @param crc          CRC-32 of the new bundle
+
+    @retval TRUE        Ready to program
+    @retval FALSE       Bundle too large, web asset open or flash error
+ */
+bool_t nor_assets_update_begin(u32_t size, u32_t crc);
+
+/**
+    Get the offset from which the new bundle has to be written.
+
+    @return u32_t       Offset of the first sector that has not been written
+                        (a multiple of 4 KB); the bundle size if all sectors
+                        have been written
+ */
+u32_t nor_assets_update_offset(void);
+
+/**
+    Program part of the new bundle.
+
+    The first part must start on a 4 KB boundary, e.g. at
+    nor_assets_update_offset(), and the following parts must be contiguous.
+    A sector is programmed when it is complete; sectors that were written
+    before an interruption are skipped.
+
+    @param offset       Offset in the bundle
+    @param data         Data to program
+    @param nr_of_bytes  Number of bytes
+
+    @retval TRUE        Data accepted
+    @retval FALSE       Parameter or flash error
+ */
+bool_t nor_assets_update_write(u32_t offset, const void * data, u32_t nr_of_bytes);
+
+/**
+    Finish an update.
+
+    The CRC of the new bundle in the NOR flash is checked, the progress record
+    is erased and the bundle is checked with nor_assets_init(). On a CRC
+    error the progress record is erased too, so that the next update
+    compares all sectors again.
+
+    @retval TRUE        New bundle valid
+    @retval FALSE       Sectors missing, CRC error or invalid bundle
+ */
+bool_t nor_assets_update_end(void);
+
+/**
+    Get the statistics of the last update.
+
+    @param stat         Pointer to statistics to fill
+ */
+void nor_assets_update_stat(nor_assets_update_stat_t * stat);
+
+/// @}
+#ifdef __cplusplus
+}
+#endif
+
+#endif // #ifndef __NOR_ASSETS_H__
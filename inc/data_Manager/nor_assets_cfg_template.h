@@ -0,0 +1,53 @@
+#ifndef __NOR_ASSETS_CFG_H__
+#define __NOR_ASSETS_CFG_H__
+/* =============================================================================
+
+    Title:          nor_assets_cfg.h : NOR flash asset bundle configuration
+    Creation Date:  2026-10-17
+
+============================================================================= */
+
+
+/** 
+    @addtogroup NOR_ASSETS
+ */
+/// @{
+
+/* _____STANDARD INCLUDES____________________________________________________ */
+
+/* _____PROJECT INCLUDES_____________________________________________________ */
+#include "defines.h"
+
+/* _____DEFINITIONS _________________________________________________________ */
+/// Byte offset of the bundle in the NOR flash (multiple of the 4 KB sector size)
+#define NOR_ASSETS_CFG_OFFSET       0
+
+/**
+    Size of the NOR flash area reserved for the bundle in bytes.
+
+    The last 4 KB sector holds the progress record of an update, so the
+    bundle can be up to 4 KB smaller. Must not overlap the FatFs NOR drive
+    (FSNOR_START_SECTOR in 'FatFs/fsflash_cfg.h'), which starts at 2 MB.
+ */
+#define NOR_ASSETS_CFG_MAX_SIZE     (2UL << 20)
+
+/**
+    Check the CRC of the whole bundle in nor_assets_init() (1=enabled, 
+    0=disabled).
+
+    When disabled, only the CRC of the header is checked and the bundle CRC
+    can be checked later with nor_assets_verify().
+ */
+#define NOR_ASSETS_CFG_VERIFY       1
+
+/**
+    Serve web assets with the lwIP HTTP server (1=enabled, 0=disabled).
+
+    When enabled, fs_open_custom() is provided for LWIP_HTTPD_CUSTOM_FILES and
+    assets of type NOR_ASSET_TYPE_WEB are sent straight from the NOR flash.
+    nor_assets_update_begin() fails while a web asset is open.
+ */
+#define NOR_ASSETS_CFG_HTTPD        1
+
+/// @}
+#endif // #ifndef __NOR_ASSETS_CFG_H__
@@ -0,0 +1,115 @@
+#ifndef __VARINT_H__
+#define __VARINT_H__
+/* =============================================================================
+
+    Title:          varint.h : Varint and delta encoding of numeric tuples
+    Creation Date:  2026-10-17
+
+============================================================================= */
+/** 
+    @ingroup DATA
+    @defgroup VARINT varint.h : Varint and delta encoding of numeric tuples
+
+    Compact encoding of sensor readings for variable-length log_fs records.
+
+    File(s):
+    - data/varint.h
+    - data/varint.c
+
+    Each value of a tuple is zigzag encoded (0, -1, 1, -2, 2, ... map to 
+    0, 1, 2, 3, 4, ...) and stored as a little endian base-128 varint: 7 bits 
+    per byte, with bit 7 set if more bytes follow. A value between -64 and 63 
+    takes 1 byte and a full 32-bit value takes 5 bytes.
+
+    If a reference tuple is specified, the difference to the reference is 
+    encoded instead (delta encoding). Slowly changing sensor readings then 
+    encode to 1 byte per value. The same reference must be passed to 
+    varint_decode(), for example the previous tuple that was decoded.
+
+    Example:
+
+    @code
+    s32_t tuple[3];
+    s32_t tuple_prev[3];
+    u8_t  buf[3 * VARINT_SIZE_MAX];
+    size_t len;
+
+    // Encode difference to previous tuple and write it as a variable-length record
+    len = varint_encode(buf, sizeof(buf), tuple, tuple_prev, 3);
+    log_fs_record_wr(buf, len);
+    memcpy(tuple_prev, tuple, sizeof(tuple));
+    @endcode
+
+    @warn_s
+    A delta encoded tuple can only be decoded if the reference is known. Write
+    a tuple without a reference (absolute values) periodically, for example 
+    every time a new file is created, so that reading can restart from it if a
+    record is lost.
+    @warn_e
+ */
+/// @{
+
+/* _____STANDARD INCLUDES____________________________________________________ */
+#include <stddef.h>
+
+/* _____PROJECT INCLUDES_____________________________________________________ */
+#include <defines.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* _____DEFINITIONS _________________________________________________________ */
+/// Maximum number of bytes used to encode a 32-bit value
+#define VARINT_SIZE_MAX 5
+
+/* _____TYPE DEFINITIONS_____________________________________________________ */
+
+/* _____GLOBAL VARIABLES_____________________________________________________ */
+
+/* _____GLOBAL FUNCTION DECLARATIONS_________________________________________ */
+/**
+    Encode a tuple of signed values.
+
+    @param buf              Buffer to encode into
+    @param buf_size         Size of buffer (in bytes)
+    @param values           Tuple of values to encode
+    @param ref              Reference tuple to encode the difference to, or 
+                            NULL to encode absolute values
+    @param nr_of_values     Number of values in tuple
+
+    @return size_t          Number of bytes encoded, or 0 if the buffer is too
+                            small
+ */
+size_t varint_encode(u8_t *        buf,
+                     size_t        buf_size,
+                     const s32_t * values,
+                     const s32_t * ref,
+                     u8_t          nr_of_values);
+
+/**
+    Decode a tuple of signed values.
+
+    @param buf              Buffer to decode from
+    @param buf_size         Number of bytes in buffer
+    @param values           Tuple to decode into
+    @param ref              Reference tuple that was used to encode, or NULL
+                            if absolute values were encoded
+    @param nr_of_values     Number of values in tuple
+
+    @return size_t          Number of bytes decoded, or 0 if the buffer is 
+                            truncated or contains an invalid varint
+ */
+size_t varint_decode(const u8_t *  buf,
+                     size_t        buf_size,
+                     s32_t *       values,
+                     const s32_t * ref,
+                     u8_t          nr_of_values);
+
+/* _____MACROS_______________________________________________________________ */
+
+/// @}
+#ifdef __cplusplus
+}
+#endif
+
+#endif // #ifndef __VARINT_H__
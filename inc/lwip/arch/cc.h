@@ -70,6 +70,8 @@ typedef uintptr_t          mem_ptr_t;
     #define PACK_STRUCT_END
     #define PACK_STRUCT_FIELD(fld) fld
 	#define ALIGNED(n)  __align(n)
+	/* Peripheral SRAM: place .bss.$RAM2 at 0x20000000 with the scatter file */
+	#define DMA_SAFE_BSS __attribute__((section(".bss.$RAM2"), zero_init))
 #elif defined (__IAR_SYSTEMS_ICC__) 
 	/* IAR Embedded Workbench tools */
     #define PACK_STRUCT_BEGIN __packed
@@ -80,6 +82,9 @@ typedef uintptr_t          mem_ptr_t;
 	#define ALIGNEDX(x)      _Pragma(#x)
 	#define ALIGNEDXX(x)     ALIGNEDX(data_alignment=x)
 	#define ALIGNED(x)       ALIGNEDXX(x)
+	/* A location pragma only applies to the definition that follows it, but
+	   the pbuf pool is defined by lwIP (memp.c) */
+	#error "DMA_SAFE_BSS: the EMAC buffers can not be placed in the peripheral SRAM with IAR"
 #else 
 	/* GCC tools (CodeSourcery) */
     #define PACK_STRUCT_BEGIN
@@ -88,10 +93,24 @@ typedef uintptr_t          mem_ptr_t;
     #define PACK_STRUCT_FIELD(fld) fld
 	#define ALIGNED(n)  __attribute__((aligned (n)))
 //	#define ALIGNED(n)  __align(n)
+	/* Peripheral SRAM (RAM2 of the LPCXpresso managed linker script) */
+	#define DMA_SAFE_BSS __attribute__((section(".bss.$RAM2")))
 #endif 
 
-/* Used with IP headers only */
-#define LWIP_CHKSUM_ALGORITHM 1
+/* The EMAC DMA can only access the 32 kB peripheral SRAM and the external
+   memory. The pbuf pool is placed in the peripheral SRAM (the heap is in the
+   SDRAM, see LWIP_RAM_HEAP_POINTER in lwipopts.h), so that pool pbufs are
+   sent without a bounce copy. lpc17xx_40xx_emac.c checks that the pool and
+   the driver data (descriptor rings) fit. */
+extern u8_t DMA_SAFE_BSS memp_memory_PBUF_POOL_base[];
+
+/* Checksum routines of the port (lpc_chksum.c), word wide and unrolled.
+   LWIP_CHKSUM_COPY is used by tcp_write() to checksum the data while it is
+   copied (LWIP_CHECKSUM_ON_COPY in lwipopts.h). */
+#define LWIP_CHKSUM lpc_chksum
+#define LWIP_CHKSUM_COPY(dst, src, len) lpc_chksum_copy(dst, src, len)
+u16_t lpc_chksum(const void *dataptr, int len);
+u16_t lpc_chksum_copy(void *dst, const void *src, u16_t len);
 
 #ifdef LWIP_DEBUG
 /**
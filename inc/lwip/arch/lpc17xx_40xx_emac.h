@@ -54,9 +54,57 @@ extern "C"
  */
 
 /**
- * @brief	Attempt to read a packet from the EMAC interface
+ * @brief	EMAC driver TX statistics
+ */
+typedef struct {
+	u32_t frames;			/*!< Frames queued for transmission */
+	u32_t bounced;			/*!< Frames copied to a DMA safe bounce buffer */
+	u32_t bounceBytes;		/*!< Bytes copied to bounce buffers */
+	u32_t bounceFail;		/*!< Frames dropped, no bounce buffer could be allocated */
+	u32_t queued;			/*!< Frames that waited in the TX software queue */
+	u32_t queueDrops;		/*!< Frames dropped, TX software queue full */
+} lpc_emac_tx_stats_t;
+
+/**
+ * @brief	EMAC driver descriptor ring high-water marks
+ */
+typedef struct {
+	u32_t rxDescs;			/*!< Number of RX descriptors */
+	u32_t txDescs;			/*!< Number of TX descriptors */
+	u32_t rxMax;			/*!< Most received frames waiting in the RX ring */
+	u32_t rxBatchMax;		/*!< Most frames passed to lwIP by one lpc_enetif_input() call */
+	u32_t rxNoBufMax;		/*!< Most RX descriptors without a buffer (heap exhausted) */
+	u32_t txMax;			/*!< Most TX descriptors in use */
+	u32_t txqMax;			/*!< Most frames in the TX software queue */
+} lpc_emac_ring_stats_t;
+
+/**
+ * @brief	Latency of an RX stage, in timestamp ticks
+ */
+typedef struct {
+	u32_t count;			/*!< Number of frames */
+	u32_t max;				/*!< Longest time */
+	u64_t sum;				/*!< Sum of the times */
+} lpc_emac_lat_t;
+
+/**
+ * @brief	EMAC driver RX latency statistics
+ */
+typedef struct {
+	lpc_emac_lat_t wait;	/*!< RX event (interrupt, or first poll with NO_SYS=1) to lwIP input */
+	lpc_emac_lat_t tcp;		/*!< lwIP input to TCP input */
+	lpc_emac_lat_t stack;	/*!< lwIP input to its return (IP, TCP and application) */
+	u32_t hz;				/*!< Timestamp ticks per second */
+} lpc_emac_lat_stats_t;
+
+/**
+ * @brief	Read the received packets from the EMAC interface
  * @param	netif	: lwip network interface structure pointer
  * @return	Nothing
+ * @note	All frames waiting in the RX ring are passed to lwIP. With NO_SYS=1
+ * the frames are only processed once a batch is complete (RX done status,
+ * see lpc_emac_set_rx_coalesce()) or the oldest frame has waited for the
+ * coalescing time, so this can be called from the main loop at any rate.
  */
 void lpc_enetif_input(struct netif *netif);
 
@@ -71,7 +119,8 @@ s32_t lpc_rx_queue(struct netif *netif);
  * @brief	Polls if an available TX descriptor is ready
  * @param	netif	: lwip network interface structure pointer
  * @return	0 if no descriptors are read, or >0
- * @note	Can be used to determine if the low level transmit function will block
+ * @note	Can be used to determine if the low level transmit function will
+ * queue a frame in the TX software queue instead of sending it
  */
 s32_t lpc_tx_ready(struct netif *netif);
 
@@ -79,6 +128,8 @@ s32_t lpc_tx_ready(struct netif *netif);
  * @brief	Call for freeing TX buffers that are complete
  * @param	netif	: lwip network interface structure pointer
  * @return	Nothing
+ * @note	Also sends the frames waiting in the TX software queue. With
+ * NO_SYS=1 it must be called from the main loop.
  */
 void lpc_tx_reclaim(struct netif *netif);
 
@@ -92,6 +143,66 @@ void lpc_tx_reclaim(struct netif *netif);
  */
 err_t lpc_enetif_init(struct netif *netif);
 
+/**
+ * @brief	Set the number of RX and TX descriptors
+ * @param	rx_descs	: Number of RX descriptors, 3 to LPC_MAX_BUFF_RXDESCS
+ * @param	tx_descs	: Number of TX descriptors, 2 to LPC_MAX_BUFF_TXDESCS
+ * @return	ERR_OK, or ERR_VAL if a size is out of range or the interface is
+ * already initialized
+ * @note	Must be called before lpc_enetif_init(). The defaults are
+ * LPC_NUM_BUFF_RXDESCS and LPC_NUM_BUFF_TXDESCS.
+ */
+err_t lpc_emac_set_rings(u32_t rx_descs, u32_t tx_descs);
+
+/**
+ * @brief	Set up the RX interrupt moderation
+ * @param	frames	: Number of received frames per RX done event (1 = every frame)
+ * @param	time_ms	: Maximum time a frame of an incomplete batch waits, in ms
+ * @return	Nothing
+ * @note	The RX done interrupt is only requested on every frames'th RX
+ * descriptor. frames is limited to half of the RX ring, and time_ms is at
+ * least 1 when frames is more than 1. Takes effect as descriptors are
+ * requeued.
+ */
+void lpc_emac_set_rx_coalesce(u32_t frames, u32_t time_ms);
+
+/**
+ * @brief	Get the TX statistics
+ * @param	stats	: Pointer to the statistics to fill
+ * @return	Nothing
+ * @note	A frame is bounced when a payload is outside the memory the EMAC
+ * DMA can access (internal flash and SRAM), or in the NOR flash
+ */
+void lpc_emac_get_tx_stats(lpc_emac_tx_stats_t *stats);
+
+/**
+ * @brief	Get the descriptor ring high-water marks
+ * @param	stats	: Pointer to the statistics to fill
+ * @return	Nothing
+ */
+void lpc_emac_get_ring_stats(lpc_emac_ring_stats_t *stats);
+
+/**
+ * @brief	Get the RX latency statistics
+ * @param	stats	: Pointer to the statistics to fill
+ * @return	Nothing
+ * @note	All zero when LPC_EMAC_LAT_EN is 0
+ */
+void lpc_emac_get_lat_stats(lpc_emac_lat_stats_t *stats);
+
+/**
+ * @brief	Clear the TX, ring and latency statistics of the driver
+ * @return	Nothing
+ */
+void lpc_emac_clear_stats(void);
+
+/**
+ * @brief	Timestamp the TCP input of the frame being received
+ * @return	ERR_OK
+ * @note	Called by lwIP through LWIP_HOOK_TCP_INPACKET_PCB (lwipopts.h)
+ */
+err_t lpc_emac_lat_tcp(void);
+
 /**
  * @brief	Set up the MAC interface duplex
  * @param	full_duplex	: 0 = half duplex, 1 = full duplex
@@ -53,11 +53,45 @@ extern "C"
    Only applies if PHY_USE_AUTONEG = 0 */
 #define PHY_USE_100MBS 1
 
-/* Defines the number of descriptors used for RX */
-#define LPC_NUM_BUFF_RXDESCS 4
+/* Maximum number of RX and TX descriptors. The descriptor rings are
+   allocated at this size in the peripheral SRAM (20 bytes per RX and 16
+   bytes per TX descriptor); lpc_emac_set_rings() selects the size in use. */
+#define LPC_MAX_BUFF_RXDESCS 32
+#define LPC_MAX_BUFF_TXDESCS 32
 
-/* Defines the number of descriptors used for TX */
-#define LPC_NUM_BUFF_TXDESCS 4
+/* Defines the default number of descriptors used for RX */
+#define LPC_NUM_BUFF_RXDESCS 16
+
+/* Defines the default number of descriptors used for TX */
+#define LPC_NUM_BUFF_TXDESCS 16
+
+/* Number of frames the TX software queue holds while all TX descriptors
+   are in use. When it is full, the frame is dropped and ERR_WOULDBLOCK is
+   returned to lwIP. */
+#define LPC_TX_QUEUE_LEN 16
+
+/* Default RX interrupt moderation (see lpc_emac_set_rx_coalesce()): an RX
+   done event is raised after every LPC_RX_COAL_FRAMES received frames, and
+   frames of an incomplete batch are processed after LPC_RX_COAL_TIME ms. */
+#define LPC_RX_COAL_FRAMES 8
+#define LPC_RX_COAL_TIME 1
+
+/* Copy TX frames with a payload outside the DMA accessible memory (internal
+   flash and SRAM) or in the NOR flash (which may be reprogrammed while the
+   frame is queued) to a PBUF_RAM bounce buffer. The heap and the pbuf pool are
+   DMA accessible (see lwipopts.h and cc.h), so only PBUF_ROM/PBUF_REF payloads
+   are copied; see lpc_emac_get_tx_stats(). */
+#define LPC_TX_PBUF_BOUNCE_EN 1
+
+/* RX latency statistics (see lpc_emac_get_lat_stats()). The timestamps come
+   from the DWT cycle counter of the Cortex-M3, which runs freely; Timer0
+   (getTimer0_counter()) is restarted by the DHT11, HC-SR04 and bluetooth
+   drivers. */
+#define LPC_EMAC_LAT_EN 1
+#define LPC_EMAC_TIMESTAMP_INIT()	do { CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; \
+									 DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; } while (0)
+#define LPC_EMAC_TIMESTAMP()		(DWT->CYCCNT)
+#define LPC_EMAC_TIMESTAMP_HZ		SystemCoreClock
 
 /* Disable slow speed memory buffering */
 #define LPC_CHECK_SLOWMEM 0
@@ -36,6 +36,8 @@
 #include "lwipopts_test.h"
 #else /* LWIP_OPTTEST_FILE */
 
+#include "gfx/sdram_HY57V281620_X2.h"
+
 #define LWIP_IPV4                  1
 #define LWIP_IPV6                  0
 
@@ -118,7 +120,16 @@
 
 /* MEM_SIZE: the size of the heap memory. If the application will send
 a lot of data that needs to be copied, this should be set high. */
-#define MEM_SIZE               10240
+#define MEM_SIZE               (256 * 1024)
+
+/* LWIP_RAM_HEAP_POINTER: the heap holds the PBUF_RAM pbufs (received frames,
+   TCP segment data, bounce buffers). It is placed in the SDRAM, which the EMAC
+   DMA can access, so that these frames are sent without a bounce copy (see
+   lpc_packet_addr_notsafe()). SDRAM_BASE_ADDR + 9 MB, after the NAND FTL
+   tables (FSNAND_MAP_ADDR, the overlap is checked in lpc17xx_40xx_emac.c).
+   SDRAMInit() must be called before lwip_init(). */
+#define LWIP_RAM_HEAP_ADDR      (SDRAM_BASE_ADDR + 0x00900000)
+#define LWIP_RAM_HEAP_POINTER   ((void *) LWIP_RAM_HEAP_ADDR)
 
 /* MEMP_NUM_PBUF: the number of memp struct pbufs. If the application
    sends a lot of data out of ROM (or other static memory), this
@@ -157,8 +168,10 @@ a lot of data that needs to be copied, this should be set high. */
 
 
 /* ---------- Pbuf options ---------- */
-/* PBUF_POOL_SIZE: the number of buffers in the pbuf pool. */
-#define PBUF_POOL_SIZE          120
+/* PBUF_POOL_SIZE: the number of buffers in the pbuf pool. The pool is in
+   the 32 kB peripheral SRAM (see cc.h), together with the EMAC descriptors:
+   96 * (16 + PBUF_POOL_BUFSIZE) = 26 kB. */
+#define PBUF_POOL_SIZE          96
 
 /* PBUF_POOL_BUFSIZE: the size of each pbuf in the pbuf pool. */
 #define PBUF_POOL_BUFSIZE       256
@@ -210,6 +223,11 @@ a lot of data that needs to be copied, this should be set high. */
 /* Maximum number of retransmissions of SYN segments. */
 #define TCP_SYNMAXRTX           4
 
+/* Checksum the data copied by tcp_write() while it is copied
+   (LWIP_CHKSUM_COPY, see cc.h), instead of in a second pass over the
+   segment in tcp_output(). */
+#define LWIP_CHECKSUM_ON_COPY   1
+
 
 /* ---------- ARP options ---------- */
 #define LWIP_ARP                1
@@ -262,8 +280,11 @@ a lot of data that needs to be copied, this should be set high. */
 
 /* ---------- Statistics options ---------- */
 
-#define LWIP_STATS              0
+/* The statistics are shown by the CLI commands "net stats" and "net lat" */
+#define LWIP_STATS              1
 #define LWIP_STATS_DISPLAY      0
+/* 32 bit counters, 16 bit ones wrap within seconds at 100 Mbit */
+#define LWIP_STATS_LARGE        1
 
 #if LWIP_STATS
 #define LINK_STATS              1
@@ -277,11 +298,30 @@ a lot of data that needs to be copied, this should be set high. */
 #define MEMP_STATS              1
 #define PBUF_STATS              1
 #define SYS_STATS               1
+/* For the TCP retransmitted segments counter */
+#define MIB2_STATS              1
 #endif /* LWIP_STATS */
 
+/* ---------- Hooks ---------- */
+/* TCP input timestamp of the EMAC driver RX latency statistics */
+#define LWIP_HOOK_FILENAME              "arch/lpc17xx_40xx_emac.h"
+#define LWIP_HOOK_TCP_INPACKET_PCB(pcb, hdr, optlen, opt1len, opt2, p) lpc_emac_lat_tcp()
+
 /* ---------- NETBIOS options ---------- */
 #define LWIP_NETBIOS_RESPOND_NAME_QUERY 1
 
+/* ---------- HTTPD options ---------- */
+/* Web pages of the NOR flash asset bundle (data_Manager/nor_assets.c) are
+   looked up before the compiled-in fsdata.c files. */
+#define LWIP_HTTPD_CUSTOM_FILES         1
+
+/* File data is copied into the TCP send buffer (SDRAM heap) instead of being
+   referenced by PBUF_ROM pbufs. Queued and retransmitted segments then never
+   point into the NOR flash, which may be reprogrammed, or into the internal
+   flash, which the EMAC DMA can not reach (one copy instead of a bounce copy
+   per transmission). */
+#define HTTP_IS_DATA_VOLATILE(hs)       TCP_WRITE_FLAG_COPY
+
 /* ---------- PPP options ---------- */
 
 #define PPP_SUPPORT             1      /* Set > 0 for PPP */
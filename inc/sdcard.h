@@ -18,6 +18,28 @@ The divider must be a even value between 2 and 254!
 In SPI mode, max clock speed is 20MHz for MMC and 25MHz for SD */
 #define SPI_CLOCKRATE_LOW   400000
 #define SPI_CLOCKRATE_HIGH  25000000
+#define SPI_CLOCKRATE_MIN   1000000     /* Lowest data transfer clock of the CRC error step-down */
+
+/* Check the CRC16 of received data blocks and switch on CRC checking in the
+card (CRC_ON_OFF), so that corrupted commands and written blocks are rejected
+(1=enabled, 0=disabled). SD_ReadSector() and SD_WriteSector() retry a transfer
+that failed with a CRC error up to SD_CRC_RETRY times. From the second retry
+on, the SPI clock is halved before each retry (down to SPI_CLOCKRATE_MIN) and
+stays lowered, see SD_GetClockRate(). */
+#define SD_USE_CRC          1
+#define SD_CRC_RETRY        3
+
+/* Use the GPDMA for the data phase of block transfers (1=enabled, 0=disabled).
+The blocking functions wait for the DMA interrupt, so they must not be called
+with interrupts disabled. The channel interrupts are installed with
+wsBoard_DMA_Init(). */
+#define SD_USE_DMA          1
+#define SD_DMA_CH_RX        2   /* GPDMA channel for SSP receive (must have a lower number than transmit) */
+#define SD_DMA_CH_TX        3   /* GPDMA channel for SSP transmit */
+
+#if SD_USE_DMA && (SD_DMA_CH_RX >= SD_DMA_CH_TX)
+#error "SD_DMA_CH_RX must have a higher priority (lower number) than SD_DMA_CH_TX"
+#endif
 
 
 /* type defintion */
@@ -25,6 +47,10 @@ typedef unsigned char    SD_BOOL;
 #define SD_TRUE     1
 #define SD_FALSE    0
 
+/* Completion callback of the asynchronous functions, called from the DMA
+interrupt with ok = SD_FALSE if the transfer failed */
+typedef void (*SD_Callback)(SD_BOOL ok);
+
 #ifndef NULL
  #ifdef __cplusplus              // EC++
   #define NULL          0
@@ -61,6 +87,17 @@ SD_BOOL     SD_Init (void);
 SD_BOOL     SD_ReadSector (uint32_t sect, uint8_t *buf, uint32_t cnt);
 SD_BOOL     SD_WriteSector (uint32_t sect, const uint8_t *buf, uint32_t cnt);
 SD_BOOL     SD_ReadConfiguration (void);
+SD_BOOL     SD_WriteStreamOpen (uint32_t sect, uint32_t pre_erase);
+SD_BOOL     SD_WriteStreamBlock (const uint8_t *buf);
+SD_BOOL     SD_WriteStreamReady (void);
+SD_BOOL     SD_WriteStreamClose (void);
+#if SD_USE_DMA
+SD_BOOL     SD_ReadSectorAsync (uint32_t sect, uint8_t *buf, SD_Callback cb);
+SD_BOOL     SD_WriteStreamBlockAsync (const uint8_t *buf, SD_Callback cb);
+#endif
+SD_BOOL     SD_Busy (void);
+uint32_t    SD_GetClockRate (void);
+uint32_t    SD_GetCrcErrors (void);
 void        disk_timerproc (void);
 
 #endif /* INC_SDCARD_H_ */
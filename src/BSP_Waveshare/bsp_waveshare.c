@@ -97,6 +97,10 @@ STATIC const PINMUX_GRP_T eth_pinmuxing[] = {
 
 };
 
+/* GPDMA channel interrupt handlers (wsBoard_DMA_Init()) */
+static wsBoard_DMA_Handler_t dmaHandler[GPDMA_NUMBER_CHANNELS];
+static bool dmaInitialized;
+
 /* Sets up system pin muxing */
 void wsBoard_Eth_SetupMuxing(void)
 {
@@ -550,6 +554,57 @@ void wsBoard_SSP_Init(LPC_SSP_T *pSSP)
 	}
 }
 
+/* Initialize GPDMA controller and reserve the channels of the board drivers */
+static void wsBoard_DMA_Setup(void)
+{
+	uint8_t ch;
+
+	if (!dmaInitialized) {
+		Chip_GPDMA_Init(LPC_GPDMA);
+
+		/* The allocator hands out the lowest free channel: claim 0 to
+		   WSBOARD_DMA_CH_RESERVED-1, so that it never returns them */
+		for (ch = 0; ch < WSBOARD_DMA_CH_RESERVED; ch++) {
+			Chip_GPDMA_GetFreeChannel(LPC_GPDMA, 0);
+		}
+
+		NVIC_EnableIRQ(DMA_IRQn);
+		dmaInitialized = true;
+	}
+}
+
+/* Initialize GPDMA controller and install a channel interrupt handler */
+void wsBoard_DMA_Init(uint8_t ch, wsBoard_DMA_Handler_t handler)
+{
+	wsBoard_DMA_Setup();
+	dmaHandler[ch] = handler;
+}
+
+/* GPDMA interrupt of a channel without a handler (override in the application) */
+__attribute__ ((weak)) void wsBoard_DMA_IRQHook(uint8_t ch)
+{
+	LPC_GPDMA->INTTCCLEAR = (1 << ch);
+	LPC_GPDMA->INTERRCLR = (1 << ch);
+}
+
+/* Dispatch GPDMA interrupts to the channel handlers */
+void DMA_IRQHandler(void)
+{
+	uint32_t stat = LPC_GPDMA->INTSTAT;
+	uint8_t ch;
+
+	for (ch = 0; ch < GPDMA_NUMBER_CHANNELS; ch++) {
+		if (stat & (1 << ch)) {
+			if (dmaHandler[ch]) {
+				dmaHandler[ch](ch);
+			}
+			else {
+				wsBoard_DMA_IRQHook(ch);
+			}
+		}
+	}
+}
+
 /* Set up and initialize all required blocks and functions related to the
    board hardware */
 void wsBoard_Init(void)
@@ -569,6 +624,10 @@ void wsBoard_Init(void)
 	wsBoard_Joystick_Init();
 	wsBoard_Buttons_Init();
 	SDRAMInit();
+
+	/* Reserve the GPDMA channels of the board drivers before the
+	   application allocates any */
+	wsBoard_DMA_Setup();
 	//open1788_LCDinit();
 	//open1788_LCD_Clear(Black);
 }
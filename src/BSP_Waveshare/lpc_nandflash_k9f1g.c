@@ -49,6 +49,15 @@ static const lpc_nandflash_size_t nandSize = {
 	K9F1G_PAGE_SIZE,  K9F1G_SPARE_SIZE,  K9F1G_PAGES_PER_BLOCK,  K9F1G_BLOCK_COUNT
 };
 
+#if defined(K9F1G_DMA_CH) && (K9F1G_DMA_CH >= WSBOARD_DMA_CH_RESERVED)
+#error "K9F1G_DMA_CH must be a reserved GPDMA channel (see WSBOARD_DMA_CH_RESERVED)"
+#endif
+
+#if defined(K9F1G_DMA_CH)
+/* A lpc_nandflash_read_data_start() transfer has been started */
+static bool dmaStarted;
+#endif
+
 /*****************************************************************************
  * Public types/enumerations/variables
  ****************************************************************************/
@@ -57,12 +66,33 @@ static const lpc_nandflash_size_t nandSize = {
  * Private functions
  ****************************************************************************/
 
+/* Wait for the end of a page read (tR), returns false on timeout */
+static bool waitReadReady(void)
+{
+	/* A status read takes far more than 1 ns */
+	uint32_t tout = NANDFLASH_READ_TIME;
+
+	while (!(lpc_nandflash_read_status() & NANDFLASH_STATUS_DEV_READY)) {
+		if (!--tout) {
+			return false;
+		}
+	}
+	/* Back from status to data output */
+	wsBoard_NANDFLash_WriteCmd(K9F1G_READ_1);
+	return true;
+}
+
 /*****************************************************************************
  * Public functions
  ****************************************************************************/
 /* Initialize flash */
 void lpc_nandflash_init(void)
-{}
+{
+#if defined(K9F1G_DMA_CH)
+	/* Polled transfers, no channel interrupt handler */
+	wsBoard_DMA_Init(K9F1G_DMA_CH, NULL);
+#endif
+}
 
 /* De-initialize flash */
 void lpc_nandflash_DeInit(void)
@@ -161,6 +191,36 @@ uint32_t lpc_nandflash_write_page(uint32_t block, uint32_t page, uint8_t *data,
 	return i;
 }
 
+/* Write buffer to flash from an offset in the page */
+uint32_t lpc_nandflash_write_ofs(uint32_t block, uint32_t page, uint32_t ofs, uint8_t *data, uint32_t size)
+{
+	uint32_t i = 0;
+	uint32_t row = COLUMN_ADDR(block, page);
+
+#if defined(BOARD_NAND_LOCKEDCS)
+	wsBoard_NANDFLash_CSLatch(true);
+#endif
+	wsBoard_NANDFLash_WriteCmd(K9F1G_PAGE_PROGRAM_1);
+
+	/* Write address*/
+	wsBoard_NANDFLash_WriteAddr(ofs & 0xFF);
+	wsBoard_NANDFLash_WriteAddr((ofs >> 8) & 0xFF);
+	wsBoard_NANDFLash_WriteAddr(row & 0xFF);
+	wsBoard_NANDFLash_WriteAddr((row >> 8) & 0xFF);
+
+	/*Write data */
+	for (i = 0; i < size; i++) {
+		wsBoard_NANDFLash_WriteByte(*data);
+		data++;
+	}
+
+	wsBoard_NANDFLash_WriteCmd(K9F1G_PAGE_PROGRAM_2);
+#if defined(BOARD_NAND_LOCKEDCS)
+	wsBoard_NANDFLash_CSLatch(false);
+#endif
+	return i;
+}
+
 /* Start reading data from flash */
 void lpc_nandflash_read_start(uint32_t block, uint32_t page, uint32_t ofs)
 {
@@ -186,12 +246,18 @@ void lpc_nandflash_read_start(uint32_t block, uint32_t page, uint32_t ofs)
 /* Read data from flash */
 void lpc_nandflash_read_data(uint8_t *data, uint32_t size)
 {
-	uint32_t i = 0;
-
 #if defined(BOARD_NAND_LOCKEDCS)
 	wsBoard_NANDFLash_CSLatch(true);
 #endif
-	for (i = 0; i < size; i++) {
+	for (; size && ((uint32_t) data & 3); size--) {
+		*data = wsBoard_NANDFLash_ReadByte();
+		data++;
+	}
+	for (; size >= 4; size -= 4) {
+		*(uint32_t *) data = wsBoard_NANDFLash_ReadWord();
+		data += 4;
+	}
+	for (; size; size--) {
 		*data = wsBoard_NANDFLash_ReadByte();
 		data++;
 	}
@@ -200,6 +266,73 @@ void lpc_nandflash_read_data(uint8_t *data, uint32_t size)
 #endif
 }
 
+/* Start reading data from flash with the GPDMA */
+void lpc_nandflash_read_data_start(uint8_t *data, uint32_t size)
+{
+#if defined(K9F1G_DMA_CH)
+	if (!(((uint32_t) data | size) & 3) && size / 4 <= 0xFFF) {
+#if defined(BOARD_NAND_LOCKEDCS)
+		wsBoard_NANDFLash_CSLatch(true);
+#endif
+		LPC_GPDMA->INTTCCLEAR = (1 << K9F1G_DMA_CH);
+		LPC_GPDMA->INTERRCLR = (1 << K9F1G_DMA_CH);
+
+		/* Word reads of the data window (the EMC splits them into byte
+		   accesses), bursts of 4 words into the buffer */
+		LPC_GPDMA->CH[K9F1G_DMA_CH].SRCADDR = EMC_ADDRESS_CS1;
+		LPC_GPDMA->CH[K9F1G_DMA_CH].DESTADDR = (uint32_t) data;
+		LPC_GPDMA->CH[K9F1G_DMA_CH].LLI = 0;
+		LPC_GPDMA->CH[K9F1G_DMA_CH].CONTROL = GPDMA_DMACCxControl_TransferSize(size / 4)
+											  | GPDMA_DMACCxControl_SBSize(GPDMA_BSIZE_4)
+											  | GPDMA_DMACCxControl_DBSize(GPDMA_BSIZE_4)
+											  | GPDMA_DMACCxControl_SWidth(GPDMA_WIDTH_WORD)
+											  | GPDMA_DMACCxControl_DWidth(GPDMA_WIDTH_WORD)
+											  | GPDMA_DMACCxControl_SI
+											  | GPDMA_DMACCxControl_DI;
+		LPC_GPDMA->CH[K9F1G_DMA_CH].CONFIG = GPDMA_DMACCxConfig_E
+											 | GPDMA_DMACCxConfig_TransferType(GPDMA_TRANSFERTYPE_M2M_CONTROLLER_DMA);
+		dmaStarted = true;
+		return;
+	}
+#endif
+	lpc_nandflash_read_data(data, size);
+}
+
+/* Wait for the end of lpc_nandflash_read_data_start() */
+void lpc_nandflash_read_data_wait(void)
+{
+#if defined(K9F1G_DMA_CH)
+	if (dmaStarted) {
+		while (LPC_GPDMA->ENBLDCHNS & (1 << K9F1G_DMA_CH)) {}
+		dmaStarted = false;
+#if defined(BOARD_NAND_LOCKEDCS)
+		wsBoard_NANDFLash_CSLatch(false);
+#endif
+	}
+#endif
+}
+
+/* Read the main area of consecutive pages */
+uint32_t lpc_nandflash_read_pages(uint32_t block, uint32_t page, uint32_t n, uint8_t *data)
+{
+	uint32_t i;
+
+	/* No cache read on the K9F1G: the next page is requested as soon as
+	   the data register has been streamed out */
+	for (i = 0; i < n; i++) {
+		lpc_nandflash_read_start(block + page / K9F1G_PAGES_PER_BLOCK, page % K9F1G_PAGES_PER_BLOCK, 0);
+		if (!waitReadReady()) {
+			break;
+		}
+		lpc_nandflash_read_data_start(data, K9F1G_PAGE_SIZE);
+		lpc_nandflash_read_data_wait();
+		data += K9F1G_PAGE_SIZE;
+		page++;
+	}
+
+	return i;
+}
+
 /**
  * @}
  */
@@ -49,6 +49,8 @@
 #define BLOCK_SIZE                   (64 << 10)		/* 32K words */
 /* Toggle bit */
 #define TOGGLE_BIT                   (1 << 6)		/* DQ6 */
+/* Maximum number of toggle bit polls of a word program or sector erase */
+#define PROG_TIMEOUT                 1000000
 
 /*****************************************************************************
  * Public types/enumerations/variables
@@ -58,6 +60,19 @@
  * Private functions
  ****************************************************************************/
 
+/* Wait for the end of a program or erase operation */
+static bool waitReady(UNS_32 addr)
+{
+	UNS_32 tout = PROG_TIMEOUT;
+
+	while (!lpc_norflash_toggle_bit_check(addr)) {
+		if (!--tout) {
+			return false;
+		}
+	}
+	return true;
+}
+
 /*****************************************************************************
  * Public functions
  ****************************************************************************/
@@ -150,6 +165,65 @@ UNS_32 lpc_norflash_write_buffer(UNS_32 addr, UNS_16 *data, UNS_32 size)
 	return i;
 }
 
+/* Program a buffer, erasing and writing only what differs */
+bool lpc_norflash_program(UNS_32 addr, const UNS_16 *data, UNS_32 size, lpc_norflash_prog_stat_t *stat)
+{
+	const volatile UNS_16 *flash;
+	UNS_32 sector, len, i;
+	bool erase;
+
+	while (size) {
+		/* Part of the buffer in this sector */
+		sector = addr & ~(SECTOR_SIZE - 1);
+		len = sector + SECTOR_SIZE - addr;
+		if (len > size) {
+			len = size;
+		}
+		flash = (const volatile UNS_16 *) (EMC_ADDRESS_CS0 + addr);
+
+		/* Programming can only clear bits */
+		erase = false;
+		for (i = 0; i < len / 2; i++) {
+			if ((flash[i] & data[i]) != data[i]) {
+				erase = true;
+				break;
+			}
+		}
+
+		if (erase) {
+			/* The erase command takes the word address */
+			lpc_norflash_erase_sector(sector >> 1);
+			if (!waitReady(sector)) {
+				return false;
+			}
+			if (stat) {
+				stat->sectors_erased++;
+			}
+		}
+
+		for (i = 0; i < len / 2; i++) {
+			if (flash[i] == data[i]) {
+				if (stat) {
+					stat->words_skipped++;
+				}
+				continue;
+			}
+			lpc_norflash_write_word(addr + i * 2, data[i]);
+			if (!waitReady(addr + i * 2) || flash[i] != data[i]) {
+				return false;
+			}
+			if (stat) {
+				stat->words_written++;
+			}
+		}
+
+		addr += len;
+		data += len / 2;
+		size -= len;
+	}
+	return true;
+}
+
 /* Read 16-bit data from flash */
 UNS_16 lpc_norflash_read_word(UNS_32 addr)
 {
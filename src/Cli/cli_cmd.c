@@ -12,11 +12,17 @@
 #include <monitor.h>
 #include <Cli/vt100.h>
 #include <data_Manager/at45d.h>
+#include <data_Manager/nor_assets.h>
+#include <data_Manager/crc.h>
 #include <hardware_delay.h>
 #include <BSP_Waveshare/bsp_waveshare.h>
 #include <FatFs/diskio.h>
 #include <FatFs/ff.h>
+#include <FatFs/ff_clmt.h>
 #include <FatFs/rtc.h>
+#include <lwip/stats.h>
+#include <lwip/mem.h>
+#include <arch/lpc17xx_40xx_emac.h>
 
 Bool new_char_arrived;	//  variable for Cli ISR
 char new_cli_data;		// Char received thru UART3
@@ -479,6 +485,267 @@ static const char* cli_cmd_sd_read_sector_fn(u8_t argc, char* argv[]) {
 	return "read sector successful";
 }
 
+/*
+ * RANDOM ACCESS BENCHMARK ON DRIVE 0: NORMAL SEEK VERSUS FAST SEEK (CLMT)
+ */
+static const char* cli_cmd_sd_seek_fn(u8_t argc, char* argv[]) {
+	FRESULT res;
+	UINT  n = 1000, i, br, t_open, t_seek;
+	DWORD seed, sects;
+	BYTE  mode;
+
+	if (argc > 1){
+		if (!cli_util_argv_to_u16(1, 1, 65535)) return "Wrong number of seeks...";
+		n = cli_argv_val.u16;
+	}
+	res = f_mount(0, &FatFs);
+	if (res) { put_rc(res); return "Mount fail...!!!"; }
+
+	for (mode = 0; mode < 2; mode++) {
+		t_open = Timer;
+		if (mode) res = clmt_open(&File[0], argv[0]);
+		else      res = f_open(&File[0], argv[0], FA_READ | FA_OPEN_EXISTING);
+		if (res) { put_rc(res); return "File open fail...!!!"; }
+		t_open = Timer - t_open;
+
+		sects = File[0].fsize / 512;
+		if (!sects) { f_close(&File[0]); return "File too small..."; }
+
+		seed = 1;		/* Same offsets in both modes */
+		t_seek = Timer;
+		for (i = 0; i < n; i++) {
+			seed = seed * 1103515245 + 12345;
+			res = f_lseek(&File[0], ((seed >> 8) % sects) * 512);
+			if (!res) res = f_read(&File[0], Buff, 512, &br);
+			if (res) break;
+		}
+		t_seek = Timer - t_seek;
+		xprintf("%s seek%s: open %u ms, %u seek+read in %u ms\n", mode ? "Fast" : "Normal",
+				(mode && !File[0].cltbl) ? " (no CLMT)" : "", t_open, i, t_seek);
+
+		if (mode) clmt_close(&File[0]);
+		else      f_close(&File[0]);
+		if (res) { put_rc(res); return "Read fail...!!!"; }
+	}
+	return "Seek benchmark done...";
+}
+
+
+/*
+ * LIST THE ASSETS OF THE NOR FLASH BUNDLE
+ */
+static const char* cli_cmd_asset_list_fn(u8_t argc, char* argv[]) {
+	const nor_asset_t *asset;
+	u16_t i;
+
+	lpc_norflash_init();
+	if (!nor_assets_init()) return "No valid asset bundle...";
+
+	for (i = 0; i < nor_assets_count(); i++) {
+		asset = nor_assets_entry(i);
+		xprintf("%08lX %8lu %u %s\n", (DWORD)nor_assets_data(asset), (DWORD)asset->size,
+				asset->type, nor_assets_name(asset));
+	}
+	xprintf("%u assets\n", nor_assets_count());
+	return "Asset list done...";
+}
+
+/*
+ * CHECK THE CRC OF THE NOR FLASH BUNDLE AND OF EACH ASSET
+ */
+static const char* cli_cmd_asset_verify_fn(u8_t argc, char* argv[]) {
+	lpc_norflash_init();
+	if (!nor_assets_init()) return "No valid asset bundle...";
+	return nor_assets_verify() ? "Asset bundle OK..." : "Asset bundle CRC error...!!!";
+}
+
+
+/*
+ * UPDATE THE NOR FLASH BUNDLE FROM A FILE ON DRIVE 0 (RESUMES AN INTERRUPTED UPDATE)
+ */
+static const char* cli_cmd_asset_update_fn(u8_t argc, char* argv[]) {
+	FRESULT res;
+	UINT br, t;
+	DWORD size, ofs, crc = 0xFFFFFFFF;
+	nor_assets_update_stat_t stat;
+
+	res = f_mount(0, &FatFs);
+	if (res) { put_rc(res); return "Mount fail...!!!"; }
+	res = f_open(&File[0], argv[0], FA_READ | FA_OPEN_EXISTING);
+	if (res) { put_rc(res); return "File open fail...!!!"; }
+	size = File[0].fsize;
+
+	/* CRC of the bundle identifies it when an update is resumed */
+	do {
+		res = f_read(&File[0], Buff, sizeof(Buff), &br);
+		crc = crc32_calc(crc, Buff, br);
+	} while (!res && br == sizeof(Buff));
+	if (res) { f_close(&File[0]); put_rc(res); return "Read fail...!!!"; }
+	crc ^= 0xFFFFFFFF;
+
+	t = Timer;
+	lpc_norflash_init();
+	if (!nor_assets_update_begin(size, crc)) { f_close(&File[0]); return "Update start fail...!!!"; }
+	ofs = nor_assets_update_offset();
+	if (ofs) xprintf("Resuming at %lu of %lu bytes\n", ofs, size);
+
+	res = f_lseek(&File[0], ofs);
+	while (!res && ofs < size) {
+		res = f_read(&File[0], Buff, sizeof(Buff), &br);
+		if (res || !br) break;
+		if (!nor_assets_update_write(ofs, Buff, br)) { f_close(&File[0]); return "NOR flash write fail...!!!"; }
+		ofs += br;
+	}
+	f_close(&File[0]);
+	if (res) { put_rc(res); return "Read fail...!!!"; }
+
+	if (!nor_assets_update_end()) return "Bundle verify fail...!!!";
+	nor_assets_update_stat(&stat);
+	xprintf("%lu bytes in %u ms: %lu sectors resumed, %lu erased, %lu words written, %lu skipped\n",
+			size, Timer - t, stat.sectors_resumed, stat.sectors_erased, stat.words_written, stat.words_skipped);
+	return "Asset update done...";
+}
+
+/*
+ * ONE LINE OF LWIP PROTOCOL STATISTICS
+ */
+static void net_stats_proto(const char* name, const struct stats_proto* proto) {
+	xprintf("%-5s %10lu %10lu %8lu %8lu %8lu %8lu\n", name, (DWORD)proto->xmit, (DWORD)proto->recv,
+			(DWORD)proto->drop, (DWORD)proto->memerr, (DWORD)proto->chkerr, (DWORD)proto->err);
+}
+
+/*
+ * ONE LINE OF LWIP HEAP OR POOL STATISTICS
+ */
+static void net_stats_mem(const char* name, const struct stats_mem* mem) {
+	xprintf("%-16s %8lu %8lu %8lu %8lu\n", name, (DWORD)mem->avail, (DWORD)mem->used,
+			(DWORD)mem->max, (DWORD)mem->err);
+}
+
+#if NO_SYS
+/*
+ * LARGEST BLOCK THAT CAN BE ALLOCATED FROM THE LWIP HEAP
+ * Trial allocations on the live heap, so NO_SYS=1 only: the CLI then runs in
+ * the same loop as lwIP and nothing else allocates while it probes. With an
+ * OS, an allocation of another thread could fail because of a trial block,
+ * and its error count would be lost when the statistics are restored.
+ */
+static mem_size_t net_heap_largest(void) {
+	mem_size_t lo = 0, hi = MEM_SIZE, mid;
+	mem_size_t max = lwip_stats.mem.max;
+	STAT_COUNTER err = lwip_stats.mem.err;
+	void* p;
+
+	/* Binary search with trial allocations (the heap is first fit) */
+	while (lo < hi) {
+		mid = lo + (hi - lo + 1) / 2;
+		p = mem_malloc(mid);
+		if (p) { mem_free(p); lo = mid; }
+		else hi = mid - 1;
+	}
+	/* The trial allocations must not show in the statistics */
+	lwip_stats.mem.max = max;
+	lwip_stats.mem.err = err;
+	return lo;
+}
+#endif
+
+/*
+ * SHOW LWIP, HEAP AND EMAC DRIVER STATISTICS
+ */
+static const char* cli_cmd_net_stats_fn(u8_t argc, char* argv[]) {
+	static const char* const pool_names[] = {
+#define LWIP_MEMPOOL(name, num, size, desc) desc,
+#include <lwip/priv/memp_std.h>
+	};
+	lpc_emac_tx_stats_t tx;
+	lpc_emac_ring_stats_t ring;
+	mem_size_t avail;
+#if NO_SYS
+	mem_size_t largest;
+#endif
+	u16_t i;
+
+	if (lwip_stats.memp[0] == NULL) return "lwIP not initialized...";
+
+	xprintf("%-5s %10s %10s %8s %8s %8s %8s\n", "", "xmit", "recv", "drop", "memerr", "chkerr", "err");
+	net_stats_proto("link", &lwip_stats.link);
+	net_stats_proto("ip", &lwip_stats.ip);
+	net_stats_proto("udp", &lwip_stats.udp);
+	net_stats_proto("tcp", &lwip_stats.tcp);
+	xprintf("tcp retransmitted segments %lu\n\n", (DWORD)lwip_stats.mib2.tcpretranssegs);
+
+	xprintf("%-16s %8s %8s %8s %8s\n", "", "avail", "used", "max", "err");
+	net_stats_mem("HEAP", &lwip_stats.mem);
+	for (i = 0; i < MEMP_MAX; i++) net_stats_mem(pool_names[i], lwip_stats.memp[i]);
+
+	avail = lwip_stats.mem.avail - lwip_stats.mem.used;
+#if NO_SYS
+	largest = net_heap_largest();
+	xprintf("heap %lu bytes free, largest block %lu, fragmentation %lu%%\n\n", (DWORD)avail, (DWORD)largest,
+			avail ? 100 - (DWORD)((u64_t)largest * 100 / avail) : 0);
+#else
+	xprintf("heap %lu bytes free\n\n", (DWORD)avail);
+#endif
+
+	lpc_emac_get_tx_stats(&tx);
+	lpc_emac_get_ring_stats(&ring);
+	xprintf("emac tx %lu frames, %lu bounced (%lu bytes, %lu failed), %lu queued, %lu dropped\n",
+			tx.frames, tx.bounced, tx.bounceBytes, tx.bounceFail, tx.queued, tx.queueDrops);
+	xprintf("emac rx ring %lu: max %lu waiting, %lu per batch, %lu without buffer\n",
+			ring.rxDescs, ring.rxMax, ring.rxBatchMax, ring.rxNoBufMax);
+	xprintf("emac tx ring %lu: max %lu in use, %lu in queue\n", ring.txDescs, ring.txMax, ring.txqMax);
+	return "Network statistics done...";
+}
+
+/*
+ * ONE LINE OF RX LATENCY STATISTICS, IN MICROSECONDS
+ */
+static void net_lat_show(const char* name, const lpc_emac_lat_t* lat, DWORD mhz) {
+	xprintf("%-6s %10lu %10lu %10lu\n", name, lat->count,
+			lat->count ? (DWORD)(lat->sum / lat->count / mhz) : 0, lat->max / mhz);
+}
+
+/*
+ * SHOW THE RX LATENCY PER STAGE
+ */
+static const char* cli_cmd_net_lat_fn(u8_t argc, char* argv[]) {
+	lpc_emac_lat_stats_t lat;
+	DWORD mhz;
+
+	lpc_emac_get_lat_stats(&lat);
+	mhz = lat.hz / 1000000;
+	if (!mhz) return "Latency statistics disabled (LPC_EMAC_LAT_EN)...";
+
+	xprintf("%-6s %10s %10s %10s\n", "us", "frames", "avg", "max");
+	net_lat_show("wait", &lat.wait, mhz);	/* RX event to lwIP input */
+	net_lat_show("tcp", &lat.tcp, mhz);		/* lwIP input to TCP input */
+	net_lat_show("stack", &lat.stack, mhz);	/* lwIP input to its return */
+	return "Latency statistics done...";
+}
+
+/*
+ * CLEAR THE NETWORK STATISTICS (HIGH-WATER MARKS START AT THE CURRENT USE)
+ */
+static const char* cli_cmd_net_clear_fn(u8_t argc, char* argv[]) {
+	u16_t i;
+
+	if (lwip_stats.memp[0] == NULL) return "lwIP not initialized...";
+
+	memset(&lwip_stats.link, 0, sizeof(lwip_stats.link));
+	memset(&lwip_stats.ip, 0, sizeof(lwip_stats.ip));
+	memset(&lwip_stats.udp, 0, sizeof(lwip_stats.udp));
+	memset(&lwip_stats.tcp, 0, sizeof(lwip_stats.tcp));
+	lwip_stats.mib2.tcpretranssegs = 0;
+	lwip_stats.mem.max = lwip_stats.mem.used;
+	lwip_stats.mem.err = 0;
+	for (i = 0; i < MEMP_MAX; i++) {
+		lwip_stats.memp[i]->max = lwip_stats.memp[i]->used;
+		lwip_stats.memp[i]->err = 0;
+	}
+	lpc_emac_clear_stats();
+	return "Network statistics cleared...";
+}
 
 /*
  * READ ENTIRE PAGE FOR 264 BYTES from SPIFLASH AT45DB081D
@@ -654,11 +921,35 @@ CLI_GROUP_END()
 CLI_CMD_CREATE(cli_cmd_sd_init, "init", 1, 1, "<drive #>","Initialize SD drive")
 CLI_CMD_CREATE(cli_cmd_sd_dump_sector, "ds", 2, 2, "<drive #> <sector #>","Dump a sector data")
 CLI_CMD_CREATE(cli_cmd_sd_read_sector, "sr", 3, 3, "<drive #> <sector #> <bytes to read>","Read a sector data")
+CLI_CMD_CREATE(cli_cmd_sd_seek, "seek", 1, 2, "<file> [seeks]","Random 512 byte reads, normal seek versus fast seek")
 //IO commands grouped as sd
 CLI_GROUP_CREATE(cli_group_sd, "sd")
 	CLI_CMD_ADD(cli_cmd_sd_init, cli_cmd_sd_init_fn)
 	CLI_CMD_ADD(cli_cmd_sd_dump_sector, cli_cmd_sd_dump_sector_fn)
 	CLI_CMD_ADD(cli_cmd_sd_read_sector, cli_cmd_sd_read_sector_fn)
+	CLI_CMD_ADD(cli_cmd_sd_seek, cli_cmd_sd_seek_fn)
+CLI_GROUP_END()
+//----------------------------------
+// NOR FLASH ASSET BUNDLE
+CLI_CMD_CREATE(cli_cmd_asset_list, "ls", 0, 0, "","List the assets of the NOR flash bundle")
+CLI_CMD_CREATE(cli_cmd_asset_verify, "verify", 0, 0, "","Check the CRC of the NOR flash bundle")
+CLI_CMD_CREATE(cli_cmd_asset_update, "update", 1, 1, "<file>","Program the NOR flash bundle from a file (resumes an interrupted update)")
+//IO commands grouped as asset
+CLI_GROUP_CREATE(cli_group_asset, "asset")
+	CLI_CMD_ADD(cli_cmd_asset_list, cli_cmd_asset_list_fn)
+	CLI_CMD_ADD(cli_cmd_asset_verify, cli_cmd_asset_verify_fn)
+	CLI_CMD_ADD(cli_cmd_asset_update, cli_cmd_asset_update_fn)
+CLI_GROUP_END()
+//----------------------------------
+// LWIP AND EMAC DRIVER INSTRUMENTATION
+CLI_CMD_CREATE(cli_cmd_net_stats, "stats", 0, 0, "","Show lwIP, heap and EMAC ring statistics")
+CLI_CMD_CREATE(cli_cmd_net_lat, "lat", 0, 0, "","Show the RX latency per stage (event, lwIP input, TCP input)")
+CLI_CMD_CREATE(cli_cmd_net_clear, "clr", 0, 0, "","Clear the network statistics")
+//IO commands grouped as net
+CLI_GROUP_CREATE(cli_group_net, "net")
+	CLI_CMD_ADD(cli_cmd_net_stats, cli_cmd_net_stats_fn)
+	CLI_CMD_ADD(cli_cmd_net_lat, cli_cmd_net_lat_fn)
+	CLI_CMD_ADD(cli_cmd_net_clear, cli_cmd_net_clear_fn)
 CLI_GROUP_END()
 //----------------------------------
 
@@ -675,6 +966,8 @@ CLI_CMD_LIST_CREATE()
 	CLI_GROUP_ADD(cli_group_i2c)
 	CLI_GROUP_ADD(cli_group_spifi)
 	CLI_GROUP_ADD(cli_group_sd)
+	CLI_GROUP_ADD(cli_group_asset)
+	CLI_GROUP_ADD(cli_group_net)
 	CLI_CMD_ADD (cli_cmd_cmd_buffer, cli_cmd_command_buffer_fn)
 	CLI_CMD_ADD (cli_cmd_history, cli_cmd_hist_buffer_fn)
 	CLI_CMD_ADD (cli_cmd_cls, cli_cmd_clear_screen_fn)
@@ -698,4 +991,5 @@ void SysTick_Handler (void)
 	}
 
 	disk_timerproc();	/* Disk timer process */
+	ff_timerproc();		/* FatFs lock timeout */
 }
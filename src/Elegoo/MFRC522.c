@@ -17,6 +17,7 @@
 #include <hardware_delay.h>
 #include <string.h>
 #include <monitor.h>
+#include <data_Manager/crc.h>
 
 DEFINE_PIN(MFRC522_CS, 1, 21)
 DEFINE_PIN(MFRC522_RST_PWRDWN, 1, 31)
@@ -200,6 +201,8 @@ void PCD_ClearRegisterBitMask(uint8_t reg,///< The register to update. One of th
 
 /**
  * Use the CRC coprocessor in the MFRC522 to calculate a CRC_A.
+ * If MFRC522_SOFTWARE_CRC is set, the CRC_A is calculated locally instead
+ * (ISO 14443-3 CRC_A: reflected CRC-16/CCITT with preset 0x6363).
  *
  * @return STATUS_OK on success, STATUS_??? otherwise.
  */
@@ -207,6 +210,13 @@ StatusCode PCD_CalculateCRC(uint8_t *data,///< In: Pointer to the data to transf
 		uint8_t length,	///< In: The number of uint8_ts to transfer.
 		uint8_t *result	///< Out: Pointer to result buffer. Result is written to result[0..1], low uint8_t first.
 		) {
+#if MFRC522_SOFTWARE_CRC
+	uint16_t crc = crc16_ccitt_rev_calc(0x6363, data, length);
+
+	result[0] = crc & 0xFF;
+	result[1] = crc >> 8;
+	return STATUS_OK;
+#else
 	PCD_WriteRegister(CommandReg, PCD_Idle);		// Stop any active command.
 	PCD_WriteRegister(DivIrqReg, 0x04);	// Clear the CRCIRq interrupt request bit
 	PCD_SetRegisterBitMask(FIFOLevelReg, 0x80);	// FlushBuffer = 1, FIFO initialization
@@ -231,6 +241,7 @@ StatusCode PCD_CalculateCRC(uint8_t *data,///< In: Pointer to the data to transf
 	result[0] = PCD_ReadRegister(CRCResultRegL);
 	result[1] = PCD_ReadRegister(CRCResultRegH);
 	return STATUS_OK;
+#endif
 } // End PCD_CalculateCRC()
 
 /////////////////////////////////////////////////////////////////////////////////////
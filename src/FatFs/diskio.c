@@ -0,0 +1,129 @@
+/*-----------------------------------------------------------------------*/
+/* Low level disk I/O module: dispatch to the physical drive drivers     */
+/*-----------------------------------------------------------------------*/
+/* Volume n of FatFs is physical drive n (_MULTI_PARTITION 0):           */
+/*   DRV_MCI  : SD card on the MCI interface     (fs_mci.c)              */
+/*   DRV_NAND : On-board K9F1G NAND flash        (fs_nand.c)             */
+/*   DRV_NOR  : On-board SST39VF320 NOR flash    (fs_nor.c)              */
+/*                                                                       */
+/* The drivers keep no shared state, so with _FS_REENTRANT different    */
+/* volumes are accessed in parallel; FatFs serializes each volume.       */
+/*-----------------------------------------------------------------------*/
+
+#include "FatFs/diskio.h"
+
+
+/*-----------------------------------------------------------------------*/
+/* Initialize a Drive                                                    */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS disk_initialize (
+	BYTE drv				/* Physical drive nmuber (0..) */
+)
+{
+	switch (drv) {
+	case DRV_MCI :
+		return mci_disk_initialize();
+	case DRV_NAND :
+		return nand_disk_initialize();
+	case DRV_NOR :
+		return nor_disk_initialize();
+	}
+	return STA_NOINIT;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Get Disk Status                                                       */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS disk_status (
+	BYTE drv		/* Physical drive nmuber (0..) */
+)
+{
+	switch (drv) {
+	case DRV_MCI :
+		return mci_disk_status();
+	case DRV_NAND :
+		return nand_disk_status();
+	case DRV_NOR :
+		return nor_disk_status();
+	}
+	return STA_NOINIT;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Read Sector(s)                                                        */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_read (
+	BYTE drv,		/* Physical drive nmuber (0..) */
+	BYTE *buff,		/* Data buffer to store read data */
+	DWORD sector,	/* Sector address (LBA) */
+	BYTE count		/* Number of sectors to read (1..255) */
+)
+{
+	switch (drv) {
+	case DRV_MCI :
+		return mci_disk_read(buff, sector, count);
+	case DRV_NAND :
+		return nand_disk_read(buff, sector, count);
+	case DRV_NOR :
+		return nor_disk_read(buff, sector, count);
+	}
+	return RES_PARERR;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Write Sector(s)                                                       */
+/*-----------------------------------------------------------------------*/
+
+#if _USE_WRITE
+DRESULT disk_write (
+	BYTE drv,			/* Physical drive nmuber (0..) */
+	const BYTE *buff,	/* Data to be written */
+	DWORD sector,		/* Sector address (LBA) */
+	BYTE count			/* Number of sectors to write (1..255) */
+)
+{
+	switch (drv) {
+	case DRV_MCI :
+		return mci_disk_write(buff, sector, count);
+	case DRV_NAND :
+		return nand_disk_write(buff, sector, count);
+	case DRV_NOR :
+		return nor_disk_write(buff, sector, count);
+	}
+	return RES_PARERR;
+}
+#endif
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Miscellaneous Functions                                               */
+/*-----------------------------------------------------------------------*/
+
+#if _USE_IOCTL
+DRESULT disk_ioctl (
+	BYTE drv,		/* Physical drive nmuber (0..) */
+	BYTE ctrl,		/* Control code */
+	void *buff		/* Buffer to send/receive control data */
+)
+{
+	switch (drv) {
+	case DRV_MCI :
+		return mci_disk_ioctl(ctrl, buff);
+	case DRV_NAND :
+		return nand_disk_ioctl(ctrl, buff);
+	case DRV_NOR :
+		return nor_disk_ioctl(ctrl, buff);
+	}
+	return RES_PARERR;
+}
+#endif
@@ -0,0 +1,243 @@
+/*------------------------------------------------------------------------/
+/  Fast seek helper: cached cluster link map tables (CLMT) for FatFs
+/-------------------------------------------------------------------------/
+/
+/  See ff_clmt.h. Not reentrant: with _FS_REENTRANT, call the clmt_
+/  functions from one task only.
+/
+/-------------------------------------------------------------------------*/
+
+#include "FatFs/ff_clmt.h"
+
+
+/* Table slot */
+typedef struct {
+	FATFS*	fs;			/* File system of the mapped file (0: slot empty) */
+	WORD	id;			/* Mount ID of the file system */
+	WORD	refs;		/* Number of open files using the table */
+	DWORD	sclust;		/* Start cluster of the mapped file */
+	DWORD	fsize;		/* Size of the mapped file */
+	DWORD	lastuse;	/* Value of clmtTick at last open */
+} CLMT_SLOT;
+
+static CLMT_SLOT clmtSlot[CLMT_SLOTS];
+
+/* Tables (clmtPool[n] belongs to clmtSlot[n]) */
+#if CLMT_POOL_ADDR
+#define clmtPool ((DWORD (*)[CLMT_SLOT_SIZE]) CLMT_POOL_ADDR)
+#else
+static DWORD clmtPool[CLMT_SLOTS][CLMT_SLOT_SIZE];
+#endif
+
+/* Incremented on every open to find the least recently used slot */
+static DWORD clmtTick;
+
+#if !_FS_READONLY
+/* Used to look up the start cluster of a file by its name */
+static FIL clmtFile;
+#endif
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Find the slot of a file: cached table or least recently used free slot */
+/*-----------------------------------------------------------------------*/
+
+static int clmt_find (
+	const FIL* fp,	/* File object (opened) */
+	int* cached		/* Set to 1 if the slot holds the table of the file */
+)
+{
+	int i, victim = -1;
+
+
+	*cached = 0;
+	for (i = 0; i < CLMT_SLOTS; i++) {
+		if (clmtSlot[i].fs == fp->fs && clmtSlot[i].id == fp->id &&
+			clmtSlot[i].sclust == fp->sclust && clmtSlot[i].fsize == fp->fsize) {
+			*cached = 1;
+			return i;
+		}
+		if (clmtSlot[i].refs == 0 &&
+			(victim < 0 || clmtSlot[i].fs == 0 ||
+			 (clmtSlot[victim].fs != 0 && clmtSlot[i].lastuse < clmtSlot[victim].lastuse)))
+			victim = i;
+	}
+	return victim;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Open a file read-only in fast seek mode                               */
+/*-----------------------------------------------------------------------*/
+/* If no slot is free or the file has too many fragments, the file is
+/  opened in normal seek mode (fp->cltbl = 0) and FR_OK is returned. */
+
+FRESULT clmt_open (
+	FIL* fp,			/* Pointer to the blank file object */
+	const TCHAR* path	/* Pointer to the file name */
+)
+{
+	FRESULT res;
+	int i, cached;
+
+
+	res = f_open(fp, path, FA_READ | FA_OPEN_EXISTING);
+	if (res != FR_OK || fp->sclust == 0) return res;	/* Error or no data cluster */
+
+	i = clmt_find(fp, &cached);
+	if (i < 0) return FR_OK;							/* All slots in use */
+
+	if (!cached) {										/* Create CLMT in the slot */
+		clmtSlot[i].fs = 0;
+		clmtPool[i][0] = CLMT_SLOT_SIZE;
+		fp->cltbl = clmtPool[i];
+		res = f_lseek(fp, CREATE_LINKMAP);
+		if (res != FR_OK) {
+			fp->cltbl = 0;
+			if (res == FR_NOT_ENOUGH_CORE) return FR_OK;	/* Too many fragments */
+			f_close(fp);
+			return res;
+		}
+		clmtSlot[i].fs = fp->fs;
+		clmtSlot[i].id = fp->id;
+		clmtSlot[i].sclust = fp->sclust;
+		clmtSlot[i].fsize = fp->fsize;
+	}
+
+	fp->cltbl = clmtPool[i];
+	clmtSlot[i].refs++;
+	clmtSlot[i].lastuse = ++clmtTick;
+
+	return FR_OK;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Close a file opened with clmt_open()                                  */
+/*-----------------------------------------------------------------------*/
+/* The table stays cached for the next clmt_open() of the file. */
+
+FRESULT clmt_close (
+	FIL* fp		/* Pointer to the file object to be closed */
+)
+{
+	int i;
+
+
+	if (fp->cltbl) {
+		for (i = 0; i < CLMT_SLOTS; i++) {
+			if (fp->cltbl == clmtPool[i] && clmtSlot[i].refs) {
+				clmtSlot[i].refs--;
+				break;
+			}
+		}
+		fp->cltbl = 0;
+	}
+
+	return f_close(fp);
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Drop all cached tables of closed files                                */
+/*-----------------------------------------------------------------------*/
+
+void clmt_flush (void)
+{
+	int i;
+
+
+	for (i = 0; i < CLMT_SLOTS; i++) {
+		if (clmtSlot[i].refs == 0) clmtSlot[i].fs = 0;
+	}
+}
+
+
+
+#if !_FS_READONLY
+/*-----------------------------------------------------------------------*/
+/* Drop the cached table of a file                                       */
+/*-----------------------------------------------------------------------*/
+/* A table still used by an open file stays valid for that file; its slot
+/  is reused only after clmt_close(). */
+
+static void clmt_drop (
+	const FATFS* fs,	/* File system of the file */
+	DWORD sclust		/* Start cluster of the file (0: no table) */
+)
+{
+	int i;
+
+
+	if (!sclust) return;
+	for (i = 0; i < CLMT_SLOTS; i++) {
+		if (clmtSlot[i].fs == fs && clmtSlot[i].sclust == sclust) clmtSlot[i].fs = 0;
+	}
+}
+
+
+static void clmt_drop_path (
+	const TCHAR* path	/* Pointer to the file name */
+)
+{
+	if (f_open(&clmtFile, path, FA_READ | FA_OPEN_EXISTING) == FR_OK) {
+		clmt_drop(clmtFile.fs, clmtFile.sclust);
+		f_close(&clmtFile);
+	}
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Change a file and drop its cached table                               */
+/*-----------------------------------------------------------------------*/
+/* Same as f_open(), f_truncate(), f_unlink() and f_rename(). The table is
+/  dropped before the file is changed: creating a file with FA_CREATE_ALWAYS
+/  frees its old cluster chain, which can then be allocated again. */
+
+FRESULT clmt_open_write (
+	FIL* fp,			/* Pointer to the blank file object */
+	const TCHAR* path,	/* Pointer to the file name */
+	BYTE mode			/* Access mode and file open mode flags */
+)
+{
+	if (mode & (FA_WRITE | FA_CREATE_ALWAYS)) clmt_drop_path(path);
+
+	return f_open(fp, path, mode);
+}
+
+
+FRESULT clmt_truncate (
+	FIL* fp		/* Pointer to the file object */
+)
+{
+	if (fp) clmt_drop(fp->fs, fp->sclust);
+
+	return f_truncate(fp);
+}
+
+
+FRESULT clmt_unlink (
+	const TCHAR* path	/* Pointer to the file or directory path */
+)
+{
+	clmt_drop_path(path);
+
+	return f_unlink(path);
+}
+
+
+FRESULT clmt_rename (
+	const TCHAR* path_old,	/* Pointer to the old name */
+	const TCHAR* path_new	/* Pointer to the new name */
+)
+{
+	clmt_drop_path(path_old);
+
+	return f_rename(path_old, path_new);
+}
+#endif /* !_FS_READONLY */
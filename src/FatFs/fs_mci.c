@@ -45,6 +45,40 @@ static volatile WORD Timer2;
 
 static CARD_HANDLE_T *hCard;
 
+#if FSMCI_CACHE_SECTORS
+#define CACHE_SETS (FSMCI_CACHE_SECTORS / FSMCI_CACHE_WAYS)
+
+#if ((FSMCI_CACHE_SECTORS % FSMCI_CACHE_WAYS) != 0)
+#error "FSMCI_CACHE_SECTORS must be a multiple of FSMCI_CACHE_WAYS"
+#endif
+#if ((FSMCI_CACHE_READ_AHEAD < 1) || (FSMCI_CACHE_READ_AHEAD > CACHE_SETS))
+#error "FSMCI_CACHE_READ_AHEAD must be 1 to (FSMCI_CACHE_SECTORS / FSMCI_CACHE_WAYS)"
+#endif
+
+/* Cache line (sector buffer is cacheData[] at the same index) */
+typedef struct {
+	DWORD sector;	/* Cached sector number */
+	DWORD lru;		/* Value of cacheTick when last used */
+	BYTE valid;		/* Sector buffer holds sector */
+	BYTE dirty;		/* Sector buffer has not been written to the card yet */
+} CACHE_LINE_T;
+
+static CACHE_LINE_T cacheLine[FSMCI_CACHE_SECTORS];
+
+/* Sector buffers of the cache lines, followed by the read-ahead buffer */
+#if FSMCI_CACHE_ADDR
+#define cacheData ((BYTE (*)[_MAX_SS]) FSMCI_CACHE_ADDR)
+#else
+static BYTE cacheData[FSMCI_CACHE_SECTORS + FSMCI_CACHE_READ_AHEAD][_MAX_SS] __attribute__ ((aligned(4)));
+#endif
+
+/* Incremented on every cache access to find the least recently used line */
+static DWORD cacheTick;
+
+/* Sector after the last one read (a read miss here starts a read-ahead) */
+static DWORD cacheNextSector;
+#endif
+
 /*****************************************************************************
  * Public types/enumerations/variables
  ****************************************************************************/
@@ -53,16 +87,197 @@ static CARD_HANDLE_T *hCard;
  * Private functions
  ****************************************************************************/
 
+#if FSMCI_CACHE_SECTORS
+/* Discard all cache lines */
+static void cacheInvalidate(void)
+{
+	memset(cacheLine, 0, sizeof(cacheLine));
+	cacheTick = 0;
+	cacheNextSector = 0;
+}
+
+/* Return cache line that holds sector or NULL if not cached */
+static CACHE_LINE_T *cacheFind(DWORD sector)
+{
+	CACHE_LINE_T *line = &cacheLine[(sector % CACHE_SETS) * FSMCI_CACHE_WAYS];
+	int i;
+
+	for (i = 0; i < FSMCI_CACHE_WAYS; i++, line++) {
+		if (line->valid && (line->sector == sector)) {
+			return line;
+		}
+	}
+	return NULL;
+}
+
+/* Write dirty cache line to the card */
+static int cacheFlushLine(CACHE_LINE_T *line)
+{
+	if (line->valid && line->dirty) {
+		if (!FSMCI_CardWriteSectors(hCard, cacheData[line - cacheLine], line->sector, 1)) {
+			return 0;
+		}
+		line->dirty = 0;
+	}
+	return 1;
+}
+
+/* Write all dirty cache lines to the card */
+static int cacheFlush(void)
+{
+	int i;
+
+	for (i = 0; i < FSMCI_CACHE_SECTORS; i++) {
+		if (!cacheFlushLine(&cacheLine[i])) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Free the least recently used line of the set that sector maps to (NULL if write back failed) */
+static CACHE_LINE_T *cacheVictim(DWORD sector)
+{
+	CACHE_LINE_T *line = &cacheLine[(sector % CACHE_SETS) * FSMCI_CACHE_WAYS];
+	CACHE_LINE_T *victim = line;
+	int i;
+
+	for (i = 0; i < FSMCI_CACHE_WAYS; i++, line++) {
+		if (!line->valid) {
+			victim = line;
+			break;
+		}
+		if ((DWORD) (cacheTick - line->lru) > (DWORD) (cacheTick - victim->lru)) {
+			victim = line;
+		}
+	}
+
+	if (!cacheFlushLine(victim)) {
+		return NULL;
+	}
+	victim->valid = 0;
+	return victim;
+}
+
+/* Assign sector to a free line */
+static void cacheFill(CACHE_LINE_T *line, DWORD sector)
+{
+	line->sector = sector;
+	line->valid = 1;
+	line->dirty = 0;
+	line->lru = ++cacheTick;
+}
+
+/* Read sequential sectors ahead into the cache with one multi-block transfer */
+static void cacheReadAhead(DWORD sector)
+{
+	CACHE_LINE_T *line;
+	DWORD cnt = FSMCI_CACHE_READ_AHEAD;
+	DWORD i;
+
+	/* Clip to end of card */
+	if (cnt > FSMCI_CardGetSectorCnt(hCard) - sector) {
+		cnt = FSMCI_CardGetSectorCnt(hCard) - sector;
+	}
+	if (cnt < 2) {
+		return;
+	}
+
+	if (!FSMCI_CardReadSectors(hCard, cacheData[FSMCI_CACHE_SECTORS], sector, cnt)) {
+		return;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		/* Keep sectors that are already cached (they may be dirty) */
+		if (cacheFind(sector + i)) {
+			continue;
+		}
+		line = cacheVictim(sector + i);
+		if (!line) {
+			return;
+		}
+		memcpy(cacheData[line - cacheLine], cacheData[FSMCI_CACHE_SECTORS + i], _MAX_SS);
+		cacheFill(line, sector + i);
+	}
+}
+
+/* Read a sector through the cache */
+static int cacheRead(BYTE *buff, DWORD sector)
+{
+	CACHE_LINE_T *line = cacheFind(sector);
+
+	if (!line && (FSMCI_CACHE_READ_AHEAD > 1) && (sector == cacheNextSector)) {
+		/* Sequential read miss */
+		cacheReadAhead(sector);
+		line = cacheFind(sector);
+	}
+
+	if (!line) {
+		line = cacheVictim(sector);
+		if (!line) {
+			return 0;
+		}
+		if (!FSMCI_CardReadSectors(hCard, cacheData[line - cacheLine], sector, 1)) {
+			return 0;
+		}
+		cacheFill(line, sector);
+	}
+
+	line->lru = ++cacheTick;
+	memcpy(buff, cacheData[line - cacheLine], _MAX_SS);
+	cacheNextSector = sector + 1;
+	return 1;
+}
+
+/* Write a sector into the cache (written back later) */
+static int cacheWrite(const BYTE *buff, DWORD sector)
+{
+	CACHE_LINE_T *line = cacheFind(sector);
+
+	if (!line) {
+		line = cacheVictim(sector);
+		if (!line) {
+			return 0;
+		}
+		cacheFill(line, sector);
+	}
+
+	line->lru = ++cacheTick;
+	line->dirty = 1;
+	memcpy(cacheData[line - cacheLine], buff, _MAX_SS);
+	return 1;
+}
+
+/* Bring sectors that were transferred directly in line with the cache */
+static void cacheSync(BYTE *buff, DWORD sector, BYTE count, int write)
+{
+	CACHE_LINE_T *line;
+
+	for (; count; count--, sector++, buff += _MAX_SS) {
+		line = cacheFind(sector);
+		if (!line) {
+			continue;
+		}
+		if (write) {
+			/* Card now holds the newest data */
+			memcpy(cacheData[line - cacheLine], buff, _MAX_SS);
+			line->dirty = 0;
+		}
+		else if (line->dirty) {
+			/* Card data is stale */
+			memcpy(buff, cacheData[line - cacheLine], _MAX_SS);
+		}
+	}
+}
+#endif
+
 /*****************************************************************************
  * Public functions
  ****************************************************************************/
 
 /* Initialize Disk Drive */
-DSTATUS disk_initialize(BYTE drv)
+DSTATUS mci_disk_initialize(void)
 {
-	if (drv) {
-		return STA_NOINIT;				/* Supports only single drive */
-	}
 	/*	if (Stat & STA_NODISK) return Stat;	*//* No card in the socket */
 
 	if (Stat != STA_NOINIT) {
@@ -79,6 +294,9 @@ DSTATUS disk_initialize(BYTE drv)
 
 	/* Reset */
 	Stat = STA_NOINIT;
+#if FSMCI_CACHE_SECTORS
+	cacheInvalidate();
+#endif
 
 	FSMCI_CardInsertWait(hCard); /* Wait for card to be inserted */
 
@@ -94,14 +312,11 @@ DSTATUS disk_initialize(BYTE drv)
 }
 
 /* Disk Drive miscellaneous Functions */
-DRESULT disk_ioctl(BYTE drv, BYTE ctrl, void *buff)
+DRESULT mci_disk_ioctl(BYTE ctrl, void *buff)
 {
 	DRESULT res;
 	BYTE *ptr = buff;
 
-	if (drv) {
-		return RES_PARERR;
-	}
 	if (Stat & STA_NOINIT) {
 		return RES_NOTRDY;
 	}
@@ -110,6 +325,11 @@ DRESULT disk_ioctl(BYTE drv, BYTE ctrl, void *buff)
 
 	switch (ctrl) {
 	case CTRL_SYNC:	/* Make sure that no pending write process */
+#if FSMCI_CACHE_SECTORS
+		if (!cacheFlush()) {
+			break;
+		}
+#endif
 		if (FSMCI_CardReadyWait(hCard, 50)) {
 			res = RES_OK;
 		}
@@ -166,16 +386,26 @@ DRESULT disk_ioctl(BYTE drv, BYTE ctrl, void *buff)
 }
 
 /* Read Sector(s) */
-DRESULT disk_read(BYTE drv, BYTE *buff, DWORD sector, BYTE count)
+DRESULT mci_disk_read(BYTE *buff, DWORD sector, BYTE count)
 {
-	if (drv || !count) {
+	if (!count) {
 		return RES_PARERR;
 	}
 	if (Stat & STA_NOINIT) {
 		return RES_NOTRDY;
 	}
 
+#if FSMCI_CACHE_SECTORS
+	if (count == 1) {
+		return cacheRead(buff, sector) ? RES_OK : RES_ERROR;
+	}
+#endif
+
 	if (FSMCI_CardReadSectors(hCard, buff, sector, count)) {
+#if FSMCI_CACHE_SECTORS
+		cacheSync(buff, sector, count, 0);
+		cacheNextSector = sector + count;
+#endif
 		return RES_OK;
 	}
 
@@ -183,27 +413,32 @@ DRESULT disk_read(BYTE drv, BYTE *buff, DWORD sector, BYTE count)
 }
 
 /* Get Disk Status */
-DSTATUS disk_status(BYTE drv)
+DSTATUS mci_disk_status(void)
 {
-	if (drv) {
-		return STA_NOINIT;	/* Supports only single drive */
-
-	}
 	return Stat;
 }
 
 /* Write Sector(s) */
-DRESULT disk_write(BYTE drv, const BYTE *buff, DWORD sector, BYTE count)
+DRESULT mci_disk_write(const BYTE *buff, DWORD sector, BYTE count)
 {
 
-	if (drv || !count) {
+	if (!count) {
 		return RES_PARERR;
 	}
 	if (Stat & STA_NOINIT) {
 		return RES_NOTRDY;
 	}
 
+#if FSMCI_CACHE_SECTORS
+	if (count == 1) {
+		return cacheWrite(buff, sector) ? RES_OK : RES_ERROR;
+	}
+#endif
+
 	if ( FSMCI_CardWriteSectors(hCard, (void *) buff, sector, count)) {
+#if FSMCI_CACHE_SECTORS
+		cacheSync((BYTE *) buff, sector, count, 1);
+#endif
 		return RES_OK;
 	}
 
@@ -0,0 +1,97 @@
+/*
+ * @brief K9F1G NAND flash drive of the FatFs disk I/O layer (DRV_NAND)
+ *
+ * FAT sectors are stored by the flash translation layer (nand_ftl.c), which
+ * maps them onto FSNAND_BLOCK_COUNT blocks starting at FSNAND_START_BLOCK
+ * with bad block management, ECC and wear leveling. The last written page
+ * is programmed when another page is written or on CTRL_SYNC (f_sync() /
+ * f_close()).
+ */
+
+#include "FatFs/nand_ftl.h"
+#include "chip.h"
+
+/*****************************************************************************
+ * Private types/enumerations/variables
+ ****************************************************************************/
+
+/* Disk Status */
+static volatile DSTATUS Stat = STA_NOINIT;
+
+/*****************************************************************************
+ * Public functions
+ ****************************************************************************/
+
+/* Initialize Disk Drive */
+DSTATUS nand_disk_initialize(void)
+{
+	if (Stat != STA_NOINIT) {
+		return Stat;
+	}
+
+	if (!nand_ftl_mount()) {
+		return Stat;
+	}
+
+	Stat &= ~STA_NOINIT;
+	return Stat;
+}
+
+/* Get Disk Status */
+DSTATUS nand_disk_status(void)
+{
+	return Stat;
+}
+
+/* Read Sector(s) */
+DRESULT nand_disk_read(BYTE *buff, DWORD sector, BYTE count)
+{
+	if (!count || sector + count > NAND_FTL_SECTOR_COUNT) {
+		return RES_PARERR;
+	}
+	if (Stat & STA_NOINIT) {
+		return RES_NOTRDY;
+	}
+
+	return nand_ftl_read(buff, sector, count) ? RES_OK : RES_ERROR;
+}
+
+/* Write Sector(s) */
+DRESULT nand_disk_write(const BYTE *buff, DWORD sector, BYTE count)
+{
+	if (!count || sector + count > NAND_FTL_SECTOR_COUNT) {
+		return RES_PARERR;
+	}
+	if (Stat & STA_NOINIT) {
+		return RES_NOTRDY;
+	}
+
+	return nand_ftl_write(buff, sector, count) ? RES_OK : RES_ERROR;
+}
+
+/* Disk Drive miscellaneous Functions */
+DRESULT nand_disk_ioctl(BYTE ctrl, void *buff)
+{
+	if (Stat & STA_NOINIT) {
+		return RES_NOTRDY;
+	}
+
+	switch (ctrl) {
+	case CTRL_SYNC:	/* Program the page held in RAM */
+		return nand_ftl_sync() ? RES_OK : RES_ERROR;
+
+	case GET_SECTOR_COUNT:	/* Get number of sectors on the disk (DWORD) */
+		*(DWORD *) buff = NAND_FTL_SECTOR_COUNT;
+		return RES_OK;
+
+	case GET_SECTOR_SIZE:	/* Get R/W sector size (WORD) */
+		*(WORD *) buff = 512;
+		return RES_OK;
+
+	case GET_BLOCK_SIZE:/* Get erase block size in unit of sector (DWORD) */
+		*(DWORD *) buff = K9F1G_PAGES_PER_BLOCK * (K9F1G_PAGE_SIZE / 512);
+		return RES_OK;
+	}
+
+	return RES_PARERR;
+}
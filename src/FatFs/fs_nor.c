@@ -0,0 +1,176 @@
+/*
+ * @brief SST39VF320 NOR flash drive of the FatFs disk I/O layer (DRV_NOR)
+ *
+ * FAT sectors are mapped onto FSNOR_SECTOR_COUNT flash sectors (4 KB, 8 FAT
+ * sectors each) starting at FSNOR_START_SECTOR. Reads come straight from the
+ * memory mapped flash. Writes go through a flash sector buffer that is
+ * written back with lpc_norflash_program() when another flash sector is
+ * written or on CTRL_SYNC: the flash sector is only erased if a bit has to
+ * change from 0 to 1, and only words that differ are programmed.
+ */
+
+#include "FatFs/fsflash_cfg.h"
+#include "chip.h"
+
+/*****************************************************************************
+ * Private types/enumerations/variables
+ ****************************************************************************/
+
+#define FLASH_SECTOR_SIZE	(4 << 10)
+#define SECTORS_PER_FLASH	(FLASH_SECTOR_SIZE / 512)
+#define NO_SECTOR			0xFFFFFFFF
+
+/* Byte offset in the NOR flash of a flash sector of the drive */
+#define FLASH_OFFSET(fs)	lpc_norflash_get_sector_offset(FSNOR_START_SECTOR + (fs))
+
+/* Disk Status */
+static volatile DSTATUS Stat = STA_NOINIT;
+
+/* Flash sector buffer */
+static WORD sectBuf[FLASH_SECTOR_SIZE / 2];
+
+/* Flash sector held in sectBuf (relative to FSNOR_START_SECTOR) */
+static DWORD bufSector = NO_SECTOR;
+
+/* sectBuf has been changed and must be written back */
+static BYTE bufDirty;
+
+/*****************************************************************************
+ * Private functions
+ ****************************************************************************/
+
+/* Write sectBuf back to its flash sector */
+static int bufFlush(void)
+{
+	if (!bufDirty) {
+		return 1;
+	}
+
+	if (!lpc_norflash_program(FLASH_OFFSET(bufSector), sectBuf, FLASH_SECTOR_SIZE, NULL)) {
+		return 0;
+	}
+
+	bufDirty = 0;
+	return 1;
+}
+
+/* Load a flash sector into sectBuf (writing back the previous one) */
+static int bufLoad(DWORD fsect)
+{
+	if (bufSector == fsect) {
+		return 1;
+	}
+	if (!bufFlush()) {
+		return 0;
+	}
+
+	memcpy(sectBuf, (const void *) (EMC_ADDRESS_CS0 + FLASH_OFFSET(fsect)), FLASH_SECTOR_SIZE);
+	bufSector = fsect;
+	return 1;
+}
+
+/*****************************************************************************
+ * Public functions
+ ****************************************************************************/
+
+/* Initialize Disk Drive */
+DSTATUS nor_disk_initialize(void)
+{
+	UNS_32 size, sector_count;
+
+	if (Stat != STA_NOINIT) {
+		return Stat;
+	}
+
+	lpc_norflash_init();
+	lpc_norflash_get_size(&size, &sector_count);
+	if (FSNOR_START_SECTOR + FSNOR_SECTOR_COUNT > sector_count) {
+		return Stat;
+	}
+
+	bufSector = NO_SECTOR;
+	bufDirty = 0;
+
+	Stat &= ~STA_NOINIT;
+	return Stat;
+}
+
+/* Get Disk Status */
+DSTATUS nor_disk_status(void)
+{
+	return Stat;
+}
+
+/* Read Sector(s) */
+DRESULT nor_disk_read(BYTE *buff, DWORD sector, BYTE count)
+{
+	DWORD fsect, ofs;
+
+	if (!count || sector + count > FSNOR_SECTOR_COUNT * SECTORS_PER_FLASH) {
+		return RES_PARERR;
+	}
+	if (Stat & STA_NOINIT) {
+		return RES_NOTRDY;
+	}
+
+	for (; count; count--, sector++, buff += 512) {
+		fsect = sector / SECTORS_PER_FLASH;
+		ofs = (sector % SECTORS_PER_FLASH) * 512;
+		if (fsect == bufSector) {
+			memcpy(buff, (BYTE *) sectBuf + ofs, 512);
+		}
+		else {
+			memcpy(buff, (const void *) (EMC_ADDRESS_CS0 + FLASH_OFFSET(fsect) + ofs), 512);
+		}
+	}
+
+	return RES_OK;
+}
+
+/* Write Sector(s) */
+DRESULT nor_disk_write(const BYTE *buff, DWORD sector, BYTE count)
+{
+	if (!count || sector + count > FSNOR_SECTOR_COUNT * SECTORS_PER_FLASH) {
+		return RES_PARERR;
+	}
+	if (Stat & STA_NOINIT) {
+		return RES_NOTRDY;
+	}
+
+	for (; count; count--, sector++, buff += 512) {
+		if (!bufLoad(sector / SECTORS_PER_FLASH)) {
+			return RES_ERROR;
+		}
+		memcpy((BYTE *) sectBuf + (sector % SECTORS_PER_FLASH) * 512, buff, 512);
+		bufDirty = 1;
+	}
+
+	return RES_OK;
+}
+
+/* Disk Drive miscellaneous Functions */
+DRESULT nor_disk_ioctl(BYTE ctrl, void *buff)
+{
+	if (Stat & STA_NOINIT) {
+		return RES_NOTRDY;
+	}
+
+	switch (ctrl) {
+	case CTRL_SYNC:	/* Write back the flash sector buffer */
+		return bufFlush() ? RES_OK : RES_ERROR;
+
+	case GET_SECTOR_COUNT:	/* Get number of sectors on the disk (DWORD) */
+		*(DWORD *) buff = FSNOR_SECTOR_COUNT * SECTORS_PER_FLASH;
+		return RES_OK;
+
+	case GET_SECTOR_SIZE:	/* Get R/W sector size (WORD) */
+		*(WORD *) buff = 512;
+		return RES_OK;
+
+	case GET_BLOCK_SIZE:/* Get erase block size in unit of sector (DWORD) */
+		*(DWORD *) buff = SECTORS_PER_FLASH;
+		return RES_OK;
+	}
+
+	return RES_PARERR;
+}
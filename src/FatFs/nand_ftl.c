@@ -0,0 +1,794 @@
+/*
+ * @brief Flash translation layer of the K9F1G NAND flash
+ *
+ * See nand_ftl.h for the on-flash format. Pages of a block are programmed
+ * in order, and blocks are erased when they are allocated, so a block whose
+ * first page is erased is free. After a power loss only the page with the
+ * highest sequence number can have been left half programmed: it is checked
+ * at mount time and its tag is cleared if its data cannot be corrected, so
+ * that the previous copy of the logical page is used again.
+ */
+
+#include "FatFs/nand_ftl.h"
+#include "chip.h"
+
+/*****************************************************************************
+ * Private types/enumerations/variables
+ ****************************************************************************/
+
+#define PAGES_PER_BLOCK		K9F1G_PAGES_PER_BLOCK
+#define SECTORS_PER_PAGE	(K9F1G_PAGE_SIZE / 512)
+#define FTL_PAGES			((FSNAND_BLOCK_COUNT - FSNAND_RESERVE_BLOCKS) * PAGES_PER_BLOCK)
+#define FTL_BLOCKS			(FSNAND_BLOCK_COUNT - FSNAND_RESERVE_BLOCKS)
+#define NONE				0xFFFFFFFF
+
+/* Maximum number of status polls of a read, program or erase */
+#define NAND_TIMEOUT		1000000
+
+/* Spare area layout (offsets in the spare area) */
+#define SPARE_BAD			0
+#define SPARE_TAG			8
+#define SPARE_TAG_ECC		24
+#define SPARE_DATA_ECC		32
+#define SPARE_DATA_ECC_END	(SPARE_DATA_ECC + K9F1G_PAGE_SIZE / ECC_CHUNK * 3)
+
+/* Bytes covered by 3 bytes of ECC */
+#define ECC_CHUNK			256
+
+/* Block states */
+#define BLK_FREE			0	/* No valid pages, erased when allocated */
+#define BLK_USED			1	/* Written */
+#define BLK_RETIRE			2	/* Written, failed a program: moved to BLK_BAD by the next collection */
+#define BLK_BAD				3	/* Not used */
+
+/* Tag of a page (spare area) */
+typedef struct {
+	DWORD	lpn;		/* Logical page */
+	DWORD	seq;		/* Sequence number, incremented on each page program */
+	DWORD	erase;		/* Erase count of the block */
+	DWORD	rsvd;		/* 0xFFFFFFFF */
+} FTL_TAG;
+
+/* Block information */
+typedef struct {
+	DWORD	erase;		/* Erase count */
+	WORD	valid;		/* Number of mapped pages */
+	BYTE	state;		/* BLK_xxx */
+	BYTE	rsvd;
+} FTL_BLOCK;
+
+/* Mapping tables (FSNAND_MAP_ADDR): physical page of each logical page,
+   sequence number of that physical page (used at mount time) and blocks */
+#define ftlMap		((DWORD *) FSNAND_MAP_ADDR)
+#define ftlSeq		(ftlMap + FTL_PAGES)
+#define ftlBlk		((FTL_BLOCK *) (ftlSeq + FTL_PAGES))
+
+/* Page buffers (data and spare area): page being written and last page read */
+static DWORD wrBuf[(K9F1G_PAGE_SIZE + K9F1G_SPARE_SIZE) / 4];
+static DWORD rdBuf[(K9F1G_PAGE_SIZE + K9F1G_SPARE_SIZE) / 4];
+
+/* Logical pages in wrBuf and rdBuf */
+static DWORD wrLpn = NONE;
+static DWORD rdLpn = NONE;
+
+/* wrBuf has been changed and must be programmed */
+static BYTE wrDirty;
+
+/* Block being written and its next free page */
+static DWORD activeBlock = NONE;
+static DWORD activePage;
+
+/* Sequence number of the next page program */
+static DWORD seqNext;
+
+static NAND_FTL_STAT ftlStat;
+
+/*****************************************************************************
+ * Private functions
+ ****************************************************************************/
+
+/* Parity of a byte */
+static BYTE parity8(BYTE b)
+{
+	b ^= b >> 4;
+	b ^= b >> 2;
+	b ^= b >> 1;
+	return b & 1;
+}
+
+/* Hamming code of len bytes (power of 2, 4 to 256): bits 0..10 are the
+   parities of the data bits whose bit address has the corresponding bit set,
+   bits 11..21 the parities of those that have it cleared */
+static DWORD eccCalc(const BYTE *data, UINT len)
+{
+	UINT i;
+	uint32_t w, p, col = 0;
+	DWORD line = 0, p1;
+	BYTE c;
+
+	/* Four bytes at a time: bit 0 of each byte of p gets the parity of
+	   that byte */
+	for (i = 0; i < len; i += 4) {
+		memcpy(&w, data + i, 4);
+		col ^= w;
+		p = w ^ (w >> 4);
+		p ^= p >> 2;
+		p ^= p >> 1;
+		if (p & 0x00000001) {
+			line ^= i;
+		}
+		if (p & 0x00000100) {
+			line ^= i + 1;
+		}
+		if (p & 0x00010000) {
+			line ^= i + 2;
+		}
+		if (p & 0x01000000) {
+			line ^= i + 3;
+		}
+	}
+	col ^= col >> 16;
+	col ^= col >> 8;
+	c = (BYTE) col;
+
+	p1 = (line << 3) | parity8(c & 0xAA) | (parity8(c & 0xCC) << 1) | (parity8(c & 0xF0) << 2);
+
+	return p1 | ((parity8(c) ? p1 ^ (len * 8 - 1) : p1) << 11);
+}
+
+/* Store an ECC (inverted, so that an erased page has a valid ECC) */
+static void eccStore(BYTE *ecc, DWORD code)
+{
+	code = ~code;
+	ecc[0] = (BYTE) code;
+	ecc[1] = (BYTE) (code >> 8);
+	ecc[2] = (BYTE) (code >> 16);
+}
+
+/* Check len bytes against a stored ECC, returns 0: no error, 1: corrected,
+   -1: uncorrectable */
+static int eccCorrect(BYTE *data, UINT len, const BYTE *ecc)
+{
+	DWORD s, s1, s0;
+
+	s = (~(ecc[0] | (ecc[1] << 8) | (ecc[2] << 16)) & 0x3FFFFF) ^ eccCalc(data, len);
+	if (!s) {
+		return 0;
+	}
+
+	s1 = s & 0x7FF;
+	s0 = s >> 11;
+	if ((s1 ^ s0) == len * 8 - 1) {
+		/* One data bit error, s1 is its address */
+		data[s1 >> 3] ^= 1 << (s1 & 7);
+		return 1;
+	}
+	if (!(s & (s - 1))) {
+		/* One bit error in the ECC */
+		return 1;
+	}
+	return -1;
+}
+
+/* Compute the data ECC of a page buffer */
+static void eccSet(BYTE *buf)
+{
+	UINT i;
+
+	for (i = 0; i < K9F1G_PAGE_SIZE / ECC_CHUNK; i++) {
+		eccStore(buf + K9F1G_PAGE_SIZE + SPARE_DATA_ECC + i * 3, eccCalc(buf + i * ECC_CHUNK, ECC_CHUNK));
+	}
+}
+
+/* Wait until the NAND flash is ready, returns the status (0 on timeout) */
+static uint8_t nandWaitReady(void)
+{
+	uint32_t tout = NAND_TIMEOUT;
+	uint8_t status;
+
+	do {
+		status = lpc_nandflash_read_status();
+		if (status & NANDFLASH_STATUS_DEV_READY) {
+			return status;
+		}
+	} while (--tout);
+
+	return 0;
+}
+
+/* Read part of a page */
+static int nandRead(DWORD block, DWORD page, DWORD ofs, BYTE *buff, DWORD size)
+{
+	lpc_nandflash_read_start(FSNAND_START_BLOCK + block, page, ofs);
+	if (!nandWaitReady()) {
+		return 0;
+	}
+	/* Back from status to data output */
+	wsBoard_NANDFLash_WriteCmd(K9F1G_READ_1);
+	lpc_nandflash_read_data(buff, size);
+	return 1;
+}
+
+/* Program a page (ofs 0) or part of a programmed page */
+static int nandProgram(DWORD ppn, DWORD ofs, BYTE *buff, DWORD size)
+{
+	uint8_t status;
+
+	if (ofs) {
+		lpc_nandflash_write_ofs(FSNAND_START_BLOCK + ppn / PAGES_PER_BLOCK, ppn % PAGES_PER_BLOCK, ofs, buff, size);
+	}
+	else {
+		lpc_nandflash_write_page(FSNAND_START_BLOCK + ppn / PAGES_PER_BLOCK, ppn % PAGES_PER_BLOCK, buff, size);
+	}
+	status = nandWaitReady();
+	return status && !(status & NANDFLASH_STATUS_PAGE_PROG_FAIL);
+}
+
+/* Erase a block */
+static int nandErase(DWORD block)
+{
+	uint8_t status;
+
+	lpc_nandflash_erase_block(FSNAND_START_BLOCK + block);
+	status = nandWaitReady();
+	return status && !(status & NANDFLASH_STATUS_BLOCK_ERASE_FAIL);
+}
+
+/* Get the tag of a page from its spare area, returns 1: valid, 0: erased
+   page, -1: invalid tag */
+static int tagGet(const BYTE *spare, FTL_TAG *tag)
+{
+	BYTE buf[sizeof(FTL_TAG)];
+	UINT i;
+
+	for (i = SPARE_TAG; i < SPARE_TAG_ECC + 3 && spare[i] == 0xFF; i++) {}
+	if (i == SPARE_TAG_ECC + 3) {
+		return 0;
+	}
+
+	memcpy(buf, spare + SPARE_TAG, sizeof(buf));
+	if (eccCorrect(buf, sizeof(buf), spare + SPARE_TAG_ECC) < 0) {
+		return -1;
+	}
+	memcpy(tag, buf, sizeof(buf));
+	return 1;
+}
+
+/* Clear the tag of a page, so that it is not mapped at the next mount */
+static void tagKill(DWORD ppn)
+{
+	BYTE zero[SPARE_TAG_ECC + 3 - SPARE_TAG];
+
+	memset(zero, 0, sizeof(zero));
+	nandProgram(ppn, K9F1G_SPARE_START_ADDR + SPARE_TAG, zero, sizeof(zero));
+}
+
+/* Check and correct the data of a page against the ECC in its spare area,
+   returns 1: OK, -1: uncorrectable bit error */
+static int pageCorrect(BYTE *data, const BYTE *spare)
+{
+	UINT i;
+	int res, fixed = 0;
+
+	for (i = 0; i < K9F1G_PAGE_SIZE / ECC_CHUNK; i++) {
+		res = eccCorrect(data + i * ECC_CHUNK, ECC_CHUNK, spare + SPARE_DATA_ECC + i * 3);
+		if (res < 0) {
+			ftlStat.eccFailed++;
+			return -1;
+		}
+		fixed |= res;
+	}
+	if (fixed) {
+		ftlStat.eccCorrected++;
+	}
+	return 1;
+}
+
+/* Read a page into a page buffer and correct its data, returns 1: OK,
+   0: flash error, -1: uncorrectable bit error */
+static int pageRead(DWORD ppn, BYTE *buf)
+{
+	if (!nandRead(ppn / PAGES_PER_BLOCK, ppn % PAGES_PER_BLOCK, 0, buf, K9F1G_PAGE_SIZE + K9F1G_SPARE_SIZE)) {
+		return 0;
+	}
+	return pageCorrect(buf, buf + K9F1G_PAGE_SIZE);
+}
+
+/* Start reading the data of a logical page into a buffer, returns 2: data
+   in the buffer (page in RAM or never written), 1: transfer started (to be
+   completed by pageFinish()), 0: flash error */
+static int pageStart(DWORD lpn, BYTE *data)
+{
+	DWORD ppn = ftlMap[lpn];
+
+	if (lpn == wrLpn) {
+		memcpy(data, wrBuf, K9F1G_PAGE_SIZE);
+		return 2;
+	}
+	if (ppn == NONE) {
+		memset(data, 0xFF, K9F1G_PAGE_SIZE);
+		return 2;
+	}
+
+	lpc_nandflash_read_start(FSNAND_START_BLOCK + ppn / PAGES_PER_BLOCK, ppn % PAGES_PER_BLOCK, 0);
+	if (!nandWaitReady()) {
+		return 0;
+	}
+	wsBoard_NANDFLash_WriteCmd(K9F1G_READ_1);
+	lpc_nandflash_read_data_start(data, K9F1G_PAGE_SIZE);
+	return 1;
+}
+
+/* Complete pageStart(): wait for the data and read the spare area */
+static void pageFinish(BYTE *spare)
+{
+	lpc_nandflash_read_data_wait();
+	lpc_nandflash_read_data(spare, K9F1G_SPARE_SIZE);
+}
+
+/* Read whole logical pages into a buffer: the ECC of each page is checked
+   while the next page is streamed from the flash */
+static int pagesRead(BYTE *buff, DWORD lpn, DWORD n)
+{
+	BYTE spare[K9F1G_SPARE_SIZE];
+	DWORD i;
+	int res, next;
+
+	res = pageStart(lpn, buff);
+	for (i = 0; res && i < n; i++, buff += K9F1G_PAGE_SIZE) {
+		if (res == 1) {
+			pageFinish(spare);
+		}
+		next = (i + 1 < n) ? pageStart(lpn + i + 1, buff + K9F1G_PAGE_SIZE) : 2;
+		if (res == 1 && pageCorrect(buff, spare) < 0) {
+			if (next == 1) {
+				lpc_nandflash_read_data_wait();
+			}
+			return 0;
+		}
+		res = next;
+	}
+
+	return res != 0;
+}
+
+/* Mark a block bad (best effort: the marker may not be programmable) */
+static void blockMarkBad(DWORD block)
+{
+	BYTE marker = 0;
+
+	ftlBlk[block].state = BLK_BAD;
+	ftlBlk[block].valid = 0;
+	ftlStat.badBlocks++;
+	nandProgram(block * PAGES_PER_BLOCK, K9F1G_SPARE_START_ADDR + SPARE_BAD, &marker, 1);
+}
+
+/* Erase the free block with the lowest erase count */
+static DWORD blockAlloc(void)
+{
+	DWORD b, best;
+
+	for (;;) {
+		best = NONE;
+		for (b = 0; b < FSNAND_BLOCK_COUNT; b++) {
+			if (ftlBlk[b].state == BLK_FREE && (best == NONE || ftlBlk[b].erase < ftlBlk[best].erase)) {
+				best = b;
+			}
+		}
+		if (best == NONE) {
+			return NONE;
+		}
+
+		ftlStat.freeBlocks--;
+		if (++ftlBlk[best].erase > ftlStat.maxErase) {
+			ftlStat.maxErase = ftlBlk[best].erase;
+		}
+		if (nandErase(best)) {
+			ftlBlk[best].state = BLK_USED;
+			ftlBlk[best].valid = 0;
+			return best;
+		}
+		blockMarkBad(best);
+	}
+}
+
+/* Choose the block to collect: a block to retire, else a cold block (wl),
+   else the block with the fewest valid pages (gc) */
+static DWORD blockVictim(int wl, int gc)
+{
+	DWORD b, best = NONE, cold = NONE;
+
+	for (b = 0; b < FSNAND_BLOCK_COUNT; b++) {
+		if (b == activeBlock) {
+			continue;
+		}
+		if (ftlBlk[b].state == BLK_RETIRE) {
+			return b;
+		}
+		if (ftlBlk[b].state != BLK_USED) {
+			continue;
+		}
+		if (best == NONE || ftlBlk[b].valid < ftlBlk[best].valid) {
+			best = b;
+		}
+		if (cold == NONE || ftlBlk[b].erase < ftlBlk[cold].erase) {
+			cold = b;
+		}
+	}
+
+	if (wl && cold != NONE && ftlBlk[cold].erase + FSNAND_WL_DELTA <= ftlStat.maxErase) {
+		return cold;
+	}
+	/* Collecting a full block would not free anything */
+	if (!gc || best == NONE || ftlBlk[best].valid == PAGES_PER_BLOCK) {
+		return NONE;
+	}
+	return best;
+}
+
+static int blockCollect(DWORD block);
+
+/* Get the next free page, collecting blocks first if few are free (!gc) */
+static int nextPage(DWORD *ppn, int gc)
+{
+	if (activeBlock == NONE || activePage == PAGES_PER_BLOCK) {
+		activeBlock = NONE;
+		if (!gc) {
+			while (ftlStat.freeBlocks <= FSNAND_GC_FREE_BLOCKS && blockCollect(blockVictim(0, 1))) {}
+		}
+	}
+
+	/* The collection may have opened a block */
+	if (activeBlock == NONE || activePage == PAGES_PER_BLOCK) {
+		activeBlock = blockAlloc();
+		if (activeBlock == NONE) {
+			return 0;
+		}
+		activePage = 0;
+	}
+
+	*ppn = activeBlock * PAGES_PER_BLOCK + activePage++;
+	return 1;
+}
+
+/* Program a logical page from a page buffer with its data ECC set */
+static int pageWrite(DWORD lpn, BYTE *buf, int gc)
+{
+	BYTE *spare = buf + K9F1G_PAGE_SIZE;
+	FTL_TAG tag;
+	DWORD ppn, old;
+
+	for (;;) {
+		if (!nextPage(&ppn, gc)) {
+			return 0;
+		}
+
+		tag.lpn = lpn;
+		tag.seq = seqNext++;
+		tag.erase = ftlBlk[ppn / PAGES_PER_BLOCK].erase;
+		tag.rsvd = NONE;
+		memset(spare, 0xFF, SPARE_DATA_ECC);
+		memset(spare + SPARE_DATA_ECC_END, 0xFF, K9F1G_SPARE_SIZE - SPARE_DATA_ECC_END);
+		memcpy(spare + SPARE_TAG, &tag, sizeof(tag));
+		eccStore(spare + SPARE_TAG_ECC, eccCalc(spare + SPARE_TAG, sizeof(tag)));
+
+		if (nandProgram(ppn, 0, buf, K9F1G_PAGE_SIZE + K9F1G_SPARE_SIZE)) {
+			break;
+		}
+
+		/* Program failure: stop writing to the block, its pages are moved
+		   by the next collection */
+		ftlBlk[activeBlock].state = BLK_RETIRE;
+		activeBlock = NONE;
+	}
+
+	old = ftlMap[lpn];
+	if (old != NONE) {
+		ftlBlk[old / PAGES_PER_BLOCK].valid--;
+	}
+	ftlMap[lpn] = ppn;
+	ftlBlk[ppn / PAGES_PER_BLOCK].valid++;
+	return 1;
+}
+
+/* Find the logical page mapped to a physical page */
+static DWORD mapFind(DWORD ppn)
+{
+	DWORD lpn;
+
+	for (lpn = 0; lpn < FTL_PAGES; lpn++) {
+		if (ftlMap[lpn] == ppn) {
+			return lpn;
+		}
+	}
+	return NONE;
+}
+
+/* Move the valid pages of a block and free it (or mark it bad) */
+static int blockCollect(DWORD block)
+{
+	BYTE *buf = (BYTE *) rdBuf;
+	DWORD page, ppn, lpn;
+	FTL_TAG tag;
+	int res;
+
+	if (block == NONE) {
+		return 0;
+	}
+
+	rdLpn = NONE;
+	for (page = 0; page < PAGES_PER_BLOCK && ftlBlk[block].valid; page++) {
+		ppn = block * PAGES_PER_BLOCK + page;
+
+		/* Check the tag before reading the whole page */
+		if (!nandRead(block, page, K9F1G_PAGE_SIZE, buf + K9F1G_PAGE_SIZE, K9F1G_SPARE_SIZE)) {
+			return 0;
+		}
+		res = tagGet(buf + K9F1G_PAGE_SIZE, &tag);
+		lpn = (res > 0) ? tag.lpn : (res < 0) ? mapFind(ppn) : NONE;
+		if (lpn >= FTL_PAGES || ftlMap[lpn] != ppn) {
+			continue;
+		}
+
+		res = pageRead(ppn, buf);
+		if (!res) {
+			return 0;
+		}
+		/* Data that cannot be corrected keeps its ECC, so that the error
+		   is still reported when it is read */
+		if (res > 0) {
+			eccSet(buf);
+		}
+		if (!pageWrite(lpn, buf, 1)) {
+			return 0;
+		}
+	}
+
+	if (ftlBlk[block].state == BLK_RETIRE) {
+		blockMarkBad(block);
+	}
+	else {
+		ftlBlk[block].state = BLK_FREE;
+		ftlBlk[block].valid = 0;
+		ftlStat.freeBlocks++;
+	}
+	ftlStat.collected++;
+	return 1;
+}
+
+/* Rebuild the tables from the spare areas, returns the page with the
+   highest sequence number in *last */
+static int ftlScan(DWORD *last)
+{
+	BYTE spare[K9F1G_SPARE_SIZE];
+	DWORD b, page, ppn, sum = 0, used = 0;
+	FTL_BLOCK *blk;
+	FTL_TAG tag;
+	int res;
+
+	memset(ftlMap, 0xFF, FTL_PAGES * sizeof(DWORD));
+	memset(&ftlStat, 0, sizeof(ftlStat));
+	seqNext = 0;
+	*last = NONE;
+
+	for (b = 0; b < FSNAND_BLOCK_COUNT; b++) {
+		blk = &ftlBlk[b];
+		blk->erase = NONE;
+		blk->valid = 0;
+		blk->state = BLK_FREE;
+
+		for (page = 0; page < PAGES_PER_BLOCK; page++) {
+			if (!nandRead(b, page, K9F1G_PAGE_SIZE, spare, sizeof(spare))) {
+				return 0;
+			}
+			/* Factory bad block marker in the first or second page */
+			if (page < 2 && spare[SPARE_BAD] != 0xFF) {
+				blk->state = BLK_BAD;
+				break;
+			}
+
+			res = tagGet(spare, &tag);
+			if (!res) {
+				/* Pages are programmed in order: the rest is erased (the
+				   second page is still read for the bad block marker) */
+				if (page) {
+					break;
+				}
+				continue;
+			}
+			blk->state = BLK_USED;
+			if (res < 0) {
+				continue;
+			}
+
+			ppn = b * PAGES_PER_BLOCK + page;
+			blk->erase = tag.erase;
+			if (tag.seq >= seqNext) {
+				seqNext = tag.seq + 1;
+				*last = ppn;
+			}
+			if (tag.lpn >= FTL_PAGES) {
+				continue;
+			}
+			if (ftlMap[tag.lpn] != NONE) {
+				if (tag.seq < ftlSeq[tag.lpn]) {
+					continue;
+				}
+				ftlBlk[ftlMap[tag.lpn] / PAGES_PER_BLOCK].valid--;
+			}
+			ftlMap[tag.lpn] = ppn;
+			ftlSeq[tag.lpn] = tag.seq;
+			blk->valid++;
+		}
+
+		if (blk->state == BLK_BAD) {
+			ftlStat.badBlocks++;
+		}
+		else if (blk->state == BLK_FREE) {
+			ftlStat.freeBlocks++;
+		}
+		if (blk->erase != NONE) {
+			sum += blk->erase;
+			used++;
+			if (blk->erase > ftlStat.maxErase) {
+				ftlStat.maxErase = blk->erase;
+			}
+		}
+	}
+
+	/* The erase count of an erased block is lost: use the average */
+	for (b = 0; b < FSNAND_BLOCK_COUNT; b++) {
+		if (ftlBlk[b].erase == NONE) {
+			ftlBlk[b].erase = used ? sum / used : 0;
+		}
+	}
+
+	return 1;
+}
+
+/* Program the page being written */
+static int wrFlush(void)
+{
+	if (!wrDirty) {
+		return 1;
+	}
+
+	eccSet((BYTE *) wrBuf);
+	if (!pageWrite(wrLpn, (BYTE *) wrBuf, 0)) {
+		return 0;
+	}
+	wrDirty = 0;
+	return 1;
+}
+
+/*****************************************************************************
+ * Public functions
+ ****************************************************************************/
+
+/* Scan the NAND flash and build the mapping table */
+int nand_ftl_mount(void)
+{
+	DWORD last;
+
+	lpc_nandflash_init();
+	wrLpn = rdLpn = NONE;
+	wrDirty = 0;
+	activeBlock = NONE;
+
+	wsBoard_NANDFLash_WriteCmd(K9F1G_RESET);
+	if (!nandWaitReady() || !ftlScan(&last)) {
+		return 0;
+	}
+
+	/* Only the last programmed page can have been interrupted */
+	if (last != NONE && pageRead(last, (BYTE *) rdBuf) < 0) {
+		tagKill(last);
+		if (!ftlScan(&last)) {
+			return 0;
+		}
+	}
+
+	return FSNAND_BLOCK_COUNT - ftlStat.badBlocks >= FTL_BLOCKS + FSNAND_GC_FREE_BLOCKS + 1;
+}
+
+/* Read sectors */
+int nand_ftl_read(BYTE *buff, DWORD sector, UINT count)
+{
+	DWORD lpn, ofs, n;
+
+	for (; count; count -= n, sector += n, buff += n * 512) {
+		lpn = sector / SECTORS_PER_PAGE;
+		ofs = (sector % SECTORS_PER_PAGE) * 512;
+
+		/* Whole pages go straight into the caller's buffer */
+		if (!ofs && count >= SECTORS_PER_PAGE) {
+			n = count / SECTORS_PER_PAGE;
+			if (!pagesRead(buff, lpn, n)) {
+				return 0;
+			}
+			n *= SECTORS_PER_PAGE;
+			continue;
+		}
+
+		n = 1;
+		if (lpn == wrLpn) {
+			memcpy(buff, (BYTE *) wrBuf + ofs, 512);
+			continue;
+		}
+		if (lpn != rdLpn) {
+			rdLpn = NONE;
+			if (ftlMap[lpn] == NONE) {
+				memset(rdBuf, 0xFF, K9F1G_PAGE_SIZE);
+			}
+			else if (pageRead(ftlMap[lpn], (BYTE *) rdBuf) <= 0) {
+				return 0;
+			}
+			rdLpn = lpn;
+		}
+		memcpy(buff, (BYTE *) rdBuf + ofs, 512);
+	}
+
+	return 1;
+}
+
+/* Write sectors */
+int nand_ftl_write(const BYTE *buff, DWORD sector, UINT count)
+{
+	DWORD lpn, ofs;
+
+	for (; count; count--, sector++, buff += 512) {
+		lpn = sector / SECTORS_PER_PAGE;
+		ofs = (sector % SECTORS_PER_PAGE) * 512;
+
+		if (lpn != wrLpn) {
+			if (!wrFlush()) {
+				return 0;
+			}
+			wrLpn = NONE;
+
+			/* Keep the sectors of the page that are not written */
+			if (ofs || count < SECTORS_PER_PAGE) {
+				if (lpn == rdLpn) {
+					memcpy(wrBuf, rdBuf, K9F1G_PAGE_SIZE);
+				}
+				else if (ftlMap[lpn] == NONE) {
+					memset(wrBuf, 0xFF, K9F1G_PAGE_SIZE);
+				}
+				else if (pageRead(ftlMap[lpn], (BYTE *) wrBuf) <= 0) {
+					return 0;
+				}
+			}
+			wrLpn = lpn;
+		}
+		if (lpn == rdLpn) {
+			rdLpn = NONE;
+		}
+
+		memcpy((BYTE *) wrBuf + ofs, buff, 512);
+		wrDirty = 1;
+	}
+
+	return 1;
+}
+
+/* Program the page held in RAM */
+int nand_ftl_sync(void)
+{
+	return wrFlush();
+}
+
+/* Background garbage collection and wear leveling step */
+int nand_ftl_gc(void)
+{
+	if (ftlStat.freeBlocks <= FSNAND_GC_FREE_BLOCKS / 2) {
+		/* Leave the last free blocks to the writes */
+		return 0;
+	}
+	return blockCollect(blockVictim(1, ftlStat.freeBlocks < FSNAND_IDLE_FREE_BLOCKS));
+}
+
+/* Get the statistics of the flash translation layer */
+void nand_ftl_get_stat(NAND_FTL_STAT *stat)
+{
+	*stat = ftlStat;
+}
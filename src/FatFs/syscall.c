@@ -0,0 +1,112 @@
+/*------------------------------------------------------------------------/
+/  Sync functions of FatFs (_FS_REENTRANT) without an O/S
+/-------------------------------------------------------------------------/
+/
+/  Each volume has a lock word that is taken with LDREX/STREX, so the main
+/  loop and interrupt handlers can access files at the same time (on
+/  different volumes in parallel, on the same volume one after another).
+/
+/  An interrupt handler cannot wait for the code it has interrupted to
+/  release a volume: ff_req_grant() fails at once in that case and the FatFs
+/  function returns FR_TIMEOUT. In thread mode it waits up to _FS_TIMEOUT
+/  calls of ff_timerproc().
+/
+/-------------------------------------------------------------------------*/
+
+#include "chip.h"
+#include "FatFs/ff.h"
+
+
+#if _FS_REENTRANT
+
+/* Lock word of each volume (0: free, 1: taken) */
+static volatile DWORD ffLock[_VOLUMES];
+
+/* Time tick counter (ff_timerproc()) */
+static volatile DWORD ffTicks;
+
+
+
+/*------------------------------------------------------------------------*/
+/* Create a Synchronization Object                                        */
+/*------------------------------------------------------------------------*/
+
+int ff_cre_syncobj (	/* 1:Function succeeded, 0:Could not create */
+	BYTE vol,			/* Corresponding logical drive being processed */
+	_SYNC_t *sobj		/* Pointer to return the created sync object */
+)
+{
+	if (vol >= _VOLUMES) return 0;
+
+	ffLock[vol] = 0;
+	*sobj = &ffLock[vol];
+	return 1;
+}
+
+
+
+/*------------------------------------------------------------------------*/
+/* Delete a Synchronization Object                                        */
+/*------------------------------------------------------------------------*/
+
+int ff_del_syncobj (	/* 1:Function succeeded, 0:Could not delete */
+	_SYNC_t sobj		/* Sync object tied to the logical drive to be deleted */
+)
+{
+	*sobj = 0;
+	return 1;
+}
+
+
+
+/*------------------------------------------------------------------------*/
+/* Request Grant to Access the Volume                                     */
+/*------------------------------------------------------------------------*/
+
+int ff_req_grant (	/* 1:Got a grant to access the volume, 0:Could not get a grant */
+	_SYNC_t sobj	/* Sync object to wait */
+)
+{
+	DWORD start = ffTicks;
+
+
+	for (;;) {
+		if (__LDREXW((volatile uint32_t *)sobj) == 0) {
+			if (__STREXW(1, (volatile uint32_t *)sobj) == 0) {
+				__DMB();
+				return 1;
+			}
+		} else {
+			__CLREX();
+			if (__get_IPSR()) return 0;			/* Owner was interrupted by us */
+			if (ffTicks - start >= _FS_TIMEOUT) return 0;
+		}
+	}
+}
+
+
+
+/*------------------------------------------------------------------------*/
+/* Release Grant to Access the Volume                                     */
+/*------------------------------------------------------------------------*/
+
+void ff_rel_grant (
+	_SYNC_t sobj	/* Sync object to be signaled */
+)
+{
+	__DMB();
+	*sobj = 0;
+}
+
+
+
+/*------------------------------------------------------------------------*/
+/* Time tick of _FS_TIMEOUT, call every 1ms                               */
+/*------------------------------------------------------------------------*/
+
+void ff_timerproc (void)
+{
+	ffTicks++;
+}
+
+#endif
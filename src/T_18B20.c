@@ -11,6 +11,7 @@
 #include <T_18B20.h>
 #include <hardware_delay.h>
 #include <monitor.h>
+#include <data_Manager/crc.h>
 
 Bool DS18B20Init(DS18b20_t* temp)
 {
@@ -121,12 +122,15 @@ POWERTYPE_t DS18B20GetPWRSupplyStatus(void)
 {
 
 }
-
-uint8_t DS18B20CalcAndCompareCRC(uint8_t _crc)
+*/
+Bool DS18B20CalcAndCompareCRC(DS18b20_t* temp)
 {
-
+	/* The CRC over the first 8 scratchpad bytes must match the 9th byte */
+	if (crc8_maxim_calc(0, &temp->ScratchPad_s, offsetof(struct SPAD, CRC)) != temp->ScratchPad_s.CRC)
+		return FALSE;
+	return TRUE;
 }
-*/
+
 Bool DS18B20GetScrachtPadReg(DS18b20_t* temp)
 {
 	if (!OW_reset_pulse()) return FALSE;
@@ -142,7 +146,7 @@ Bool DS18B20GetScrachtPadReg(DS18b20_t* temp)
 	temp->ScratchPad_s.reserved1 	= OW_read_byte();
 	temp->ScratchPad_s.reserved2 	= OW_read_byte();
 	temp->ScratchPad_s.CRC 			= OW_read_byte();
-	return TRUE;
+	return DS18B20CalcAndCompareCRC(temp);
 }
 
 #endif
@@ -27,12 +27,17 @@
 ============================================================================= */
 
 /* _____STANDARD INCLUDES____________________________________________________ */
+#include <string.h>
 
 /* _____PROJECT INCLUDES_____________________________________________________ */
 #include <data_Manager/at45d.h>
 #include <BSP_Waveshare/bsp_waveshare.h>
 
 /* _____LOCAL DEFINITIONS____________________________________________________ */
+#if AT45D_CFG_DMA && (AT45D_CFG_DMA_CH_TX >= WSBOARD_DMA_CH_RESERVED)
+#error "AT45D_CFG_DMA_CH_RX/TX must be reserved GPDMA channels (see WSBOARD_DMA_CH_RESERVED)"
+#endif
+
 /// @name Read commands
 //@{
 #define AT45D_CMD_CONTINUOUS_ARRAY_READ             0xe8
@@ -69,14 +74,153 @@
 /* _____MACROS_______________________________________________________________ */
 #define ATD45D_SSPx		LPC_SSP1
 #define spi_cs_hi() 	Chip_GPIO_SetPinOutHigh(LPC_GPIO, 1, 18 )
-#define spi_cs_lo()  	Chip_GPIO_SetPinOutLow(LPC_GPIO, 1, 18 )
+#define spi_cs_lo()  	do { AT45D_STATS_INC(transactions); Chip_GPIO_SetPinOutLow(LPC_GPIO, 1, 18 ); } while(0)
+
+#if AT45D_CFG_STATS
+#define AT45D_STATS_INC(field)      at45d_stats.field++
+#define AT45D_STATS_ADD(field, n)   at45d_stats.field += (n)
+#else
+#define AT45D_STATS_INC(field)
+#define AT45D_STATS_ADD(field, n)
+#endif
+
+#if AT45D_CFG_DMA
+/// GPDMA request lines of SSP1 (see LPC178x User Manual, DMA connections)
+#define AT45D_DMA_REQ_TX    3
+#define AT45D_DMA_REQ_RX    4
+
+/// Maximum number of bytes per DMA transfer (12-bit transfer size)
+#define AT45D_DMA_SIZE_MAX  4095
+
+/// Blocks smaller than this are transferred by the CPU (DMA setup is not worth it)
+#define AT45D_DMA_SIZE_MIN  16
+
+/// Channel bits in GPDMA interrupt status and clear registers
+#define AT45D_DMA_CH_MASK   ((1 << AT45D_CFG_DMA_CH_RX) | (1 << AT45D_CFG_DMA_CH_TX))
+#endif
 
 /* _____GLOBAL VARIABLES_____________________________________________________ */
 
+/// Alternate between both SRAM buffers for page writes
+#define AT45D_DOUBLE_BUFFER ((AT45D_CFG_DOUBLE_BUFFER != 0) && (AT45D_SRAM_BUFFERS == 2))
+
 /* _____LOCAL VARIABLES______________________________________________________ */
 static bool_t       at45d_ready_flag;
 
+/// Function called while waiting for the DataFlash (NULL = busy-wait)
+static at45d_busy_handler_t at45d_busy_handler;
+
+#if AT45D_CFG_STATS
+/// Driver statistics
+static at45d_stats_t at45d_stats;
+#endif
+
+#if AT45D_DOUBLE_BUFFER
+/// SRAM buffer to use for the next page write (0 = buffer 1, 1 = buffer 2)
+static u8_t         at45d_buf_next;
+#endif
+
+#if AT45D_CFG_DMA
+/// DMA transfer in progress (cleared in at45d_dma_irq())
+static volatile bool_t at45d_dma_busy;
+
+/// Asynchronous transfer: deselect DataFlash and call callback when done
+static bool_t           at45d_dma_async;
+/// Asynchronous transfer started a program (DataFlash busy when deselected)
+static bool_t           at45d_dma_prg;
+/// Function to call when asynchronous transfer is done
+static at45d_callback_t at45d_dma_callback;
+#if AT45D_DOUBLE_BUFFER
+/// Buffer to main memory page program command sent when the asynchronous buffer write is done
+static u8_t             at45d_dma_prg_cmd;
+/// Page to program when the asynchronous buffer write is done
+static u16_t            at45d_dma_prg_page;
+#endif
+/// Transfer completed without DMA errors
+static bool_t           at45d_dma_ok;
+
+/// Remaining data to transmit (NULL = send dummy bytes)
+static const u8_t *     at45d_dma_tx;
+/// Remaining data to receive (NULL = discard received bytes)
+static u8_t *           at45d_dma_rx;
+/// Number of bytes remaining
+static u16_t            at45d_dma_remaining;
+
+/// Dummy byte sent when there is no data to transmit (leaves SRAM buffer bytes unchanged)
+static const u8_t       at45d_dma_dummy_tx = 0xff;
+/// Received bytes are discarded here when there is no receive buffer
+static u8_t             at45d_dma_dummy_rx;
+#endif
+
 /* _____LOCAL FUNCTION DECLARATIONS__________________________________________ */
+/// Wait until DataFlash is not busy
+static void at45d_wait_ready(void);
+
+/**
+    Transfer a page of data into one of the SRAM buffers.
+
+    Bytes outside [start_byte_in_page, start_byte_in_page + nr_of_bytes) are
+    filled with 0xFF so that a program without erase leaves them unchanged.
+    The DataFlash accepts a buffer write while the other buffer is being
+    programmed, so this does not wait for the DataFlash to be ready.
+
+    @param buf                  0 = buffer 1, 1 = buffer 2
+    @param buffer               Data to write
+    @param start_byte_in_page   Offset of first data byte in page
+    @param nr_of_bytes          Number of data bytes
+ */
+static void at45d_buf_wr(u8_t        buf,
+                         const void *buffer,
+                         u16_t       start_byte_in_page,
+                         u16_t       nr_of_bytes);
+
+/**
+    Program an SRAM buffer into a page of main memory.
+
+    Waits for the previous operation to finish before the command is sent, but
+    returns as soon as the program has been started.
+
+    @param cmd      Buffer to main memory page program command
+    @param page     0 to (AT45D_PAGES-1)
+ */
+static void at45d_buf_prg(u8_t cmd, u16_t page);
+
+/**
+    Select DataFlash and send a continuous array read command.
+
+    Waits until the DataFlash is ready first. The number of bytes is clipped
+    to the end of the DataFlash.
+
+    @param address      0 to AT45D_ADR_MAX
+    @param nr_of_bytes  Number of bytes to read
+
+    @return u16_t       Number of bytes to read (0 if address is out of bounds;
+                        DataFlash is not selected)
+ */
+static u16_t at45d_rd_start(at45d_adr_t address, u16_t nr_of_bytes);
+
+#if AT45D_CFG_DMA
+/**
+    Start a DMA transfer between memory and the SSP.
+
+    The DataFlash must already be selected. The caller sets at45d_dma_async,
+    at45d_dma_prg and at45d_dma_callback first.
+
+    @param tx           Data to send (NULL = send dummy bytes)
+    @param rx           Buffer for received data (NULL = discard)
+    @param nr_of_bytes  Number of bytes to transfer
+ */
+static void at45d_dma_xfer(const void *tx, void *rx, u16_t nr_of_bytes);
+
+/// Program both GPDMA channels for the next (up to AT45D_DMA_SIZE_MAX) bytes
+static void at45d_dma_start(void);
+
+/// Wait until DMA transfer has finished
+static void at45d_dma_wait(void);
+
+/// GPDMA interrupt handler of both channels (installed with wsBoard_DMA_Init())
+static void at45d_dma_irq(u8_t ch);
+#endif
 
 /* _____LOCAL FUNCTIONS______________________________________________________ */
 //#if ((AT45D_PAGE_SIZE != 256) && (AT45D_PAGE_SIZE != 264))
@@ -90,6 +234,7 @@ static bool_t       at45d_ready_flag;
 //#endif
 
 static char spi_RW_u8(char data) {
+	AT45D_STATS_INC(bytes);
 	while (!(ATD45D_SSPx->SR & SSP_STAT_TFE));
 	ATD45D_SSPx->DR = data;	// send data
 	while (!(ATD45D_SSPx->SR & SSP_STAT_RNE));
@@ -99,6 +244,15 @@ static char spi_RW_u8(char data) {
 static void spi_wr_data(const void* buf, size_t nr_of_bytes)
 {
 	const u8_t *data_u8 = (u8_t *)buf;
+#if AT45D_CFG_DMA
+	if(nr_of_bytes >= AT45D_DMA_SIZE_MIN)
+	{
+		at45d_dma_async = FALSE;
+		at45d_dma_xfer(buf, NULL, nr_of_bytes);
+		at45d_dma_wait();
+		return;
+	}
+#endif
 	while (nr_of_bytes--)
 	{
 		spi_RW_u8(*data_u8++);
@@ -106,11 +260,37 @@ static void spi_wr_data(const void* buf, size_t nr_of_bytes)
 }
 
 static void spi_rd_data(char* buffer, size_t nr_of_bytes){
+#if AT45D_CFG_DMA
+	if(nr_of_bytes >= AT45D_DMA_SIZE_MIN)
+	{
+		at45d_dma_async = FALSE;
+		at45d_dma_xfer(NULL, buffer, nr_of_bytes);
+		at45d_dma_wait();
+		return;
+	}
+#endif
 	while (nr_of_bytes--){
 		*buffer++ = spi_RW_u8(0);
 	}
 }
 
+static void spi_wr_ff(size_t nr_of_bytes)
+{
+#if AT45D_CFG_DMA
+	if(nr_of_bytes >= AT45D_DMA_SIZE_MIN)
+	{
+		at45d_dma_async = FALSE;
+		at45d_dma_xfer(NULL, NULL, nr_of_bytes);
+		at45d_dma_wait();
+		return;
+	}
+#endif
+	while (nr_of_bytes--)
+	{
+		spi_RW_u8(0xff);
+	}
+}
+
 
 static void at45d_tx_adr(u16_t page, u16_t start_byte_in_page)
 {
@@ -125,57 +305,87 @@ static void at45d_tx_adr(u16_t page, u16_t start_byte_in_page)
 #endif
 }
 
-/* _____GLOBAL FUNCTIONS_____________________________________________________ */
-void at45d_init(spi_handle_t handle)
+static void at45d_wait_ready(void)
 {
-//	Chip_Clock_SetPCLKDiv(SYSCTL_CLOCK_SSP1, SYSCTL_CLKDIV_1);
-//	Board_SSP_Init(LPC_SSP1);
-//	Chip_SSP_Init(LPC_SSP1);
-//	Chip_SSP_SetMaster(LPC_SSP1, TRUE);
-//	Chip_SSP_SetBitRate(LPC_SSP1, AT45D_MAX_SPI_CLOCK_HZ);
-//	Chip_SSP_Enable(LPC_SSP1);
-
-//	LPC_SYSCTL->PCLKSEL[0] |= (SYSCTL_CLKDIV_1 << 20);
-//	LPC_SYSCTL->PCONP |= _BIT(SYSCTL_CLOCK_SSP1);
-//	LPC_SSP1->CPSR |= 2; /* CPSDVSR=2 */
-//	LPC_SSP1->CR0 |= 0x0007; /* Set mode: SPI mode 0, 8-bit */
-//	LPC_SSP1->CR1 |= 0x2; /* Enable SSP with Master */
-//	LPC_SSP1->CR0 |= ((SystemCoreClock/(2*AT45D_MAX_SPI_CLOCK_HZ))-1)<<8;
+    // (at45d_ready() is also FALSE while a DMA transfer is busy)
+    if(at45d_ready())
+    {
+        return;
+    }
+    AT45D_STATS_INC(waits);
 
-	/*
-	 * Must be initialized in Main function calling Board_SSP_INit
-	 */
-	Chip_GPIO_SetPinDIROutput(LPC_GPIO1, 1, 18);
+    while(!at45d_ready())
+    {
+        if(at45d_busy_handler != NULL)
+        {
+            at45d_busy_handler();
+        }
+    }
 }
 
-void at45d_power_down(void)
+static void at45d_buf_wr(u8_t        buf,
+                         const void *buffer,
+                         u16_t       start_byte_in_page,
+                         u16_t       nr_of_bytes)
 {
+#if AT45D_CFG_DMA
+    // Wait until asynchronous transfer has finished
+    at45d_dma_wait();
+#endif
+
+    // Clip data to page
+    if(start_byte_in_page > AT45D_PAGE_SIZE)
+    {
+        start_byte_in_page = AT45D_PAGE_SIZE;
+    }
+    if(nr_of_bytes > AT45D_PAGE_SIZE - start_byte_in_page)
+    {
+        nr_of_bytes = AT45D_PAGE_SIZE - start_byte_in_page;
+    }
 
     // Select DataFlash
     spi_cs_lo();
 
     // Send command
-    spi_RW_u8(AT45D_CMD_MAIN_POWER_DOWN);
+    spi_RW_u8((buf == 0) ? AT45D_CMD_BUFFER1_WRITE : AT45D_CMD_BUFFER2_WRITE);
+
+    // Send start byte in buffer
+    spi_RW_u8(0x00);
+    spi_RW_u8(0x00);
+    spi_RW_u8(0x00);
+
+    // Fill buffer with data to be written (other bytes are 0xFF to leave them unchanged)
+    spi_wr_ff(start_byte_in_page);
+    spi_wr_data(buffer, nr_of_bytes);
+    spi_wr_ff(AT45D_PAGE_SIZE - start_byte_in_page - nr_of_bytes);
 
     // Deselect DataFlash
     spi_cs_hi();
 }
 
-void at45d_resume_from_power_down(void)
+static void at45d_buf_prg(u8_t cmd, u16_t page)
 {
+    // Wait until previous program (from the other buffer) has finished
+    at45d_wait_ready();
+
     // Select DataFlash
     spi_cs_lo();
 
     // Send command
-    spi_RW_u8(AT45D_CMD_MAIN_RESUME_FROM_POWER_DOWN);
+    spi_RW_u8(cmd);
+
+    // Send address
+    at45d_tx_adr(page, 0);
 
     // Deselect DataFlash
     spi_cs_hi();
+
+    // Set flag to busy
+    at45d_ready_flag = FALSE;
+    AT45D_STATS_INC(programs);
 }
 
-u16_t at45d_rd(void       *buffer,
-               at45d_adr_t address,
-               u16_t       nr_of_bytes)
+static u16_t at45d_rd_start(at45d_adr_t address, u16_t nr_of_bytes)
 {
     at45d_adr_t max_bytes_to_read;
     u16_t       page;
@@ -195,10 +405,7 @@ u16_t at45d_rd(void       *buffer,
     }
 
     // Wait until DataFlash is not busy
-    while(!at45d_ready())
-    {
-        ;
-    }
+    at45d_wait_ready();
 
     // Select DataFlash
     spi_cs_lo();
@@ -224,6 +431,171 @@ u16_t at45d_rd(void       *buffer,
     spi_RW_u8(0x00);
     spi_RW_u8(0x00);
 
+    return nr_of_bytes;
+}
+
+#if AT45D_CFG_DMA
+static void at45d_dma_xfer(const void *tx, void *rx, u16_t nr_of_bytes)
+{
+    at45d_dma_tx        = (const u8_t *)tx;
+    at45d_dma_rx        = (u8_t *)rx;
+    at45d_dma_remaining = nr_of_bytes;
+    at45d_dma_ok        = TRUE;
+    at45d_dma_busy      = TRUE;
+    AT45D_STATS_ADD(bytes,     nr_of_bytes);
+    AT45D_STATS_ADD(bytes_dma, nr_of_bytes);
+
+    at45d_dma_start();
+}
+
+static void at45d_dma_start(void)
+{
+    u16_t nr_of_bytes = at45d_dma_remaining;
+
+    if(nr_of_bytes > AT45D_DMA_SIZE_MAX)
+    {
+        nr_of_bytes = AT45D_DMA_SIZE_MAX;
+    }
+
+    // Clear stale interrupt flags of both channels
+    LPC_GPDMA->INTTCCLEAR = AT45D_DMA_CH_MASK;
+    LPC_GPDMA->INTERRCLR  = AT45D_DMA_CH_MASK;
+
+    // Receive channel: SSP to memory (terminal count interrupt when done)
+    LPC_GPDMA->CH[AT45D_CFG_DMA_CH_RX].SRCADDR  = (u32_t)&ATD45D_SSPx->DR;
+    LPC_GPDMA->CH[AT45D_CFG_DMA_CH_RX].DESTADDR = (at45d_dma_rx != NULL) ? (u32_t)at45d_dma_rx
+                                                                         : (u32_t)&at45d_dma_dummy_rx;
+    LPC_GPDMA->CH[AT45D_CFG_DMA_CH_RX].LLI      = 0;
+    LPC_GPDMA->CH[AT45D_CFG_DMA_CH_RX].CONTROL  =   GPDMA_DMACCxControl_TransferSize(nr_of_bytes)
+                                                  | GPDMA_DMACCxControl_SBSize(GPDMA_BSIZE_4)
+                                                  | GPDMA_DMACCxControl_DBSize(GPDMA_BSIZE_4)
+                                                  | GPDMA_DMACCxControl_SWidth(GPDMA_WIDTH_BYTE)
+                                                  | GPDMA_DMACCxControl_DWidth(GPDMA_WIDTH_BYTE)
+                                                  | ((at45d_dma_rx != NULL) ? GPDMA_DMACCxControl_DI : 0)
+                                                  | GPDMA_DMACCxControl_I;
+    LPC_GPDMA->CH[AT45D_CFG_DMA_CH_RX].CONFIG   =   GPDMA_DMACCxConfig_E
+                                                  | GPDMA_DMACCxConfig_SrcPeripheral(AT45D_DMA_REQ_RX)
+                                                  | GPDMA_DMACCxConfig_TransferType(GPDMA_TRANSFERTYPE_P2M_CONTROLLER_DMA)
+                                                  | GPDMA_DMACCxConfig_IE
+                                                  | GPDMA_DMACCxConfig_ITC;
+
+    // Transmit channel: memory to SSP (started last so that no byte is missed)
+    LPC_GPDMA->CH[AT45D_CFG_DMA_CH_TX].SRCADDR  = (at45d_dma_tx != NULL) ? (u32_t)at45d_dma_tx
+                                                                         : (u32_t)&at45d_dma_dummy_tx;
+    LPC_GPDMA->CH[AT45D_CFG_DMA_CH_TX].DESTADDR = (u32_t)&ATD45D_SSPx->DR;
+    LPC_GPDMA->CH[AT45D_CFG_DMA_CH_TX].LLI      = 0;
+    LPC_GPDMA->CH[AT45D_CFG_DMA_CH_TX].CONTROL  =   GPDMA_DMACCxControl_TransferSize(nr_of_bytes)
+                                                  | GPDMA_DMACCxControl_SBSize(GPDMA_BSIZE_4)
+                                                  | GPDMA_DMACCxControl_DBSize(GPDMA_BSIZE_4)
+                                                  | GPDMA_DMACCxControl_SWidth(GPDMA_WIDTH_BYTE)
+                                                  | GPDMA_DMACCxControl_DWidth(GPDMA_WIDTH_BYTE)
+                                                  | ((at45d_dma_tx != NULL) ? GPDMA_DMACCxControl_SI : 0);
+    LPC_GPDMA->CH[AT45D_CFG_DMA_CH_TX].CONFIG   =   GPDMA_DMACCxConfig_E
+                                                  | GPDMA_DMACCxConfig_DestPeripheral(AT45D_DMA_REQ_TX)
+                                                  | GPDMA_DMACCxConfig_TransferType(GPDMA_TRANSFERTYPE_M2P_CONTROLLER_DMA)
+                                                  | GPDMA_DMACCxConfig_IE;
+
+    // Advance to next block
+    if(at45d_dma_tx != NULL)
+    {
+        at45d_dma_tx += nr_of_bytes;
+    }
+    if(at45d_dma_rx != NULL)
+    {
+        at45d_dma_rx += nr_of_bytes;
+    }
+    at45d_dma_remaining -= nr_of_bytes;
+}
+
+static void at45d_dma_wait(void)
+{
+    // Wait for at45d_dma_irq() to finish transfer
+    while(at45d_dma_busy)
+    {
+        ;
+    }
+}
+#endif
+
+/* _____GLOBAL FUNCTIONS_____________________________________________________ */
+void at45d_init(spi_handle_t handle)
+{
+//	Chip_Clock_SetPCLKDiv(SYSCTL_CLOCK_SSP1, SYSCTL_CLKDIV_1);
+//	Board_SSP_Init(LPC_SSP1);
+//	Chip_SSP_Init(LPC_SSP1);
+//	Chip_SSP_SetMaster(LPC_SSP1, TRUE);
+//	Chip_SSP_SetBitRate(LPC_SSP1, AT45D_MAX_SPI_CLOCK_HZ);
+//	Chip_SSP_Enable(LPC_SSP1);
+
+//	LPC_SYSCTL->PCLKSEL[0] |= (SYSCTL_CLKDIV_1 << 20);
+//	LPC_SYSCTL->PCONP |= _BIT(SYSCTL_CLOCK_SSP1);
+//	LPC_SSP1->CPSR |= 2; /* CPSDVSR=2 */
+//	LPC_SSP1->CR0 |= 0x0007; /* Set mode: SPI mode 0, 8-bit */
+//	LPC_SSP1->CR1 |= 0x2; /* Enable SSP with Master */
+//	LPC_SSP1->CR0 |= ((SystemCoreClock/(2*AT45D_MAX_SPI_CLOCK_HZ))-1)<<8;
+
+	/*
+	 * Must be initialized in Main function calling Board_SSP_INit
+	 */
+	Chip_GPIO_SetPinDIROutput(LPC_GPIO1, 1, 18);
+
+#if AT45D_CFG_STATS
+    at45d_reset_stats();
+#endif
+
+#if AT45D_CFG_DMA
+    // Enable GPDMA controller and SSP DMA requests
+    wsBoard_DMA_Init(AT45D_CFG_DMA_CH_RX, at45d_dma_irq);
+    wsBoard_DMA_Init(AT45D_CFG_DMA_CH_TX, at45d_dma_irq);
+    Chip_SSP_DMA_Enable(ATD45D_SSPx);
+#endif
+}
+
+void at45d_power_down(void)
+{
+#if AT45D_CFG_DMA
+    // Wait until asynchronous transfer has finished
+    at45d_dma_wait();
+#endif
+
+    // Select DataFlash
+    spi_cs_lo();
+
+    // Send command
+    spi_RW_u8(AT45D_CMD_MAIN_POWER_DOWN);
+
+    // Deselect DataFlash
+    spi_cs_hi();
+}
+
+void at45d_resume_from_power_down(void)
+{
+#if AT45D_CFG_DMA
+    // Wait until asynchronous transfer has finished
+    at45d_dma_wait();
+#endif
+
+    // Select DataFlash
+    spi_cs_lo();
+
+    // Send command
+    spi_RW_u8(AT45D_CMD_MAIN_RESUME_FROM_POWER_DOWN);
+
+    // Deselect DataFlash
+    spi_cs_hi();
+}
+
+u16_t at45d_rd(void       *buffer,
+               at45d_adr_t address,
+               u16_t       nr_of_bytes)
+{
+    // Select DataFlash and send read command
+    nr_of_bytes = at45d_rd_start(address, nr_of_bytes);
+    if(nr_of_bytes == 0)
+    {
+        return 0;
+    }
+
     // Read data
     spi_rd_data(buffer, nr_of_bytes);
 
@@ -233,14 +605,40 @@ u16_t at45d_rd(void       *buffer,
     return nr_of_bytes;
 }
 
-void at45d_rd_page(void* buffer, u16_t page)
+#if AT45D_CFG_DMA
+u16_t at45d_rd_async(void            *buffer,
+                     at45d_adr_t      address,
+                     u16_t            nr_of_bytes,
+                     at45d_callback_t callback)
 {
-    // Wait until DataFlash is not busy
-    while(!at45d_ready())
+    // Previous asynchronous transfer still busy?
+    if(at45d_dma_busy)
     {
-        ;
+        return 0;
     }
 
+    // Select DataFlash and send read command
+    nr_of_bytes = at45d_rd_start(address, nr_of_bytes);
+    if(nr_of_bytes == 0)
+    {
+        return 0;
+    }
+
+    // Read data (DataFlash is deselected in at45d_dma_irq())
+    at45d_dma_async    = TRUE;
+    at45d_dma_prg      = FALSE;
+    at45d_dma_callback = callback;
+    at45d_dma_xfer(NULL, buffer, nr_of_bytes);
+
+    return nr_of_bytes;
+}
+#endif
+
+void at45d_rd_page(void* buffer, u16_t page)
+{
+    // Wait until DataFlash is not busy
+    at45d_wait_ready();
+
     // Select DataFlash
     spi_cs_lo();
 
@@ -269,10 +667,7 @@ void at45d_rd_page_offset(void *buffer,
                           u16_t nr_of_bytes)
 {
     // Wait until DataFlash is not busy
-    while(!at45d_ready())
-    {
-        ;
-    }
+    at45d_wait_ready();
 
     // Select DataFlash
     spi_cs_lo();
@@ -298,11 +693,22 @@ void at45d_rd_page_offset(void *buffer,
 
 void at45d_wr_page(const void* buffer, u16_t page)
 {
+#if AT45D_DOUBLE_BUFFER
+    u8_t buf = at45d_buf_next;
+
+    // Use the other buffer next time
+    at45d_buf_next ^= 1;
+
+    // Transfer data while the other buffer may still be programming
+    at45d_buf_wr(buf, buffer, 0, AT45D_PAGE_SIZE);
+
+    // Start program of buffer (with built-in erase)
+    at45d_buf_prg((buf == 0) ? AT45D_CMD_BUF1_TO_MAIN_PAGE_PRG_W_ERASE
+                             : AT45D_CMD_BUF2_TO_MAIN_PAGE_PRG_W_ERASE,
+                  page);
+#else
     // Wait until DataFlash is not busy
-    while(!at45d_ready())
-    {
-        ;
-    }
+    at45d_wait_ready();
 
     // Select DataFlash
     spi_cs_lo();
@@ -314,90 +720,109 @@ void at45d_wr_page(const void* buffer, u16_t page)
     at45d_tx_adr(page, 0);
 
     // Send data to be written
-    spi_wr_data(buffer, (u8_t)AT45D_PAGE_SIZE);
+    spi_wr_data(buffer, AT45D_PAGE_SIZE);
 
     // Deselect DataFlash
     spi_cs_hi();
 
     // Set flag to busy
     at45d_ready_flag = FALSE;
+    AT45D_STATS_INC(programs);
+#endif
 }
 
-void at45d_wr_page_offset(const void* buffer,
-                          u16_t       page,
-                          u16_t       start_byte_in_page,
-                          u16_t       nr_of_bytes)
+#if AT45D_CFG_DMA
+bool_t at45d_wr_page_async(const void      *buffer,
+                           u16_t            page,
+                           at45d_callback_t callback)
 {
-    u16_t i;
-    u8_t *bufffer_u8 = (u8_t *)buffer;
+#if AT45D_DOUBLE_BUFFER
+    u8_t buf;
+#endif
 
-    // Wait until DataFlash is not busy
-    while(!at45d_ready())
+    // Previous asynchronous transfer still busy?
+    if(at45d_dma_busy)
     {
-        ;
-    }   
+        return FALSE;
+    }
+
+    // Wait until DataFlash is not busy (the program is started from at45d_dma_irq(), which can not wait)
+    at45d_wait_ready();
+
+#if AT45D_DOUBLE_BUFFER
+    buf = at45d_buf_next;
+
+    // Use the other buffer next time
+    at45d_buf_next ^= 1;
 
     // Select DataFlash
     spi_cs_lo();
 
     // Send command
-    spi_RW_u8(AT45D_CMD_BUFFER1_WRITE);
+    spi_RW_u8((buf == 0) ? AT45D_CMD_BUFFER1_WRITE : AT45D_CMD_BUFFER2_WRITE);
 
     // Send start byte in buffer
     spi_RW_u8(0x00);
     spi_RW_u8(0x00);
     spi_RW_u8(0x00);
 
-    // Fill buffer with data to be written (other bytes are 0xFF to leave them unchanged)
-    for(i=0; i<AT45D_PAGE_SIZE; i++)
-    {
-        if(  (i >= start_byte_in_page                  )
-           &&(i  < start_byte_in_page + nr_of_bytes)  )
-        {
-        	spi_RW_u8(*bufffer_u8++);
-        }
-        else
-        {
-            // Leave unchanged
-        	spi_RW_u8(0xff);
-        }
-    }
-
-    // Deselect DataFlash
-    spi_cs_hi();
-
-    // Set flag to busy
-    at45d_ready_flag = FALSE;
-
-    // Wait until DataFlash is not busy
-    while(!at45d_ready())
-    {
-        ;
-    }
-
+    // Program of buffer (with built-in erase) is started in at45d_dma_irq()
+    at45d_dma_prg_cmd  = (buf == 0) ? AT45D_CMD_BUF1_TO_MAIN_PAGE_PRG_W_ERASE
+                                    : AT45D_CMD_BUF2_TO_MAIN_PAGE_PRG_W_ERASE;
+    at45d_dma_prg_page = page;
+#else
     // Select DataFlash
     spi_cs_lo();
 
     // Send command
-    spi_RW_u8(AT45D_CMD_BUF1_TO_MAIN_PAGE_PRG_W_ERASE);
+    spi_RW_u8((u8_t)AT45D_CMD_MAIN_MEM_PROG_THROUGH_BUF1);
 
     // Send address
-    at45d_tx_adr(page, 0);    
+    at45d_tx_adr(page, 0);
+#endif
 
-    // Deselect DataFlash
-    spi_cs_hi();
+    // Send data to be written (program starts in at45d_dma_irq())
+    at45d_dma_async    = TRUE;
+    at45d_dma_prg      = TRUE;
+    at45d_dma_callback = callback;
+    at45d_dma_xfer(buffer, NULL, AT45D_PAGE_SIZE);
 
-    // Set flag to busy
-    at45d_ready_flag = FALSE;
+    return TRUE;
+}
+#endif
+
+void at45d_wr_page_offset(const void* buffer,
+                          u16_t       page,
+                          u16_t       start_byte_in_page,
+                          u16_t       nr_of_bytes)
+{
+    u8_t buf;
+
+#if AT45D_DOUBLE_BUFFER
+    buf = at45d_buf_next;
+
+    // Use the other buffer next time
+    at45d_buf_next ^= 1;
+#else
+    buf = 0;
+
+    // Wait until buffer 1 is not in use anymore
+    at45d_wait_ready();
+#endif
+
+    // Transfer data (other bytes are 0xFF)
+    at45d_buf_wr(buf, buffer, start_byte_in_page, nr_of_bytes);
+
+    // Start program of buffer (without erase so that 0xFF bytes leave page unchanged)
+    at45d_buf_prg((buf == 0) ? AT45D_CMD_BUF1_TO_MAIN_PAGE_PRG_WO_ERASE
+                             : AT45D_CMD_BUF2_TO_MAIN_PAGE_PRG_WO_ERASE,
+                  page);
 }
 
 void at45d_erase_page(u16_t page)
 {
     // Wait until DataFlash is not busy
-    while(!at45d_ready())
-    {
-        ;
-    }
+    at45d_wait_ready();
     // Select DataFlash
     spi_cs_lo();
 
@@ -412,12 +837,21 @@ void at45d_erase_page(u16_t page)
 
     // Set flag to busy
     at45d_ready_flag = FALSE;
+    AT45D_STATS_INC(erases);
 }
 
 bool_t at45d_ready(void)
 {
     u8_t data;
 
+#if AT45D_CFG_DMA
+    // DMA transfer still busy?
+    if(at45d_dma_busy)
+    {
+        return FALSE;
+    }
+#endif
+
     // If flag has already been set, then take short cut
     if(at45d_ready_flag)
     {
@@ -436,10 +870,28 @@ bool_t at45d_ready(void)
     }
     else
     {
+        AT45D_STATS_INC(busy_polls);
         return FALSE;
     }
 }
 
+void at45d_set_busy_handler(at45d_busy_handler_t handler)
+{
+    at45d_busy_handler = handler;
+}
+
+#if AT45D_CFG_STATS
+void at45d_get_stats(at45d_stats_t *stats)
+{
+    *stats = at45d_stats;
+}
+
+void at45d_reset_stats(void)
+{
+    memset(&at45d_stats, 0, sizeof(at45d_stats));
+}
+#endif
+
 u8_t at45d_get_status(void)
 {
     u8_t data;
@@ -483,10 +935,7 @@ bool_t at45d_set_page_size_to_pwr_of_two(void)
     }
 
     // Wait until DataFlash is not busy
-    while(!at45d_ready())
-    {
-        ;
-    }
+    at45d_wait_ready();
 
     // Select DataFlash
     spi_cs_lo();
@@ -501,10 +950,82 @@ bool_t at45d_set_page_size_to_pwr_of_two(void)
     spi_cs_hi();
 
     // Wait until DataFlash is not busy
-    while(!at45d_ready())
+    at45d_wait_ready();
+
+    return TRUE;
+}
+
+#if AT45D_CFG_DMA
+static void at45d_dma_irq(u8_t ch)
+{
+    u32_t            stat_tc  = LPC_GPDMA->INTTCSTAT  & AT45D_DMA_CH_MASK;
+    u32_t            stat_err = LPC_GPDMA->INTERRSTAT & AT45D_DMA_CH_MASK;
+    at45d_callback_t callback;
+
+    // Both channels are handled together
+    (void)ch;
+
+    // Clear interrupt flags
+    LPC_GPDMA->INTTCCLEAR = stat_tc;
+    LPC_GPDMA->INTERRCLR  = stat_err;
+
+    if(stat_err != 0)
     {
-        ;
+        // Abort transfer
+        LPC_GPDMA->CH[AT45D_CFG_DMA_CH_RX].CONFIG = 0;
+        LPC_GPDMA->CH[AT45D_CFG_DMA_CH_TX].CONFIG = 0;
+        at45d_dma_remaining = 0;
+        at45d_dma_ok        = FALSE;
+    }
+    else if((stat_tc & (1 << AT45D_CFG_DMA_CH_RX)) == 0)
+    {
+        // Not finished yet (last byte has not been received)
+        return;
+    }
+    else if(at45d_dma_remaining != 0)
+    {
+        // Continue with next block
+        at45d_dma_start();
+        return;
     }
 
-    return TRUE;
+    if(at45d_dma_async)
+    {
+        // Deselect DataFlash
+        spi_cs_hi();
+
+#if AT45D_DOUBLE_BUFFER
+        // Start program of the SRAM buffer (DataFlash was ready before the buffer write)
+        if(at45d_dma_prg && at45d_dma_ok)
+        {
+            spi_cs_lo();
+            spi_RW_u8(at45d_dma_prg_cmd);
+            at45d_tx_adr(at45d_dma_prg_page, 0);
+            spi_cs_hi();
+        }
+        else
+        {
+            // Do not program an incomplete buffer
+            at45d_dma_prg = FALSE;
+        }
+#endif
+
+        // Program started?
+        if(at45d_dma_prg)
+        {
+            // Set flag to busy
+            at45d_ready_flag = FALSE;
+            AT45D_STATS_INC(programs);
+        }
+    }
+
+    // Transfer finished (a new one may be started from the callback)
+    callback       = at45d_dma_async ? at45d_dma_callback : NULL;
+    at45d_dma_busy = FALSE;
+
+    if(callback != NULL)
+    {
+        callback(at45d_dma_ok);
+    }
 }
+#endif
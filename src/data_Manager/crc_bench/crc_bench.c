@@ -0,0 +1,154 @@
+/**
+ * crc_bench: Compares the CRC calculation methods of data_Manager/crc.c
+ * (CRC_CFG_METHOD), for results and speed.
+ *
+ * Host tool, not part of the firmware. crc.c is built once per method
+ * (crc_bitwise.c, crc_table.c, crc_slice4.c); the bitwise build is the
+ * reference.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "defines.h"
+
+#define BUF_SIZE            1024
+#define MAX_LEN             600
+#define BENCH_BYTES         (64UL << 20)
+
+#define NR_OF_METHODS       3
+
+#define CRC_DECLARE(m) \
+  u8_t crc8_calc_##m(u8_t crc, const void *data, size_t nr_of_bytes); \
+  u8_t crc8_maxim_calc_##m(u8_t crc, const void *data, size_t nr_of_bytes); \
+  u16_t crc16_ccitt_calc_##m(u16_t crc, const void *data, size_t nr_of_bytes); \
+  u16_t crc16_ccitt_rev_calc_##m(u16_t crc, const void *data, size_t nr_of_bytes); \
+  u32_t crc32_calc_##m(u32_t crc, const void *data, size_t nr_of_bytes);
+
+CRC_DECLARE(bitwise)
+CRC_DECLARE(table)
+CRC_DECLARE(slice4)
+
+/* All CRCs are called through one type; the result is widened to u32_t */
+typedef u32_t (*crc_fn_t)(u32_t crc, const void *data, size_t nr_of_bytes);
+
+#define CRC_WRAP(fn, type) \
+  static u32_t fn##_w(u32_t crc, const void *data, size_t nr_of_bytes) \
+  { return fn((type)crc, data, nr_of_bytes); }
+
+#define CRC_WRAP_METHOD(m) \
+  CRC_WRAP(crc8_calc_##m, u8_t) \
+  CRC_WRAP(crc8_maxim_calc_##m, u8_t) \
+  CRC_WRAP(crc16_ccitt_calc_##m, u16_t) \
+  CRC_WRAP(crc16_ccitt_rev_calc_##m, u16_t) \
+  CRC_WRAP(crc32_calc_##m, u32_t)
+
+CRC_WRAP_METHOD(bitwise)
+CRC_WRAP_METHOD(table)
+CRC_WRAP_METHOD(slice4)
+
+struct crc {
+  const char *name;
+  u32_t init;
+  u32_t check;              /* CRC of "123456789" from init, no final XOR */
+  crc_fn_t fn[NR_OF_METHODS];
+};
+
+#define CRC_ENTRY(name, fn, init, check) \
+  { name, init, check, { fn##_bitwise_w, fn##_table_w, fn##_slice4_w } }
+
+static const struct crc crcs[] = {
+  CRC_ENTRY("crc8",          crc8_calc,            0xff,       0),
+  CRC_ENTRY("crc8_maxim",    crc8_maxim_calc,      0x00,       0xa1),
+  CRC_ENTRY("crc16_ccitt",   crc16_ccitt_calc,     0xffff,     0x29b1),
+  CRC_ENTRY("crc16_ccitt_rev", crc16_ccitt_rev_calc, 0x6363,   0xbf05),
+  CRC_ENTRY("crc32",         crc32_calc,           0xffffffff, 0xcbf43926 ^ 0xffffffff),
+};
+
+static const char *method_names[NR_OF_METHODS] = { "bitwise", "table", "slice4" };
+
+static u32_t sink;
+
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Checks the known check values and all methods against bitwise */
+static int check(const u8_t *buf)
+{
+  unsigned c;
+  int m, ofs, len;
+  u32_t ref;
+
+  for (c = 0; c < sizeof(crcs) / sizeof(crcs[0]); c++) {
+    /* crc8 (0x4D reflected, init 0xFF) has no published check value */
+    if (crcs[c].check != 0 && crcs[c].fn[0](crcs[c].init, "123456789", 9) != crcs[c].check) {
+      printf("%s: check value differs\n", crcs[c].name);
+      return 0;
+    }
+    for (ofs = 0; ofs < 4; ofs++) {
+      for (len = 0; len <= MAX_LEN; len++) {
+        ref = crcs[c].fn[0](crcs[c].init, buf + ofs, len);
+        for (m = 1; m < NR_OF_METHODS; m++) {
+          if (crcs[c].fn[m](crcs[c].init, buf + ofs, len) != ref) {
+            printf("%s %s differs: offset %d, length %d\n", crcs[c].name, method_names[m], ofs, len);
+            return 0;
+          }
+        }
+      }
+    }
+  }
+  return 1;
+}
+
+static double bench(crc_fn_t fn, u32_t init, const u8_t *buf, int len)
+{
+  unsigned long n, loops = BENCH_BYTES / len;
+  double t;
+
+  t = now();
+  for (n = 0; n < loops; n++) {
+    sink += fn(init, buf, len);
+  }
+  t = now() - t;
+  return t / loops / len * 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+  /* log_fs record, AT45D page, SD data block */
+  static const int lens[] = { 16, 264, 512 };
+  static u32_t buf_words[BUF_SIZE / 4];
+  u8_t *buf = (u8_t *)buf_words;
+  unsigned c, i;
+  int m;
+
+  (void)argc;
+  (void)argv;
+
+  for (i = 0; i < BUF_SIZE; i++) {
+    buf[i] = (u8_t)rand();
+  }
+  if (!check(buf)) {
+    return 1;
+  }
+  printf("Results equal for all methods, offsets 0..3 and lengths 0..%d\n", MAX_LEN);
+
+  for (i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+    printf("%d bytes (ns/byte):    bitwise    table   slice4\n", lens[i]);
+    for (c = 0; c < sizeof(crcs) / sizeof(crcs[0]); c++) {
+      printf("  %-16s", crcs[c].name);
+      for (m = 0; m < NR_OF_METHODS; m++) {
+        printf(" %8.2f", bench(crcs[c].fn[m], crcs[c].init, buf, lens[i]));
+      }
+      printf("\n");
+    }
+  }
+  return sink == 0x12345678UL;
+}
@@ -0,0 +1,16 @@
+/**
+ * crc_bench: data_Manager/crc.c built with CRC_METHOD_BITWISE, the functions
+ * renamed with the suffix _bitwise.
+ *
+ * Host tool, not part of the firmware.
+ */
+
+#define CRC_CFG_METHOD          CRC_METHOD_BITWISE
+
+#define crc8_calc               crc8_calc_bitwise
+#define crc8_maxim_calc         crc8_maxim_calc_bitwise
+#define crc16_ccitt_calc        crc16_ccitt_calc_bitwise
+#define crc16_ccitt_rev_calc    crc16_ccitt_rev_calc_bitwise
+#define crc32_calc              crc32_calc_bitwise
+
+#include "../crc.c"
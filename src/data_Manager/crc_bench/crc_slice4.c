@@ -0,0 +1,16 @@
+/**
+ * crc_bench: data_Manager/crc.c built with CRC_METHOD_SLICE4, the functions
+ * renamed with the suffix _slice4.
+ *
+ * Host tool, not part of the firmware.
+ */
+
+#define CRC_CFG_METHOD          CRC_METHOD_SLICE4
+
+#define crc8_calc               crc8_calc_slice4
+#define crc8_maxim_calc         crc8_maxim_calc_slice4
+#define crc16_ccitt_calc        crc16_ccitt_calc_slice4
+#define crc16_ccitt_rev_calc    crc16_ccitt_rev_calc_slice4
+#define crc32_calc              crc32_calc_slice4
+
+#include "../crc.c"
@@ -33,6 +33,7 @@
 /* _____PROJECT INCLUDES_____________________________________________________ */
 #include "data_Manager/log_fs.h"
 #include "data_Manager/at45d.h"
+#include "data_Manager/crc.h"
 
 #include "data_Manager/dbg.h"
 DBG_DECL_NAME("log_fs")
@@ -60,6 +61,14 @@ DBG_DECL_NAME("log_fs")
 /// Last record offset
 #define LOG_FS_REC_OFFSET_LAST  (sizeof(log_fs_page_header_t) + (LOG_FS_RECORDS_PER_PAGE-1) * sizeof(log_fs_rec_block_t))
 
+#if LOG_FS_CFG_REC_VAR_SIZE
+/// End of record space in a page (also used as "no record" offset)
+#define LOG_FS_REC_OFFSET_END   LOG_FS_CFG_PAGE_SIZE
+#else
+/// End of record space in a page (also used as "no record" offset)
+#define LOG_FS_REC_OFFSET_END   (LOG_FS_REC_OFFSET_LAST + sizeof(log_fs_rec_block_t))
+#endif
+
 /// Marker size definition
 typedef u8_t log_fs_marker_t;
 
@@ -71,6 +80,42 @@ typedef u8_t log_fs_marker_t;
 #define LOG_FS_MARKER_BAD       0x00 /* 0000 0000b */
 //@}
 
+/// Number of pages managed by the file system
+#define LOG_FS_PAGES            (LOG_FS_CFG_PAGE_END - LOG_FS_CFG_PAGE_START + 1)
+
+/// Window of newest circular file is moved forward when it wraps
+#define LOG_FS_WINDOW_ROTATE    (   LOG_FS_CFG_WINDOW_ROTATE                        \
+                                 && (LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_CIRCULAR)   \
+                                 && (LOG_FS_CFG_MAX_PAGES > 1                   )   )
+
+#if LOG_FS_CFG_PAGE_INDEX
+/// @name 2-bit page states stored in the RAM index
+//@{
+#define LOG_FS_INDEX_FREE       0
+#define LOG_FS_INDEX_FILE       1
+#define LOG_FS_INDEX_RECORD     2
+#define LOG_FS_INDEX_BAD        3
+//@}
+#endif
+
+#if LOG_FS_CFG_CHECKPOINT
+/// Checkpoint magic number
+#define LOG_FS_CHECKPOINT_MAGIC         0x4c46
+
+/// Checkpoint size (header, RAM index and CRC)
+#define LOG_FS_CHECKPOINT_SIZE          (  sizeof(log_fs_checkpoint_t) \
+                                         + sizeof(log_fs_index_state)  \
+                                         + sizeof(log_fs_index_nr)     \
+                                         + sizeof(u16_t)               )
+
+/// Number of pages in each checkpoint slot
+#define LOG_FS_CHECKPOINT_SLOT_PAGES    UDIV_ROUNDUP(LOG_FS_CHECKPOINT_SIZE, LOG_FS_CFG_PAGE_SIZE)
+
+/// Number of checkpoint slots in the reserved page range (used in turn)
+#define LOG_FS_CHECKPOINT_SLOTS         (  (LOG_FS_CFG_CHECKPOINT_PAGE_END - LOG_FS_CFG_CHECKPOINT_PAGE_START + 1) \
+                                         / LOG_FS_CHECKPOINT_SLOT_PAGES                                          )
+#endif
+
 /// Specification of data address in Serial Flash
 typedef struct
 {
@@ -90,6 +135,9 @@ typedef struct
     log_fs_marker_t marker;     ///< FREE, FILE, RECORD or BAD
     log_fs_nr_t     nr;         ///< Rolling number to find FILE or RECORD start and end
     log_fs_crc_t    crc;        ///< CRC checksum
+#if LOG_FS_CFG_ERASE_CNT
+    u32_t           erase_cnt;  ///< Number of times page has been erased (written directly after erase)
+#endif
 } __attribute__((__packed__)) log_fs_page_header_t;
 
 /// Specification of file info (including CRC) that is stored after a FILE page header
@@ -103,10 +151,42 @@ typedef struct
 typedef struct
 {
     log_fs_marker_t marker;                             ///< Record marker
+#if LOG_FS_CFG_REC_VAR_SIZE
+    u8_t            len;                                ///< Record data length (CRC is stored directly after data)
+#endif
     u8_t            data[LOG_FS_CFG_REC_DATA_SIZE];     ///< Record data content
     log_fs_crc_t    crc;                                ///< CRC checksum
 } __attribute__((__packed__)) log_fs_rec_block_t;
 
+#if LOG_FS_CFG_CHECKPOINT
+/// Specification of checkpoint header that is stored at the start of a checkpoint slot
+typedef struct
+{
+    u16_t                magic;             ///< LOG_FS_CHECKPOINT_MAGIC
+    u32_t                seq;               ///< Sequence number (newest checkpoint has the largest)
+    log_fs_page_t        page_start;        ///< LOG_FS_CFG_PAGE_START when checkpoint was written
+    log_fs_page_t        page_end;          ///< LOG_FS_CFG_PAGE_END when checkpoint was written
+    log_fs_page_t        file_page_first;   ///< Page number of first file
+    log_fs_page_t        file_page_last;    ///< Page number of last file
+    log_fs_nr_t          file_page_nr_next; ///< Next file page number to use
+    log_fs_page_t        file_page_open;    ///< Page number of open file
+    log_fs_page_t        rec_page_first;    ///< First page with records of open file
+    log_fs_page_t        rec_page_last;     ///< Last page with records of open file
+    log_fs_nr_t          rec_page_nr_next;  ///< Next record page number to use
+    log_fs_adr_t         rec_adr_wr;        ///< Next write address of open file
+} __attribute__((__packed__)) log_fs_checkpoint_t;
+#endif
+
+/// Write statistics (reset by log_fs_init())
+typedef struct
+{
+    u32_t                rec_bytes;         ///< Record data bytes written
+    u32_t                prg_bytes;         ///< Bytes programmed
+    u32_t                prg_pages;         ///< Page program operations
+    u32_t                erases;            ///< Page erases
+    u32_t                bad_marked;        ///< Markers overwritten to BAD
+} log_fs_cnt_t;
+
 /// File data and state
 typedef struct
 {
@@ -117,6 +197,7 @@ typedef struct
     log_fs_page_t        file_page_first;   ///< Page number of first file (LOG_FS_PAGE_INVALID if empty)
     log_fs_page_t        file_page_last;    ///< Page number of last file (LOG_FS_PAGE_INVALID if empty)
     log_fs_page_t        file_page_nr_next; ///< Next file page number to use (starts at 0)
+    log_fs_page_t        file_page_open;    ///< Page number of open file (LOG_FS_PAGE_INVALID if none)
 
     log_fs_page_t        rec_page_first;    ///< First page with records (LOG_FS_PAGE_INVALID if empty)
     log_fs_page_t        rec_page_last;     ///< Last page with records (LOG_FS_PAGE_INVALID if empty)
@@ -124,15 +205,68 @@ typedef struct
 
     log_fs_adr_t         rec_adr_rd;        ///< Current read address  (page = LOG_FS_PAGE_INVALID when file is opened)
     log_fs_adr_t         rec_adr_wr;        ///< Next write address (open position)
+
+    log_fs_cnt_t         cnt;               ///< Write statistics
 } log_fs_t;
 
 /* _____MACROS_______________________________________________________________ */
+/// Number of page header bytes that are written with the page marker (erase counter is excluded)
+#define LOG_FS_PAGE_HEADER_WR_SIZE (offsetof(log_fs_page_header_t, crc) + sizeof(log_fs_crc_t))
+
+#if LOG_FS_CFG_REC_VAR_SIZE
+/// Size of a record block with 'len' data bytes on Serial Flash
+#define LOG_FS_REC_SIZE(len)    (offsetof(log_fs_rec_block_t, data) + (len) + sizeof(log_fs_crc_t))
+
+/// Page is full if an empty record block does not fit at the offset
+#define LOG_FS_REC_PAGE_FULL(offset) ((offset) + LOG_FS_REC_SIZE(0) > LOG_FS_REC_OFFSET_END)
+#else
+/// Page is full if the offset is beyond the last record block
+#define LOG_FS_REC_PAGE_FULL(offset) ((offset) > LOG_FS_REC_OFFSET_LAST)
+#endif
+
+/// Number of pages from page 'from' to page 'to' (going forward and wrapping at LOG_FS_CFG_PAGE_END)
+#define LOG_FS_PAGE_DISTANCE(from, to) ((log_fs_page_t)(((to) + LOG_FS_PAGES - (from)) % LOG_FS_PAGES))
 
 /* _____GLOBAL VARIABLES_____________________________________________________ */
 
 /* _____LOCAL VARIABLES______________________________________________________ */
 static log_fs_t log_fs;
 
+/// Buffer used to write a batch of record blocks to a page
+static u8_t     log_fs_rec_buf[LOG_FS_RECORDS_PER_PAGE * sizeof(log_fs_rec_block_t)];
+
+#if LOG_FS_CFG_PAGE_INDEX
+/// Page state of each page (2 bits per page, 4 pages per byte)
+static u8_t        log_fs_index_state[(LOG_FS_PAGES + 3) / 4];
+/// Rolling number of each FILE or RECORD page
+static log_fs_nr_t log_fs_index_nr[LOG_FS_PAGES];
+
+/// Marker value of each 2-bit page state
+static const log_fs_marker_t log_fs_index_marker[4] =
+{
+    LOG_FS_MARKER_FREE,
+    LOG_FS_MARKER_FILE,
+    LOG_FS_MARKER_RECORD,
+    LOG_FS_MARKER_BAD,
+};
+#endif
+
+#if LOG_FS_CFG_CHECKPOINT
+/// Sequence number of newest checkpoint
+static u32_t log_fs_checkpoint_seq;
+/// Slot of newest checkpoint (slots are used in turn)
+static u16_t log_fs_checkpoint_slot;
+/// Number of record pages written since newest checkpoint
+static u16_t log_fs_checkpoint_rec_pages;
+/// Page buffer used to write a checkpoint
+static u8_t  log_fs_checkpoint_buf[LOG_FS_CFG_PAGE_SIZE];
+#endif
+
+#if LOG_FS_WINDOW_ROTATE
+/// Page buffer used to move a FILE page
+static u8_t  log_fs_file_page_buf[LOG_FS_CFG_PAGE_SIZE];
+#endif
+
 /* _____LOCAL FUNCTION DECLARATIONS__________________________________________ */
 /**
     Get next page number.
@@ -297,6 +431,210 @@ static bool_t log_fs_record_block_rd(log_fs_page_t   page,
 static bool_t log_fs_record_block_wr(log_fs_page_t   page,
                                      log_fs_offset_t offset);
 
+#if LOG_FS_CFG_REC_VAR_SIZE
+/**
+    Return the size of the record block at the specified page and offset.
+
+    The marker and length are read. The length of each record block chains it
+    to the next one. The chain ends at a FREE marker, an invalid marker or an 
+    invalid length.
+
+    @param page             Specified page to read from
+    @param offset           Specified offset to read from
+
+    @return log_fs_offset_t Size of record block on Serial Flash or 0 if the 
+                            chain ends at the offset
+ */
+static log_fs_offset_t log_fs_record_size_rd(log_fs_page_t   page,
+                                             log_fs_offset_t offset);
+#endif
+
+/**
+    Return the offset of the record block after the specified one.
+
+    @param page             Record page
+    @param offset           Offset of record block or LOG_FS_REC_OFFSET_END
+
+    @return log_fs_offset_t Offset of next record block or 
+                            LOG_FS_REC_OFFSET_END if the end of the page has
+                            been reached
+ */
+static log_fs_offset_t log_fs_record_offset_next(log_fs_page_t   page,
+                                                 log_fs_offset_t offset);
+
+/**
+    Return the offset of the record block before the specified one.
+
+    @param page             Record page
+    @param offset           Offset of record block or LOG_FS_REC_OFFSET_END
+                            to return the last record block in the page
+
+    @return log_fs_offset_t Offset of previous record block or
+                            LOG_FS_REC_OFFSET_END if the start of the page has
+                            been reached
+ */
+static log_fs_offset_t log_fs_record_offset_previous(log_fs_page_t   page,
+                                                     log_fs_offset_t offset);
+
+/**
+    Find the first FREE record block in the specified page.
+
+    @param page             Record page
+
+    @return log_fs_offset_t Offset of FREE record block or 
+                            LOG_FS_REC_OFFSET_END if page is full
+ */
+static log_fs_offset_t log_fs_record_offset_free(log_fs_page_t page);
+
+/**
+    Write data to the specified page and offset.
+
+    All page writes go through this function so that the write statistics are
+    kept (see log_fs_stats()).
+
+    @param data             Pointer to data
+    @param page             Page to write to
+    @param offset           Offset inside page
+    @param nr_of_bytes      Number of bytes to write
+ */
+static void log_fs_page_wr_offset(const void *    data,
+                                  log_fs_page_t   page,
+                                  log_fs_offset_t offset,
+                                  size_t          nr_of_bytes);
+
+/**
+    Erase the specified page.
+
+    The RAM index (if enabled) is updated to mark the page as FREE. If
+    LOG_FS_CFG_ERASE_CNT is enabled, the page's erase counter is read before
+    the erase and written back incremented.
+
+    @param page             Page to erase
+ */
+static void log_fs_page_erase(log_fs_page_t page);
+
+#if LOG_FS_CFG_ERASE_CNT
+/**
+    Read the erase counter of the specified page.
+
+    @param page             Page to read
+
+    @return u32_t           Erase count (0 if never written)
+ */
+static u32_t log_fs_page_erase_cnt_rd(log_fs_page_t page);
+#endif
+
+#if LOG_FS_CFG_PAGE_INDEX
+/**
+    Update the RAM index entry of the specified page.
+
+    @param page             Page to update
+    @param marker           New page marker (FREE, FILE, RECORD or BAD)
+    @param nr               Rolling number of FILE or RECORD page
+ */
+static void log_fs_index_set(log_fs_page_t   page,
+                             log_fs_marker_t marker,
+                             log_fs_nr_t     nr);
+
+/**
+    Build the RAM index by reading the page header of each page once.
+ */
+static void log_fs_index_build(void);
+#endif
+
+#if LOG_FS_CFG_CHECKPOINT
+/**
+    Write the checkpoint page buffer to the specified page.
+
+    @param page             Page to write to (erased automatically)
+ */
+static void log_fs_checkpoint_page_wr(log_fs_page_t page);
+
+/**
+    Append data to the checkpoint being written.
+
+    Data is collected in a page buffer and a page is written each time the
+    buffer is full.
+
+    @param page             Pointer to page that will be written next
+    @param offset           Pointer to offset in page buffer
+    @param data             Pointer to a buffer containing the data
+    @param nr_of_bytes      Number of bytes to append
+ */
+static void log_fs_checkpoint_data_wr(log_fs_page_t *   page,
+                                      log_fs_offset_t * offset,
+                                      const void *      data,
+                                      size_t            nr_of_bytes);
+
+/**
+    Read the checkpoint header of a checkpoint slot.
+
+    @param slot             Checkpoint slot
+    @param checkpoint       Pointer to buffer for checkpoint header
+
+    @retval TRUE            Checkpoint header is valid for this file system
+    @retval FALSE           No checkpoint in slot
+ */
+static bool_t log_fs_checkpoint_hdr_rd(u16_t                 slot,
+                                       log_fs_checkpoint_t * checkpoint);
+
+/**
+    Read and verify the RAM index of a checkpoint slot.
+
+    @param slot             Checkpoint slot
+    @param checkpoint       Checkpoint header that has already been read
+
+    @retval TRUE            Checkpoint CRC is valid and RAM index restored
+    @retval FALSE           Checkpoint is invalid
+ */
+static bool_t log_fs_checkpoint_index_rd(u16_t                       slot,
+                                         const log_fs_checkpoint_t * checkpoint);
+
+/**
+    Update the RAM index with page headers written after the checkpoint.
+
+    Starting at the specified page, each page header is read and compared
+    with the RAM index. The index is updated until a page is reached (after
+    the start page) that has not changed since the checkpoint was written.
+
+    @param page             Page to start at
+ */
+static void log_fs_checkpoint_roll_forward(log_fs_page_t page);
+
+/**
+    Restore the newest valid checkpoint and roll the RAM index forward.
+
+    @retval TRUE            File system state restored
+    @retval FALSE           No valid checkpoint found
+ */
+static bool_t log_fs_checkpoint_rd(void);
+#endif
+
+/**
+    Get the marker of the page header at the start of the specified page.
+
+    If the RAM index is enabled, the marker and rolling number is fetched from
+    RAM, otherwise the page header is read (see log_fs_page_header_rd()). The
+    marker and rolling number is stored in log_fs.page_header.
+
+    @param page             Specified page
+    
+    @return log_fs_marker_t Marker of page header. BAD if CRC check failed
+ */
+static log_fs_marker_t log_fs_page_header_get(log_fs_page_t page);
+
+/**
+    Get the marker at the start of the specified page.
+
+    If the RAM index is enabled, the marker is fetched from RAM, otherwise it
+    is read (see log_fs_marker_rd()).
+
+    @param page             Specified page
+    
+    @return log_fs_marker_t Marker value
+ */
+static log_fs_marker_t log_fs_page_marker_get(log_fs_page_t page);
+
 /**
     Given the start page of a file, this function calculates the first record 
     page that may be written to (the start boundary). It is the next page.
@@ -317,6 +655,129 @@ static log_fs_page_t log_fs_record_pages_bound_start(void);
  */
 static log_fs_page_t log_fs_record_pages_bound_end(void);
 
+/**
+    Prepare the current record write page by writing a RECORD page header.
+
+    Called before the first record is written to a page. If the page header
+    could not be written, the next page is erased and becomes the write page.
+
+    @retval LOG_FS_ERR_NONE         Page header written
+    @retval LOG_FS_ERR_FULL         File (or file system) is full
+    @retval LOG_FS_ERR_WRITE_FAIL   Failed to write page header
+ */
+static log_fs_err_t log_fs_record_page_start(void);
+
+/**
+    Move the record write address to the next page after the current page
+    is full.
+
+    The next page is erased (if space is available). In circular mode the
+    oldest record page may be erased.
+ */
+static void log_fs_record_page_next(void);
+
+/**
+    Return the page at a position in the sequence of record pages of the open
+    file.
+
+    Position 0 is the first (oldest) record page. Positions follow the same
+    wrap rules as record writing. BAD pages are included.
+
+    @param pos              Position relative to first record page
+
+    @return log_fs_page_t   Page number
+ */
+static log_fs_page_t log_fs_record_page_at(log_fs_page_t pos);
+
+/**
+    Return the position of the last (newest) record page of the open file.
+
+    See log_fs_record_page_at().
+
+    @return log_fs_page_t   Position relative to first record page
+ */
+static log_fs_page_t log_fs_record_page_pos_last(void);
+
+/**
+    Find the first RECORD page at or after a position.
+
+    @param pos              Position to start searching from. Updated with the
+                            position of the RECORD page found
+    @param pos_end          Last position to search
+
+    @retval TRUE            RECORD page found. The page header is in
+                            log_fs.page_header
+    @retval FALSE           No RECORD page found
+ */
+static bool_t log_fs_record_page_find(log_fs_page_t * pos, 
+                                      log_fs_page_t   pos_end);
+
+#if LOG_FS_CFG_REC_TIME_STAMP
+/**
+    Read the first valid record of a record page.
+
+    @param page             Record page
+    @param offset           Offset of record found
+
+    @retval TRUE            Record found and copied into log_fs.record_block
+    @retval FALSE           No valid record in page
+ */
+static bool_t log_fs_record_page_first_rd(log_fs_page_t     page, 
+                                          log_fs_offset_t * offset);
+#endif
+
+/**
+    Find first (oldest) and last (newest) file page.
+
+    The rolling number of each FILE page is compared with the next to find the
+    largest difference.
+ */
+static void log_fs_file_pages_find(void);
+
+/**
+    Find the page where a new file will be created if there are no files.
+
+    If LOG_FS_CFG_ERASE_CNT is enabled, the FREE or BAD (deleted) page with the
+    smallest erase count is selected so that the start of the file system does
+    not wear out first when all of the files are deleted and created again.
+    Otherwise the first FREE page is selected.
+
+    @return log_fs_page_t   Page for new file (LOG_FS_CFG_PAGE_START if there
+                            are no FREE pages)
+ */
+static log_fs_page_t log_fs_file_page_empty_find(void);
+
+#if LOG_FS_WINDOW_ROTATE
+/**
+    Move the window of the open (newest) circular file one page forward.
+
+    Called when record writing wraps. The FILE page (including the file
+    attribute data) is copied to the next page, which holds the oldest
+    records, and the old FILE page is erased. The page after the old end of
+    the window becomes the last page of the window. Nothing is moved if the
+    open file is not the newest file or if the copy failed.
+ */
+static void log_fs_window_rotate(void);
+
+/**
+    Update the file system state after the open file's FILE page has been
+    moved to the next page.
+
+    The old FILE page is erased if that has not been done yet.
+
+    @param file_page_new    New FILE page of the open file
+ */
+static void log_fs_window_moved(log_fs_page_t file_page_new);
+
+/**
+    Erase FILE pages left behind by an interrupted window move.
+
+    A FILE page followed by a valid FILE page with the same rolling number is
+    the old copy.
+ */
+static void log_fs_window_fix(void);
+#endif
+
 /**
     Find page number of the first page that contains the specified marker.
     
@@ -388,35 +849,8 @@ static log_fs_page_t log_fs_page_previous(log_fs_page_t page)
 
 static log_fs_crc_t log_fs_crc_calc(const void * data, size_t nr_of_bytes)
 {
-    u8_t         i;
-    u8_t *       data_u8 = (u8_t *)data;
-    log_fs_crc_t crc = 0xff;
-
-    // Repeat until all the data bytes have been processed...
-    while(nr_of_bytes != 0)
-    {
-        nr_of_bytes--;
-
-        // XOR CRC with 8-bit data
-        crc = crc ^ (*data_u8++);
-
-        // Repeat 8 times (for each bit)
-        for(i=8; i!=0; i--)
-        {
-            // Is lowest bit set?
-            if((crc & 1) != 0)
-            {
-                // Shift right and XOR with reverse of polynomial x^8+x^6+x^3+x^2+x^0
-                crc = (crc >> 1) ^ 0xb2;
-            }
-            else
-            {
-                // Shift right
-                crc = (crc >> 1);
-            }
-        }
-    }
-	return crc;
+    // CRC-8, polynomial x^8+x^6+x^3+x^2+x^0 (reversed 0xb2), initial value 0xff
+    return crc8_calc(0xff, data, nr_of_bytes);
 }
 
 static log_fs_crc_t log_fs_crc_page_header(void)
@@ -433,8 +867,14 @@ static log_fs_crc_t log_fs_crc_file_info(void)
 
 static log_fs_crc_t log_fs_crc_record_block(void)
 {
+#if LOG_FS_CFG_REC_VAR_SIZE
+    // Calculate CRC over marker, length and data
+    return log_fs_crc_calc(&log_fs.record_block, 
+                           LOG_FS_REC_SIZE(log_fs.record_block.len) - sizeof(log_fs_crc_t));
+#else
     // Calculate CRC over whole block, except for CRC part
     return log_fs_crc_calc(&log_fs.record_block, offsetof(log_fs_rec_block_t, crc));
+#endif
 }
 
 static log_fs_marker_t log_fs_marker_rd(log_fs_page_t   page,
@@ -458,10 +898,18 @@ static log_fs_marker_t log_fs_marker_rd(log_fs_page_t   page,
 
         // Set marker to BAD
         marker = LOG_FS_MARKER_BAD;
-        at45d_wr_page_offset(&marker,
-                             page,
-                             offset,
-                             sizeof(log_fs_marker_t));
+        log_fs.cnt.bad_marked++;
+        log_fs_page_wr_offset(&marker,
+                              page,
+                              offset,
+                              sizeof(log_fs_marker_t));
+#if LOG_FS_CFG_PAGE_INDEX
+        // Page marker?
+        if(offset == 0)
+        {
+            log_fs_index_set(page, LOG_FS_MARKER_BAD, 0);
+        }
+#endif
     }
 
     return marker;
@@ -473,11 +921,16 @@ static bool_t log_fs_marker_wr(log_fs_marker_t marker,
 {
     log_fs_marker_t marker_rd;
 
+    if(marker == LOG_FS_MARKER_BAD)
+    {
+        log_fs.cnt.bad_marked++;
+    }
+
     // Write marker
-    at45d_wr_page_offset(&marker,
-                         page,
-                         offset,
-                         sizeof(log_fs_marker_t));
+    log_fs_page_wr_offset(&marker,
+                          page,
+                          offset,
+                          sizeof(log_fs_marker_t));
 
     // Marker correctly written?
     marker_rd = log_fs_marker_rd(page, offset);
@@ -487,15 +940,30 @@ static bool_t log_fs_marker_wr(log_fs_marker_t marker,
                 page, offset, marker, marker_rd);
         // Set marker to BAD
         marker = LOG_FS_MARKER_BAD;
-        at45d_wr_page_offset(&marker,
-                             page,
-                             offset,
-                             sizeof(log_fs_marker_t));
+        log_fs.cnt.bad_marked++;
+        log_fs_page_wr_offset(&marker,
+                              page,
+                              offset,
+                              sizeof(log_fs_marker_t));
+#if LOG_FS_CFG_PAGE_INDEX
+        // Page marker?
+        if(offset == 0)
+        {
+            log_fs_index_set(page, LOG_FS_MARKER_BAD, 0);
+        }
+#endif
         // Failure
         return FALSE;
     }
     else
     {
+#if LOG_FS_CFG_PAGE_INDEX
+        // Page marker?
+        if(offset == 0)
+        {
+            log_fs_index_set(page, marker, log_fs_index_nr[page - LOG_FS_CFG_PAGE_START]);
+        }
+#endif
         // Success
         return TRUE;
     }
@@ -503,22 +971,31 @@ static bool_t log_fs_marker_wr(log_fs_marker_t marker,
 
 static log_fs_marker_t log_fs_page_header_rd(log_fs_page_t page)
 {
-    log_fs_marker_t marker;
-    log_fs_crc_t    crc;
-
-    // Read marker (and set to BAD if invalid value)
-    marker = log_fs_marker_rd(page, 0);
-    if(  (marker == LOG_FS_MARKER_FREE) || (marker == LOG_FS_MARKER_BAD)  )
-    {
-        return marker;
-    }
+    log_fs_page_header_t page_header_rd;
+    log_fs_crc_t         crc;
 
-    // Read page header
-    at45d_rd_page_offset(&log_fs.page_header,
+    // Read page header (marker, rolling number and CRC) in one transaction
+    at45d_rd_page_offset(&page_header_rd,
                          page,
                          0,
                          sizeof(log_fs_page_header_t));
 
+    switch(page_header_rd.marker)
+    {
+    case LOG_FS_MARKER_FREE:
+    case LOG_FS_MARKER_BAD:
+        return page_header_rd.marker;
+    case LOG_FS_MARKER_FILE:
+    case LOG_FS_MARKER_RECORD:
+        break;
+    default:
+        // Invalid marker. Re-read marker to set it to BAD
+        return log_fs_marker_rd(page, 0);
+    }
+
+    // Keep page header
+    memcpy(&log_fs.page_header, &page_header_rd, sizeof(log_fs_page_header_t));
+
     // Check CRC
     crc = log_fs_crc_page_header();
     if(crc != log_fs.page_header.crc)
@@ -544,21 +1021,24 @@ static bool_t log_fs_page_header_wr(log_fs_page_t page)
     DBG_INFO("Writing page header (page %u, marker 0x%02X, nr %u, crc 0x%02X)",
              page, log_fs.page_header.marker, log_fs.page_header.nr, log_fs.page_header.crc);
 
-    // Write page header
-    at45d_wr_page_offset(&log_fs.page_header,
-                         page,
-                         0,
-                         sizeof(log_fs_page_header_t));
+    // Write page header (erase counter was written when page was erased)
+    log_fs_page_wr_offset(&log_fs.page_header,
+                          page,
+                          0,
+                          LOG_FS_PAGE_HEADER_WR_SIZE);
 
     // Read back page header
     at45d_rd_page_offset(&page_header_rd,
                          page,
                          0,
-                         sizeof(log_fs_page_header_t));
+                         LOG_FS_PAGE_HEADER_WR_SIZE);
 
     // Match?
-    if(memcmp(&log_fs.page_header, &page_header_rd, sizeof(log_fs_page_header_t)) == 0)
+    if(memcmp(&log_fs.page_header, &page_header_rd, LOG_FS_PAGE_HEADER_WR_SIZE) == 0)
     {
+#if LOG_FS_CFG_PAGE_INDEX
+        log_fs_index_set(page, log_fs.page_header.marker, log_fs.page_header.nr);
+#endif
         // Success
         return TRUE;
     }
@@ -624,10 +1104,10 @@ static bool_t log_fs_file_block_wr(log_fs_page_t page)
     // Set file block CRC
     log_fs.file_info.crc = log_fs_crc_file_info();
     // Write file block
-    at45d_wr_page_offset(&log_fs.file_info,
-                         page,
-                         sizeof(log_fs_page_header_t),
-                         sizeof(log_fs_file_info_t));
+    log_fs_page_wr_offset(&log_fs.file_info,
+                          page,
+                          sizeof(log_fs_page_header_t),
+                          sizeof(log_fs_file_info_t));
     // Read back file block
     at45d_rd_page_offset(&file_block_rd,
                          page,
@@ -651,6 +1131,27 @@ static bool_t log_fs_file_block_wr(log_fs_page_t page)
 static bool_t log_fs_record_block_rd(log_fs_page_t   page,
                                      log_fs_offset_t offset)
 {
+#if LOG_FS_CFG_REC_VAR_SIZE
+    log_fs_offset_t size;
+    u8_t *          block_u8 = (u8_t *)&log_fs.record_block;
+
+    // Read marker and length
+    size = log_fs_record_size_rd(page, offset);
+    if(  (size == 0                                        )
+       ||(log_fs.record_block.marker != LOG_FS_MARKER_RECORD)  )
+    {
+        return FALSE;
+    }
+    // Read record entry (CRC follows data)
+    at45d_rd_page_offset(&log_fs.record_block,
+                         page,
+                         offset,
+                         size);
+    log_fs.record_block.crc = block_u8[size - sizeof(log_fs_crc_t)];
+    // Fill rest of data with 0xff
+    memset(&log_fs.record_block.data[log_fs.record_block.len], 0xff,
+           LOG_FS_CFG_REC_DATA_SIZE - log_fs.record_block.len);
+#else
     // Read marker (and set to BAD if invalid value)
     if(log_fs_marker_rd(page, offset) != LOG_FS_MARKER_RECORD)
     {
@@ -661,6 +1162,7 @@ static bool_t log_fs_record_block_rd(log_fs_page_t   page,
                          page,
                          offset,
                          sizeof(log_fs_rec_block_t));
+#endif
     // CRC correct?
     if(log_fs.record_block.crc != log_fs_crc_record_block())
     {
@@ -678,9 +1180,18 @@ static bool_t log_fs_record_block_wr(log_fs_page_t   page,
                                      log_fs_offset_t offset)
 {
     log_fs_rec_block_t record_block_rd;
+#if LOG_FS_CFG_REC_VAR_SIZE
+    log_fs_offset_t    size     = LOG_FS_REC_SIZE(log_fs.record_block.len);
+    u8_t *             block_u8 = (u8_t *)&log_fs.record_block;
 
     // Sanity check
-    if(offset + sizeof(log_fs_rec_block_t) >= LOG_FS_CFG_PAGE_SIZE)
+    if(offset + size > LOG_FS_CFG_PAGE_SIZE)
+#else
+    log_fs_offset_t    size     = sizeof(log_fs_rec_block_t);
+
+    // Sanity check
+    if(offset + size >= LOG_FS_CFG_PAGE_SIZE)
+#endif
     {
         DBG_ERR("Record block will overflow the page");
         return FALSE;
@@ -690,28 +1201,781 @@ static bool_t log_fs_record_block_wr(log_fs_page_t   page,
     log_fs.record_block.marker = LOG_FS_MARKER_RECORD;
     // Set record block CRC
     log_fs.record_block.crc = log_fs_crc_record_block();
+#if LOG_FS_CFG_REC_VAR_SIZE
+    // Move CRC to directly after data
+    block_u8[size - sizeof(log_fs_crc_t)] = log_fs.record_block.crc;
+#endif
     // Write record entry
-    at45d_wr_page_offset(&log_fs.record_block,
-                         page,
-                         offset,
-                         sizeof(log_fs_rec_block_t));
+    log_fs_page_wr_offset(&log_fs.record_block,
+                          page,
+                          offset,
+                          size);
     // Read back record entry
     at45d_rd_page_offset(&record_block_rd,
                          page,
                          offset,
-                         sizeof(log_fs_rec_block_t));
+                         size);
     // Match?
-    if(memcmp(&log_fs.record_block, &record_block_rd, sizeof(log_fs_rec_block_t)) != 0)
+    if(memcmp(&log_fs.record_block, &record_block_rd, size) != 0)
+    {
+        // Mark record as BAD
+        DBG_ERR("Record block write failed (page %u, offset %u)", page, offset);
+        log_fs_marker_wr(LOG_FS_MARKER_BAD, page, offset);
+        // Failure
+        return FALSE;
+    }
+
+    // Success
+    return TRUE;
+}
+
+#if LOG_FS_CFG_REC_VAR_SIZE
+static log_fs_offset_t log_fs_record_size_rd(log_fs_page_t   page,
+                                             log_fs_offset_t offset)
+{
+    log_fs_offset_t size;
+
+    // Beyond end of page?
+    if(LOG_FS_REC_PAGE_FULL(offset))
+    {
+        return 0;
+    }
+    // Read marker and length
+    at45d_rd_page_offset(&log_fs.record_block,
+                         page,
+                         offset,
+                         offsetof(log_fs_rec_block_t, data));
+    // Chain ends at FREE or invalid marker
+    if(  (log_fs.record_block.marker != LOG_FS_MARKER_RECORD)
+       &&(log_fs.record_block.marker != LOG_FS_MARKER_BAD   )  )
+    {
+        return 0;
+    }
+    // Invalid length?
+    size = LOG_FS_REC_SIZE(log_fs.record_block.len);
+    if(  (log_fs.record_block.len > LOG_FS_CFG_REC_DATA_SIZE)
+       ||(offset + size > LOG_FS_REC_OFFSET_END            )  )
+    {
+        DBG_ERR("Invalid record length %u (page %u, offset %u)", 
+                log_fs.record_block.len, page, offset);
+        return 0;
+    }
+    return size;
+}
+#endif
+
+static log_fs_offset_t log_fs_record_offset_next(log_fs_page_t   page,
+                                                 log_fs_offset_t offset)
+{
+#if LOG_FS_CFG_REC_VAR_SIZE
+    log_fs_offset_t size;
+
+    // Follow chain
+    size = log_fs_record_size_rd(page, offset);
+    if(size == 0)
+    {
+        return LOG_FS_REC_OFFSET_END;
+    }
+    offset += size;
+    // End of page?
+    if(LOG_FS_REC_PAGE_FULL(offset))
+    {
+        return LOG_FS_REC_OFFSET_END;
+    }
+    return offset;
+#else
+    (void)page;
+
+    // End of page?
+    if(offset >= LOG_FS_REC_OFFSET_LAST)
+    {
+        return LOG_FS_REC_OFFSET_END;
+    }
+    return offset + sizeof(log_fs_rec_block_t);
+#endif
+}
+
+static log_fs_offset_t log_fs_record_offset_previous(log_fs_page_t   page,
+                                                     log_fs_offset_t offset)
+{
+#if LOG_FS_CFG_REC_VAR_SIZE
+    log_fs_offset_t i      = LOG_FS_REC_OFFSET_END;
+    log_fs_offset_t i_next = LOG_FS_REC_OFFSET_FIRST;
+    log_fs_offset_t size;
+
+    // Follow chain from start of page to find record block before offset
+    while(i_next < offset)
+    {
+        // Chain ends?
+        size = log_fs_record_size_rd(page, i_next);
+        if(size == 0)
+        {
+            break;
+        }
+        i       = i_next;
+        i_next += size;
+    }
+    return i;
+#else
+    (void)page;
+
+    // Start of page?
+    if(offset <= LOG_FS_REC_OFFSET_FIRST)
+    {
+        return LOG_FS_REC_OFFSET_END;
+    }
+    // End of page?
+    if(offset > LOG_FS_REC_OFFSET_LAST)
+    {
+        return LOG_FS_REC_OFFSET_LAST;
+    }
+    return offset - sizeof(log_fs_rec_block_t);
+#endif
+}
+
+static log_fs_offset_t log_fs_record_offset_free(log_fs_page_t page)
+{
+    log_fs_offset_t offset = LOG_FS_REC_OFFSET_FIRST;
+
+    while(!LOG_FS_REC_PAGE_FULL(offset))
+    {
+#if LOG_FS_CFG_REC_VAR_SIZE
+        // End of chain?
+        if(log_fs_record_size_rd(page, offset) == 0)
+        {
+            // Not FREE (chain is broken)?
+            if(log_fs_marker_rd(page, offset) != LOG_FS_MARKER_FREE)
+            {
+                break;
+            }
+            return offset;
+        }
+        offset = log_fs_record_offset_next(page, offset);
+#else
+        if(log_fs_marker_rd(page, offset) == LOG_FS_MARKER_FREE)
+        {
+            return offset;
+        }
+        offset += sizeof(log_fs_rec_block_t);
+#endif
+    }
+
+    // Page is full
+    return LOG_FS_REC_OFFSET_END;
+}
+
+static void log_fs_page_wr_offset(const void *    data,
+                                  log_fs_page_t   page,
+                                  log_fs_offset_t offset,
+                                  size_t          nr_of_bytes)
+{
+    at45d_wr_page_offset(data, page, offset, nr_of_bytes);
+    log_fs.cnt.prg_pages++;
+    log_fs.cnt.prg_bytes += nr_of_bytes;
+}
+
+#if LOG_FS_CFG_ERASE_CNT
+static u32_t log_fs_page_erase_cnt_rd(log_fs_page_t page)
+{
+    u32_t erase_cnt;
+
+    at45d_rd_page_offset(&erase_cnt,
+                         page,
+                         offsetof(log_fs_page_header_t, erase_cnt),
+                         sizeof(erase_cnt));
+    // Never written?
+    if(erase_cnt == 0xffffffff)
+    {
+        erase_cnt = 0;
+    }
+    return erase_cnt;
+}
+#endif
+
+static void log_fs_page_erase(log_fs_page_t page)
+{
+#if LOG_FS_CFG_ERASE_CNT
+    u32_t erase_cnt = log_fs_page_erase_cnt_rd(page);
+#endif
+
+    at45d_erase_page(page);
+    log_fs.cnt.erases++;
+
+#if LOG_FS_CFG_ERASE_CNT
+    // Write incremented erase counter (rest of page header stays FREE)
+    erase_cnt++;
+    log_fs_page_wr_offset(&erase_cnt,
+                          page,
+                          offsetof(log_fs_page_header_t, erase_cnt),
+                          sizeof(erase_cnt));
+#endif
+#if LOG_FS_CFG_PAGE_INDEX
+    log_fs_index_set(page, LOG_FS_MARKER_FREE, 0);
+#endif
+}
+
+#if LOG_FS_CFG_PAGE_INDEX
+static void log_fs_index_set(log_fs_page_t   page,
+                             log_fs_marker_t marker,
+                             log_fs_nr_t     nr)
+{
+    u8_t state;
+    u8_t shift;
+
+    // Sanity check
+    DBG_ASSERT( (page >= LOG_FS_CFG_PAGE_START) && (page <= LOG_FS_CFG_PAGE_END) );
+
+    // Convert marker to 2-bit page state
+    switch(marker)
+    {
+    case LOG_FS_MARKER_FREE:   state = LOG_FS_INDEX_FREE;   break;
+    case LOG_FS_MARKER_FILE:   state = LOG_FS_INDEX_FILE;   break;
+    case LOG_FS_MARKER_RECORD: state = LOG_FS_INDEX_RECORD; break;
+    default:                   state = LOG_FS_INDEX_BAD;    break;
+    }
+
+    // Update page state and rolling number
+    page -= LOG_FS_CFG_PAGE_START;
+    shift = (page & 3) << 1;
+    log_fs_index_state[page >> 2] &= ~(3 << shift);
+    log_fs_index_state[page >> 2] |=  (state << shift);
+    log_fs_index_nr[page]          =  nr;
+}
+
+static void log_fs_index_build(void)
+{
+    log_fs_page_t   page;
+    log_fs_marker_t marker;
+
+    // Read each page header once
+    for(page = LOG_FS_CFG_PAGE_START; page <= LOG_FS_CFG_PAGE_END; page++)
+    {
+        marker = log_fs_page_header_rd(page);
+        if(  (marker == LOG_FS_MARKER_FILE) || (marker == LOG_FS_MARKER_RECORD)  )
+        {
+            log_fs_index_set(page, marker, log_fs.page_header.nr);
+        }
+        else
+        {
+            log_fs_index_set(page, marker, 0);
+        }
+    }
+}
+#endif
+
+static log_fs_marker_t log_fs_page_header_get(log_fs_page_t page)
+{
+#if LOG_FS_CFG_PAGE_INDEX
+    log_fs_marker_t marker = log_fs_page_marker_get(page);
+
+    // FILE or RECORD page?
+    if(  (marker == LOG_FS_MARKER_FILE) || (marker == LOG_FS_MARKER_RECORD)  )
+    {
+        // Fetch page header from RAM index
+        log_fs.page_header.marker = marker;
+        log_fs.page_header.nr     = log_fs_index_nr[page - LOG_FS_CFG_PAGE_START];
+    }
+    return marker;
+#else
+    return log_fs_page_header_rd(page);
+#endif
+}
+
+static log_fs_marker_t log_fs_page_marker_get(log_fs_page_t page)
+{
+#if LOG_FS_CFG_PAGE_INDEX
+    u8_t state;
+
+    // Sanity check
+    DBG_ASSERT( (page >= LOG_FS_CFG_PAGE_START) && (page <= LOG_FS_CFG_PAGE_END) );
+
+    page -= LOG_FS_CFG_PAGE_START;
+    state = (log_fs_index_state[page >> 2] >> ((page & 3) << 1)) & 3;
+    return log_fs_index_marker[state];
+#else
+    return log_fs_marker_rd(page, 0);
+#endif
+}
+
+#if LOG_FS_CFG_CHECKPOINT
+static void log_fs_checkpoint_page_wr(log_fs_page_t page)
+{
+    at45d_wr_page(log_fs_checkpoint_buf, page);
+    log_fs.cnt.prg_pages++;
+    log_fs.cnt.prg_bytes += LOG_FS_CFG_PAGE_SIZE;
+    log_fs.cnt.erases++;
+}
+
+static void log_fs_checkpoint_data_wr(log_fs_page_t *   page,
+                                      log_fs_offset_t * offset,
+                                      const void *      data,
+                                      size_t            nr_of_bytes)
+{
+    const u8_t * data_u8 = (const u8_t *)data;
+
+    while(nr_of_bytes != 0)
+    {
+        nr_of_bytes--;
+
+        // Copy byte to page buffer
+        log_fs_checkpoint_buf[(*offset)++] = *data_u8++;
+
+        // Page buffer full?
+        if(*offset == LOG_FS_CFG_PAGE_SIZE)
+        {
+            // Write page (erased automatically) and start with next page
+            log_fs_checkpoint_page_wr(*page);
+            (*page)++;
+            *offset = 0;
+        }
+    }
+}
+
+static bool_t log_fs_checkpoint_index_rd(u16_t                       slot,
+                                         const log_fs_checkpoint_t * checkpoint)
+{
+    at45d_adr_t adr;
+    u16_t       crc;
+    u16_t       crc_rd;
+
+    // Calculate address of RAM index (located after checkpoint header)
+    adr  =  (at45d_adr_t)(LOG_FS_CFG_CHECKPOINT_PAGE_START + slot * LOG_FS_CHECKPOINT_SLOT_PAGES)
+          * LOG_FS_CFG_PAGE_SIZE;
+    adr += sizeof(log_fs_checkpoint_t);
+
+    // Read RAM index and CRC
+    at45d_rd(log_fs_index_state, adr, sizeof(log_fs_index_state));
+    adr += sizeof(log_fs_index_state);
+    at45d_rd(log_fs_index_nr, adr, sizeof(log_fs_index_nr));
+    adr += sizeof(log_fs_index_nr);
+    at45d_rd(&crc_rd, adr, sizeof(crc_rd));
+
+    // Calculate CRC over checkpoint header and RAM index
+    crc = crc16_ccitt_calc(0xffff, checkpoint,         sizeof(log_fs_checkpoint_t));
+    crc = crc16_ccitt_calc(crc,    log_fs_index_state, sizeof(log_fs_index_state));
+    crc = crc16_ccitt_calc(crc,    log_fs_index_nr,    sizeof(log_fs_index_nr));
+
+    // CRC correct?
+    if(crc != crc_rd)
+    {
+        DBG_ERR("Checkpoint CRC check failed (slot %u): wr 0x%04X, rd 0x%04X",
+                slot, crc_rd, crc);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void log_fs_checkpoint_roll_forward(log_fs_page_t page)
+{
+    log_fs_page_t   i;
+    log_fs_marker_t marker;
+    log_fs_marker_t marker_index;
+    log_fs_nr_t     nr_index;
+
+    for(i = 0; i < LOG_FS_PAGES; i++)
+    {
+        // Fetch page header from RAM index
+        marker_index = log_fs_page_header_get(page);
+        nr_index     = log_fs.page_header.nr;
+
+        // Read page header from Serial Flash
+        marker = log_fs_page_header_rd(page);
+
+        // Page header unchanged since checkpoint?
+        if(  (marker == marker_index)
+           &&(  ((marker != LOG_FS_MARKER_FILE) && (marker != LOG_FS_MARKER_RECORD))
+              ||(log_fs.page_header.nr == nr_index                                 )  )  )
+        {
+            // Stop (start page may be partially filled)
+            if(i != 0)
+            {
+                break;
+            }
+        }
+        else
+        {
+            DBG_INFO("Roll forward page %u (marker 0x%02X)", page, marker);
+
+            // Update RAM index
+            if(  (marker == LOG_FS_MARKER_FILE) || (marker == LOG_FS_MARKER_RECORD)  )
+            {
+                log_fs_index_set(page, marker, log_fs.page_header.nr);
+            }
+            else
+            {
+                log_fs_index_set(page, marker, 0);
+            }
+
+            // New file created after checkpoint?
+            if(  (marker                == LOG_FS_MARKER_FILE      )
+               &&(log_fs.page_header.nr == log_fs.file_page_nr_next)  )
+            {
+                DBG_INFO("New file at page %u", page);
+                log_fs.file_page_last = page;
+                if(log_fs.file_page_first == LOG_FS_PAGE_INVALID)
+                {
+                    log_fs.file_page_first = page;
+                }
+                log_fs.file_page_nr_next++;
+                // New file is open for writing
+                log_fs.file_page_open            = page;
+                log_fs.file_info.file.start_page = page;
+            }
+#if LOG_FS_WINDOW_ROTATE
+            // Open file's window moved after checkpoint?
+            else if(  (marker                == LOG_FS_MARKER_FILE                           )
+                    &&(log_fs.file_page_open != LOG_FS_PAGE_INVALID                          )
+                    &&(log_fs.file_page_open == log_fs.file_page_last                        )
+                    &&(page                  == log_fs_page_next(log_fs.file_page_open)      )
+                    &&(log_fs.page_header.nr == (log_fs_nr_t)(log_fs.file_page_nr_next - 1)) )
+            {
+                DBG_INFO("File moved to page %u", page);
+                log_fs_window_moved(page);
+            }
+#endif
+        }
+
+#if (LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_CIRCULAR)
+        // End of open file's record pages reached?
+        if(  (log_fs.file_page_open != LOG_FS_PAGE_INVALID     )
+           &&(page == log_fs_record_pages_bound_end()          )  )
+        {
+            // Wrap to start page
+            page = log_fs_record_pages_bound_start();
+        }
+        else
+#endif
+        {
+            // Next page
+            page = log_fs_page_next(page);
+        }
+    }
+}
+
+static bool_t log_fs_checkpoint_hdr_rd(u16_t                 slot,
+                                       log_fs_checkpoint_t * checkpoint)
+{
+    at45d_rd(checkpoint,
+             (at45d_adr_t)(LOG_FS_CFG_CHECKPOINT_PAGE_START + slot * LOG_FS_CHECKPOINT_SLOT_PAGES)
+             * LOG_FS_CFG_PAGE_SIZE,
+             sizeof(log_fs_checkpoint_t));
+
+    return  (checkpoint->magic      == LOG_FS_CHECKPOINT_MAGIC)
+          &&(checkpoint->page_start == LOG_FS_CFG_PAGE_START  )
+          &&(checkpoint->page_end   == LOG_FS_CFG_PAGE_END    );
+}
+
+static bool_t log_fs_checkpoint_rd(void)
+{
+    log_fs_checkpoint_t checkpoint;
+    u16_t               slot;
+    u16_t               slot_newest;
+    u32_t               seq_newest;
+    u32_t               seq_limit = 0xffffffff;
+    log_fs_page_t       page;
+#if LOG_FS_CFG_ERASE_CNT
+    log_fs_page_t       page_file;
+#endif
+    log_fs_file_t       file;
+
+    log_fs_checkpoint_seq = 0;
+    while(TRUE)
+    {
+        // Find newest checkpoint that has not been tried yet
+        slot_newest = LOG_FS_CHECKPOINT_SLOTS;
+        seq_newest  = 0;
+        for(slot = 0; slot < LOG_FS_CHECKPOINT_SLOTS; slot++)
+        {
+            if(!log_fs_checkpoint_hdr_rd(slot, &checkpoint))
+            {
+                continue;
+            }
+            // Continue sequence after largest number found
+            if(log_fs_checkpoint_seq < checkpoint.seq)
+            {
+                log_fs_checkpoint_seq = checkpoint.seq;
+            }
+            if(  (checkpoint.seq < seq_limit )
+               &&(checkpoint.seq > seq_newest)  )
+            {
+                slot_newest = slot;
+                seq_newest  = checkpoint.seq;
+            }
+        }
+        // No more valid checkpoints?
+        if(slot_newest == LOG_FS_CHECKPOINT_SLOTS)
+        {
+            break;
+        }
+        seq_limit = seq_newest;
+
+        // Read newest checkpoint and verify RAM index
+        slot = slot_newest;
+        log_fs_checkpoint_hdr_rd(slot, &checkpoint);
+        if(!log_fs_checkpoint_index_rd(slot, &checkpoint))
+        {
+            continue;
+        }
+        DBG_INFO("Checkpoint %lu restored (slot %u)", (unsigned long)checkpoint.seq, slot);
+
+        // Restore state
+        log_fs_checkpoint_slot      = slot;
+        log_fs_checkpoint_rec_pages = 0;
+        log_fs.file_page_first      = checkpoint.file_page_first;
+        log_fs.file_page_last       = checkpoint.file_page_last;
+        log_fs.file_page_nr_next    = checkpoint.file_page_nr_next;
+        log_fs.file_page_open       = checkpoint.file_page_open;
+        log_fs.rec_page_first       = checkpoint.rec_page_first;
+        log_fs.rec_page_last        = checkpoint.rec_page_last;
+        log_fs.rec_page_nr_next     = checkpoint.rec_page_nr_next;
+        log_fs.rec_adr_rd.page      = LOG_FS_PAGE_INVALID;
+        log_fs.rec_adr_wr           = checkpoint.rec_adr_wr;
+
+        // Roll forward records and files written after checkpoint
+        if(log_fs.file_page_open != LOG_FS_PAGE_INVALID)
+        {
+            log_fs.file_info.file.start_page = log_fs.file_page_open;
+            page = log_fs.rec_adr_wr.page;
+        }
+        else if(log_fs.file_page_last != LOG_FS_PAGE_INVALID)
+        {
+            page = log_fs.file_page_last;
+        }
+        else
+        {
+            // Start where log_fs_create() will start
+            page = log_fs_file_page_empty_find();
+#if LOG_FS_CFG_ERASE_CNT
+            // log_fs_create() erases the selected page which changes its erase
+            // count. Look for a file created after checkpoint instead.
+            for(page_file =  LOG_FS_CFG_PAGE_START;
+                page_file <= LOG_FS_CFG_PAGE_END;
+                page_file++)
+            {
+                if(  (log_fs_page_marker_get(page_file) != LOG_FS_MARKER_FILE      )
+                   &&(log_fs_page_header_rd(page_file)  == LOG_FS_MARKER_FILE      )
+                   &&(log_fs.page_header.nr             == log_fs.file_page_nr_next)  )
+                {
+                    page = page_file;
+                    break;
+                }
+            }
+#endif
+        }
+        log_fs_checkpoint_roll_forward(page);
+
+        // Roll forward oldest file deleted after checkpoint
+        if(log_fs.file_page_first != LOG_FS_PAGE_INVALID)
+        {
+            log_fs_checkpoint_roll_forward(log_fs.file_page_first);
+
+            // Oldest file deleted?
+            if(log_fs_page_marker_get(log_fs.file_page_first) != LOG_FS_MARKER_FILE)
+            {
+                DBG_INFO("File at page %u deleted", log_fs.file_page_first);
+                if(log_fs.file_page_open == log_fs.file_page_first)
+                {
+                    log_fs.file_page_open = LOG_FS_PAGE_INVALID;
+                }
+                if(log_fs.file_page_first == log_fs.file_page_last)
+                {
+                    log_fs.file_page_first = LOG_FS_PAGE_INVALID;
+                    log_fs.file_page_last  = LOG_FS_PAGE_INVALID;
+                }
+                else
+                {
+                    log_fs.file_page_first = log_fs_page_header_find_next(LOG_FS_MARKER_FILE,
+                                                                          LOG_FS_CFG_PAGE_START,
+                                                                          LOG_FS_CFG_PAGE_END,
+                                                                          log_fs.file_page_first);
+                    if(log_fs.file_page_first == LOG_FS_PAGE_INVALID)
+                    {
+                        log_fs.file_page_last = LOG_FS_PAGE_INVALID;
+                    }
+                }
+            }
+        }
+
+        DBG_INFO("First file at page %u", log_fs.file_page_first);
+        DBG_INFO("Last file at page %u", log_fs.file_page_last);
+        DBG_INFO("Next file nr %u", log_fs.file_page_nr_next);
+
+        // Reopen file to find next write position
+        if(log_fs.file_page_open != LOG_FS_PAGE_INVALID)
+        {
+            file.start_page = log_fs.file_page_open;
+            if(log_fs_open(&file) != LOG_FS_ERR_NONE)
+            {
+                log_fs.file_page_open = LOG_FS_PAGE_INVALID;
+            }
+        }
+
+        return TRUE;
+    }
+
+    // No valid checkpoint (first checkpoint is written to slot 0)
+    DBG_INFO("No valid checkpoint");
+    log_fs_checkpoint_slot = LOG_FS_CHECKPOINT_SLOTS - 1;
+    return FALSE;
+}
+#endif
+
+static log_fs_err_t log_fs_record_page_start(void)
+{
+    log_fs_marker_t marker;
+    log_fs_page_t   page = log_fs.rec_adr_wr.page;
+
+    // Read page's marker
+    marker = log_fs_page_marker_get(page);
+ 
+#if (LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_LINEAR)
+    // Maximum space reached?
+    if(  (marker == LOG_FS_MARKER_FILE                               )
+       ||(page   == log_fs_page_next(log_fs_record_pages_bound_end()))  )
+    {
+        // File system full
+        DBG_WARN("File system is full");
+        return LOG_FS_ERR_FULL;
+    }
+#endif
+
+    // Page marked as BAD?
+    if(marker == LOG_FS_MARKER_BAD)
+    {
+        DBG_INFO("Erase page %u", page);
+        log_fs_page_erase(page);
+    }
+
+    // Write record page header
+    log_fs.page_header.marker  = LOG_FS_MARKER_RECORD;
+    log_fs.page_header.nr      = log_fs.rec_page_nr_next;
+    if(!log_fs_page_header_wr(page))
+    {
+        // Failed to write record page header. Move on to next page
+        page = log_fs_page_next(page);
+
+        // Read next page's marker
+        marker = log_fs_page_marker_get(page);
+
+        // Maximum space reached?
+        if(  (marker == LOG_FS_MARKER_FILE                               )
+           ||(page   == log_fs_page_next(log_fs_record_pages_bound_end()))  )
+        {
+#if (LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_LINEAR)
+            // File system full
+            DBG_WARN("File system is full");
+            return LOG_FS_ERR_FULL;
+#endif
+
+#if (LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_CIRCULAR)
+            // Wrap
+            page = log_fs_record_pages_bound_start();
+#endif
+        }
+
+        // Erase next page
+        DBG_INFO("Erase page %u", page);
+        log_fs_page_erase(page);
+        // Next record write page (record number is not incremented)
+        log_fs.rec_adr_wr.page = page;
+
+#if (LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_CIRCULAR)
+        // First record page erased?
+        if(page == log_fs.rec_page_first)
+        {
+            // Next record page will be the first
+            log_fs.rec_page_first = log_fs_page_header_find_next(LOG_FS_MARKER_RECORD,
+                                                                 log_fs_record_pages_bound_start(),
+                                                                 log_fs_record_pages_bound_end(),
+                                                                 log_fs.rec_page_first);
+            DBG_INFO("rec_page_first=%u", log_fs.rec_page_first);
+        }
+#endif
+        // Failed to write record page header correctly
+        DBG_WARN("Write failed");
+        return LOG_FS_ERR_WRITE_FAIL;
+    }
+    DBG_INFO("Page %u written with RECORD page header (nr=%u)",
+             log_fs.rec_adr_wr.page,
+             log_fs.page_header.nr);
+    // Next record number
+    log_fs.rec_page_nr_next++;
+    DBG_INFO("rec_page_nr_next=%u", log_fs.rec_page_nr_next);
+
+    // Update last record page
+    log_fs.rec_page_last = page;
+    DBG_INFO("rec_page_last=%u", log_fs.rec_page_last);
+    // Is this also the first record page?
+    if(log_fs.rec_page_first == LOG_FS_PAGE_INVALID)
     {
-        // Mark record as BAD
-        DBG_ERR("Record block write failed (page %u, offset %u)", page, offset);
-        log_fs_marker_wr(LOG_FS_MARKER_BAD, page, offset);
-        // Failure
-        return FALSE;
+        log_fs.rec_page_first = page;
+        DBG_INFO("rec_page_first=%u", log_fs.rec_page_first);
     }
 
-    // Success
-    return TRUE;
+#if LOG_FS_CFG_CHECKPOINT
+    // Time for a new checkpoint?
+    if(++log_fs_checkpoint_rec_pages >= LOG_FS_CFG_CHECKPOINT_PERIOD)
+    {
+        log_fs_checkpoint_wr();
+    }
+#endif
+
+    return LOG_FS_ERR_NONE;
+}
+
+static void log_fs_record_page_next(void)
+{
+    log_fs_page_t page;
+
+    // Next page
+    page = log_fs_page_next(log_fs.rec_adr_wr.page);
+
+#if (LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_LINEAR)
+    // Space available?
+    if(  (page != log_fs_page_next(log_fs_record_pages_bound_end()))
+       &&(log_fs_page_marker_get(page) != LOG_FS_MARKER_FILE          )  )
+    {
+        // Erase next page
+        DBG_INFO("Erase page %u", page);
+        log_fs_page_erase(page);
+    }
+#endif
+
+#if (LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_CIRCULAR)
+    // Maximum space reached?
+    if(  (page == log_fs_page_next(log_fs_record_pages_bound_end()))
+       ||(log_fs_page_marker_get(page) == LOG_FS_MARKER_FILE          )  )
+    {
+#if LOG_FS_WINDOW_ROTATE
+        // Move window one page forward (unless the next file starts there)
+        if(log_fs_page_marker_get(page) != LOG_FS_MARKER_FILE)
+        {
+            log_fs_window_rotate();
+        }
+#endif
+        // Wrap
+        page = log_fs_record_pages_bound_start();
+    }
+    // Erase next page
+    DBG_INFO("Erase page %u", page);
+    log_fs_page_erase(page);
+
+    // First record page erased?
+    if(page == log_fs.rec_page_first)
+    {
+        // Next record page will be the first
+        log_fs.rec_page_first = log_fs_page_header_find_next(LOG_FS_MARKER_RECORD,
+                                                             log_fs_record_pages_bound_start(),
+                                                             log_fs_record_pages_bound_end(),
+                                                             log_fs.rec_page_first);
+        DBG_INFO("rec_page_first=%u", log_fs.rec_page_first);
+    }
+#endif
+
+    // Next record write address
+    log_fs.rec_adr_wr.page   = page;
+    log_fs.rec_adr_wr.offset = LOG_FS_REC_OFFSET_FIRST;
 }
 
 static log_fs_page_t log_fs_record_pages_bound_start(void)
@@ -731,7 +1995,7 @@ static log_fs_page_t log_fs_record_pages_bound_end(void)
     // Wrap?
     if(file_page > LOG_FS_CFG_PAGE_END)
     {
-        file_page -= (LOG_FS_CFG_PAGE_END - LOG_FS_CFG_PAGE_START);
+        file_page -= LOG_FS_PAGES;
     }
     return file_page;
 #else
@@ -739,6 +2003,96 @@ static log_fs_page_t log_fs_record_pages_bound_end(void)
 #endif    
 }
 
+static log_fs_page_t log_fs_record_page_at(log_fs_page_t pos)
+{
+    log_fs_page_t page;
+    log_fs_page_t offset;
+
+#if (LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_CIRCULAR)
+    log_fs_page_t bound_start = log_fs_record_pages_bound_start();
+    log_fs_page_t bound_size  = LOG_FS_PAGE_DISTANCE(bound_start, log_fs_record_pages_bound_end()) + 1;
+
+    // Calculate offset from start boundary (wrap at end boundary)
+    offset = LOG_FS_PAGE_DISTANCE(bound_start, log_fs.rec_page_first) + pos;
+    if(offset >= bound_size)
+    {
+        offset -= bound_size;
+    }
+    page = bound_start;
+#else
+    // Record pages follow file page
+    offset = pos;
+    page   = log_fs.rec_page_first;
+#endif
+
+    // Advance page by offset (wrap at end of file system)
+    offset += page - LOG_FS_CFG_PAGE_START;
+    if(offset >= LOG_FS_PAGES)
+    {
+        offset -= LOG_FS_PAGES;
+    }
+    return LOG_FS_CFG_PAGE_START + offset;
+}
+
+static log_fs_page_t log_fs_record_page_pos_last(void)
+{
+#if (LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_CIRCULAR)
+    log_fs_page_t bound_start = log_fs_record_pages_bound_start();
+    log_fs_page_t bound_size  = LOG_FS_PAGE_DISTANCE(bound_start, log_fs_record_pages_bound_end()) + 1;
+    log_fs_page_t pos;
+
+    pos =   LOG_FS_PAGE_DISTANCE(bound_start, log_fs.rec_page_last) + bound_size
+          - LOG_FS_PAGE_DISTANCE(bound_start, log_fs.rec_page_first);
+    if(pos >= bound_size)
+    {
+        pos -= bound_size;
+    }
+    return pos;
+#else
+    return LOG_FS_PAGE_DISTANCE(log_fs.rec_page_first, log_fs.rec_page_last);
+#endif
+}
+
+static bool_t log_fs_record_page_find(log_fs_page_t * pos, 
+                                      log_fs_page_t   pos_end)
+{
+    // Skip BAD pages
+    while(*pos <= pos_end)
+    {
+        if(log_fs_page_header_get(log_fs_record_page_at(*pos)) == LOG_FS_MARKER_RECORD)
+        {
+            return TRUE;
+        }
+        (*pos)++;
+    }
+    return FALSE;
+}
+
+#if LOG_FS_CFG_REC_TIME_STAMP
+static bool_t log_fs_record_page_first_rd(log_fs_page_t     page, 
+                                          log_fs_offset_t * offset)
+{
+    log_fs_offset_t i;
+
+    for(i = LOG_FS_REC_OFFSET_FIRST; i != LOG_FS_REC_OFFSET_END; i = log_fs_record_offset_next(page, i))
+    {
+        // Write position reached?
+        if(  (page == log_fs.rec_adr_wr.page  )
+           &&(i    == log_fs.rec_adr_wr.offset)  )
+        {
+            break;
+        }
+        // Valid record?
+        if(log_fs_record_block_rd(page, i))
+        {
+            *offset = i;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+#endif
+
 static log_fs_page_t log_fs_page_header_find_first(log_fs_marker_t marker,
                                                    log_fs_page_t   page_start, 
                                                    log_fs_page_t   page_end)
@@ -753,7 +2107,7 @@ static log_fs_page_t log_fs_page_header_find_first(log_fs_marker_t marker,
     while(TRUE)
     {
         // Read page header. Does it match specified marker?
-        if(log_fs_page_header_rd(page) == marker)
+        if(log_fs_page_header_get(page) == marker)
         {
             // Marker found
             return page;
@@ -804,7 +2158,7 @@ static log_fs_page_t log_fs_page_header_find_next(log_fs_marker_t marker,
         }
         
         // Read page header. Does it match specified marker?
-        if(log_fs_page_header_rd(page) == marker)
+        if(log_fs_page_header_get(page) == marker)
         {
             // Marker found
             return page;
@@ -812,8 +2166,7 @@ static log_fs_page_t log_fs_page_header_find_next(log_fs_marker_t marker,
     }
 }                        
 
-/* _____GLOBAL FUNCTIONS_____________________________________________________ */
-log_fs_err_t log_fs_init(void)
+static void log_fs_file_pages_find(void)
 {
     log_fs_page_t file_page_first;
     log_fs_page_t file_page;
@@ -824,24 +2177,6 @@ log_fs_err_t log_fs_init(void)
     log_fs_nr_t   file_nr_diff;
     log_fs_nr_t   file_nr_diff_largest;
 
-    // Report structure sizes so that correct packing of structures can be verified
-    DBG_INFO("Page header size: %u",  sizeof(log_fs_page_header_t));
-    DBG_INFO("File block size: %u",   sizeof(log_fs_file_info_t));
-    DBG_INFO("Record block size: %u", sizeof(log_fs_rec_block_t));
-    DBG_INFO("Record data size: %u",  LOG_FS_CFG_REC_DATA_SIZE);
-    DBG_INFO("Records per page: %u",  LOG_FS_REC_PAGE_DATA_SIZE / sizeof(log_fs_rec_block_t));
-
-    // Sanity checks
-    DBG_ASSERT(sizeof(log_fs_rec_block_t) <= LOG_FS_REC_PAGE_DATA_SIZE);    
-    if(LOG_FS_REC_PAGE_DATA_SIZE % sizeof(log_fs_rec_block_t) != 0)
-    {
-        DBG_WARN("%u bytes will be wasted per page", 
-                 LOG_FS_REC_PAGE_DATA_SIZE % sizeof(log_fs_rec_block_t));
-    }
-
-    // Reset status
-    memset(&log_fs, 0, sizeof(log_fs_t));
-    
     // Find first page containing a file entry
     file_page_first = log_fs_page_header_find_first(LOG_FS_MARKER_FILE,
                                                     LOG_FS_CFG_PAGE_START,
@@ -854,7 +2189,7 @@ log_fs_err_t log_fs_init(void)
         DBG_INFO("No files found");
         log_fs.file_page_first = LOG_FS_PAGE_INVALID;
         log_fs.file_page_last  = LOG_FS_PAGE_INVALID;
-        return LOG_FS_ERR_NONE;
+        return;
     }    
 
     // Reset variable to keep track of largest file number difference
@@ -880,7 +2215,7 @@ log_fs_err_t log_fs_init(void)
             log_fs.file_page_first   = file_page;
             log_fs.file_page_last    = file_page;
             log_fs.file_page_nr_next = ++file_nr;
-            return LOG_FS_ERR_NONE;
+            return;
         }
 
         // Note file number of next file entry
@@ -915,6 +2250,244 @@ log_fs_err_t log_fs_init(void)
     DBG_INFO("Last file at page %u", log_fs.file_page_last);
     DBG_INFO("Next file nr %u", log_fs.file_page_nr_next);
 
+}
+
+static log_fs_page_t log_fs_file_page_empty_find(void)
+{
+    log_fs_page_t   page;
+    log_fs_page_t   page_found = LOG_FS_CFG_PAGE_START;
+#if LOG_FS_CFG_ERASE_CNT
+    log_fs_marker_t marker;
+    u32_t           erase_cnt;
+    u32_t           erase_cnt_min = 0xffffffff;
+#endif
+
+    for(page = LOG_FS_CFG_PAGE_START; page <= LOG_FS_CFG_PAGE_END; page++)
+    {
+#if LOG_FS_CFG_ERASE_CNT
+        // FREE or BAD marker?
+        marker = log_fs_page_marker_get(page);
+        if(  (marker != LOG_FS_MARKER_FREE)
+           &&(marker != LOG_FS_MARKER_BAD )  )
+        {
+            continue;
+        }
+        // Least erased page so far?
+        erase_cnt = log_fs_page_erase_cnt_rd(page);
+        if(erase_cnt < erase_cnt_min)
+        {
+            erase_cnt_min = erase_cnt;
+            page_found    = page;
+        }
+#else
+        // First FREE page?
+        if(log_fs_page_marker_get(page) == LOG_FS_MARKER_FREE)
+        {
+            page_found = page;
+            break;
+        }
+#endif
+    }
+
+    return page_found;
+}
+
+#if LOG_FS_WINDOW_ROTATE
+static void log_fs_window_rotate(void)
+{
+    log_fs_page_t        file_page     = log_fs.file_page_open;
+    log_fs_page_t        file_page_new = log_fs_page_next(file_page);
+    log_fs_page_header_t page_header;
+#if LOG_FS_CFG_ERASE_CNT
+    u32_t                erase_cnt;
+#endif
+
+    // Only the newest file may move (pages after its window are not used by other files)
+    if(file_page != log_fs.file_page_last)
+    {
+        return;
+    }
+
+    // Read FILE page (page header, file info and file attribute data)
+    at45d_rd_page(log_fs_file_page_buf, file_page);
+    memcpy(&page_header, 
+           &log_fs_file_page_buf[0], 
+           sizeof(log_fs_page_header_t));
+    memcpy(&log_fs.file_info, 
+           &log_fs_file_page_buf[sizeof(log_fs_page_header_t)], 
+           sizeof(log_fs_file_info_t));
+
+#if LOG_FS_CFG_ERASE_CNT
+    // Erase counter of new page (incremented by the erase of the page write)
+    erase_cnt = log_fs_page_erase_cnt_rd(file_page_new) + 1;
+    page_header.erase_cnt = erase_cnt;
+    memcpy(&log_fs_file_page_buf[0], 
+           &page_header, 
+           sizeof(log_fs_page_header_t));
+#endif
+
+    // Set new start page
+    log_fs.file_info.file.start_page = file_page_new;
+    log_fs.file_info.crc             = log_fs_crc_file_info();
+    memcpy(&log_fs_file_page_buf[sizeof(log_fs_page_header_t)], 
+           &log_fs.file_info, 
+           sizeof(log_fs_file_info_t));
+
+    // Write copy of FILE page over page with oldest records (erased automatically)
+    DBG_INFO("Move file page %u to page %u", file_page, file_page_new);
+    at45d_wr_page(log_fs_file_page_buf, file_page_new);
+    log_fs.cnt.prg_pages++;
+    log_fs.cnt.prg_bytes += LOG_FS_CFG_PAGE_SIZE;
+    log_fs.cnt.erases++;
+#if LOG_FS_CFG_PAGE_INDEX
+    log_fs_index_set(file_page_new, LOG_FS_MARKER_FILE, page_header.nr);
+#endif
+
+    // Read back file block
+    if(!log_fs_file_block_rd(file_page_new))
+    {
+        // Page is erased again by the wrap. Restore file info of open file
+        DBG_ERR("Move failed (page %u)", file_page_new);
+        log_fs_file_block_rd(file_page);
+        return;
+    }
+
+    // Erase old FILE page and update state
+    log_fs_window_moved(file_page_new);
+
+#if LOG_FS_CFG_CHECKPOINT
+    // Journal moved file
+    log_fs_checkpoint_wr();
+#endif
+}
+
+static void log_fs_window_moved(log_fs_page_t file_page_new)
+{
+    log_fs_page_t   file_page = log_fs.file_page_open;
+    log_fs_marker_t marker;
+
+    // Erase old FILE page (if not done yet)
+    marker = log_fs_page_header_rd(file_page);
+    if(marker == LOG_FS_MARKER_FILE)
+    {
+        DBG_INFO("Erase old file page %u", file_page);
+        log_fs_page_erase(file_page);
+    }
+#if LOG_FS_CFG_PAGE_INDEX
+    else
+    {
+        log_fs_index_set(file_page, marker, 0);
+    }
+#endif
+
+    // Open file is the newest file (and maybe also the oldest)
+    if(log_fs.file_page_first == file_page)
+    {
+        log_fs.file_page_first = file_page_new;
+    }
+    log_fs.file_page_last            = file_page_new;
+    log_fs.file_page_open            = file_page_new;
+    log_fs.file_info.file.start_page = file_page_new;
+
+    // Oldest records were overwritten
+    if(log_fs.rec_page_first == file_page_new)
+    {
+        log_fs.rec_page_first = log_fs_page_header_find_first(LOG_FS_MARKER_RECORD,
+                                                              log_fs_record_pages_bound_start(),
+                                                              log_fs_record_pages_bound_end());
+        DBG_INFO("rec_page_first=%u", log_fs.rec_page_first);
+    }
+    if(log_fs.rec_adr_rd.page == file_page_new)
+    {
+        // Read position lost. Next read starts at first record
+        log_fs.rec_adr_rd.page = LOG_FS_PAGE_INVALID;
+    }
+}
+
+static void log_fs_window_fix(void)
+{
+    log_fs_page_t page;
+    log_fs_nr_t   nr;
+
+    for(page = LOG_FS_CFG_PAGE_START; page <= LOG_FS_CFG_PAGE_END; page++)
+    {
+        if(log_fs_page_header_get(page) != LOG_FS_MARKER_FILE)
+        {
+            continue;
+        }
+        nr = log_fs.page_header.nr;
+
+        // Followed by complete copy of FILE page?
+        if(  (log_fs_page_header_get(log_fs_page_next(page)) == LOG_FS_MARKER_FILE)
+           &&(log_fs.page_header.nr                          == nr                )
+           &&(log_fs_file_block_rd(log_fs_page_next(page))                        )  )
+        {
+            DBG_INFO("Erase old file page %u", page);
+            log_fs_page_erase(page);
+        }
+    }
+}
+#endif
+
+/* _____GLOBAL FUNCTIONS_____________________________________________________ */
+log_fs_err_t log_fs_init(void)
+{
+    // Report structure sizes so that correct packing of structures can be verified
+    DBG_INFO("Page header size: %u",  sizeof(log_fs_page_header_t));
+    DBG_INFO("File block size: %u",   sizeof(log_fs_file_info_t));
+    DBG_INFO("Record block size: %u", sizeof(log_fs_rec_block_t));
+    DBG_INFO("Record data size: %u",  LOG_FS_CFG_REC_DATA_SIZE);
+#if LOG_FS_CFG_REC_VAR_SIZE
+    DBG_INFO("Variable-length records");
+#else
+    DBG_INFO("Records per page: %u",  LOG_FS_REC_PAGE_DATA_SIZE / sizeof(log_fs_rec_block_t));
+#endif
+
+    // Sanity checks
+    DBG_ASSERT(sizeof(log_fs_rec_block_t) <= LOG_FS_REC_PAGE_DATA_SIZE);    
+#if !LOG_FS_CFG_REC_VAR_SIZE
+    if(LOG_FS_REC_PAGE_DATA_SIZE % sizeof(log_fs_rec_block_t) != 0)
+    {
+        DBG_WARN("%u bytes will be wasted per page", 
+                 LOG_FS_REC_PAGE_DATA_SIZE % sizeof(log_fs_rec_block_t));
+    }
+#endif
+
+    // Reset status
+    memset(&log_fs, 0, sizeof(log_fs_t));
+    log_fs.file_page_open = LOG_FS_PAGE_INVALID;
+
+#if LOG_FS_CFG_CHECKPOINT
+    // Sanity check
+    DBG_ASSERT(  (LOG_FS_CFG_CHECKPOINT_PAGE_END - LOG_FS_CFG_CHECKPOINT_PAGE_START + 1)
+               >= (2 * LOG_FS_CHECKPOINT_SLOT_PAGES)                                   );
+
+    // Restore newest valid checkpoint?
+    if(log_fs_checkpoint_rd())
+    {
+        return LOG_FS_ERR_NONE;
+    }
+#endif
+
+#if LOG_FS_CFG_PAGE_INDEX
+    // Index all page headers in one pass
+    DBG_INFO("Page index size: %u", sizeof(log_fs_index_state) + sizeof(log_fs_index_nr));
+    log_fs_index_build();
+#endif
+
+#if LOG_FS_WINDOW_ROTATE
+    // Complete interrupted move of a FILE page
+    log_fs_window_fix();
+#endif
+
+    // Find first and last file
+    log_fs_file_pages_find();
+
+#if LOG_FS_CFG_CHECKPOINT
+    // Write checkpoint so that next mount is fast
+    log_fs_checkpoint_wr();
+#endif
+
     return LOG_FS_ERR_NONE;
 }
 
@@ -936,7 +2509,7 @@ log_fs_err_t log_fs_create(const log_fs_time_stamp_t * time_stamp)
             // Next page
             page = log_fs_page_next(page);
             // Read page header
-            marker = log_fs_page_header_rd(page);
+            marker = log_fs_page_header_get(page);
             // Valid record page?
             if(marker == LOG_FS_MARKER_RECORD)
             {
@@ -950,7 +2523,7 @@ log_fs_err_t log_fs_create(const log_fs_time_stamp_t * time_stamp)
         page_new_file = log_fs_page_next(page_last_record);
 
         // Is this page a file marker?
-        if(log_fs_marker_rd(page_new_file, 0) == LOG_FS_MARKER_FILE)
+        if(log_fs_page_marker_get(page_new_file) == LOG_FS_MARKER_FILE)
         {
             // Yes, file system is full
             DBG_WARN("File system is full");
@@ -958,7 +2531,7 @@ log_fs_err_t log_fs_create(const log_fs_time_stamp_t * time_stamp)
         }
 
         // At least one more page available for records?
-        if(log_fs_marker_rd(log_fs_page_next(page_new_file), 0) == LOG_FS_MARKER_FILE)
+        if(log_fs_page_marker_get(log_fs_page_next(page_new_file)) == LOG_FS_MARKER_FILE)
         {
             // No, file system is full
             DBG_WARN("File system is full");
@@ -967,35 +2540,15 @@ log_fs_err_t log_fs_create(const log_fs_time_stamp_t * time_stamp)
     }
     else
     {
-        // Find first free page
-        page = LOG_FS_CFG_PAGE_START;
-        do
-        {
-            // FREE marker?
-            if(log_fs_marker_rd(page, 0) == LOG_FS_MARKER_FREE)
-            {
-                // This page will be used to create a new file
-                page_new_file = page;
-                break;
-            }
-            // Next page
-            page++;
-        }
-        while(page <= LOG_FS_CFG_PAGE_END);
-
-        // No FREE markers found?
-        if(page > LOG_FS_CFG_PAGE_END)
-        {
-            // Start at first page
-            page_new_file = LOG_FS_CFG_PAGE_START;            
-        }
+        // Find page to start with
+        page_new_file = log_fs_file_page_empty_find();
     }
 
     // Erase file page (if not FREE)
-    if(log_fs_marker_rd(page_new_file, 0) != LOG_FS_MARKER_FREE)
+    if(log_fs_page_marker_get(page_new_file) != LOG_FS_MARKER_FREE)
     {
         DBG_INFO("Erase file page %u", page_new_file);
-        at45d_erase_page(page_new_file);
+        log_fs_page_erase(page_new_file);
     }
 
     // Populate file info
@@ -1014,6 +2567,8 @@ log_fs_err_t log_fs_create(const log_fs_time_stamp_t * time_stamp)
 
     // Remember last file
     log_fs.file_page_last = page_new_file;
+    // New file is open
+    log_fs.file_page_open = page_new_file;
     // Is this also the first file?
     if(log_fs.file_page_first == LOG_FS_PAGE_INVALID)
     {
@@ -1025,10 +2580,10 @@ log_fs_err_t log_fs_create(const log_fs_time_stamp_t * time_stamp)
 
     // Erase first record page (if not FREE)
     page = log_fs_page_next(page_new_file);
-    if(log_fs_marker_rd(page, 0) != LOG_FS_MARKER_FREE)
+    if(log_fs_page_marker_get(page) != LOG_FS_MARKER_FREE)
     {
         DBG_INFO("Erase first record page %u", page);
-        at45d_erase_page(page);
+        log_fs_page_erase(page);
     }
 
     // Reset read and write addresses
@@ -1039,6 +2594,11 @@ log_fs_err_t log_fs_create(const log_fs_time_stamp_t * time_stamp)
     log_fs.rec_adr_wr.page   = page;
     log_fs.rec_adr_wr.offset = LOG_FS_REC_OFFSET_FIRST;
 
+#if LOG_FS_CFG_CHECKPOINT
+    // Journal new file
+    log_fs_checkpoint_wr();
+#endif
+
     return LOG_FS_ERR_NONE;
 }
 
@@ -1059,10 +2619,10 @@ size_t log_fs_file_attr_data_wr(log_fs_offset_t offset,
         nr_of_bytes = LOG_FS_FILE_ATTR_DATA_SIZE - offset;
     }
     // Write file attribute data
-    at45d_wr_page_offset(data, 
-                         log_fs.file_info.file.start_page, 
-                         sizeof(log_fs_page_header_t) + sizeof(log_fs_file_info_t) + offset,
-                         nr_of_bytes);
+    log_fs_page_wr_offset(data, 
+                          log_fs.file_info.file.start_page, 
+                          sizeof(log_fs_page_header_t) + sizeof(log_fs_file_info_t) + offset,
+                          nr_of_bytes);
 
     return nr_of_bytes;
 }
@@ -1169,8 +2729,9 @@ log_fs_err_t log_fs_file_find_next(log_fs_file_t * file)
         // Next page
         page = log_fs_page_next(page);        
 
-        // Read (possible) file entry at start of page
-        if(log_fs_file_block_rd(page))
+        // FILE page (in index) with a valid file entry at start of page?
+        if(  (log_fs_page_marker_get(page) == LOG_FS_MARKER_FILE)
+           &&(log_fs_file_block_rd(page)                        )  )
         {
             // Return file info
             memcpy(file, &log_fs.file_info.file, sizeof(log_fs_file_t));
@@ -1211,8 +2772,9 @@ log_fs_err_t log_fs_file_find_previous(log_fs_file_t * file)
         // Previous page
         page = log_fs_page_previous(page);
 
-        // Read (possible) file entry at start of page
-        if(log_fs_file_block_rd(page))
+        // FILE page (in index) with a valid file entry at start of page?
+        if(  (log_fs_page_marker_get(page) == LOG_FS_MARKER_FILE)
+           &&(log_fs_file_block_rd(page)                        )  )
         {
             // Return file info
             memcpy(file, &log_fs.file_info.file, sizeof(log_fs_file_t));
@@ -1257,12 +2819,13 @@ log_fs_err_t log_fs_open(const log_fs_file_t * file)
         DBG_ERR("Invalid file");
         return LOG_FS_ERR_FILE_INVALID;
     }    
+    log_fs.file_page_open = file->start_page;
 
     // Start search for record pages after file page
     rec_search_page_start = log_fs_record_pages_bound_start();
 
     // Two consecutive file pages?
-    if(log_fs_page_header_rd(rec_search_page_start) == LOG_FS_MARKER_FILE)
+    if(log_fs_page_header_get(rec_search_page_start) == LOG_FS_MARKER_FILE)
     {
         // File is empty
         DBG_INFO("File is empty");
@@ -1332,11 +2895,11 @@ log_fs_err_t log_fs_open(const log_fs_file_t * file)
         log_fs.rec_adr_wr.offset = LOG_FS_REC_OFFSET_FIRST;
 
         // First record page not FREE?
-        if(log_fs_marker_rd(rec_search_page_start, 0) != LOG_FS_MARKER_FREE)
+        if(log_fs_page_marker_get(rec_search_page_start) != LOG_FS_MARKER_FREE)
         {
             // Erase first record page
             DBG_INFO("Erase first record page %u", rec_search_page_start);
-            at45d_erase_page(rec_search_page_start);
+            log_fs_page_erase(rec_search_page_start);
         }
 
         return LOG_FS_ERR_NONE;
@@ -1401,19 +2964,10 @@ log_fs_err_t log_fs_open(const log_fs_file_t * file)
 
     // Find next free record position
     rec_page = log_fs.rec_page_last;
-    offset   = LOG_FS_REC_OFFSET_FIRST;
-    while(offset <= LOG_FS_REC_OFFSET_LAST)
-    {
-        marker = log_fs_marker_rd(rec_page, offset);
-        if(marker == LOG_FS_MARKER_FREE)
-        {
-            break;
-        }
-        offset += sizeof(log_fs_rec_block_t);
-    }
+    offset   = log_fs_record_offset_free(rec_page);
 
     // Free space found?
-    if(marker == LOG_FS_MARKER_FREE)
+    if(offset != LOG_FS_REC_OFFSET_END)
     {
         // Save location of first free record entry
         log_fs.rec_adr_wr.page   = rec_page;
@@ -1430,7 +2984,7 @@ log_fs_err_t log_fs_open(const log_fs_file_t * file)
         // Space available?
         if(rec_page != log_fs_page_next(log_fs_record_pages_bound_end()))
         {
-            marker = log_fs_marker_rd(rec_page, 0);
+            marker = log_fs_page_marker_get(rec_page);
             if(marker == LOG_FS_MARKER_FILE)
             {
                 DBG_INFO("File is full. More data cannot be appended");
@@ -1439,7 +2993,7 @@ log_fs_err_t log_fs_open(const log_fs_file_t * file)
             {
                 // Erase next page
                 DBG_INFO("Erase page %u", rec_page);
-                at45d_erase_page(rec_page);
+                log_fs_page_erase(rec_page);
             }
         }
 #endif
@@ -1447,14 +3001,14 @@ log_fs_err_t log_fs_open(const log_fs_file_t * file)
 #if (LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_CIRCULAR)
         // Maximum space reached?
         if(  (rec_page == log_fs_page_next(log_fs_record_pages_bound_end()))
-           ||(log_fs_marker_rd(rec_page, 0) == LOG_FS_MARKER_FILE          )  )
+           ||(log_fs_page_marker_get(rec_page) == LOG_FS_MARKER_FILE          )  )
         {
             // Wrap
             rec_page = log_fs_record_pages_bound_start();
         }
         // Erase next page
         DBG_INFO("Erase page %u", rec_page);
-        at45d_erase_page(rec_page);
+        log_fs_page_erase(rec_page);
         // First page erased?
         if(rec_page == log_fs.rec_page_first)
         {
@@ -1524,7 +3078,7 @@ log_fs_err_t log_fs_file_delete(const log_fs_file_t * file)
         page = log_fs_page_previous(page);
 
         // Read page header
-        marker = log_fs_page_header_rd(page);
+        marker = log_fs_page_header_get(page);
 
         if(marker == LOG_FS_MARKER_RECORD)
         {
@@ -1539,6 +3093,17 @@ log_fs_err_t log_fs_file_delete(const log_fs_file_t * file)
     DBG_INFO("Marking FILE page %u as BAD", page);
     log_fs_marker_wr(LOG_FS_MARKER_BAD, page, 0);
 
+    // Was deleted file open?
+    if(page == log_fs.file_page_open)
+    {
+        log_fs.file_page_open = LOG_FS_PAGE_INVALID;
+    }
+
+#if LOG_FS_CFG_CHECKPOINT
+    // Journal deleted file
+    log_fs_checkpoint_wr();
+#endif
+
     return LOG_FS_ERR_NONE;
 }
 
@@ -1552,7 +3117,7 @@ log_fs_err_t log_fs_record_rd_first(void * data, size_t nr_of_bytes)
 
     // Start before first record
     log_fs.rec_adr_rd.page   = log_fs_page_previous(log_fs.rec_page_first);
-    log_fs.rec_adr_rd.offset = LOG_FS_REC_OFFSET_LAST;    
+    log_fs.rec_adr_rd.offset = LOG_FS_REC_OFFSET_END;    
 
     // Return first valid record
     return log_fs_record_rd_next(data, nr_of_bytes);
@@ -1591,8 +3156,11 @@ log_fs_err_t log_fs_record_rd_next(void * data, size_t nr_of_bytes)
     // Find next valid record
     while(TRUE)
     {
+        // Next record address
+        offset = log_fs_record_offset_next(page, offset);
+
         // End of page?
-        if(offset >= LOG_FS_REC_OFFSET_LAST)
+        if(offset == LOG_FS_REC_OFFSET_END)
         {
             // Start record reading after page header
             offset = LOG_FS_REC_OFFSET_FIRST;
@@ -1637,7 +3205,7 @@ log_fs_err_t log_fs_record_rd_next(void * data, size_t nr_of_bytes)
 #endif
 
                 // Read page header
-                marker = log_fs_page_header_rd(page);
+                marker = log_fs_page_header_get(page);
 
 #if (LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_LINEAR)
                 // Next file reached?
@@ -1651,11 +3219,6 @@ log_fs_err_t log_fs_record_rd_next(void * data, size_t nr_of_bytes)
             }
             while(marker != LOG_FS_MARKER_RECORD);
         }
-        else
-        {
-            // Next record address
-            offset += sizeof(log_fs_rec_block_t);        
-        }
 
         // Has last record been read?
         if(  (page   == log_fs.rec_adr_wr.page  )
@@ -1696,12 +3259,12 @@ log_fs_err_t log_fs_record_rd_previous(void * data, size_t nr_of_bytes)
     // Find previous valid record
     while(TRUE)
     {
-        // End of page?
-        if(offset <= LOG_FS_REC_OFFSET_FIRST)
+        // Previous record address
+        offset = log_fs_record_offset_previous(page, offset);
+
+        // Start of page?
+        if(offset == LOG_FS_REC_OFFSET_END)
         {
-            // Start record reading at last offset
-            offset = LOG_FS_REC_OFFSET_LAST;
-            
             // Previous record page
             do
             {
@@ -1735,14 +3298,17 @@ log_fs_err_t log_fs_record_rd_previous(void * data, size_t nr_of_bytes)
                 }
 #endif
                 // Read page header
-                marker = log_fs_page_header_rd(page);
+                marker = log_fs_page_header_get(page);
             }
             while(marker != LOG_FS_MARKER_RECORD);            
-        }
-        else
-        {
-            // Previous record address
-            offset -= sizeof(log_fs_rec_block_t);        
+
+            // Start record reading at last record in page
+            offset = log_fs_record_offset_previous(page, LOG_FS_REC_OFFSET_END);
+            if(offset == LOG_FS_REC_OFFSET_END)
+            {
+                // No records in page
+                continue;
+            }
         }
 
         // Read record
@@ -1759,112 +3325,247 @@ log_fs_err_t log_fs_record_rd_previous(void * data, size_t nr_of_bytes)
     }
 }
 
-log_fs_err_t log_fs_record_wr(const void * data, size_t nr_of_bytes)
+size_t log_fs_record_size(void)
 {
-    size_t          i;
-    log_fs_marker_t marker;
-    log_fs_page_t   page    = log_fs.rec_adr_wr.page;
-    log_fs_page_t   offset  = log_fs.rec_adr_wr.offset;
-    u8_t *          data_u8 = (u8_t *)data;
-    bool_t          success;
+#if LOG_FS_CFG_REC_VAR_SIZE
+    return log_fs.record_block.len;
+#else
+    return LOG_FS_CFG_REC_DATA_SIZE;
+#endif
+}
 
-    // Record too small to hold all of the supplied data?
-    if(nr_of_bytes > LOG_FS_CFG_REC_DATA_SIZE)
+#if !LOG_FS_CFG_REC_VAR_SIZE
+log_fs_err_t log_fs_record_seek_index(u32_t  index,
+                                      void * data, 
+                                      size_t nr_of_bytes)
+{
+    log_fs_nr_t     nr_first;
+    log_fs_nr_t     nr;
+    u32_t           nr_seek;
+    log_fs_page_t   pos;
+    log_fs_page_t   pos_lo;
+    log_fs_page_t   pos_hi;
+    log_fs_page_t   pos_mid;
+    log_fs_page_t   page;
+    log_fs_offset_t offset;
+
+    // No record pages?
+    if(log_fs.rec_page_first == LOG_FS_PAGE_INVALID)
     {
-        DBG_ERR("Record size too small and %u bytes will be discarded",
-                (nr_of_bytes - LOG_FS_CFG_REC_DATA_SIZE));
+        return LOG_FS_ERR_NO_RECORD;
     }
 
-    // First record to write in page?
-    if(offset == LOG_FS_REC_OFFSET_FIRST)
+    // Fetch rolling number of first record page
+    if(log_fs_page_header_get(log_fs.rec_page_first) != LOG_FS_MARKER_RECORD)
     {
-        // Read page's marker
-        marker = log_fs_marker_rd(page, 0);
- 
-#if (LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_LINEAR)
-        // Maximum space reached?
-        if(  (marker == LOG_FS_MARKER_FILE                               )
-           ||(page   == log_fs_page_next(log_fs_record_pages_bound_end()))  )
+        DBG_ERR("First record page %u invalid", log_fs.rec_page_first);
+        return LOG_FS_ERR_NO_RECORD;
+    }
+    nr_first = log_fs.page_header.nr;
+
+    // Calculate record page (relative rolling number) and offset in page
+    nr_seek = index / LOG_FS_RECORDS_PER_PAGE;
+    offset  = LOG_FS_REC_OFFSET_FIRST + (index % LOG_FS_RECORDS_PER_PAGE) * sizeof(log_fs_rec_block_t);
+
+    // Bisect record pages (rolling numbers increase, but BAD pages are skipped)
+    pos_lo = 0;
+    pos_hi = log_fs_record_page_pos_last() + 1;
+    while(pos_lo < pos_hi)
+    {
+        pos_mid = pos_lo + (pos_hi - pos_lo) / 2;
+        pos     = pos_mid;
+        // Only BAD pages in upper half?
+        if(!log_fs_record_page_find(&pos, pos_hi - 1))
         {
-            // File system full
-            DBG_WARN("File system is full");
-            return LOG_FS_ERR_FULL;
+            pos_hi = pos_mid;
+            continue;
+        }
+        nr = log_fs.page_header.nr - nr_first;
+        if(nr == nr_seek)
+        {
+            // Record page found
+            page = log_fs_record_page_at(pos);
+            // Record not written yet?
+            if(  (page   == log_fs.rec_adr_wr.page  )
+               &&(offset >= log_fs.rec_adr_wr.offset)  )
+            {
+                return LOG_FS_ERR_NO_RECORD;
+            }
+            // Read record
+            log_fs.rec_adr_rd.page   = page;
+            log_fs.rec_adr_rd.offset = offset;
+            if(log_fs_record_block_rd(page, offset))
+            {
+                // More bytes requested than can be stored in record?
+                if(nr_of_bytes > LOG_FS_CFG_REC_DATA_SIZE)
+                {
+                    DBG_ERR("More bytes requested than can be stored in a record");
+                    // Clip number of bytes that will be copied
+                    nr_of_bytes = LOG_FS_CFG_REC_DATA_SIZE;
+                }
+                // Copy content of record to user supplied buffer
+                memcpy(data, &log_fs.record_block.data, nr_of_bytes);
+                return LOG_FS_ERR_NONE;
+            }
+            // Record is BAD; return next valid record
+            return log_fs_record_rd_next(data, nr_of_bytes);
+        }
+        else if(nr < nr_seek)
+        {
+            // Search upper half
+            pos_lo = pos + 1;
         }
+        else
+        {
+            // Search lower half
+            pos_hi = pos_mid;
+        }
+    }
+
+    // Record page does not exist (beyond last record or page is BAD)
+    return LOG_FS_ERR_NO_RECORD;
+}
 #endif
 
-        // Page marked as BAD?
-        if(marker == LOG_FS_MARKER_BAD)
+#if LOG_FS_CFG_REC_TIME_STAMP
+log_fs_err_t log_fs_record_seek_time(const log_fs_time_stamp_t * time_stamp,
+                                     void *                      data, 
+                                     size_t                      nr_of_bytes)
+{
+    log_fs_err_t    err;
+    log_fs_page_t   pos;
+    log_fs_page_t   pos_lo;
+    log_fs_page_t   pos_hi;
+    log_fs_page_t   pos_mid;
+    log_fs_page_t   page;
+    log_fs_page_t   page_found   = LOG_FS_PAGE_INVALID;
+    log_fs_offset_t offset;
+    log_fs_offset_t offset_found = 0;
+
+    // No record pages?
+    if(log_fs.rec_page_first == LOG_FS_PAGE_INVALID)
+    {
+        return LOG_FS_ERR_NO_RECORD;
+    }
+
+    // Bisect record pages to find the last page that starts with an older record
+    pos_lo = 0;
+    pos_hi = log_fs_record_page_pos_last() + 1;
+    while(pos_lo < pos_hi)
+    {
+        pos_mid = pos_lo + (pos_hi - pos_lo) / 2;
+        // Find first RECORD page (with a valid record) in upper half
+        pos = pos_mid;
+        while(TRUE)
         {
-            DBG_INFO("Erase page %u", page);
-            at45d_erase_page(page);
+            if(!log_fs_record_page_find(&pos, pos_hi - 1))
+            {
+                page = LOG_FS_PAGE_INVALID;
+                break;
+            }
+            page = log_fs_record_page_at(pos);
+            if(log_fs_record_page_first_rd(page, &offset))
+            {
+                break;
+            }
+            pos++;
         }
-
-        // Write record page header
-        log_fs.page_header.marker  = LOG_FS_MARKER_RECORD;
-        log_fs.page_header.nr      = log_fs.rec_page_nr_next;
-        if(!log_fs_page_header_wr(page))
+        // Nothing in upper half or first record is not older?
+        if(  (page == LOG_FS_PAGE_INVALID)
+           ||(memcmp(log_fs.record_block.data, time_stamp, sizeof(log_fs_time_stamp_t)) >= 0)  )
         {
-            // Failed to write record page header. Move on to next page
-            page = log_fs_page_next(page);
+            // Search lower half
+            pos_hi = pos_mid;
+        }
+        else
+        {
+            // Remember page and search upper half
+            page_found   = page;
+            offset_found = offset;
+            pos_lo       = pos + 1;
+        }
+    }
+
+    if(page_found == LOG_FS_PAGE_INVALID)
+    {
+        // Start at first record
+        err = log_fs_record_rd_first(data, nr_of_bytes);
+    }
+    else
+    {
+        // Start after older record
+        log_fs.rec_adr_rd.page   = page_found;
+        log_fs.rec_adr_rd.offset = offset_found;
+        err = log_fs_record_rd_next(data, nr_of_bytes);
+    }
 
-            // Read next page's marker
-            marker = log_fs_marker_rd(page, 0);
+    // Skip older records (at most one page of records)
+    while(  (err == LOG_FS_ERR_NONE)
+          &&(memcmp(log_fs.record_block.data, time_stamp, sizeof(log_fs_time_stamp_t)) < 0)  )
+    {
+        err = log_fs_record_rd_next(data, nr_of_bytes);
+    }
 
-            // Maximum space reached?
-            if(  (marker == LOG_FS_MARKER_FILE                               )
-               ||(page   == log_fs_page_next(log_fs_record_pages_bound_end()))  )
-            {
-#if (LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_LINEAR)
-                // File system full
-                DBG_WARN("File system is full");
-                return LOG_FS_ERR_FULL;
+    return err;
+}
 #endif
 
-#if (LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_CIRCULAR)
-                // Wrap
-                page = log_fs_record_pages_bound_start();
+log_fs_err_t log_fs_record_wr(const void * data, size_t nr_of_bytes)
+{
+    size_t          i;
+    log_fs_err_t    err;
+    log_fs_page_t   page;
+    log_fs_page_t   offset;
+    log_fs_offset_t size;
+    u8_t *          data_u8 = (u8_t *)data;
+    bool_t          success;
+
+    // Record too small to hold all of the supplied data?
+    if(nr_of_bytes > LOG_FS_CFG_REC_DATA_SIZE)
+    {
+        DBG_ERR("Record size too small and %u bytes will be discarded",
+                (nr_of_bytes - LOG_FS_CFG_REC_DATA_SIZE));
+#if LOG_FS_CFG_REC_VAR_SIZE
+        nr_of_bytes = LOG_FS_CFG_REC_DATA_SIZE;
 #endif
-            }
+    }
 
-            // Erase next page
-            DBG_INFO("Erase page %u", page);
-            at45d_erase_page(page);
-            // Next record write page (record number is not incremented)
-            log_fs.rec_adr_wr.page = page;
+#if LOG_FS_CFG_REC_VAR_SIZE
+    // Set record length
+    log_fs.record_block.len = (u8_t)nr_of_bytes;
+    size = LOG_FS_REC_SIZE(nr_of_bytes);
 
-#if (LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_CIRCULAR)
-            // First record page erased?
-            if(page == log_fs.rec_page_first)
-            {
-                // Next record page will be the first
-                log_fs.rec_page_first = log_fs_page_header_find_next(LOG_FS_MARKER_RECORD,
-                                                                     log_fs_record_pages_bound_start(),
-                                                                     log_fs_record_pages_bound_end(),
-                                                                     log_fs.rec_page_first);
-                DBG_INFO("rec_page_first=%u", log_fs.rec_page_first);
-            }
+    // Record does not fit in rest of page?
+    if(log_fs.rec_adr_wr.offset + size > LOG_FS_REC_OFFSET_END)
+    {
+        // Erase next page and move write address to it
+        log_fs_record_page_next();
+    }
+#else
+    size = sizeof(log_fs_rec_block_t);
 #endif
-            // Failed to write record page header correctly
-            DBG_WARN("Write failed");
-            return LOG_FS_ERR_WRITE_FAIL;
-        }
-        DBG_INFO("Page %u written with RECORD page header (nr=%u)",
-                 log_fs.rec_adr_wr.page,
-                 log_fs.page_header.nr);
-        // Next record number
-        log_fs.rec_page_nr_next++;
-        DBG_INFO("rec_page_nr_next=%u", log_fs.rec_page_nr_next);
 
-        // Update last record page
-        log_fs.rec_page_last = page;
-        DBG_INFO("rec_page_last=%u", log_fs.rec_page_last);
-        // Is this also the first record page?
-        if(log_fs.rec_page_first == LOG_FS_PAGE_INVALID)
+    // First record to write in page?
+    if(log_fs.rec_adr_wr.offset == LOG_FS_REC_OFFSET_FIRST)
+    {
+        // Write record page header
+        err = log_fs_record_page_start();
+        if(err != LOG_FS_ERR_NONE)
         {
-            log_fs.rec_page_first = page;
-            DBG_INFO("rec_page_first=%u", log_fs.rec_page_first);
+            return err;
         }
-        
+    }
+    page   = log_fs.rec_adr_wr.page;
+    offset = log_fs.rec_adr_wr.offset;
+
+    // Keep write statistics
+    if(nr_of_bytes < LOG_FS_CFG_REC_DATA_SIZE)
+    {
+        log_fs.cnt.rec_bytes += nr_of_bytes;
+    }
+    else
+    {
+        log_fs.cnt.rec_bytes += LOG_FS_CFG_REC_DATA_SIZE;
     }
 
     // Copy data
@@ -1888,56 +3589,160 @@ log_fs_err_t log_fs_record_wr(const void * data, size_t nr_of_bytes)
     success = log_fs_record_block_wr(page, offset);
 
     // Last record in page?
-    if(offset == LOG_FS_REC_OFFSET_LAST)
+    if(LOG_FS_REC_PAGE_FULL(offset + size))
     {
-        // Next page
-        page = log_fs_page_next(page);
+        // Erase next page and move write address to it
+        log_fs_record_page_next();
+    }
+#if LOG_FS_CFG_REC_VAR_SIZE
+    // Record length not written correctly (chain is broken)?
+    else if(  (!success                                    )
+            &&(log_fs_record_size_rd(page, offset) != size)  )
+    {
+        // Erase next page and move write address to it
+        log_fs_record_page_next();
+    }
+#endif
+    else
+    {
+        // Next offset
+        log_fs.rec_adr_wr.offset = offset + size;
+    }
+    
+    // Success?
+    if(success)
+    {
+        return LOG_FS_ERR_NONE;
+    }
+    else
+    {
+        DBG_WARN("Write failed");
+        return LOG_FS_ERR_WRITE_FAIL;
+    }
+}
 
-#if (LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_LINEAR)
-        // Space available?
-        if(  (page != log_fs_page_next(log_fs_record_pages_bound_end()))
-           &&(log_fs_marker_rd(page, 0) != LOG_FS_MARKER_FILE          )  )
+log_fs_err_t log_fs_record_wr_batch(const void * recs, size_t nr_of_recs)
+{
+    size_t               i;
+    size_t               nr;
+    log_fs_err_t         err;
+    log_fs_page_t        page;
+    log_fs_offset_t      offset;
+    log_fs_rec_block_t * block;
+    const u8_t *         recs_u8 = (const u8_t *)recs;
+    bool_t               success = TRUE;
+#if LOG_FS_CFG_REC_VAR_SIZE
+    bool_t               chain_broken;
+#endif
+
+    while(nr_of_recs != 0)
+    {
+        // First record to write in page?
+        if(log_fs.rec_adr_wr.offset == LOG_FS_REC_OFFSET_FIRST)
+        {
+            // Write record page header
+            err = log_fs_record_page_start();
+            if(err != LOG_FS_ERR_NONE)
+            {
+                return err;
+            }
+        }
+        page   = log_fs.rec_adr_wr.page;
+        offset = log_fs.rec_adr_wr.offset;
+
+        // Number of records that fit in the rest of the page
+        nr = (LOG_FS_REC_OFFSET_END - offset) / sizeof(log_fs_rec_block_t);
+#if LOG_FS_CFG_REC_VAR_SIZE
+        if(nr == 0)
         {
-            // Erase next page
-            DBG_INFO("Erase page %u", page);
-            at45d_erase_page(page);
+            // Erase next page and move write address to it
+            log_fs_record_page_next();
+            continue;
         }
 #endif
+        if(nr > nr_of_recs)
+        {
+            nr = nr_of_recs;
+        }
 
-#if (LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_CIRCULAR)
-        // Maximum space reached?
-        if(  (page == log_fs_page_next(log_fs_record_pages_bound_end()))
-           ||(log_fs_marker_rd(page, 0) == LOG_FS_MARKER_FILE          )  )
+        // Populate record blocks
+        block = (log_fs_rec_block_t *)log_fs_rec_buf;
+#if LOG_FS_CFG_REC_VAR_SIZE
+        chain_broken = FALSE;
+#endif
+        for(i = 0; i < nr; i++)
         {
-            // Wrap
-            page = log_fs_record_pages_bound_start();
+            block[i].marker = LOG_FS_MARKER_RECORD;
+#if LOG_FS_CFG_REC_VAR_SIZE
+            block[i].len    = LOG_FS_CFG_REC_DATA_SIZE;
+#endif
+            memcpy(block[i].data, &recs_u8[i * LOG_FS_CFG_REC_DATA_SIZE], LOG_FS_CFG_REC_DATA_SIZE);
+            block[i].crc    = log_fs_crc_calc(&block[i], offsetof(log_fs_rec_block_t, crc));
         }
-        // Erase next page
-        DBG_INFO("Erase page %u", page);
-        at45d_erase_page(page);
 
-        // First record page erased?
-        if(page == log_fs.rec_page_first)
+        // Write record blocks with a single buffer fill and page program
+        DBG_INFO("Write %u records (page %u, offset %u)", nr, page, offset);
+        log_fs_page_wr_offset(log_fs_rec_buf,
+                              page,
+                              offset,
+                              nr * sizeof(log_fs_rec_block_t));
+
+        // Read back record blocks
+        at45d_rd_page_offset(log_fs_rec_buf,
+                             page,
+                             offset,
+                             nr * sizeof(log_fs_rec_block_t));
+
+        // Verify each record block
+        for(i = 0; i < nr; i++)
         {
-            // Next record page will be the first
-            log_fs.rec_page_first = log_fs_page_header_find_next(LOG_FS_MARKER_RECORD,
-                                                                 log_fs_record_pages_bound_start(),
-                                                                 log_fs_record_pages_bound_end(),
-                                                                 log_fs.rec_page_first);
-            DBG_INFO("rec_page_first=%u", log_fs.rec_page_first);
+#if LOG_FS_CFG_REC_VAR_SIZE
+            if(block[i].len != LOG_FS_CFG_REC_DATA_SIZE)
+            {
+                chain_broken = TRUE;
+            }
+#endif
+            if(  (block[i].marker != LOG_FS_MARKER_RECORD)
+               ||(memcmp(block[i].data, &recs_u8[i * LOG_FS_CFG_REC_DATA_SIZE], LOG_FS_CFG_REC_DATA_SIZE) != 0)
+               ||(block[i].crc != log_fs_crc_calc(&block[i], offsetof(log_fs_rec_block_t, crc)))  )
+            {
+                // Mark record as BAD
+                DBG_ERR("Record block write failed (page %u, offset %u)",
+                        page, offset + i * sizeof(log_fs_rec_block_t));
+                log_fs_marker_wr(LOG_FS_MARKER_BAD, page, offset + i * sizeof(log_fs_rec_block_t));
+                success = FALSE;
+            }
+        }
+
+        // Keep write statistics
+        log_fs.cnt.rec_bytes += nr * LOG_FS_CFG_REC_DATA_SIZE;
+
+        // Next records
+        recs_u8    += nr * LOG_FS_CFG_REC_DATA_SIZE;
+        nr_of_recs -= nr;
+        offset     += nr * sizeof(log_fs_rec_block_t);
+
+#if LOG_FS_CFG_REC_VAR_SIZE
+        // Record length not written correctly (chain is broken)?
+        if(chain_broken)
+        {
+            offset = LOG_FS_REC_OFFSET_END;
         }
 #endif
 
-        // Next record write address
-        log_fs.rec_adr_wr.page   = page;
-        log_fs.rec_adr_wr.offset = LOG_FS_REC_OFFSET_FIRST;        
-    }
-    else
-    {
-        // Next offset
-        log_fs.rec_adr_wr.offset = offset + sizeof(log_fs_rec_block_t);
+        // Page full?
+        if(LOG_FS_REC_PAGE_FULL(offset))
+        {
+            // Erase next page and move write address to it
+            log_fs_record_page_next();
+        }
+        else
+        {
+            // Next offset
+            log_fs.rec_adr_wr.offset = offset;
+        }
     }
-    
+
     // Success?
     if(success)
     {
@@ -1950,6 +3755,144 @@ log_fs_err_t log_fs_record_wr(const void * data, size_t nr_of_bytes)
     }
 }
 
+#if LOG_FS_CFG_CHECKPOINT
+void log_fs_checkpoint_wr(void)
+{
+    log_fs_checkpoint_t checkpoint;
+    log_fs_page_t       page;
+    log_fs_offset_t     offset = 0;
+    u16_t               crc;
+
+    // Populate checkpoint header
+    checkpoint.magic             = LOG_FS_CHECKPOINT_MAGIC;
+    checkpoint.seq               = log_fs_checkpoint_seq + 1;
+    checkpoint.page_start        = LOG_FS_CFG_PAGE_START;
+    checkpoint.page_end          = LOG_FS_CFG_PAGE_END;
+    checkpoint.file_page_first   = log_fs.file_page_first;
+    checkpoint.file_page_last    = log_fs.file_page_last;
+    checkpoint.file_page_nr_next = log_fs.file_page_nr_next;
+    checkpoint.file_page_open    = log_fs.file_page_open;
+    checkpoint.rec_page_first    = log_fs.rec_page_first;
+    checkpoint.rec_page_last     = log_fs.rec_page_last;
+    checkpoint.rec_page_nr_next  = log_fs.rec_page_nr_next;
+    checkpoint.rec_adr_wr        = log_fs.rec_adr_wr;
+
+    // Use next slot (slots are used in turn to spread the wear)
+    if(++log_fs_checkpoint_slot >= LOG_FS_CHECKPOINT_SLOTS)
+    {
+        log_fs_checkpoint_slot = 0;
+    }
+    page = LOG_FS_CFG_CHECKPOINT_PAGE_START + log_fs_checkpoint_slot * LOG_FS_CHECKPOINT_SLOT_PAGES;
+    DBG_INFO("Write checkpoint %lu (slot %u)", (unsigned long)checkpoint.seq, log_fs_checkpoint_slot);
+
+    // Write checkpoint header, RAM index and CRC
+    crc = crc16_ccitt_calc(0xffff, &checkpoint,        sizeof(log_fs_checkpoint_t));
+    crc = crc16_ccitt_calc(crc,    log_fs_index_state, sizeof(log_fs_index_state));
+    crc = crc16_ccitt_calc(crc,    log_fs_index_nr,    sizeof(log_fs_index_nr));
+    log_fs_checkpoint_data_wr(&page, &offset, &checkpoint,        sizeof(log_fs_checkpoint_t));
+    log_fs_checkpoint_data_wr(&page, &offset, log_fs_index_state, sizeof(log_fs_index_state));
+    log_fs_checkpoint_data_wr(&page, &offset, log_fs_index_nr,    sizeof(log_fs_index_nr));
+    log_fs_checkpoint_data_wr(&page, &offset, &crc,               sizeof(crc));
+
+    // Write last partially filled page
+    if(offset != 0)
+    {
+        memset(&log_fs_checkpoint_buf[offset], 0xff, LOG_FS_CFG_PAGE_SIZE - offset);
+        log_fs_checkpoint_page_wr(page);
+    }
+
+    // Checkpoint is now the newest
+    log_fs_checkpoint_seq       = checkpoint.seq;
+    log_fs_checkpoint_rec_pages = 0;
+}
+#endif
+
+void log_fs_stats(log_fs_stats_t * stats)
+{
+    log_fs_page_t page;
+#if LOG_FS_CFG_ERASE_CNT
+    u32_t         erase_cnt;
+    u32_t         bin;
+#endif
+
+    memset(stats, 0, sizeof(log_fs_stats_t));
+
+    for(page = LOG_FS_CFG_PAGE_START; page <= LOG_FS_CFG_PAGE_END; page++)
+    {
+        // Count page states
+        switch(log_fs_page_marker_get(page))
+        {
+        case LOG_FS_MARKER_FREE:
+            stats->pages_free++;
+            break;
+        case LOG_FS_MARKER_FILE:
+            stats->pages_file++;
+            break;
+        case LOG_FS_MARKER_RECORD:
+            stats->pages_record++;
+            break;
+        default:
+            stats->pages_bad++;
+            break;
+        }
+
+#if LOG_FS_CFG_ERASE_CNT
+        // Erase count range and total
+        erase_cnt = log_fs_page_erase_cnt_rd(page);
+        if(  (page == LOG_FS_CFG_PAGE_START)
+           ||(erase_cnt < stats->erase_min )  )
+        {
+            stats->erase_min = erase_cnt;
+        }
+        if(erase_cnt > stats->erase_max)
+        {
+            stats->erase_max = erase_cnt;
+        }
+        stats->erase_total += erase_cnt;
+
+        // Histogram of wear (erase count relative to endurance)
+        bin = erase_cnt / UDIV_ROUNDUP(LOG_FS_CFG_ERASE_ENDURANCE, LOG_FS_STATS_HIST_BINS);
+        if(bin >= LOG_FS_STATS_HIST_BINS)
+        {
+            bin = LOG_FS_STATS_HIST_BINS - 1;
+        }
+        stats->erase_hist[bin]++;
+#endif
+    }
+
+#if LOG_FS_CFG_ERASE_CNT
+    // Wear of most erased page
+    if(stats->erase_max >= LOG_FS_CFG_ERASE_ENDURANCE)
+    {
+        stats->wear_pct = 100;
+    }
+    else
+    {
+        stats->wear_pct = (u8_t)(stats->erase_max / UDIV_ROUNDUP(LOG_FS_CFG_ERASE_ENDURANCE, 100));
+    }
+#endif
+
+    // Write statistics since log_fs_init()
+    stats->rec_bytes  = log_fs.cnt.rec_bytes;
+    stats->prg_bytes  = log_fs.cnt.prg_bytes;
+    stats->prg_pages  = log_fs.cnt.prg_pages;
+    stats->erases     = log_fs.cnt.erases;
+    stats->bad_marked = log_fs.cnt.bad_marked;
+
+    // Write amplification (avoid 32-bit overflow)
+    if(log_fs.cnt.rec_bytes != 0)
+    {
+        if(log_fs.cnt.prg_bytes < (0xffffffff / 100))
+        {
+            stats->wr_amp_x100 = (log_fs.cnt.prg_bytes * 100) / log_fs.cnt.rec_bytes;
+        }
+        else
+        {
+            stats->wr_amp_x100 = log_fs.cnt.prg_bytes / UDIV_ROUNDUP(log_fs.cnt.rec_bytes, 100);
+        }
+    }
+}
+
 void log_fs_info(void)
 {
     log_fs_page_t page;
@@ -1961,7 +3904,11 @@ void log_fs_info(void)
     printf("Page size: %u\n",         AT45D_PAGE_SIZE);
     printf("Record size: %u\n",       sizeof(log_fs_rec_block_t));
     printf("Record data size: %u\n",  LOG_FS_CFG_REC_DATA_SIZE);
+#if LOG_FS_CFG_REC_VAR_SIZE
+    printf("Records per page: variable\n");
+#else
     printf("Records per page: %u\n",  LOG_FS_REC_PAGE_DATA_SIZE / sizeof(log_fs_rec_block_t));
+#endif
     printf("First file: %u\n",        log_fs.file_page_first);
     printf("Last file: %u\n",         log_fs.file_page_last);
 
@@ -1980,7 +3927,7 @@ void log_fs_info(void)
         	printf("\n0x%04X: ", page);
         }
 
-        marker = log_fs_page_header_rd(page);
+        marker = log_fs_page_header_get(page);
         switch(marker)
         {
         case LOG_FS_MARKER_FREE:
@@ -0,0 +1,455 @@
+/**
+ * at45d.c: RAM-backed stand-in for the AT45D DataFlash driver
+ * (data_Manager/at45d.c), so that log_fs runs on the host.
+ *
+ * Host tool, not part of the firmware. The functions of at45d.h send the same
+ * command sequences as the real driver, but the DataFlash is modelled in RAM:
+ * - main memory with an erase count per page;
+ * - two SRAM buffers; a buffer can be written while the other one is being
+ *   programmed, as with AT45D_CFG_DOUBLE_BUFFER;
+ * - "program without erase" can only clear bits (page &= buffer);
+ * - page program and erase keep the DataFlash busy for AT45D_SIM_T_*_NS.
+ * Time advances by AT45D_SIM_T_BYTE_NS per SPI byte (plus
+ * AT45D_SIM_T_CS_NS per transaction) and by the status polls while busy.
+ * The polls are not looped: the number that a busy-wait would need is
+ * calculated, and at45d_stats_t is updated as the real driver would.
+ *
+ * With AT45D_CFG_DMA, at45d_rd_async() and at45d_wr_page_async() return with
+ * the transfer pending. It is finished (what at45d_dma_irq() does, including
+ * the start of the program of the SRAM buffer) when the driver is called
+ * next, at the time the last byte would have been sent.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "at45d_sim.h"
+
+/* Timing (AT45DB041E typical values, 20 MHz SPI); override with -D */
+#ifndef AT45D_SIM_T_BYTE_NS
+#define AT45D_SIM_T_BYTE_NS     400       /* SPI byte at AT45D_MAX_SPI_CLOCK_HZ */
+#endif
+#ifndef AT45D_SIM_T_CS_NS
+#define AT45D_SIM_T_CS_NS       200       /* Chip select and command set-up */
+#endif
+#ifndef AT45D_SIM_T_EP_NS
+#define AT45D_SIM_T_EP_NS       12000000  /* Page erase and program (tEP) */
+#endif
+#ifndef AT45D_SIM_T_P_NS
+#define AT45D_SIM_T_P_NS        1500000   /* Page program (tP) */
+#endif
+#ifndef AT45D_SIM_T_PE_NS
+#define AT45D_SIM_T_PE_NS       7000000   /* Page erase (tPE) */
+#endif
+
+/* Status register read: command and status byte */
+#define STATUS_RD_BYTES         2
+#define T_STATUS_RD_NS          (AT45D_SIM_T_CS_NS + STATUS_RD_BYTES * AT45D_SIM_T_BYTE_NS)
+
+/* Command with 3 address bytes, and the 4 don't care bytes of a read */
+#define CMD_ADR_BYTES           4
+#define RD_DUMMY_BYTES          4
+
+#define AT45D_DOUBLE_BUFFER     ((AT45D_CFG_DOUBLE_BUFFER != 0) && (AT45D_SRAM_BUFFERS == 2))
+
+static u8_t mem[AT45D_FLASH_SIZE_BYTES];
+static u32_t erase_cnt[AT45D_PAGES];
+static u8_t sram[2][AT45D_PAGE_SIZE];
+
+static uint64_t now_ns;
+static uint64_t wait_ns;
+static uint64_t busy_until_ns;          /* DataFlash busy until then */
+static uint64_t sram_busy_until_ns[2];  /* Buffer is being programmed until then */
+static u16_t sram_data_start[2];        /* Bytes written by the caller (the rest is 0xFF) */
+static u16_t sram_data_end[2];
+
+static at45d_sim_errors_t errors;
+static at45d_stats_t at45d_stats;
+static at45d_busy_handler_t at45d_busy_handler;
+static bool_t at45d_ready_flag;
+#if AT45D_DOUBLE_BUFFER
+static u8_t at45d_buf_next;
+#endif
+#if AT45D_CFG_DMA
+static bool_t dma_busy;                 /* Asynchronous transfer pending */
+static uint64_t dma_done_ns;            /* Time at which its last byte has been sent */
+static bool_t dma_prg;                  /* Program a page when it is done */
+static u8_t dma_buf;                    /* SRAM buffer to program (double buffer) */
+static u16_t dma_page;
+static at45d_callback_t dma_callback;
+
+static void at45d_buf_prg(u8_t buf, bool_t erase, u16_t page);
+#endif
+
+static void spi_xfer(u32_t nr_of_bytes)
+{
+  at45d_stats.transactions++;
+  at45d_stats.bytes += nr_of_bytes;
+  now_ns += AT45D_SIM_T_CS_NS + (uint64_t)nr_of_bytes * AT45D_SIM_T_BYTE_NS;
+}
+
+static void start_busy(uint64_t t_ns)
+{
+  busy_until_ns = now_ns + t_ns;
+  at45d_ready_flag = FALSE;
+}
+
+static u8_t status_rd(void)
+{
+  u8_t status = AT45D_DENSITY | (AT45D_CFG_PWR_OF_TWO_PAGE_SIZE ? (1 << AT45D_STATUS_PAGE_SIZE) : 0);
+
+  /* The status byte is sampled at the start of the read */
+  if (now_ns >= busy_until_ns) {
+    status |= 1 << AT45D_STATUS_READY;
+  }
+  spi_xfer(STATUS_RD_BYTES);
+  return status;
+}
+
+#if AT45D_CFG_DMA
+/* Start an asynchronous transfer of nr_of_bytes (command included) */
+static void dma_start(u32_t nr_of_bytes, at45d_callback_t callback)
+{
+  at45d_stats.transactions++;
+  at45d_stats.bytes += nr_of_bytes;
+  at45d_stats.bytes_dma += nr_of_bytes;
+  dma_done_ns = now_ns + AT45D_SIM_T_CS_NS + (uint64_t)nr_of_bytes * AT45D_SIM_T_BYTE_NS;
+  dma_callback = callback;
+  dma_busy = TRUE;
+}
+
+/* Wait for the asynchronous transfer and finish it as at45d_dma_irq() does */
+static void dma_wait(void)
+{
+  if (!dma_busy) {
+    return;
+  }
+  if (now_ns < dma_done_ns) {
+    wait_ns += dma_done_ns - now_ns;
+    now_ns = dma_done_ns;
+  }
+  dma_busy = FALSE;
+  if (dma_prg) {
+#if AT45D_DOUBLE_BUFFER
+    /* The DataFlash was ready before the buffer write: this does not wait */
+    at45d_buf_prg(dma_buf, TRUE, dma_page);
+#else
+    /* Deselecting the DataFlash starts the main memory program through buffer 1 */
+    memcpy(&mem[(u32_t)dma_page * AT45D_PAGE_SIZE], sram[0], AT45D_PAGE_SIZE);
+    erase_cnt[dma_page]++;
+    start_busy(AT45D_SIM_T_EP_NS);
+    sram_busy_until_ns[0] = busy_until_ns;
+    at45d_stats.programs++;
+#endif
+  }
+  if (dma_callback != NULL) {
+    dma_callback(TRUE);
+  }
+}
+#endif
+
+static void at45d_wait_ready(void)
+{
+  uint64_t polls;
+
+#if AT45D_CFG_DMA
+  dma_wait();
+#endif
+  if (at45d_ready()) {
+    return;
+  }
+  at45d_stats.waits++;
+  if (at45d_busy_handler != NULL) {
+    at45d_busy_handler();
+  }
+
+  /* Busy polls that a busy-wait would still do, then the one that finds it ready */
+  polls = 0;
+  if (now_ns < busy_until_ns) {
+    polls = (busy_until_ns - now_ns + T_STATUS_RD_NS - 1) / T_STATUS_RD_NS;
+  }
+  at45d_stats.busy_polls += (u32_t)polls;
+  at45d_stats.transactions += (u32_t)polls + 1;
+  at45d_stats.bytes += (u32_t)(polls + 1) * STATUS_RD_BYTES;
+  wait_ns += (polls + 1) * T_STATUS_RD_NS;
+  now_ns += (polls + 1) * T_STATUS_RD_NS;
+  at45d_ready_flag = TRUE;
+}
+
+static void at45d_buf_wr(u8_t buf, const void *buffer, u16_t start_byte_in_page, u16_t nr_of_bytes)
+{
+  if (start_byte_in_page > AT45D_PAGE_SIZE) {
+    start_byte_in_page = AT45D_PAGE_SIZE;
+  }
+  if (nr_of_bytes > AT45D_PAGE_SIZE - start_byte_in_page) {
+    nr_of_bytes = AT45D_PAGE_SIZE - start_byte_in_page;
+  }
+#if AT45D_CFG_DMA
+  dma_wait();
+#endif
+  if (now_ns < sram_busy_until_ns[buf]) {
+    if (errors.buf_conflicts++ == 0) {
+      printf("at45d: buffer %d written while programming\n", buf + 1);
+    }
+  }
+  spi_xfer(CMD_ADR_BYTES + AT45D_PAGE_SIZE);
+
+  memset(sram[buf], 0xff, AT45D_PAGE_SIZE);
+  memcpy(&sram[buf][start_byte_in_page], buffer, nr_of_bytes);
+  sram_data_start[buf] = start_byte_in_page;
+  sram_data_end[buf] = start_byte_in_page + nr_of_bytes;
+}
+
+static void at45d_buf_prg(u8_t buf, bool_t erase, u16_t page)
+{
+  u8_t *p = &mem[(u32_t)page * AT45D_PAGE_SIZE];
+  u16_t i;
+
+  at45d_wait_ready();
+  spi_xfer(CMD_ADR_BYTES);
+
+  if (erase) {
+    memcpy(p, sram[buf], AT45D_PAGE_SIZE);
+    erase_cnt[page]++;
+    start_busy(AT45D_SIM_T_EP_NS);
+  } else {
+    /* A 1 only leaves the bit unchanged: data bits that should be 1 but were 0 stay 0 */
+    for (i = sram_data_start[buf]; i < sram_data_end[buf]; i++) {
+      u8_t set = sram[buf][i] & ~p[i];
+
+      while (set != 0) {
+        errors.bit_sets++;
+        set &= set - 1;
+      }
+    }
+    for (i = 0; i < AT45D_PAGE_SIZE; i++) {
+      p[i] &= sram[buf][i];
+    }
+    start_busy(AT45D_SIM_T_P_NS);
+  }
+  sram_busy_until_ns[buf] = busy_until_ns;
+  at45d_stats.programs++;
+}
+
+/* Continuous read from a main memory address */
+static u16_t at45d_rd_mem(void *buffer, at45d_adr_t address, u16_t nr_of_bytes)
+{
+  if (address > AT45D_ADR_MAX) {
+    return 0;
+  }
+  if (nr_of_bytes > AT45D_ADR_MAX - address + 1) {
+    nr_of_bytes = AT45D_ADR_MAX - address + 1;
+  }
+  at45d_wait_ready();
+  spi_xfer(CMD_ADR_BYTES + RD_DUMMY_BYTES + nr_of_bytes);
+  memcpy(buffer, &mem[address], nr_of_bytes);
+  return nr_of_bytes;
+}
+
+void at45d_sim_reset(void)
+{
+  memset(mem, 0xff, sizeof(mem));
+  memset(erase_cnt, 0, sizeof(erase_cnt));
+  memset(&errors, 0, sizeof(errors));
+  memset(sram_busy_until_ns, 0, sizeof(sram_busy_until_ns));
+  now_ns = 0;
+  wait_ns = 0;
+  busy_until_ns = 0;
+  at45d_ready_flag = FALSE;
+#if AT45D_CFG_DMA
+  dma_busy = FALSE;
+#endif
+}
+
+uint64_t at45d_sim_time_ns(void)
+{
+  return now_ns;
+}
+
+uint64_t at45d_sim_wait_ns(void)
+{
+  return wait_ns;
+}
+
+u32_t at45d_sim_erase_cnt(u16_t page)
+{
+  return erase_cnt[page];
+}
+
+void at45d_sim_get_errors(at45d_sim_errors_t *e)
+{
+  *e = errors;
+}
+
+void at45d_init(spi_handle_t handle)
+{
+  (void)handle;
+  at45d_reset_stats();
+}
+
+void at45d_power_down(void)
+{
+  spi_xfer(1);
+}
+
+void at45d_resume_from_power_down(void)
+{
+  spi_xfer(1);
+}
+
+u16_t at45d_rd(void *buffer, at45d_adr_t address, u16_t nr_of_bytes)
+{
+  return at45d_rd_mem(buffer, address, nr_of_bytes);
+}
+
+#if AT45D_CFG_DMA
+u16_t at45d_rd_async(void *buffer, at45d_adr_t address, u16_t nr_of_bytes, at45d_callback_t callback)
+{
+  if (dma_busy || (address > AT45D_ADR_MAX)) {
+    return 0;
+  }
+  if (nr_of_bytes > AT45D_ADR_MAX - address + 1) {
+    nr_of_bytes = AT45D_ADR_MAX - address + 1;
+  }
+  at45d_wait_ready();
+  memcpy(buffer, &mem[address], nr_of_bytes);
+  dma_prg = FALSE;
+  dma_start(CMD_ADR_BYTES + RD_DUMMY_BYTES + nr_of_bytes, callback);
+  return nr_of_bytes;
+}
+#endif
+
+void at45d_rd_page(void *buffer, u16_t page)
+{
+  at45d_rd_mem(buffer, (at45d_adr_t)page * AT45D_PAGE_SIZE, AT45D_PAGE_SIZE);
+}
+
+void at45d_rd_page_offset(void *buffer, u16_t page, u16_t start_byte_in_page, u16_t nr_of_bytes)
+{
+  at45d_rd_mem(buffer, (at45d_adr_t)page * AT45D_PAGE_SIZE + start_byte_in_page, nr_of_bytes);
+}
+
+void at45d_wr_page(const void *buffer, u16_t page)
+{
+#if AT45D_DOUBLE_BUFFER
+  u8_t buf = at45d_buf_next;
+
+  at45d_buf_next ^= 1;
+  at45d_buf_wr(buf, buffer, 0, AT45D_PAGE_SIZE);
+  at45d_buf_prg(buf, TRUE, page);
+#else
+  /* Main memory program through buffer 1 */
+  at45d_wait_ready();
+  spi_xfer(CMD_ADR_BYTES + AT45D_PAGE_SIZE);
+  memcpy(sram[0], buffer, AT45D_PAGE_SIZE);
+  memcpy(&mem[(u32_t)page * AT45D_PAGE_SIZE], buffer, AT45D_PAGE_SIZE);
+  erase_cnt[page]++;
+  start_busy(AT45D_SIM_T_EP_NS);
+  sram_busy_until_ns[0] = busy_until_ns;
+  at45d_stats.programs++;
+#endif
+}
+
+#if AT45D_CFG_DMA
+bool_t at45d_wr_page_async(const void *buffer, u16_t page, at45d_callback_t callback)
+{
+  if (dma_busy) {
+    return FALSE;
+  }
+  at45d_wait_ready();
+#if AT45D_DOUBLE_BUFFER
+  /* Buffer write to the next SRAM buffer; at45d_dma_irq() starts its program */
+  dma_buf = at45d_buf_next;
+  at45d_buf_next ^= 1;
+  if (now_ns < sram_busy_until_ns[dma_buf]) {
+    if (errors.buf_conflicts++ == 0) {
+      printf("at45d: buffer %d written while programming\n", dma_buf + 1);
+    }
+  }
+  sram_data_start[dma_buf] = 0;
+  sram_data_end[dma_buf] = AT45D_PAGE_SIZE;
+#else
+  /* Main memory program through buffer 1 */
+  dma_buf = 0;
+#endif
+  memcpy(sram[dma_buf], buffer, AT45D_PAGE_SIZE);
+  dma_prg = TRUE;
+  dma_page = page;
+  dma_start(CMD_ADR_BYTES + AT45D_PAGE_SIZE, callback);
+  return TRUE;
+}
+#endif
+
+void at45d_wr_page_offset(const void *buffer, u16_t page, u16_t start_byte_in_page, u16_t nr_of_bytes)
+{
+  u8_t buf;
+
+#if AT45D_DOUBLE_BUFFER
+  buf = at45d_buf_next;
+  at45d_buf_next ^= 1;
+#else
+  buf = 0;
+  at45d_wait_ready();
+#endif
+  at45d_buf_wr(buf, buffer, start_byte_in_page, nr_of_bytes);
+  at45d_buf_prg(buf, FALSE, page);
+}
+
+void at45d_erase_page(u16_t page)
+{
+  at45d_wait_ready();
+  spi_xfer(CMD_ADR_BYTES);
+  memset(&mem[(u32_t)page * AT45D_PAGE_SIZE], 0xff, AT45D_PAGE_SIZE);
+  erase_cnt[page]++;
+  start_busy(AT45D_SIM_T_PE_NS);
+  at45d_stats.erases++;
+}
+
+bool_t at45d_ready(void)
+{
+#if AT45D_CFG_DMA
+  /* Polled until the transfer is done */
+  dma_wait();
+#endif
+  if (at45d_ready_flag) {
+    return TRUE;
+  }
+  if (BIT_IS_HI(status_rd(), AT45D_STATUS_READY)) {
+    at45d_ready_flag = TRUE;
+    return TRUE;
+  }
+  at45d_stats.busy_polls++;
+  return FALSE;
+}
+
+/* Called once per wait, because the busy-wait loop is not simulated */
+void at45d_set_busy_handler(at45d_busy_handler_t handler)
+{
+  at45d_busy_handler = handler;
+}
+
+void at45d_get_stats(at45d_stats_t *stats)
+{
+  *stats = at45d_stats;
+}
+
+void at45d_reset_stats(void)
+{
+  memset(&at45d_stats, 0, sizeof(at45d_stats));
+}
+
+u8_t at45d_get_status(void)
+{
+  return status_rd();
+}
+
+bool_t at45d_page_size_is_pwr_of_two(void)
+{
+  return BIT_IS_HI(status_rd(), AT45D_STATUS_PAGE_SIZE);
+}
+
+bool_t at45d_set_page_size_to_pwr_of_two(void)
+{
+  /* The configuration register is not modelled; the page size is fixed by at45d_cfg.h */
+  return FALSE;
+}
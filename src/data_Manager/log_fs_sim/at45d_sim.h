@@ -0,0 +1,30 @@
+/**
+ * at45d_sim.h: Simulation interface of the RAM-backed AT45D stand-in
+ * (at45d.c in this directory). Host tool, not part of the firmware.
+ */
+#ifndef __AT45D_SIM_H__
+#define __AT45D_SIM_H__
+
+#include <data_Manager/at45d.h>
+
+/* Flash errors that the real DataFlash would not report */
+typedef struct {
+  u32_t bit_sets;         /* Data bits that a program without erase left 0 instead of 1 */
+  u32_t buf_conflicts;    /* Buffer writes to a buffer that was still programming */
+} at45d_sim_errors_t;
+
+/* Erase the whole flash and clear the time, erase counts and errors */
+void at45d_sim_reset(void);
+
+/* Simulated time since at45d_sim_reset() (SPI transfers and waits), in ns */
+uint64_t at45d_sim_time_ns(void);
+
+/* Part of at45d_sim_time_ns() spent polling a busy DataFlash, in ns */
+uint64_t at45d_sim_wait_ns(void);
+
+/* Number of times a page was erased (page erase or program with erase) */
+u32_t at45d_sim_erase_cnt(u16_t page);
+
+void at45d_sim_get_errors(at45d_sim_errors_t *errors);
+
+#endif
@@ -0,0 +1,16 @@
+/**
+ * chip.h: Stand-in for the LPC chip header, so that at45d.h and log_fs.c can
+ * be built on the host. Only provides what lpc_types.h would.
+ * Host tool, not part of the firmware.
+ */
+#ifndef __CHIP_H_
+#define __CHIP_H_
+
+#ifndef FALSE
+#define FALSE   0
+#endif
+#ifndef TRUE
+#define TRUE    (!FALSE)
+#endif
+
+#endif
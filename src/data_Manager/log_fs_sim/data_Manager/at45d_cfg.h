@@ -0,0 +1,23 @@
+/**
+ * at45d_cfg.h: AT45D configuration for log_fs_sim (see at45d_cfg_template.h).
+ * Host tool, not part of the firmware.
+ */
+#ifndef __AT45D_CFG_H__
+#define __AT45D_CFG_H__
+
+#include "defines.h"
+
+#define AT45D_CFG_DEVICE                  AT45DB041
+#define AT45D_CFG_PWR_OF_TWO_PAGE_SIZE    0
+#define AT45D_CFG_DOUBLE_BUFFER           1
+/* Blocking transfers are done by CPU; with DMA the asynchronous functions are modelled too */
+#ifndef AT45D_CFG_DMA
+#define AT45D_CFG_DMA                     1
+#endif
+#define AT45D_CFG_DMA_CH_RX               0
+#define AT45D_CFG_DMA_CH_TX               1
+#define AT45D_CFG_STATS                   1
+
+typedef u8_t spi_handle_t;
+
+#endif
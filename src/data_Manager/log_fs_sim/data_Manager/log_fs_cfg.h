@@ -0,0 +1,60 @@
+/**
+ * log_fs_cfg.h: log_fs configuration for log_fs_sim (see
+ * log_fs_cfg_template.h). Every option can be overridden with -D, e.g.
+ * -DLOG_FS_CFG_TYPE=LOG_FS_CFG_TYPE_CIRCULAR -DLOG_FS_CFG_MAX_PAGES=64.
+ * Host tool, not part of the firmware.
+ */
+#ifndef __LOG_FS_CFG_H__
+#define __LOG_FS_CFG_H__
+
+#include "defines.h"
+#include <data_Manager/at45d.h>
+
+#define LOG_FS_CFG_PAGE_SIZE        AT45D_PAGE_SIZE
+
+/* With checkpoints, the first 64 pages are reserved for them */
+#ifndef LOG_FS_CFG_CHECKPOINT
+#define LOG_FS_CFG_CHECKPOINT       0
+#endif
+#if LOG_FS_CFG_CHECKPOINT
+#define LOG_FS_CFG_CHECKPOINT_PAGE_START    0
+#define LOG_FS_CFG_CHECKPOINT_PAGE_END      63
+#define LOG_FS_CFG_PAGE_START       64
+#else
+#define LOG_FS_CFG_CHECKPOINT_PAGE_START    0
+#define LOG_FS_CFG_CHECKPOINT_PAGE_END      0
+#define LOG_FS_CFG_PAGE_START       0
+#endif
+#ifndef LOG_FS_CFG_CHECKPOINT_PERIOD
+#define LOG_FS_CFG_CHECKPOINT_PERIOD        32
+#endif
+
+#define LOG_FS_CFG_PAGE_END         (AT45D_PAGES-1)
+
+#ifndef LOG_FS_CFG_REC_DATA_SIZE
+#define LOG_FS_CFG_REC_DATA_SIZE    13
+#endif
+#ifndef LOG_FS_CFG_TYPE
+#define LOG_FS_CFG_TYPE             LOG_FS_CFG_TYPE_LINEAR
+#endif
+#ifndef LOG_FS_CFG_MAX_PAGES
+#define LOG_FS_CFG_MAX_PAGES        0
+#endif
+#ifndef LOG_FS_CFG_WINDOW_ROTATE
+#define LOG_FS_CFG_WINDOW_ROTATE    1
+#endif
+#ifndef LOG_FS_CFG_REC_TIME_STAMP
+#define LOG_FS_CFG_REC_TIME_STAMP   0
+#endif
+#ifndef LOG_FS_CFG_REC_VAR_SIZE
+#define LOG_FS_CFG_REC_VAR_SIZE     0
+#endif
+#ifndef LOG_FS_CFG_ERASE_CNT
+#define LOG_FS_CFG_ERASE_CNT        0
+#endif
+#define LOG_FS_CFG_ERASE_ENDURANCE  100000
+#ifndef LOG_FS_CFG_PAGE_INDEX
+#define LOG_FS_CFG_PAGE_INDEX       1
+#endif
+
+#endif
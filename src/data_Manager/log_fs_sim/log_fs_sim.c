@@ -0,0 +1,322 @@
+/**
+ * log_fs_sim: Runs data_Manager/log_fs.c on a simulated AT45D DataFlash
+ * (at45d.c in this directory) and reports the cost of each operation.
+ *
+ * Host tool, not part of the firmware. For each phase the SPI transactions
+ * and bytes, page programs and erases, waits for a busy DataFlash, the
+ * simulated flash time and the host CPU time are printed. The records
+ * written hold a sequence number, which is checked when they are read back.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "data_Manager/log_fs.h"
+#include "at45d_sim.h"
+
+#define REC_SIZE            LOG_FS_CFG_REC_DATA_SIZE
+#define BATCH_RECS          16
+#define DEFAULT_RECS        10000
+#define DEFAULT_SEEKS       1000
+#define ASYNC_PAGES         48
+
+#define FS_PAGES            (LOG_FS_CFG_PAGE_END - LOG_FS_CFG_PAGE_START + 1)
+
+#if (REC_SIZE < 4)
+#error "log_fs_sim needs LOG_FS_CFG_REC_DATA_SIZE >= 4 for the sequence number"
+#endif
+
+static at45d_stats_t stats_start;
+static uint64_t sim_start_ns;
+static double cpu_start;
+
+static double cpu_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void phase_start(void)
+{
+  at45d_get_stats(&stats_start);
+  sim_start_ns = at45d_sim_time_ns();
+  cpu_start = cpu_now();
+}
+
+static void phase_end(const char *name, u32_t ops)
+{
+  double cpu_ms = (cpu_now() - cpu_start) * 1e3;
+  double sim_ms = (at45d_sim_time_ns() - sim_start_ns) * 1e-6;
+  at45d_stats_t s;
+
+  at45d_get_stats(&s);
+  printf("%-10s %7lu %8lu %9lu %7lu %6lu %6lu %10.1f %8.2f",
+         name, (unsigned long)ops,
+         (unsigned long)(s.transactions - stats_start.transactions),
+         (unsigned long)(s.bytes - stats_start.bytes),
+         (unsigned long)(s.programs - stats_start.programs),
+         (unsigned long)(s.erases - stats_start.erases),
+         (unsigned long)(s.waits - stats_start.waits),
+         sim_ms, cpu_ms);
+  if (ops > 1) {
+    printf("  (%.3f ms/op)", sim_ms / ops);
+  }
+  printf("\n");
+}
+
+static void rec_fill(u8_t *rec, u32_t seq)
+{
+  memset(rec, (u8_t)seq, REC_SIZE);
+  memcpy(rec, &seq, sizeof(seq));
+}
+
+static u32_t rec_seq(const u8_t *rec)
+{
+  u32_t seq;
+
+  memcpy(&seq, rec, sizeof(seq));
+  return seq;
+}
+
+static void fail(const char *what, u32_t n)
+{
+  printf("FAILED: %s (%lu)\n", what, (unsigned long)n);
+  exit(1);
+}
+
+#if AT45D_CFG_DMA
+static u32_t async_done;
+
+static void async_callback(bool_t ok)
+{
+  if (!ok) {
+    fail("asynchronous transfer", async_done);
+  }
+  async_done++;
+}
+
+/*
+ * Asynchronous page writes between blocking page and partial page writes, as
+ * a driver user would mix them; each must use the SRAM buffer that is not
+ * being programmed. The pages are read back (one asynchronously) and the
+ * flash is blank again afterwards.
+ */
+static void async_check(void)
+{
+  static u8_t wr_buf[AT45D_PAGE_SIZE];
+  static u8_t async_buf[AT45D_PAGE_SIZE];
+  static u8_t rd_buf[AT45D_PAGE_SIZE];
+  at45d_sim_errors_t errors;
+  u16_t page;
+  u32_t n, i;
+
+  async_done = 0;
+  phase_start();
+  for (n = 0; n < ASYNC_PAGES; n++) {
+    page = (u16_t)(LOG_FS_CFG_PAGE_START + n);
+    if (n % 3 == 0) {
+      /* The previous asynchronous write has been finished by the blocking calls */
+      memset(async_buf, (u8_t)(n + 1), AT45D_PAGE_SIZE);
+      if (!at45d_wr_page_async(async_buf, page, async_callback)) {
+        fail("at45d_wr_page_async() busy", n);
+      }
+    } else {
+      memset(wr_buf, (u8_t)(n + 1), AT45D_PAGE_SIZE);
+      if (n % 3 == 1) {
+        at45d_wr_page(wr_buf, page);
+      } else {
+        at45d_wr_page_offset(wr_buf, page, 0, AT45D_PAGE_SIZE);
+      }
+    }
+  }
+  for (n = 0; n < ASYNC_PAGES; n++) {
+    page = (u16_t)(LOG_FS_CFG_PAGE_START + n);
+    if (n == 0) {
+      if (at45d_rd_async(rd_buf, (at45d_adr_t)page * AT45D_PAGE_SIZE, AT45D_PAGE_SIZE,
+                         async_callback) != AT45D_PAGE_SIZE) {
+        fail("at45d_rd_async()", n);
+      }
+      while (!at45d_ready()) {
+        ;
+      }
+    } else {
+      at45d_rd_page(rd_buf, page);
+    }
+    for (i = 0; i < AT45D_PAGE_SIZE; i++) {
+      if (rd_buf[i] != (u8_t)(n + 1)) {
+        fail("page written with the async and blocking functions differs", n);
+      }
+    }
+  }
+  phase_end("async", ASYNC_PAGES);
+  if (async_done != ASYNC_PAGES / 3 + 1) {
+    fail("asynchronous callbacks", async_done);
+  }
+  at45d_sim_get_errors(&errors);
+  if ((errors.bit_sets != 0) || (errors.buf_conflicts != 0)) {
+    fail("flash errors during asynchronous writes", errors.bit_sets + errors.buf_conflicts);
+  }
+  at45d_sim_reset();
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+  static const log_fs_time_stamp_t ts = { 26, 10, 17, 12, 0, 0 };
+  u32_t nr_of_recs = (argc > 1) ? strtoul(argv[1], NULL, 0) : DEFAULT_RECS;
+  u32_t nr_of_seeks = (argc > 2) ? strtoul(argv[2], NULL, 0) : DEFAULT_SEEKS;
+  u8_t recs[BATCH_RECS][REC_SIZE];
+  u8_t rec[REC_SIZE];
+  log_fs_file_t file;
+  log_fs_err_t err;
+  u32_t seq, seq_first, seq_next, n, i;
+  u32_t erase_min, erase_max, erase_total;
+  at45d_sim_errors_t errors;
+
+  printf("%d pages of %d bytes, %d byte records, %s", (int)FS_PAGES, LOG_FS_CFG_PAGE_SIZE, REC_SIZE,
+         (LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_CIRCULAR) ? "circular" : "linear");
+  if (LOG_FS_CFG_MAX_PAGES != 0) {
+    printf(", %d pages per file%s", LOG_FS_CFG_MAX_PAGES,
+           ((LOG_FS_CFG_TYPE == LOG_FS_CFG_TYPE_CIRCULAR) && LOG_FS_CFG_WINDOW_ROTATE) ? " (rotated)" : "");
+  }
+  printf("%s%s%s\n\n", LOG_FS_CFG_PAGE_INDEX ? ", page index" : "",
+         LOG_FS_CFG_CHECKPOINT ? ", checkpoints" : "", LOG_FS_CFG_ERASE_CNT ? ", erase counters" : "");
+  printf("phase          ops    trans     bytes    prgs erases  waits     sim ms   cpu ms\n");
+
+  at45d_sim_reset();
+  at45d_init(0);
+
+#if AT45D_CFG_DMA
+  async_check();
+#endif
+
+  phase_start();
+  err = log_fs_init();
+  phase_end("init", 1);
+  if (err != LOG_FS_ERR_NONE) {
+    fail("log_fs_init() on blank flash", err);
+  }
+
+  phase_start();
+  err = log_fs_create(&ts);
+  phase_end("create", 1);
+  if (err != LOG_FS_ERR_NONE) {
+    fail("log_fs_create()", err);
+  }
+
+  /* Record by record, then the same number in batches */
+  seq = 0;
+  phase_start();
+  for (n = 0; n < nr_of_recs; n++) {
+    rec_fill(rec, seq++);
+    err = log_fs_record_wr(rec, REC_SIZE);
+    if (err != LOG_FS_ERR_NONE) {
+      break;
+    }
+  }
+  phase_end("append", n);
+  if (err != LOG_FS_ERR_NONE) {
+    printf("log_fs_record_wr() stopped after %lu records (error %d)\n", (unsigned long)n, err);
+    seq--;
+  }
+
+  if (err == LOG_FS_ERR_NONE) {
+    phase_start();
+    for (n = 0; n < nr_of_recs; n += BATCH_RECS) {
+      for (i = 0; i < BATCH_RECS; i++) {
+        rec_fill(recs[i], seq++);
+      }
+      err = log_fs_record_wr_batch(recs, BATCH_RECS);
+      if (err != LOG_FS_ERR_NONE) {
+        break;
+      }
+    }
+    phase_end("append_b", n);
+    if (err != LOG_FS_ERR_NONE) {
+      printf("log_fs_record_wr_batch() stopped after %lu records (error %d)\n", (unsigned long)n, err);
+    }
+  }
+
+  phase_start();
+  err = log_fs_init();
+  if (err == LOG_FS_ERR_NONE) {
+    err = log_fs_file_find_last(&file);
+  }
+  if (err == LOG_FS_ERR_NONE) {
+    err = log_fs_open(&file);
+  }
+  phase_end("mount", 1);
+  if (err != LOG_FS_ERR_NONE) {
+    fail("mount", err);
+  }
+
+  /* All records are read back in order; a full file may have lost the last batch */
+  phase_start();
+  if (log_fs_record_rd_first(rec, REC_SIZE) != LOG_FS_ERR_NONE) {
+    fail("log_fs_record_rd_first()", 0);
+  }
+  seq_first = rec_seq(rec);
+  n = 1;
+  while (log_fs_record_rd_next(rec, REC_SIZE) == LOG_FS_ERR_NONE) {
+    if (rec_seq(rec) != seq_first + n) {
+      fail("record out of sequence", n);
+    }
+    n++;
+  }
+  phase_end("read", n);
+  seq_next = seq_first + n;
+  printf("%10s records %lu to %lu\n", "", (unsigned long)seq_first, (unsigned long)seq_next - 1);
+
+#if !LOG_FS_CFG_REC_VAR_SIZE
+  srand(1);
+  phase_start();
+  for (i = 0; i < nr_of_seeks; i++) {
+    u32_t index = (u32_t)rand() % (seq_next - seq_first);
+
+    if (log_fs_record_seek_index(index, rec, REC_SIZE) != LOG_FS_ERR_NONE) {
+      fail("log_fs_record_seek_index()", index);
+    }
+    if (rec_seq(rec) != seq_first + index) {
+      fail("log_fs_record_seek_index() found the wrong record", index);
+    }
+  }
+  phase_end("seek", nr_of_seeks);
+#endif
+
+  phase_start();
+  err = log_fs_file_find_first(&file);
+  if (err == LOG_FS_ERR_NONE) {
+    err = log_fs_file_delete(&file);
+  }
+  phase_end("delete", 1);
+  if (err != LOG_FS_ERR_NONE) {
+    fail("delete", err);
+  }
+  if (log_fs_file_find_first(&file) != LOG_FS_ERR_NO_FILE) {
+    fail("file still found after delete", 0);
+  }
+
+  erase_min = 0xffffffff;
+  erase_max = 0;
+  erase_total = 0;
+  for (n = LOG_FS_CFG_PAGE_START; n <= LOG_FS_CFG_PAGE_END; n++) {
+    u32_t cnt = at45d_sim_erase_cnt((u16_t)n);
+
+    erase_min = (cnt < erase_min) ? cnt : erase_min;
+    erase_max = (cnt > erase_max) ? cnt : erase_max;
+    erase_total += cnt;
+  }
+  at45d_sim_get_errors(&errors);
+  printf("\nsim total %.1f ms (%.1f ms waiting for the DataFlash)\n",
+         at45d_sim_time_ns() * 1e-6, at45d_sim_wait_ns() * 1e-6);
+  printf("erases per page: min %lu, max %lu, mean %.2f\n", (unsigned long)erase_min,
+         (unsigned long)erase_max, (double)erase_total / FS_PAGES);
+  printf("bits that could not be set: %lu, buffer conflicts: %lu\n", (unsigned long)errors.bit_sets,
+         (unsigned long)errors.buf_conflicts);
+
+  return (errors.bit_sets != 0) || (errors.buf_conflicts != 0);
+}
@@ -0,0 +1,295 @@
+/**
+ * mkassets: Builds a NOR flash asset bundle (see data_Manager/nor_assets.h).
+ *
+ * Host tool, not part of the firmware. The bundle layout and the name hash
+ * must match nor_assets.h and nor_assets.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define BUNDLE_MAGIC        0x5453414eUL    /* "NAST" */
+#define BUNDLE_VERSION      1
+#define HDR_SIZE            20
+#define ENTRY_SIZE          24
+
+#define TYPE_OTHER          0
+#define TYPE_FONT           1
+#define TYPE_BITMAP         2
+#define TYPE_WEB            3
+#define TYPE_TABLE          4
+
+/* lwIP FS_FILE_FLAGS_HEADER_INCLUDED */
+#define FLAG_HEADER_INCLUDED 0x01
+
+#define ALIGN4(x)           (((x) + 3) & ~(uint32_t)3)
+
+struct asset {
+  const char *file;
+  char *name;
+  uint16_t type;
+  uint16_t flags;
+  uint8_t *data;
+  uint32_t size;
+  uint32_t hash;
+  uint32_t name_ofs;
+  uint32_t data_ofs;
+};
+
+static const struct {
+  const char *name;
+  uint16_t type;
+} types[] = {
+  { "other", TYPE_OTHER }, { "font", TYPE_FONT }, { "bitmap", TYPE_BITMAP },
+  { "web", TYPE_WEB }, { "table", TYPE_TABLE }
+};
+
+static const struct {
+  const char *ext;
+  const char *content_type;
+} mime[] = {
+  { "html", "text/html" }, { "htm", "text/html" }, { "shtml", "text/html" },
+  { "css", "text/css" }, { "js", "application/javascript" },
+  { "json", "application/json" }, { "txt", "text/plain" },
+  { "xml", "text/xml" }, { "gif", "image/gif" }, { "png", "image/png" },
+  { "jpg", "image/jpeg" }, { "jpeg", "image/jpeg" }, { "bmp", "image/bmp" },
+  { "ico", "image/x-icon" }, { "svg", "image/svg+xml" }
+};
+
+static uint32_t crc32(uint32_t crc, const uint8_t *data, uint32_t len)
+{
+  int i;
+
+  while (len--) {
+    crc ^= *data++;
+    for (i = 0; i < 8; i++) {
+      crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320UL : 0);
+    }
+  }
+  return crc;
+}
+
+static uint32_t fnv1a(const char *name)
+{
+  uint32_t hash = 0x811c9dc5UL;
+
+  while (*name) {
+    hash ^= (uint8_t)*name++;
+    hash *= 0x01000193UL;
+  }
+  return hash;
+}
+
+static void put16(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+  put16(p, v);
+  put16(p + 2, v >> 16);
+}
+
+static int compare(const void *a, const void *b)
+{
+  const struct asset *x = (const struct asset *)a;
+  const struct asset *y = (const struct asset *)b;
+
+  if (x->hash != y->hash) {
+    return (x->hash < y->hash) ? -1 : 1;
+  }
+  return strcmp(x->name, y->name);
+}
+
+static const char *content_type(const char *name)
+{
+  const char *ext = strrchr(name, '.');
+  size_t i;
+
+  if (ext != NULL) {
+    for (i = 0; i < sizeof(mime) / sizeof(mime[0]); i++) {
+      if (!strcmp(ext + 1, mime[i].ext)) {
+        return mime[i].content_type;
+      }
+    }
+  }
+  return "application/octet-stream";
+}
+
+static int load(struct asset *a, int http_header)
+{
+  FILE *f;
+  long len;
+  char hdr[256];
+  uint32_t hdr_len = 0;
+
+  f = fopen(a->file, "rb");
+  if (f == NULL) {
+    perror(a->file);
+    return 0;
+  }
+  fseek(f, 0, SEEK_END);
+  len = ftell(f);
+  fseek(f, 0, SEEK_SET);
+
+  if ((a->type == TYPE_WEB) && http_header) {
+    hdr_len = (uint32_t)sprintf(hdr, "HTTP/1.0 %s\r\nServer: lwIP\r\nContent-Length: %ld\r\nContent-type: %s\r\n\r\n",
+                                strstr(a->name, "404") ? "404 File not found" : "200 OK", len, content_type(a->name));
+    a->flags |= FLAG_HEADER_INCLUDED;
+  }
+
+  a->size = hdr_len + (uint32_t)len;
+  a->data = (uint8_t *)malloc(a->size ? a->size : 1);
+  if (a->data == NULL) {
+    fclose(f);
+    return 0;
+  }
+  memcpy(a->data, hdr, hdr_len);
+  if (fread(a->data + hdr_len, 1, (size_t)len, f) != (size_t)len) {
+    perror(a->file);
+    fclose(f);
+    return 0;
+  }
+  fclose(f);
+  return 1;
+}
+
+static int parse(struct asset *a, char *arg)
+{
+  char *colon = strchr(arg, ':');
+  char *eq;
+  size_t i;
+
+  if (colon == NULL) {
+    return 0;
+  }
+  *colon = '\0';
+  for (i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+    if (!strcmp(arg, types[i].name)) {
+      break;
+    }
+  }
+  if (i == sizeof(types) / sizeof(types[0])) {
+    fprintf(stderr, "unknown type '%s'\n", arg);
+    return 0;
+  }
+  a->type = types[i].type;
+  a->flags = 0;
+  a->file = colon + 1;
+
+  eq = strchr(a->file, '=');
+  if (eq != NULL) {
+    *eq = '\0';
+    a->name = strdup(eq + 1);
+  }
+  else {
+    a->name = (char *)malloc(strlen(a->file) + 2);
+    sprintf(a->name, "%s%s", ((a->type == TYPE_WEB) && (a->file[0] != '/')) ? "/" : "", a->file);
+  }
+  for (i = 0; a->name[i]; i++) {
+    if (a->name[i] == '\\') {
+      a->name[i] = '/';
+    }
+  }
+  return 1;
+}
+
+int main(int argc, char *argv[])
+{
+  struct asset *assets;
+  int count = 0, i, arg = 1, http_header = 1;
+  uint32_t ofs, size, crc;
+  uint8_t *bundle, *p;
+  FILE *f;
+
+  if ((argc > 1) && !strcmp(argv[1], "-n")) {
+    http_header = 0;
+    arg++;
+  }
+  if (argc - arg < 2) {
+    fprintf(stderr, "Usage: mkassets [-n] bundle.bin type:file[=name] ...\n"
+                    "   type: font, bitmap, web, table or other\n"
+                    "   -n:   do not prepend an HTTP header to web assets\n");
+    return 1;
+  }
+  if (argc - arg - 1 > 0xFFFF) {
+    fprintf(stderr, "too many assets\n");
+    return 1;
+  }
+
+  assets = (struct asset *)calloc((size_t)(argc - arg - 1), sizeof(*assets));
+  for (i = arg + 1; i < argc; i++, count++) {
+    if (!parse(&assets[count], argv[i])) {
+      fprintf(stderr, "invalid asset '%s'\n", argv[i]);
+      return 1;
+    }
+    if (!load(&assets[count], http_header)) {
+      return 1;
+    }
+    assets[count].hash = fnv1a(assets[count].name);
+  }
+
+  qsort(assets, (size_t)count, sizeof(*assets), compare);
+  for (i = 1; i < count; i++) {
+    if (!compare(&assets[i - 1], &assets[i])) {
+      fprintf(stderr, "duplicate name '%s'\n", assets[i].name);
+      return 1;
+    }
+  }
+
+  /* Layout: header, index, names, data (4 byte aligned) */
+  ofs = HDR_SIZE + (uint32_t)count * ENTRY_SIZE;
+  for (i = 0; i < count; i++) {
+    assets[i].name_ofs = ofs;
+    ofs += (uint32_t)strlen(assets[i].name) + 1;
+  }
+  for (i = 0; i < count; i++) {
+    ofs = ALIGN4(ofs);
+    assets[i].data_ofs = ofs;
+    ofs += assets[i].size;
+  }
+  size = ALIGN4(ofs);
+
+  /* Padding is 0xFF, like erased flash */
+  bundle = (uint8_t *)malloc(size);
+  memset(bundle, 0xFF, size);
+  for (i = 0; i < count; i++) {
+    p = bundle + HDR_SIZE + (uint32_t)i * ENTRY_SIZE;
+    put32(p + 0, assets[i].hash);
+    put32(p + 4, assets[i].name_ofs);
+    put32(p + 8, assets[i].data_ofs);
+    put32(p + 12, assets[i].size);
+    put32(p + 16, crc32(0xFFFFFFFFUL, assets[i].data, assets[i].size) ^ 0xFFFFFFFFUL);
+    put16(p + 20, assets[i].type);
+    put16(p + 22, assets[i].flags);
+    strcpy((char *)bundle + assets[i].name_ofs, assets[i].name);
+    memcpy(bundle + assets[i].data_ofs, assets[i].data, assets[i].size);
+  }
+
+  put32(bundle + 0, BUNDLE_MAGIC);
+  put16(bundle + 4, BUNDLE_VERSION);
+  put16(bundle + 6, (uint32_t)count);
+  put32(bundle + 8, size);
+  put32(bundle + 12, crc32(0xFFFFFFFFUL, bundle + HDR_SIZE, size - HDR_SIZE) ^ 0xFFFFFFFFUL);
+  crc = crc32(0xFFFFFFFFUL, bundle, 16) ^ 0xFFFFFFFFUL;
+  put32(bundle + 16, crc);
+
+  f = fopen(argv[arg], "wb");
+  if ((f == NULL) || (fwrite(bundle, 1, size, f) != size)) {
+    perror(argv[arg]);
+    return 1;
+  }
+  fclose(f);
+
+  for (i = 0; i < count; i++) {
+    printf("%08lx %8lu %-6s %s\n", (unsigned long)assets[i].data_ofs, (unsigned long)assets[i].size,
+           types[assets[i].type].name, assets[i].name);
+  }
+  printf("%d assets, %lu bytes, crc %08lx\n", count, (unsigned long)size,
+         (unsigned long)(crc32(0xFFFFFFFFUL, bundle, size) ^ 0xFFFFFFFFUL));
+  return 0;
+}
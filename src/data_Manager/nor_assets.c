@@ -0,0 +1,566 @@
+/* =============================================================================
+
+    Title:          nor_assets.c : Read-only asset bundle in memory mapped NOR flash
+    Creation Date:  2026-10-17
+
+============================================================================= */
+
+
+/* _____STANDARD INCLUDES____________________________________________________ */
+#include <string.h>
+#include <stddef.h>
+
+/* _____PROJECT INCLUDES_____________________________________________________ */
+#include <data_Manager/nor_assets.h>
+#include <data_Manager/crc.h>
+#include <BSP_Waveshare/bsp_waveshare.h>
+
+#if NOR_ASSETS_CFG_HTTPD
+#include "lwip/apps/fs.h"
+#endif
+
+/* _____LOCAL DEFINITIONS____________________________________________________ */
+/// Start of the bundle in the memory mapped NOR flash
+#define NOR_ASSETS_BASE         ((const u8_t *)(EMC_ADDRESS_CS0 + NOR_ASSETS_CFG_OFFSET))
+
+/// Erase sector size of the NOR flash
+#define NOR_ASSETS_SECTOR_SIZE  (4UL << 10)
+
+/// Number of toggle bit polls before an erase is considered to have failed
+#define NOR_ASSETS_TIMEOUT      1000000
+
+/// Offset of the progress record sector of an update
+#define NOR_ASSETS_UPD_OFFSET   (NOR_ASSETS_CFG_MAX_SIZE - NOR_ASSETS_SECTOR_SIZE)
+
+/// Progress record magic number ("NAUP")
+#define NOR_ASSETS_UPD_MAGIC    0x5055414e
+
+/// Value of the flag of a sector that has been written
+#define NOR_ASSETS_UPD_DONE     0x0000
+
+/// @name FNV-1a hash parameters
+//@{
+#define NOR_ASSETS_FNV_OFFSET   0x811c9dc5
+#define NOR_ASSETS_FNV_PRIME    0x01000193
+//@}
+
+#if (NOR_ASSETS_CFG_OFFSET % NOR_ASSETS_SECTOR_SIZE) != 0
+#error "NOR_ASSETS_CFG_OFFSET must be a multiple of the sector size"
+#endif
+
+#if (16 + (NOR_ASSETS_CFG_MAX_SIZE / NOR_ASSETS_SECTOR_SIZE) * 2) > NOR_ASSETS_SECTOR_SIZE
+#error "Progress record does not fit in a sector"
+#endif
+
+#if NOR_ASSETS_CFG_HTTPD && LWIP_HTTPD_FS_ASYNC_READ
+#error "LWIP_HTTPD_FS_ASYNC_READ is not supported"
+#endif
+
+/// Progress record of an update, followed by a u16_t flag per sector
+typedef struct
+{
+    u32_t magic;        ///< NOR_ASSETS_UPD_MAGIC
+    u32_t size;         ///< Size of the new bundle
+    u32_t crc;          ///< CRC-32 of the new bundle
+    u32_t rec_crc;      ///< CRC-32 of the preceding fields
+} nor_assets_upd_rec_t;
+
+/* _____MACROS_______________________________________________________________ */
+
+/* _____GLOBAL VARIABLES_____________________________________________________ */
+
+/* _____LOCAL VARIABLES______________________________________________________ */
+/// Header of the valid bundle (NULL = no valid bundle)
+static const nor_assets_hdr_t * nor_assets_hdr;
+
+/// Size of the bundle being updated (0 = no update)
+static u32_t nor_assets_upd_size;
+
+/// Sector buffer of an update
+static u16_t nor_assets_upd_buf[NOR_ASSETS_SECTOR_SIZE / 2];
+
+/// Offset in the bundle of the sector in the buffer
+static u32_t nor_assets_upd_ofs;
+
+/// Number of bytes in the buffer
+static u32_t nor_assets_upd_fill;
+
+/// Programming statistics of an update
+static lpc_norflash_prog_stat_t nor_assets_upd_prog_stat;
+
+/// Sectors skipped because they were written before an interruption
+static u32_t nor_assets_upd_resumed;
+
+#if NOR_ASSETS_CFG_HTTPD
+/// Number of web assets opened by the HTTP server and not closed yet
+static volatile u16_t nor_assets_httpd_open;
+#endif
+
+/* _____LOCAL FUNCTION DECLARATIONS__________________________________________ */
+/// Calculate CRC-32 of data
+static u32_t nor_assets_crc(const void * data, u32_t nr_of_bytes);
+
+/// Calculate FNV-1a hash of a zero terminated name
+static u32_t nor_assets_hash(const char * name);
+
+/// Get first entry of the index
+static const nor_asset_t * nor_assets_index(void);
+
+/// Erase the sector at an offset in the bundle
+static bool_t nor_assets_erase(u32_t offset);
+
+/// Get the progress record of an update
+static const nor_assets_upd_rec_t * nor_assets_upd_rec(void);
+
+/// Get the sector flags of the progress record
+static const u16_t * nor_assets_upd_flags(void);
+
+/// Check if there is a complete progress record
+static bool_t nor_assets_upd_rec_valid(void);
+
+/// Program the sector in the buffer (unless already done) and flag it
+static bool_t nor_assets_upd_flush(void);
+
+/* _____LOCAL FUNCTIONS______________________________________________________ */
+static u32_t nor_assets_crc(const void * data, u32_t nr_of_bytes)
+{
+    return crc32_calc(0xffffffff, data, nr_of_bytes) ^ 0xffffffff;
+}
+
+static u32_t nor_assets_hash(const char * name)
+{
+    u32_t hash = NOR_ASSETS_FNV_OFFSET;
+
+    while(*name != '\0')
+    {
+        hash ^= (u8_t)(*name++);
+        hash *= NOR_ASSETS_FNV_PRIME;
+    }
+    return hash;
+}
+
+static const nor_asset_t * nor_assets_index(void)
+{
+    return (const nor_asset_t *)(NOR_ASSETS_BASE + sizeof(nor_assets_hdr_t));
+}
+
+static bool_t nor_assets_erase(u32_t offset)
+{
+    u32_t tout = NOR_ASSETS_TIMEOUT;
+
+    offset += NOR_ASSETS_CFG_OFFSET;
+
+    // The erase command takes the word address
+    lpc_norflash_erase_sector(offset >> 1);
+    while(!lpc_norflash_toggle_bit_check(offset))
+    {
+        if(--tout == 0)
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static const nor_assets_upd_rec_t * nor_assets_upd_rec(void)
+{
+    return (const nor_assets_upd_rec_t *)(NOR_ASSETS_BASE + NOR_ASSETS_UPD_OFFSET);
+}
+
+static const u16_t * nor_assets_upd_flags(void)
+{
+    return (const u16_t *)(NOR_ASSETS_BASE + NOR_ASSETS_UPD_OFFSET + sizeof(nor_assets_upd_rec_t));
+}
+
+static bool_t nor_assets_upd_rec_valid(void)
+{
+    const nor_assets_upd_rec_t * rec = nor_assets_upd_rec();
+
+    if(rec->magic != NOR_ASSETS_UPD_MAGIC)
+    {
+        return FALSE;
+    }
+    return (nor_assets_crc(rec, offsetof(nor_assets_upd_rec_t, rec_crc)) == rec->rec_crc);
+}
+
+static bool_t nor_assets_upd_flush(void)
+{
+    u16_t sector = (u16_t)(nor_assets_upd_ofs / NOR_ASSETS_SECTOR_SIZE);
+    u16_t done   = NOR_ASSETS_UPD_DONE;
+    u32_t len    = nor_assets_upd_fill;
+
+    nor_assets_upd_fill = 0;
+
+    if(nor_assets_upd_flags()[sector] == NOR_ASSETS_UPD_DONE)
+    {
+        nor_assets_upd_resumed++;
+        return TRUE;
+    }
+
+    // Pad an odd last byte with 0xFF
+    if((len & 1) != 0)
+    {
+        ((u8_t *)nor_assets_upd_buf)[len++] = 0xff;
+    }
+    if(!lpc_norflash_program(NOR_ASSETS_CFG_OFFSET + nor_assets_upd_ofs, nor_assets_upd_buf, len,
+                             &nor_assets_upd_prog_stat))
+    {
+        return FALSE;
+    }
+
+    // Record that the sector has been written
+    return lpc_norflash_program(NOR_ASSETS_CFG_OFFSET + NOR_ASSETS_UPD_OFFSET
+                                + sizeof(nor_assets_upd_rec_t) + sector * sizeof(u16_t),
+                                &done, sizeof(done), NULL);
+}
+
+/* _____GLOBAL FUNCTIONS_____________________________________________________ */
+bool_t nor_assets_init(void)
+{
+    const nor_assets_hdr_t * hdr = (const nor_assets_hdr_t *)NOR_ASSETS_BASE;
+
+    nor_assets_hdr = NULL;
+
+    // Bundle is being updated?
+    if(nor_assets_upd_rec()->magic == NOR_ASSETS_UPD_MAGIC)
+    {
+        return FALSE;
+    }
+    if(  (hdr->magic   != NOR_ASSETS_MAGIC  )
+       ||(hdr->version != NOR_ASSETS_VERSION)  )
+    {
+        return FALSE;
+    }
+    if(nor_assets_crc(hdr, offsetof(nor_assets_hdr_t, hdr_crc)) != hdr->hdr_crc)
+    {
+        return FALSE;
+    }
+    if(  (hdr->size > NOR_ASSETS_CFG_MAX_SIZE)
+       ||(hdr->size < sizeof(nor_assets_hdr_t) + hdr->count * sizeof(nor_asset_t))  )
+    {
+        return FALSE;
+    }
+#if NOR_ASSETS_CFG_VERIFY
+    if(nor_assets_crc(NOR_ASSETS_BASE + sizeof(nor_assets_hdr_t),
+                      hdr->size - sizeof(nor_assets_hdr_t)) != hdr->crc)
+    {
+        return FALSE;
+    }
+#endif
+
+    nor_assets_hdr = hdr;
+    return TRUE;
+}
+
+bool_t nor_assets_verify(void)
+{
+    const nor_asset_t * asset;
+    u16_t               i;
+
+    if(nor_assets_hdr == NULL)
+    {
+        return FALSE;
+    }
+    if(nor_assets_crc(NOR_ASSETS_BASE + sizeof(nor_assets_hdr_t),
+                      nor_assets_hdr->size - sizeof(nor_assets_hdr_t)) != nor_assets_hdr->crc)
+    {
+        return FALSE;
+    }
+
+    asset = nor_assets_index();
+    for(i = 0; i < nor_assets_hdr->count; i++, asset++)
+    {
+        if(  (asset->name_ofs >= nor_assets_hdr->size)
+           ||(asset->data_ofs >  nor_assets_hdr->size)
+           ||(asset->size     >  nor_assets_hdr->size - asset->data_ofs)  )
+        {
+            return FALSE;
+        }
+        if(nor_assets_crc(NOR_ASSETS_BASE + asset->data_ofs, asset->size) != asset->crc)
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+u16_t nor_assets_count(void)
+{
+    if(nor_assets_hdr == NULL)
+    {
+        return 0;
+    }
+    return nor_assets_hdr->count;
+}
+
+const nor_asset_t * nor_assets_entry(u16_t index)
+{
+    if(index >= nor_assets_count())
+    {
+        return NULL;
+    }
+    return &nor_assets_index()[index];
+}
+
+const nor_asset_t * nor_assets_find(const char * name)
+{
+    const nor_asset_t * index = nor_assets_index();
+    u32_t               hash;
+    u16_t               count;
+    u16_t               lo;
+    u16_t               hi;
+    u16_t               mid;
+
+    count = nor_assets_count();
+    hash  = nor_assets_hash(name);
+
+    // Find first entry with the same hash
+    lo = 0;
+    hi = count;
+    while(lo < hi)
+    {
+        mid = (u16_t)((lo + hi) / 2);
+        if(index[mid].hash < hash)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    // Compare names of entries with the same hash
+    for(; (lo < count) && (index[lo].hash == hash); lo++)
+    {
+        if(strcmp(nor_assets_name(&index[lo]), name) == 0)
+        {
+            return &index[lo];
+        }
+    }
+    return NULL;
+}
+
+const char * nor_assets_name(const nor_asset_t * asset)
+{
+    return (const char *)(NOR_ASSETS_BASE + asset->name_ofs);
+}
+
+const void * nor_assets_data(const nor_asset_t * asset)
+{
+    return NOR_ASSETS_BASE + asset->data_ofs;
+}
+
+const void * nor_assets_get(const char * name, u32_t * size)
+{
+    const nor_asset_t * asset = nor_assets_find(name);
+
+    if(asset == NULL)
+    {
+        return NULL;
+    }
+    if(size != NULL)
+    {
+        *size = asset->size;
+    }
+    return nor_assets_data(asset);
+}
+
+bool_t nor_assets_update_begin(u32_t size, u32_t crc)
+{
+    const nor_assets_upd_rec_t * rec = nor_assets_upd_rec();
+    const nor_assets_hdr_t *     hdr = nor_assets_hdr;
+    nor_assets_upd_rec_t         new_rec;
+
+    nor_assets_hdr         = NULL;
+#if NOR_ASSETS_CFG_HTTPD
+    // Web asset still being read by the HTTP server? (no new ones are opened now)
+    if(nor_assets_httpd_open != 0)
+    {
+        nor_assets_hdr = hdr;
+        return FALSE;
+    }
+#else
+    (void)hdr;
+#endif
+    nor_assets_upd_size    = 0;
+    nor_assets_upd_fill    = 0;
+    nor_assets_upd_resumed = 0;
+    memset(&nor_assets_upd_prog_stat, 0, sizeof(nor_assets_upd_prog_stat));
+
+    if(  (size < sizeof(nor_assets_hdr_t))
+       ||(size > NOR_ASSETS_UPD_OFFSET   )  )
+    {
+        return FALSE;
+    }
+
+    // Interrupted update of the same bundle?
+    if(  (!nor_assets_upd_rec_valid())
+       ||(rec->size != size)
+       ||(rec->crc  != crc )  )
+    {
+        // No: start a new progress record with all sector flags cleared
+        new_rec.magic   = NOR_ASSETS_UPD_MAGIC;
+        new_rec.size    = size;
+        new_rec.crc     = crc;
+        new_rec.rec_crc = nor_assets_crc(&new_rec, offsetof(nor_assets_upd_rec_t, rec_crc));
+
+        if(!nor_assets_erase(NOR_ASSETS_UPD_OFFSET))
+        {
+            return FALSE;
+        }
+        if(!lpc_norflash_program(NOR_ASSETS_CFG_OFFSET + NOR_ASSETS_UPD_OFFSET,
+                                 (const u16_t *)&new_rec, sizeof(new_rec), NULL))
+        {
+            return FALSE;
+        }
+    }
+
+    nor_assets_upd_size = size;
+    return TRUE;
+}
+
+u32_t nor_assets_update_offset(void)
+{
+    u32_t offset;
+
+    for(offset = 0; offset < nor_assets_upd_size; offset += NOR_ASSETS_SECTOR_SIZE)
+    {
+        if(nor_assets_upd_flags()[offset / NOR_ASSETS_SECTOR_SIZE] != NOR_ASSETS_UPD_DONE)
+        {
+            return offset;
+        }
+    }
+    return nor_assets_upd_size;
+}
+
+bool_t nor_assets_update_write(u32_t offset, const void * data, u32_t nr_of_bytes)
+{
+    const u8_t * data_u8 = (const u8_t *)data;
+    u32_t        len;
+
+    if(  (nor_assets_upd_size == 0)
+       ||(offset > nor_assets_upd_size)
+       ||(nr_of_bytes > nor_assets_upd_size - offset)  )
+    {
+        return FALSE;
+    }
+
+    if(nor_assets_upd_fill == 0)
+    {
+        // Start of a sector
+        if((offset % NOR_ASSETS_SECTOR_SIZE) != 0)
+        {
+            return FALSE;
+        }
+        nor_assets_upd_ofs = offset;
+    }
+    else if(offset != nor_assets_upd_ofs + nor_assets_upd_fill)
+    {
+        return FALSE;
+    }
+
+    while(nr_of_bytes != 0)
+    {
+        len = NOR_ASSETS_SECTOR_SIZE - nor_assets_upd_fill;
+        if(len > nr_of_bytes)
+        {
+            len = nr_of_bytes;
+        }
+        memcpy((u8_t *)nor_assets_upd_buf + nor_assets_upd_fill, data_u8, len);
+        nor_assets_upd_fill += len;
+        data_u8             += len;
+        nr_of_bytes         -= len;
+
+        // Sector complete or end of bundle?
+        if(  (nor_assets_upd_fill == NOR_ASSETS_SECTOR_SIZE)
+           ||(nor_assets_upd_ofs + nor_assets_upd_fill == nor_assets_upd_size)  )
+        {
+            if(!nor_assets_upd_flush())
+            {
+                return FALSE;
+            }
+            nor_assets_upd_ofs += NOR_ASSETS_SECTOR_SIZE;
+        }
+    }
+    return TRUE;
+}
+
+bool_t nor_assets_update_end(void)
+{
+    u32_t  size = nor_assets_upd_size;
+    bool_t crc_ok;
+
+    if((size == 0) || (nor_assets_update_offset() != size))
+    {
+        // Keep the progress record to resume later
+        return FALSE;
+    }
+    nor_assets_upd_size = 0;
+
+    crc_ok = (nor_assets_crc(NOR_ASSETS_BASE, size) == nor_assets_upd_rec()->crc);
+
+    // Erase progress record (after a CRC error all sectors are compared again)
+    if(!nor_assets_erase(NOR_ASSETS_UPD_OFFSET))
+    {
+        return FALSE;
+    }
+    if(!crc_ok)
+    {
+        return FALSE;
+    }
+    return nor_assets_init();
+}
+
+void nor_assets_update_stat(nor_assets_update_stat_t * stat)
+{
+    stat->sectors_resumed = nor_assets_upd_resumed;
+    stat->sectors_erased  = nor_assets_upd_prog_stat.sectors_erased;
+    stat->words_written   = nor_assets_upd_prog_stat.words_written;
+    stat->words_skipped   = nor_assets_upd_prog_stat.words_skipped;
+}
+
+#if NOR_ASSETS_CFG_HTTPD
+/* 
+   lwIP HTTP server custom files (LWIP_HTTPD_CUSTOM_FILES): web assets are
+   sent straight from the NOR flash. The whole file is in memory, so
+   fs_read_custom() is never needed to read more data. The HTTP server copies
+   the data into its TCP segments (HTTP_IS_DATA_VOLATILE in lwipopts.h), so
+   the NOR flash is only read while the file is open.
+ */
+int fs_open_custom(struct fs_file *file, const char *name)
+{
+    const nor_asset_t * asset = nor_assets_find(name);
+
+    if((asset == NULL) || (asset->type != NOR_ASSET_TYPE_WEB))
+    {
+        return 0;
+    }
+
+    nor_assets_httpd_open++;
+    file->data       = (const char *)nor_assets_data(asset);
+    file->len        = (int)asset->size;
+    file->index      = (int)asset->size;
+    file->pextension = NULL;
+    file->flags      = (u8_t)asset->flags;
+#if HTTPD_PRECALCULATED_CHECKSUM
+    file->chksum_count = 0;
+    file->chksum       = NULL;
+#endif
+    return 1;
+}
+
+void fs_close_custom(struct fs_file *file)
+{
+    (void)file;
+    nor_assets_httpd_open--;
+}
+
+int fs_read_custom(struct fs_file *file, char *buffer, int count)
+{
+    (void)file;
+    (void)buffer;
+    (void)count;
+    return FS_READ_EOF;
+}
+#endif
@@ -0,0 +1,115 @@
+/* =============================================================================
+
+    Title:          varint.c : Varint and delta encoding of numeric tuples
+    Creation Date:  2026-10-17
+
+============================================================================= */
+
+/* _____STANDARD INCLUDES____________________________________________________ */
+
+/* _____PROJECT INCLUDES_____________________________________________________ */
+#include "data_Manager/varint.h"
+
+/* _____LOCAL DEFINITIONS____________________________________________________ */
+
+/* _____MACROS_______________________________________________________________ */
+
+/* _____GLOBAL VARIABLES_____________________________________________________ */
+
+/* _____LOCAL VARIABLES______________________________________________________ */
+
+/* _____LOCAL FUNCTION DECLARATIONS__________________________________________ */
+
+/* _____LOCAL FUNCTIONS______________________________________________________ */
+
+/* _____GLOBAL FUNCTIONS_____________________________________________________ */
+size_t varint_encode(u8_t *        buf,
+                     size_t        buf_size,
+                     const s32_t * values,
+                     const s32_t * ref,
+                     u8_t          nr_of_values)
+{
+    size_t i = 0;
+    u32_t  value;
+
+    while(nr_of_values != 0)
+    {
+        // Difference to reference (unsigned arithmetic wraps without overflow)
+        value = (u32_t)(*values++);
+        if(ref != NULL)
+        {
+            value -= (u32_t)(*ref++);
+        }
+        // Zigzag encode so that small negative values are also small
+        value = (value << 1) ^ (0 - (value >> 31));
+
+        // Store 7 bits per byte, least significant first
+        do
+        {
+            if(i >= buf_size)
+            {
+                // Buffer too small
+                return 0;
+            }
+            if(value >= 0x80)
+            {
+                buf[i++] = (u8_t)(value | 0x80);
+            }
+            else
+            {
+                buf[i++] = (u8_t)value;
+            }
+            value >>= 7;
+        }
+        while(value != 0);
+
+        nr_of_values--;
+    }
+
+    return i;
+}
+
+size_t varint_decode(const u8_t *  buf,
+                     size_t        buf_size,
+                     s32_t *       values,
+                     const s32_t * ref,
+                     u8_t          nr_of_values)
+{
+    size_t i = 0;
+    u32_t  value;
+    u8_t   shift;
+    u8_t   data;
+
+    while(nr_of_values != 0)
+    {
+        // Fetch 7 bits per byte, least significant first
+        value = 0;
+        shift = 0;
+        do
+        {
+            if(  (i >= buf_size                 )
+               ||(shift >= 7 * VARINT_SIZE_MAX)  )
+            {
+                // Truncated or invalid
+                return 0;
+            }
+            data   = buf[i++];
+            value |= ((u32_t)(data & 0x7f)) << shift;
+            shift += 7;
+        }
+        while((data & 0x80) != 0);
+
+        // Zigzag decode
+        value = (value >> 1) ^ (0 - (value & 1));
+        // Add reference
+        if(ref != NULL)
+        {
+            value += (u32_t)(*ref++);
+        }
+        *values++ = (s32_t)value;
+
+        nr_of_values--;
+    }
+
+    return i;
+}
@@ -0,0 +1,192 @@
+/**
+ * chksum_bench: Compares the port checksum routines (lwip/arch/lpc_chksum.c)
+ * with the lwIP reference algorithms, for results and speed.
+ *
+ * Host tool, not part of the firmware. stock1 is LWIP_CHKSUM_ALGORITHM 1
+ * (used by this port before), stock2 is the lwIP default algorithm 2; both
+ * are copied from lwip/core/inet_chksum.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lwip/opt.h"
+#include "lwip/def.h"
+#include "lwip/inet_chksum.h"
+
+#define BUF_SIZE            2048
+#define MAX_LEN             1600
+#define BENCH_BYTES         (256UL << 20)
+
+/* lwIP LWIP_CHKSUM_ALGORITHM 1 */
+static u16_t stock1(const void *dataptr, int len)
+{
+  u32_t acc;
+  u16_t src;
+  const u8_t *octetptr;
+
+  acc = 0;
+  octetptr = (const u8_t *)dataptr;
+  while (len > 1) {
+    src = (*octetptr) << 8;
+    octetptr++;
+    src |= (*octetptr);
+    octetptr++;
+    acc += src;
+    len -= 2;
+  }
+  if (len > 0) {
+    src = (*octetptr) << 8;
+    acc += src;
+  }
+  acc = (acc >> 16) + (acc & 0x0000ffffUL);
+  if ((acc & 0xffff0000UL) != 0) {
+    acc = (acc >> 16) + (acc & 0x0000ffffUL);
+  }
+  /* lwip_htons(), little endian */
+  return (u16_t)(SWAP_BYTES_IN_WORD(acc));
+}
+
+/* lwIP LWIP_CHKSUM_ALGORITHM 2 */
+static u16_t stock2(const void *dataptr, int len)
+{
+  const u8_t *pb = (const u8_t *)dataptr;
+  const u16_t *ps;
+  u16_t t = 0;
+  u32_t sum = 0;
+  int odd = ((mem_ptr_t)pb & 1);
+
+  if (odd && len > 0) {
+    ((u8_t *)&t)[1] = *pb++;
+    len--;
+  }
+  ps = (const u16_t *)(const void *)pb;
+  while (len > 1) {
+    sum += *ps++;
+    len -= 2;
+  }
+  if (len > 0) {
+    ((u8_t *)&t)[0] = *(const u8_t *)ps;
+  }
+  sum += t;
+  sum = FOLD_U32T(sum);
+  sum = FOLD_U32T(sum);
+  if (odd) {
+    sum = SWAP_BYTES_IN_WORD(sum);
+  }
+  return (u16_t)sum;
+}
+
+/* lwIP LWIP_CHKSUM_COPY_ALGORITHM 1 on top of stock2 */
+static u16_t stock2_copy(void *dst, const void *src, u16_t len)
+{
+  memcpy(dst, src, len);
+  return stock2(dst, len);
+}
+
+static u32_t sink;
+
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Checks all alignments and lengths against stock2 */
+static int check(u8_t *src, u8_t *dst)
+{
+  int so, dof, len, i;
+  u16_t ref, s;
+
+  for (i = 0; i < BUF_SIZE; i++) {
+    src[i] = (u8_t)rand();
+  }
+  /* All ones words exercise the carries */
+  memset(src + 1024, 0xff, 512);
+
+  for (so = 0; so < 4; so++) {
+    for (len = 0; len <= MAX_LEN; len++) {
+      ref = stock2(src + so, len);
+      if (stock1(src + so, len) != ref) {
+        printf("stock1 differs: offset %d, length %d\n", so, len);
+        return 0;
+      }
+      if (lpc_chksum(src + so, len) != ref) {
+        printf("lpc_chksum differs: offset %d, length %d\n", so, len);
+        return 0;
+      }
+      if (lpc_chksum(src + 1024 + so, len < 512 - so ? len : 512 - so) !=
+          stock2(src + 1024 + so, len < 512 - so ? len : 512 - so)) {
+        printf("lpc_chksum differs (all ones): offset %d, length %d\n", so, len);
+        return 0;
+      }
+      for (dof = 0; dof < 4; dof++) {
+        memset(dst, 0x55, BUF_SIZE);
+        s = lpc_chksum_copy(dst + dof, src + so, (u16_t)len);
+        if (s != ref || memcmp(dst + dof, src + so, len) != 0 ||
+            dst[dof + len] != 0x55 || (dof && dst[dof - 1] != 0x55)) {
+          printf("lpc_chksum_copy differs: offsets %d/%d, length %d\n", so, dof, len);
+          return 0;
+        }
+      }
+    }
+  }
+  return 1;
+}
+
+static void bench_sum(const char *name, u16_t (*fn)(const void *, int), const u8_t *buf, int len)
+{
+  unsigned long n, loops = BENCH_BYTES / len;
+  double t;
+
+  t = now();
+  for (n = 0; n < loops; n++) {
+    sink += fn(buf, len);
+  }
+  t = now() - t;
+  printf("  %-16s %8.1f MB/s %8.1f ns/call\n", name, loops * (double)len / t / 1e6, t / loops * 1e9);
+}
+
+static void bench_copy(const char *name, u16_t (*fn)(void *, const void *, u16_t),
+                       u8_t *dst, const u8_t *src, int len)
+{
+  unsigned long n, loops = BENCH_BYTES / len;
+  double t;
+
+  t = now();
+  for (n = 0; n < loops; n++) {
+    sink += fn(dst, src, (u16_t)len);
+  }
+  t = now() - t;
+  printf("  %-16s %8.1f MB/s %8.1f ns/call\n", name, loops * (double)len / t / 1e6, t / loops * 1e9);
+}
+
+int main(int argc, char *argv[])
+{
+  static const int lens[] = { 20, 64, 576, 1460 };
+  static u32_t src_words[BUF_SIZE / 4], dst_words[BUF_SIZE / 4];
+  u8_t *src = (u8_t *)src_words, *dst = (u8_t *)dst_words;
+  unsigned i;
+
+  (void)argc;
+  (void)argv;
+
+  if (!check(src, dst)) {
+    return 1;
+  }
+  printf("Results equal to lwIP for offsets 0..3 and lengths 0..%d\n", MAX_LEN);
+
+  for (i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+    printf("%d bytes:\n", lens[i]);
+    bench_sum("stock1", stock1, src, lens[i]);
+    bench_sum("stock2", stock2, src, lens[i]);
+    bench_sum("lpc_chksum", lpc_chksum, src, lens[i]);
+    bench_copy("memcpy+stock2", stock2_copy, dst, src, lens[i]);
+    bench_copy("lpc_chksum_copy", lpc_chksum_copy, dst, src, lens[i]);
+  }
+  return sink == 0x12345678UL;
+}
@@ -36,6 +36,7 @@
 #include "lwip/pbuf.h"
 #include "lwip/stats.h"
 #include "lwip/snmp.h"
+#include "lwip/priv/memp_priv.h"
 #include "netif/etharp.h"
 #include "netif/ppp/pppoe.h"
 
@@ -45,17 +46,22 @@
 #include "chip.h"
 #include "BSP_Waveshare/bsp_waveshare.h"
 #include "BSP_Waveshare/lpc_phy.h"
+#include "FatFs/fsflash_cfg.h"
 
 #include <string.h>
 
 extern void msDelay(uint32_t ms);
 
-#if LPC_NUM_BUFF_TXDESCS < 2
-#error LPC_NUM_BUFF_TXDESCS must be at least 2
+#if LPC_NUM_BUFF_TXDESCS < 2 || LPC_NUM_BUFF_TXDESCS > LPC_MAX_BUFF_TXDESCS
+#error LPC_NUM_BUFF_TXDESCS must be at least 2 and at most LPC_MAX_BUFF_TXDESCS
 #endif
 
-#if LPC_NUM_BUFF_RXDESCS < 3
-#error LPC_NUM_BUFF_RXDESCS must be at least 3
+#if LPC_NUM_BUFF_RXDESCS < 3 || LPC_NUM_BUFF_RXDESCS > LPC_MAX_BUFF_RXDESCS
+#error LPC_NUM_BUFF_RXDESCS must be at least 3 and at most LPC_MAX_BUFF_RXDESCS
+#endif
+
+#if (LWIP_RAM_HEAP_ADDR < FSNAND_MAP_ADDR + FSNAND_MAP_SIZE) && (LWIP_RAM_HEAP_ADDR + MEM_SIZE > FSNAND_MAP_ADDR)
+#error The lwIP heap (LWIP_RAM_HEAP_ADDR) overlaps the NAND FTL tables (FSNAND_MAP_ADDR)
 #endif
 
 /** @ingroup NET_LWIP_LPC17XX40XX_EMAC_DRIVER
@@ -104,31 +110,61 @@ extern void msDelay(uint32_t ms);
 /* LPC EMAC driver data structure */
 typedef struct {
 	/* prxs must be 8 byte aligned! */
-	ENET_RXSTAT_T prxs[LPC_NUM_BUFF_RXDESCS];	/**< Pointer to RX statuses */
-	ENET_RXDESC_T prxd[LPC_NUM_BUFF_RXDESCS];	/**< Pointer to RX descriptor list */
-	ENET_TXSTAT_T ptxs[LPC_NUM_BUFF_TXDESCS];	/**< Pointer to TX statuses */
-	ENET_TXDESC_T ptxd[LPC_NUM_BUFF_TXDESCS];	/**< Pointer to TX descriptor list */
+	ENET_RXSTAT_T prxs[LPC_MAX_BUFF_RXDESCS];	/**< Pointer to RX statuses */
+	ENET_RXDESC_T prxd[LPC_MAX_BUFF_RXDESCS];	/**< Pointer to RX descriptor list */
+	ENET_TXSTAT_T ptxs[LPC_MAX_BUFF_TXDESCS];	/**< Pointer to TX statuses */
+	ENET_TXDESC_T ptxd[LPC_MAX_BUFF_TXDESCS];	/**< Pointer to TX descriptor list */
 	struct netif *pnetif;						/**< Reference back to LWIP parent netif */
 
-	struct pbuf *rxb[LPC_NUM_BUFF_RXDESCS];		/**< RX pbuf pointer list, zero-copy mode */
+	u32_t num_rxdescs;							/**< Number of RX descriptors in use */
+	u32_t num_txdescs;							/**< Number of TX descriptors in use */
+
+	struct pbuf *rxb[LPC_MAX_BUFF_RXDESCS];		/**< RX pbuf pointer list, zero-copy mode */
 
 	u32_t rx_fill_desc_index;					/**< RX descriptor next available index */
 	volatile u32_t rx_free_descs;				/**< Count of free RX descriptors */
-	struct pbuf *txb[LPC_NUM_BUFF_TXDESCS];		/**< TX pbuf pointer list, zero-copy mode */
+	u32_t rx_coal_frames;						/**< Received frames per RX done event */
+	u32_t rx_coal_time;							/**< Maximum wait of an incomplete batch (ms) */
+	u32_t rx_coal_count;						/**< Descriptors queued since the last RX done descriptor */
+#if NO_SYS == 1
+	u32_t rx_wait_start;						/**< sys_now() when a waiting frame was first seen */
+	u8_t rx_waiting;							/**< Frames are waiting for their batch */
+#endif
+	struct pbuf *txb[LPC_MAX_BUFF_TXDESCS];		/**< TX pbuf pointer list, zero-copy mode */
 
 	u32_t lpc_last_tx_idx;						/**< TX last descriptor index, zero-copy mode */
+	struct pbuf *txq[LPC_TX_QUEUE_LEN];			/**< TX software queue, frames waiting for descriptors */
+	u32_t txq_head;								/**< TX software queue oldest frame index */
+	u32_t txq_count;							/**< TX software queue number of frames */
+	lpc_emac_tx_stats_t tx_stats;				/**< TX statistics */
+	lpc_emac_ring_stats_t ring_stats;			/**< Descriptor ring high-water marks */
+#if LPC_EMAC_LAT_EN
+	lpc_emac_lat_stats_t lat_stats;				/**< RX latency statistics */
+	volatile u32_t rx_event_ts;					/**< Timestamp of the RX event of the batch */
+	u32_t rx_input_ts;							/**< Timestamp of the lwIP input of the frame */
+	u8_t rx_in_input;							/**< A frame is in lwIP input */
+#endif
 #if NO_SYS == 0
 	sys_sem_t rx_sem;							/**< RX receive thread wakeup semaphore */
 	sys_sem_t tx_clean_sem;						/**< TX cleanup thread wakeup semaphore */
 	sys_mutex_t tx_lock_mutex;					/**< TX critical section mutex */
 	sys_mutex_t rx_lock_mutex;					/**< RX critical section mutex */
-	xSemaphoreHandle xtx_count_sem;				/**< TX free buffer counting semaphore */
 #endif
 } lpc_enetdata_t;
 
-/** \brief  LPC EMAC driver work data
+/** \brief  LPC EMAC driver work data, in the peripheral SRAM (DMA accessible)
  */
-ALIGNED(8) lpc_enetdata_t lpc_enetdata;
+DMA_SAFE_BSS ALIGNED(8) lpc_enetdata_t lpc_enetdata;
+
+/* Size of the peripheral SRAM (DMA_SAFE_BSS) */
+#define LPC_DMA_SAFE_RAM_SIZE	(32 * 1024)
+
+/* The pbuf pool (memp_memory_PBUF_POOL_base, sized as by LWIP_MEMPOOL_DECLARE)
+   and lpc_enetdata must fit in the peripheral SRAM: compile error if not */
+typedef char lpc_dma_safe_ram_check[
+	(LWIP_MEM_ALIGN_BUFFER(PBUF_POOL_SIZE * (MEMP_SIZE + MEMP_ALIGN_SIZE(LWIP_MEM_ALIGN_SIZE(sizeof(struct pbuf))
+	                                                                    + LWIP_MEM_ALIGN_SIZE(PBUF_POOL_BUFSIZE))))
+	 + sizeof(lpc_enetdata_t) + 8 /* ALIGNED(8) */ <= LPC_DMA_SAFE_RAM_SIZE) ? 1 : -1];
 
 /*****************************************************************************
  * Public types/enumerations/variables
@@ -138,6 +174,20 @@ ALIGNED(8) lpc_enetdata_t lpc_enetdata;
  * Private functions
  ****************************************************************************/
 
+#if LPC_EMAC_LAT_EN
+/* Adds the time since start to a latency statistic */
+STATIC void lpc_lat_add(lpc_emac_lat_t *lat, u32_t start)
+{
+	u32_t t = LPC_EMAC_TIMESTAMP() - start;
+
+	lat->count++;
+	lat->sum += t;
+	if (t > lat->max) {
+		lat->max = t;
+	}
+}
+#endif
+
 /* Queues a pbuf into the RX descriptor list */
 STATIC void lpc_rxqueue_pbuf(lpc_enetdata_t *lpc_enetif, struct pbuf *p)
 {
@@ -146,8 +196,13 @@ STATIC void lpc_rxqueue_pbuf(lpc_enetdata_t *lpc_enetif, struct pbuf *p)
 	/* Get next free descriptor index */
 	idx = lpc_enetif->rx_fill_desc_index;
 
-	/* Setup descriptor and clear statuses */
-	lpc_enetif->prxd[idx].Control = ENET_RCTRL_INT | ((u32_t) ENET_RCTRL_SIZE(p->len));
+	/* Setup descriptor and clear statuses. The RX done interrupt is only
+	   requested on every rx_coal_frames'th descriptor. */
+	lpc_enetif->prxd[idx].Control = (u32_t) ENET_RCTRL_SIZE(p->len);
+	if (++lpc_enetif->rx_coal_count >= lpc_enetif->rx_coal_frames) {
+		lpc_enetif->prxd[idx].Control |= ENET_RCTRL_INT;
+		lpc_enetif->rx_coal_count = 0;
+	}
 	lpc_enetif->prxd[idx].Packet = (u32_t) p->payload;
 	lpc_enetif->prxs[idx].StatusInfo = 0xFFFFFFFF;
 	lpc_enetif->prxs[idx].StatusHashCRC = 0xFFFFFFFF;
@@ -157,7 +212,7 @@ STATIC void lpc_rxqueue_pbuf(lpc_enetdata_t *lpc_enetif, struct pbuf *p)
 
 	/* Wrap at end of descriptor list */
 	idx++;
-	if (idx >= LPC_NUM_BUFF_RXDESCS) {
+	if (idx >= lpc_enetif->num_rxdescs) {
 		idx = 0;
 	}
 
@@ -174,10 +229,11 @@ STATIC void lpc_rxqueue_pbuf(lpc_enetdata_t *lpc_enetif, struct pbuf *p)
 STATIC err_t lpc_rx_setup(lpc_enetdata_t *lpc_enetif)
 {
 	/* Setup pointers to RX structures */
-	Chip_ENET_InitRxDescriptors(LPC_ETHERNET, lpc_enetif->prxd, lpc_enetif->prxs, LPC_NUM_BUFF_RXDESCS);
+	Chip_ENET_InitRxDescriptors(LPC_ETHERNET, lpc_enetif->prxd, lpc_enetif->prxs, lpc_enetif->num_rxdescs);
 
-	lpc_enetif->rx_free_descs = LPC_NUM_BUFF_RXDESCS;
+	lpc_enetif->rx_free_descs = lpc_enetif->num_rxdescs;
 	lpc_enetif->rx_fill_desc_index = 0;
+	lpc_enetif->rx_coal_count = 0;
 
 	/* Build RX buffer and descriptors */
 	lpc_rx_queue(lpc_enetif->pnetif);
@@ -215,7 +271,7 @@ STATIC struct pbuf *lpc_low_level_input(struct netif *netif) {
 		Chip_ENET_ClearIntStatus(LPC_ETHERNET, ENET_INT_RXOVERRUN);
 
 		/* De-allocate all queued RX pbufs */
-		for (idx = 0; idx < LPC_NUM_BUFF_RXDESCS; idx++) {
+		for (idx = 0; idx < lpc_enetif->num_rxdescs; idx++) {
 			if (lpc_enetif->rxb[idx] != NULL) {
 				pbuf_free(lpc_enetif->rxb[idx]);
 				lpc_enetif->rxb[idx] = NULL;
@@ -332,7 +388,9 @@ STATIC s32_t lpc_packet_addr_notsafe(void *addr) {
 	}
 	return 1;
 #else
-	/* On the LPC177x_8x and LPC40xx the only areas that are safe are... */
+	/* On the LPC177x_8x and LPC40xx the only areas that are safe are...
+	   (the static memory is reachable, but the NOR flash can be programmed or
+	   erased while a queued frame points into it, so NOR payloads are bounced) */
 	if ((((u32_t) addr >= 0x20000000) && ((u32_t) addr < 0x20008000)) /* 32kB peripheral SRAM */
 		|| (((u32_t) addr >= 0xa0000000) && ((u32_t) addr < 0xe0000000)) /* DRAM 1 GB */
 		) {
@@ -346,22 +404,97 @@ STATIC s32_t lpc_packet_addr_notsafe(void *addr) {
 /* Sets up the TX descriptor ring buffers */
 STATIC err_t lpc_tx_setup(lpc_enetdata_t *lpc_enetif)
 {
-	s32_t idx;
+	u32_t idx;
 
 	/* Build TX descriptors for local buffers */
-	for (idx = 0; idx < LPC_NUM_BUFF_TXDESCS; idx++) {
+	for (idx = 0; idx < lpc_enetif->num_txdescs; idx++) {
 		lpc_enetif->ptxd[idx].Control = 0;
 		lpc_enetif->ptxs[idx].StatusInfo = 0xFFFFFFFF;
 	}
 
 	/* Setup pointers to TX structures */
-	Chip_ENET_InitTxDescriptors(LPC_ETHERNET, lpc_enetif->ptxd, lpc_enetif->ptxs, LPC_NUM_BUFF_TXDESCS);
+	Chip_ENET_InitTxDescriptors(LPC_ETHERNET, lpc_enetif->ptxd, lpc_enetif->ptxs, lpc_enetif->num_txdescs);
 
 	lpc_enetif->lpc_last_tx_idx = 0;
 
 	return ERR_OK;
 }
 
+/* Queues a frame into the TX descriptor list. The caller must make sure
+ * that enough descriptors are free and must hold a reference to p, which
+ * is released once the frame has been sent. */
+STATIC void lpc_tx_submit(lpc_enetdata_t *lpc_enetif, struct pbuf *p, u32_t dn)
+{
+	struct pbuf *q;
+	u32_t idx, used;
+
+	/* Get free TX buffer index */
+	idx = Chip_ENET_GetTXProduceIndex(LPC_ETHERNET);
+
+	/* Setup transfers */
+	q = p;
+	while (dn > 0) {
+		dn--;
+
+		/* Only save pointer to free on last descriptor. The TX done
+		   interrupt is only requested once per frame. */
+		if (dn == 0) {
+			/* Save size of packet and signal it's ready */
+			lpc_enetif->ptxd[idx].Control = ENET_TCTRL_SIZE(q->len) | ENET_TCTRL_INT |
+											ENET_TCTRL_LAST;
+			lpc_enetif->txb[idx] = p;
+		}
+		else {
+			/* Save size of packet, descriptor is not last */
+			lpc_enetif->ptxd[idx].Control = ENET_TCTRL_SIZE(q->len);
+			lpc_enetif->txb[idx] = NULL;
+		}
+
+		LWIP_DEBUGF(EMAC_DEBUG | LWIP_DBG_TRACE,
+					("lpc_tx_submit: pbuf packet(%p) sent, chain#=%d,"
+					 " size = %d (index=%d)\n", q->payload, dn, q->len, idx));
+
+		lpc_enetif->ptxd[idx].Packet = (u32_t) q->payload;
+
+		q = q->next;
+
+		idx = Chip_ENET_IncTXProduceIndex(LPC_ETHERNET);
+	}
+
+	/* Descriptors in use (one is always kept free by the ring) */
+	used = lpc_enetif->num_txdescs - 1 - (u32_t) lpc_tx_ready(lpc_enetif->pnetif);
+	if (used > lpc_enetif->ring_stats.txMax) {
+		lpc_enetif->ring_stats.txMax = used;
+	}
+
+	LINK_STATS_INC(link.xmit);
+}
+
+/* Moves frames of the TX software queue to the TX descriptor list as long
+ * as enough descriptors are free. The TX lock must be held. */
+STATIC void lpc_tx_drain(lpc_enetdata_t *lpc_enetif)
+{
+	struct pbuf *p;
+	u32_t dn;
+
+	while (lpc_enetif->txq_count > 0) {
+		p = lpc_enetif->txq[lpc_enetif->txq_head];
+		dn = (u32_t) pbuf_clen(p);
+		if (dn > (u32_t) lpc_tx_ready(lpc_enetif->pnetif)) {
+			break;
+		}
+
+		lpc_tx_submit(lpc_enetif, p, dn);
+
+		lpc_enetif->txq[lpc_enetif->txq_head] = NULL;
+		lpc_enetif->txq_head++;
+		if (lpc_enetif->txq_head >= LPC_TX_QUEUE_LEN) {
+			lpc_enetif->txq_head = 0;
+		}
+		lpc_enetif->txq_count--;
+	}
+}
+
 /* Free TX buffers that are complete */
 STATIC void lpc_tx_reclaim_st(lpc_enetdata_t *lpc_enetif, u32_t cidx)
 {
@@ -380,23 +513,25 @@ STATIC void lpc_tx_reclaim_st(lpc_enetdata_t *lpc_enetif, u32_t cidx)
 			lpc_enetif->txb[lpc_enetif->lpc_last_tx_idx] = NULL;
 		}
 
-#if NO_SYS == 0
-		xSemaphoreGive(lpc_enetif->xtx_count_sem);
-#endif
 		lpc_enetif->lpc_last_tx_idx++;
-		if (lpc_enetif->lpc_last_tx_idx >= LPC_NUM_BUFF_TXDESCS) {
+		if (lpc_enetif->lpc_last_tx_idx >= lpc_enetif->num_txdescs) {
 			lpc_enetif->lpc_last_tx_idx = 0;
 		}
 	}
 
+	/* Send the frames waiting for free descriptors */
+	lpc_tx_drain(lpc_enetif);
+
 #if NO_SYS == 0
 	/* Restore access */
 	sys_mutex_unlock(&lpc_enetif->tx_lock_mutex);
 #endif
 }
 
-/* Low level output of a packet. Never call this from an interrupt context,
- * as it may block until TX descriptors become available. */
+/* Low level output of a packet. Does not block: when not enough TX
+ * descriptors are free, the frame is held in the TX software queue, which
+ * is drained by lpc_tx_reclaim(). ERR_WOULDBLOCK is returned (and the frame
+ * dropped) when that queue is full. */
 STATIC err_t lpc_low_level_output(struct netif *netif, struct pbuf *p)
 {
 	lpc_enetdata_t *lpc_enetif = netif->state;
@@ -406,8 +541,8 @@ STATIC err_t lpc_low_level_output(struct netif *netif, struct pbuf *p)
 	u8_t *dst;
 	struct pbuf *np;
 #endif
-	u32_t idx;
 	u32_t dn, notdmasafe = 0;
+	u8_t bounced = 0;
 
 	/* Zero-copy TX buffers may be fragmented across mutliple payload
 	   chains. Determine the number of descriptors needed for the
@@ -420,17 +555,21 @@ STATIC err_t lpc_low_level_output(struct netif *netif, struct pbuf *p)
 	for (q = p; q != NULL; q = q->next) {
 		notdmasafe += lpc_packet_addr_notsafe(q->payload);
 	}
+	lpc_enetif->tx_stats.frames++;
 
 #if LPC_TX_PBUF_BOUNCE_EN == 1
 	/* If the pbuf is not DMA safe, a new bounce buffer (pbuf) will be
 	   created that will be used instead. This requires an copy from the
-	   non-safe DMA region to the new pbuf */
-	if (notdmasafe) {
+	   non-safe DMA region to the new pbuf. A chain that needs more
+	   descriptors than the ring has is copied as well. */
+	if (notdmasafe || (dn >= lpc_enetif->num_txdescs)) {
 		/* Allocate a pbuf in DMA memory */
 		np = pbuf_alloc(PBUF_RAW, p->tot_len, PBUF_RAM);
 		if (np == NULL) {
 			LWIP_DEBUGF(EMAC_DEBUG | LWIP_DBG_TRACE,
 						("lpc_low_level_output: could not allocate TX pbuf\n"));
+			lpc_enetif->tx_stats.bounceFail++;
+			LINK_STATS_INC(link.memerr);
 			return ERR_MEM;
 		}
 
@@ -446,15 +585,18 @@ STATIC err_t lpc_low_level_output(struct netif *netif, struct pbuf *p)
 			dst += q->len;
 		}
 		np->len = p->tot_len;
+		lpc_enetif->tx_stats.bounced++;
+		lpc_enetif->tx_stats.bounceBytes += p->tot_len;
 
 		LWIP_DEBUGF(EMAC_DEBUG | LWIP_DBG_TRACE,
 					("lpc_low_level_output: Switched to DMA safe buffer, old=%p, new=%p\n",
-					 q, np));
+					 p, np));
 
 		/* use the new buffer for descrptor queueing. The original pbuf will
 		   be de-allocated outsuide this driver. */
 		p = np;
 		dn = 1;
+		bounced = 1;
 	}
 #else
 	if (notdmasafe) {
@@ -463,60 +605,46 @@ STATIC err_t lpc_low_level_output(struct netif *netif, struct pbuf *p)
 	}
 #endif
 
-	/* Wait until enough descriptors are available for the transfer. */
-	/* THIS WILL BLOCK UNTIL THERE ARE ENOUGH DESCRIPTORS AVAILABLE */
-	while (dn > lpc_tx_ready(netif)) {
-#if NO_SYS == 0
-		xSemaphoreTake(lpc_enetif->xtx_count_sem, 0);
-#else
-		msDelay(1);
-#endif
-	}
-
-	/* Get free TX buffer index */
-	idx = Chip_ENET_GetTXProduceIndex(LPC_ETHERNET);
-
 #if NO_SYS == 0
 	/* Get exclusive access */
 	sys_mutex_lock(&lpc_enetif->tx_lock_mutex);
 #endif
 
-	/* Prevent LWIP from de-allocating this pbuf. The driver will
-	   free it once it's been transmitted. */
-	if (!notdmasafe) {
-		pbuf_ref(p);
-	}
-
-	/* Setup transfers */
-	q = p;
-	while (dn > 0) {
-		dn--;
+	/* Frames are sent in order: the frame waits in the TX software queue
+	   while older frames wait or not enough descriptors are free */
+	if ((lpc_enetif->txq_count > 0) || (dn > (u32_t) lpc_tx_ready(netif))) {
+		if (lpc_enetif->txq_count >= LPC_TX_QUEUE_LEN) {
+#if NO_SYS == 0
+			sys_mutex_unlock(&lpc_enetif->tx_lock_mutex);
+#endif
+			LWIP_DEBUGF(EMAC_DEBUG | LWIP_DBG_TRACE,
+						("lpc_low_level_output: TX queue full, packet dropped\n"));
+			lpc_enetif->tx_stats.queueDrops++;
+			LINK_STATS_INC(link.drop);
+			if (bounced) {
+				pbuf_free(p);
+			}
+			return ERR_WOULDBLOCK;
+		}
 
-		/* Only save pointer to free on last descriptor */
-		if (dn == 0) {
-			/* Save size of packet and signal it's ready */
-			lpc_enetif->ptxd[idx].Control = ENET_TCTRL_SIZE(q->len) | ENET_TCTRL_INT |
-											ENET_TCTRL_LAST;
-			lpc_enetif->txb[idx] = p;
+		/* Prevent LWIP from de-allocating this pbuf. The driver will
+		   free it once it's been transmitted. */
+		if (!bounced) {
+			pbuf_ref(p);
 		}
-		else {
-			/* Save size of packet, descriptor is not last */
-			lpc_enetif->ptxd[idx].Control = ENET_TCTRL_SIZE(q->len) | ENET_TCTRL_INT;
-			lpc_enetif->txb[idx] = NULL;
+		lpc_enetif->txq[(lpc_enetif->txq_head + lpc_enetif->txq_count) % LPC_TX_QUEUE_LEN] = p;
+		lpc_enetif->txq_count++;
+		lpc_enetif->tx_stats.queued++;
+		if (lpc_enetif->txq_count > lpc_enetif->ring_stats.txqMax) {
+			lpc_enetif->ring_stats.txqMax = lpc_enetif->txq_count;
 		}
-
-		LWIP_DEBUGF(EMAC_DEBUG | LWIP_DBG_TRACE,
-					("lpc_low_level_output: pbuf packet(%p) sent, chain#=%d,"
-					 " size = %d (index=%d)\n", q->payload, dn, q->len, idx));
-
-		lpc_enetif->ptxd[idx].Packet = (u32_t) q->payload;
-
-		q = q->next;
-
-		idx = Chip_ENET_IncTXProduceIndex(LPC_ETHERNET);
 	}
-
-	LINK_STATS_INC(link.xmit);
+	else {
+		if (!bounced) {
+			pbuf_ref(p);
+		}
+		lpc_tx_submit(lpc_enetif, p, dn);
+	}
 
 #if NO_SYS == 0
 	/* Restore access */
@@ -533,8 +661,9 @@ STATIC void vPacketReceiveTask(void *pvParameters)
 	lpc_enetdata_t *lpc_enetif = pvParameters;
 
 	while (1) {
-		/* Wait for receive task to wakeup */
-		sys_arch_sem_wait(&lpc_enetif->rx_sem, 0);
+		/* Wait for receive task to wakeup. The timeout processes the
+		   frames of an incomplete batch (interrupt moderation). */
+		sys_arch_sem_wait(&lpc_enetif->rx_sem, lpc_enetif->rx_coal_time);
 
 		/* Process packets until all empty */
 		while (!Chip_ENET_IsRxEmpty(LPC_ETHERNET)) {
@@ -547,7 +676,7 @@ STATIC void vPacketReceiveTask(void *pvParameters)
 STATIC void vTransmitCleanupTask(void *pvParameters)
 {
 	lpc_enetdata_t *lpc_enetif = pvParameters;
-	s32_t idx;
+	u32_t idx;
 
 	while (1) {
 		/* Wait for transmit cleanup task to wakeup */
@@ -568,20 +697,23 @@ STATIC void vTransmitCleanupTask(void *pvParameters)
 			Chip_ENET_ResetTXLogic(LPC_ETHERNET);
 			Chip_ENET_ClearIntStatus(LPC_ETHERNET, ENET_INT_TXUNDERRUN);
 
-			/* De-allocate all queued TX pbufs */
-			for (idx = 0; idx < LPC_NUM_BUFF_TXDESCS; idx++) {
+			/* De-allocate all TX pbufs in the descriptor list */
+			for (idx = 0; idx < lpc_enetif->num_txdescs; idx++) {
 				if (lpc_enetif->txb[idx] != NULL) {
 					pbuf_free(lpc_enetif->txb[idx]);
 					lpc_enetif->txb[idx] = NULL;
 				}
 			}
 
+			/* Start TX side again and send the frames of the TX software
+			   queue (nothing else would move them to the empty list) */
+			lpc_tx_setup(lpc_enetif);
+			lpc_tx_drain(lpc_enetif);
+
 #if NO_SYS == 0
 			/* Restore access */
 			sys_mutex_unlock(&lpc_enetif->tx_lock_mutex);
 #endif
-			/* Start TX side again */
-			lpc_tx_setup(lpc_enetif);
 		}
 		else {
 			/* Free TX buffers that are done sending */
@@ -679,6 +811,9 @@ s32_t lpc_rx_queue(struct netif *netif)
 			LWIP_DEBUGF(EMAC_DEBUG | LWIP_DBG_TRACE,
 						("lpc_rx_queue: could not allocate RX pbuf (free desc=%d)\n",
 						 lpc_enetif->rx_free_descs));
+			if (lpc_enetif->rx_free_descs > lpc_enetif->ring_stats.rxNoBufMax) {
+				lpc_enetif->ring_stats.rxNoBufMax = lpc_enetif->rx_free_descs;
+			}
 			return queued;
 		}
 
@@ -696,41 +831,96 @@ s32_t lpc_rx_queue(struct netif *netif)
 	return queued;
 }
 
-/* Attempt to read a packet from the EMAC interface */
+/* Read the received packets from the EMAC interface */
 void lpc_enetif_input(struct netif *netif)
 {
+	lpc_enetdata_t *lpc_enetif = netif->state;
 	struct eth_hdr *ethhdr;
-
 	struct pbuf *p;
+	u32_t n;
 
-	/* move received packet into a new pbuf */
-	p = lpc_low_level_input(netif);
-	if (p == NULL) {
+	if (Chip_ENET_IsRxEmpty(LPC_ETHERNET) &&
+		!(Chip_ENET_GetIntStatus(LPC_ETHERNET) & ENET_INT_RXOVERRUN)) {
 		return;
 	}
 
-	/* points to packet payload, which starts with an Ethernet header */
-	ethhdr = p->payload;
+#if NO_SYS == 1
+	/* Interrupt moderation: wait until a batch is complete (RX done status
+	   of its last descriptor), or the first frame waited rx_coal_time ms.
+	   An overrun is handled at once. */
+	if (!lpc_enetif->rx_waiting) {
+		lpc_enetif->rx_waiting = 1;
+		lpc_enetif->rx_wait_start = sys_now();
+#if LPC_EMAC_LAT_EN
+		lpc_enetif->rx_event_ts = LPC_EMAC_TIMESTAMP();
+#endif
+	}
+	if (!(Chip_ENET_GetIntStatus(LPC_ETHERNET) & (ENET_INT_RXDONE | ENET_INT_RXOVERRUN)) &&
+		((u32_t) (sys_now() - lpc_enetif->rx_wait_start) < lpc_enetif->rx_coal_time)) {
+		return;
+	}
+	lpc_enetif->rx_waiting = 0;
+#endif
+
+	n = Chip_ENET_GetFillDescNum(LPC_ETHERNET, Chip_ENET_GetRXProduceIndex(LPC_ETHERNET),
+								 Chip_ENET_GetRXConsumeIndex(LPC_ETHERNET), lpc_enetif->num_rxdescs);
+	if (n > lpc_enetif->ring_stats.rxMax) {
+		lpc_enetif->ring_stats.rxMax = n;
+	}
+
+	/* Clear the RX done status before the ring is emptied, so that a batch
+	   completing meanwhile is not missed */
+	Chip_ENET_ClearIntStatus(LPC_ETHERNET, ENET_INT_RXDONE);
+
+	/* Process the whole batch, at most one ring of frames per call */
+	for (n = 0; n < lpc_enetif->num_rxdescs; n++) {
+		if (Chip_ENET_IsRxEmpty(LPC_ETHERNET) &&
+			!(Chip_ENET_GetIntStatus(LPC_ETHERNET) & ENET_INT_RXOVERRUN)) {
+			break;
+		}
 
-	switch (htons(ethhdr->type)) {
-	case ETHTYPE_IP:
-	case ETHTYPE_ARP:
+		/* move received packet into a new pbuf */
+		p = lpc_low_level_input(netif);
+		if (p == NULL) {
+			continue;
+		}
+
+		/* points to packet payload, which starts with an Ethernet header */
+		ethhdr = p->payload;
+
+		switch (htons(ethhdr->type)) {
+		case ETHTYPE_IP:
+		case ETHTYPE_ARP:
 #if PPPOE_SUPPORT
-	case ETHTYPE_PPPOEDISC:
-	case ETHTYPE_PPPOE:
+		case ETHTYPE_PPPOEDISC:
+		case ETHTYPE_PPPOE:
 #endif /* PPPOE_SUPPORT */
-		/* full packet send to tcpip_thread to process */
-		if (netif->input(p, netif) != ERR_OK) {
-			LWIP_DEBUGF(NETIF_DEBUG, ("lpc_enetif_input: IP input error\n"));
-			/* Free buffer */
+#if LPC_EMAC_LAT_EN
+			lpc_enetif->rx_input_ts = LPC_EMAC_TIMESTAMP();
+			lpc_lat_add(&lpc_enetif->lat_stats.wait, lpc_enetif->rx_event_ts);
+			lpc_enetif->rx_in_input = 1;
+#endif
+			/* full packet send to tcpip_thread to process */
+			if (netif->input(p, netif) != ERR_OK) {
+				LWIP_DEBUGF(NETIF_DEBUG, ("lpc_enetif_input: IP input error\n"));
+				/* Free buffer */
+				pbuf_free(p);
+			}
+#if LPC_EMAC_LAT_EN
+			lpc_enetif->rx_in_input = 0;
+			lpc_lat_add(&lpc_enetif->lat_stats.stack, lpc_enetif->rx_input_ts);
+#endif
+			break;
+
+		default:
+			/* Return buffer */
 			pbuf_free(p);
+			break;
 		}
-		break;
+	}
 
-	default:
-		/* Return buffer */
-		pbuf_free(p);
-		break;
+	if (n > lpc_enetif->ring_stats.rxBatchMax) {
+		lpc_enetif->ring_stats.rxBatchMax = n;
 	}
 }
 
@@ -749,7 +939,7 @@ s32_t lpc_tx_ready(struct netif *netif)
 	cidx = Chip_ENET_GetTXConsumeIndex(LPC_ETHERNET);
 	pidx = Chip_ENET_GetTXProduceIndex(LPC_ETHERNET);
 
-	return Chip_ENET_GetFreeDescNum(LPC_ETHERNET, pidx, cidx, LPC_NUM_BUFF_TXDESCS);
+	return Chip_ENET_GetFreeDescNum(LPC_ETHERNET, pidx, cidx, ((lpc_enetdata_t *) netif->state)->num_txdescs);
 }
 
 /**
@@ -774,6 +964,9 @@ void ETH_IRQHandler(void)
 	ints = Chip_ENET_GetIntStatus(LPC_ETHERNET);
 
 	if (ints & RXINTGROUP) {
+#if LPC_EMAC_LAT_EN
+		lpc_enetdata.rx_event_ts = LPC_EMAC_TIMESTAMP();
+#endif
 		/* RX group interrupt(s) */
 		/* Give semaphore to wakeup RX receive task. Note the FreeRTOS
 		   method is used instead of the LWIP arch method. */
@@ -795,6 +988,88 @@ void ETH_IRQHandler(void)
 #endif
 }
 
+/* Set the number of RX and TX descriptors */
+err_t lpc_emac_set_rings(u32_t rx_descs, u32_t tx_descs)
+{
+	if ((lpc_enetdata.pnetif != NULL) ||
+		(rx_descs < 3) || (rx_descs > LPC_MAX_BUFF_RXDESCS) ||
+		(tx_descs < 2) || (tx_descs > LPC_MAX_BUFF_TXDESCS)) {
+		return ERR_VAL;
+	}
+
+	lpc_enetdata.num_rxdescs = rx_descs;
+	lpc_enetdata.num_txdescs = tx_descs;
+
+	return ERR_OK;
+}
+
+/* Set up the RX interrupt moderation */
+void lpc_emac_set_rx_coalesce(u32_t frames, u32_t time_ms)
+{
+	u32_t rx_descs = lpc_enetdata.num_rxdescs ? lpc_enetdata.num_rxdescs : LPC_NUM_BUFF_RXDESCS;
+
+	/* Keep at least half of the ring free for the frames of the next batch */
+	if (frames > rx_descs / 2) {
+		frames = rx_descs / 2;
+	}
+	if (frames < 1) {
+		frames = 1;
+	}
+	/* An incomplete batch must not wait forever */
+	if ((frames > 1) && (time_ms < 1)) {
+		time_ms = 1;
+	}
+
+	lpc_enetdata.rx_coal_frames = frames;
+	lpc_enetdata.rx_coal_time = time_ms;
+}
+
+/* Get the TX statistics */
+void lpc_emac_get_tx_stats(lpc_emac_tx_stats_t *stats)
+{
+	*stats = lpc_enetdata.tx_stats;
+}
+
+/* Get the descriptor ring high-water marks */
+void lpc_emac_get_ring_stats(lpc_emac_ring_stats_t *stats)
+{
+	*stats = lpc_enetdata.ring_stats;
+	stats->rxDescs = lpc_enetdata.num_rxdescs;
+	stats->txDescs = lpc_enetdata.num_txdescs;
+}
+
+/* Get the RX latency statistics */
+void lpc_emac_get_lat_stats(lpc_emac_lat_stats_t *stats)
+{
+#if LPC_EMAC_LAT_EN
+	*stats = lpc_enetdata.lat_stats;
+	stats->hz = LPC_EMAC_TIMESTAMP_HZ;
+#else
+	memset(stats, 0, sizeof(*stats));
+#endif
+}
+
+/* Clear the TX, ring and latency statistics of the driver */
+void lpc_emac_clear_stats(void)
+{
+	memset(&lpc_enetdata.tx_stats, 0, sizeof(lpc_enetdata.tx_stats));
+	memset(&lpc_enetdata.ring_stats, 0, sizeof(lpc_enetdata.ring_stats));
+#if LPC_EMAC_LAT_EN
+	memset(&lpc_enetdata.lat_stats, 0, sizeof(lpc_enetdata.lat_stats));
+#endif
+}
+
+/* Timestamp the TCP input of the frame being received */
+err_t lpc_emac_lat_tcp(void)
+{
+#if LPC_EMAC_LAT_EN
+	if (lpc_enetdata.rx_in_input) {
+		lpc_lat_add(&lpc_enetdata.lat_stats.tcp, lpc_enetdata.rx_input_ts);
+	}
+#endif
+	return ERR_OK;
+}
+
 /* Set up the MAC interface duplex */
 void lpc_emac_set_duplex(int full_duplex)
 {
@@ -824,8 +1099,22 @@ err_t lpc_enetif_init(struct netif *netif)
 
 	LWIP_ASSERT("netif != NULL", (netif != NULL));
 
+	/* Default ring sizes and interrupt moderation */
+	if (lpc_enetdata.num_rxdescs == 0) {
+		lpc_enetdata.num_rxdescs = LPC_NUM_BUFF_RXDESCS;
+		lpc_enetdata.num_txdescs = LPC_NUM_BUFF_TXDESCS;
+	}
+	if (lpc_enetdata.rx_coal_frames == 0) {
+		lpc_emac_set_rx_coalesce(LPC_RX_COAL_FRAMES, LPC_RX_COAL_TIME);
+	}
+
 	lpc_enetdata.pnetif = netif;
 
+#if LPC_EMAC_LAT_EN
+	/* Start the free running timestamp counter */
+	LPC_EMAC_TIMESTAMP_INIT();
+#endif
+
 	/* set MAC hardware address */
 	wsBoard_ENET_GetMacADDR(netif->hwaddr);
 	netif->hwaddr_len = ETHARP_HWADDR_LEN;
@@ -857,11 +1146,6 @@ err_t lpc_enetif_init(struct netif *netif)
 
 	/* For FreeRTOS, start tasks */
 #if NO_SYS == 0
-	lpc_enetdata.xtx_count_sem = xSemaphoreCreateCounting(LPC_NUM_BUFF_TXDESCS,
-														  LPC_NUM_BUFF_TXDESCS);
-	LWIP_ASSERT("xtx_count_sem creation error",
-				(lpc_enetdata.xtx_count_sem != NULL));
-
 	err = sys_mutex_new(&lpc_enetdata.tx_lock_mutex);
 	LWIP_ASSERT("tx_lock_mutex creation error", (err == ERR_OK));
 
@@ -0,0 +1,200 @@
+/*
+ * @brief LWIP Internet checksum for the Cortex-M3
+ *
+ * LWIP_CHKSUM and LWIP_CHKSUM_COPY (cc.h) map to these routines. The
+ * results equal those of the lwIP reference algorithms in inet_chksum.c;
+ * chksum_bench/ compares both on the host.
+ */
+
+#include "lwip/opt.h"
+#include "lwip/def.h"
+#include "lwip/inet_chksum.h"
+
+#include <string.h>
+
+/** @defgroup NET_LWIP_CHKSUM LWIP Internet checksum
+ * @ingroup NET_LWIP
+ * Checksum routines used by LWIP through LWIP_CHKSUM and LWIP_CHKSUM_COPY
+ * (see cc.h). The data is summed as 32 bit words into a 64 bit accumulator,
+ * which the Cortex-M3 adds with an ADDS/ADC pair per word, and the carries
+ * are folded once at the end. The main loop is unrolled to 32 bytes.
+ * @{
+ */
+
+/*****************************************************************************
+ * Private types/enumerations/variables
+ ****************************************************************************/
+
+/*****************************************************************************
+ * Public types/enumerations/variables
+ ****************************************************************************/
+
+/*****************************************************************************
+ * Private functions
+ ****************************************************************************/
+
+/* Folds a 64 bit sum of 32 bit words to the 16 bit Internet sum */
+static u16_t lpc_chksum_fold(u64_t sum)
+{
+	u32_t s;
+
+	sum = (sum >> 32) + (sum & 0xFFFFFFFFUL);
+	sum = (sum >> 32) + (sum & 0xFFFFFFFFUL);
+	s = (u32_t) sum;
+	s = FOLD_U32T(s);
+	s = FOLD_U32T(s);
+
+	return (u16_t) s;
+}
+
+/*****************************************************************************
+ * Public functions
+ ****************************************************************************/
+
+/* Internet checksum (non-inverted, host order) of data at any boundary */
+u16_t lpc_chksum(const void *dataptr, int len)
+{
+	const u8_t *pb = (const u8_t *) dataptr;
+	const u32_t *pw;
+	u64_t sum = 0;
+	u16_t t = 0;
+	u16_t s;
+	int odd = ((mem_ptr_t) pb & 1);
+
+	/* Get aligned to u16_t: the first byte is the high byte of a word
+	   and the result is byte swapped at the end */
+	if (odd && (len > 0)) {
+		((u8_t *) &t)[1] = *pb++;
+		len--;
+	}
+
+	/* Get aligned to u32_t */
+	if (((mem_ptr_t) pb & 2) && (len >= 2)) {
+		sum += *(const u16_t *) pb;
+		pb += 2;
+		len -= 2;
+	}
+
+	pw = (const u32_t *) pb;
+	while (len >= 32) {
+		sum += pw[0];
+		sum += pw[1];
+		sum += pw[2];
+		sum += pw[3];
+		sum += pw[4];
+		sum += pw[5];
+		sum += pw[6];
+		sum += pw[7];
+		pw += 8;
+		len -= 32;
+	}
+	while (len >= 4) {
+		sum += *pw++;
+		len -= 4;
+	}
+
+	/* Remaining half word and byte */
+	pb = (const u8_t *) pw;
+	if (len >= 2) {
+		sum += *(const u16_t *) pb;
+		pb += 2;
+		len -= 2;
+	}
+	if (len > 0) {
+		((u8_t *) &t)[0] = *pb;
+	}
+	sum += t;
+
+	s = lpc_chksum_fold(sum);
+	if (odd) {
+		s = SWAP_BYTES_IN_WORD(s);
+	}
+
+	return s;
+}
+
+/* Copies data and returns its Internet checksum */
+u16_t lpc_chksum_copy(void *dst, const void *src, u16_t len)
+{
+	const u8_t *ps = (const u8_t *) src;
+	u8_t *pd = (u8_t *) dst;
+	const u32_t *pws;
+	u32_t *pwd;
+	u32_t w0, w1, w2, w3;
+	u64_t sum = 0;
+	u16_t t = 0;
+	u16_t s;
+	int n = len;
+	int odd;
+
+	/* Words can only be moved if source and destination are equally
+	   aligned, else copy first and sum the copy */
+	if (((mem_ptr_t) ps ^ (mem_ptr_t) pd) & 3) {
+		MEMCPY(dst, src, len);
+		return lpc_chksum(dst, len);
+	}
+
+	odd = ((mem_ptr_t) ps & 1);
+	if (odd && (n > 0)) {
+		((u8_t *) &t)[1] = *pd++ = *ps++;
+		n--;
+	}
+	if (((mem_ptr_t) ps & 2) && (n >= 2)) {
+		*(u16_t *) pd = *(const u16_t *) ps;
+		sum += *(const u16_t *) ps;
+		ps += 2;
+		pd += 2;
+		n -= 2;
+	}
+
+	pws = (const u32_t *) ps;
+	pwd = (u32_t *) pd;
+	while (n >= 16) {
+		w0 = pws[0];
+		w1 = pws[1];
+		w2 = pws[2];
+		w3 = pws[3];
+		pwd[0] = w0;
+		pwd[1] = w1;
+		pwd[2] = w2;
+		pwd[3] = w3;
+		sum += w0;
+		sum += w1;
+		sum += w2;
+		sum += w3;
+		pws += 4;
+		pwd += 4;
+		n -= 16;
+	}
+	while (n >= 4) {
+		w0 = *pws++;
+		*pwd++ = w0;
+		sum += w0;
+		n -= 4;
+	}
+
+	ps = (const u8_t *) pws;
+	pd = (u8_t *) pwd;
+	if (n >= 2) {
+		*(u16_t *) pd = *(const u16_t *) ps;
+		sum += *(const u16_t *) ps;
+		ps += 2;
+		pd += 2;
+		n -= 2;
+	}
+	if (n > 0) {
+		((u8_t *) &t)[0] = *pd = *ps;
+	}
+	sum += t;
+
+	s = lpc_chksum_fold(sum);
+	if (odd) {
+		s = SWAP_BYTES_IN_WORD(s);
+	}
+
+	return s;
+}
+
+/**
+ * @}
+ */
@@ -7,6 +7,11 @@
 
 #include <BSP_Waveshare/bsp_waveshare.h>
 #include <sdcard.h>
+#include <data_Manager/crc.h>
+
+#if SD_USE_DMA && (SD_DMA_CH_TX >= WSBOARD_DMA_CH_RESERVED)
+#error "SD_DMA_CH_RX/TX must be reserved GPDMA channels (see WSBOARD_DMA_CH_RESERVED)"
+#endif
 
 // SPI module to use
 #define SSPdev					LPC_SSP0
@@ -38,6 +43,7 @@
 /* Application specific commands supported by SD.
 All these commands shall be preceded with APP_CMD (CMD55). */
 #define SD_STATUS               13
+#define SET_WR_BLK_ERASE_COUNT  23
 #define SD_SEND_OP_COND         41
 
 /* R1 response bit flag definition */
@@ -54,12 +60,38 @@ All these commands shall be preceded with APP_CMD (CMD55). */
 /* The sector size is fixed to 512bytes in most applications. */
 #define SECTOR_SIZE 512
 
+#if SD_USE_DMA
+/* GPDMA request lines of SSP0 */
+#define SD_DMA_REQ_TX       1
+#define SD_DMA_REQ_RX       2
+#define SD_DMA_CH_MASK      ((1 << SD_DMA_CH_RX) | (1 << SD_DMA_CH_TX))
+
+/* What SD_DMA_IRQ() does after the data phase */
+#define DMA_OP_NONE         0   /* Blocking transfer, caller finishes the block */
+#define DMA_OP_READ         1   /* SD_ReadSectorAsync(): discard CRC and deselect */
+#define DMA_OP_WRITE        2   /* SD_WriteStreamBlockAsync(): send CRC and check data response */
+#endif
+
 /* Global variables */
 uint8_t CardType;          /* card type */
 CARDCONFIG CardConfig;      /* Card configuration */
 
 /* Local variables */
 static volatile uint32_t Timer1, Timer2;	/* 100Hz decrement timer stopped at zero (disk_timerproc()) */
+static SD_BOOL StreamOpen;					/* Multiple block write transaction open (SD_WriteStreamOpen()) */
+static uint32_t SpiClock;					/* Data transfer clock (stepped down after CRC errors) */
+static SD_BOOL CrcError;					/* Last transfer failed with a CRC error */
+static uint32_t CrcErrors;					/* Number of CRC errors (SD_GetCrcErrors()) */
+#if SD_USE_DMA
+static volatile SD_BOOL DmaBusy;			/* DMA transfer in progress (cleared in SD_DMA_IRQ()) */
+static SD_BOOL DmaOk;						/* DMA transfer result */
+static uint8_t DmaOp;						/* DMA_OP_xxx */
+static SD_Callback DmaCallback;				/* Completion callback of asynchronous transfer */
+static uint16_t DmaCrc;						/* CRC16 of asynchronously written block */
+static uint8_t *DmaRxBuf;					/* Destination of asynchronously read block */
+static const uint8_t DmaFill = 0xFF;		/* Transmitted while receiving */
+static uint8_t DmaSink;						/* Received while transmitting (discarded) */
+#endif
 
 
 /* Local functions */
@@ -71,7 +103,19 @@ uint8_t     SD_SendCommand (uint8_t cmd, uint32_t arg, uint8_t *buf, uint32_t le
 uint8_t     SD_SendACommand (uint8_t cmd, uint32_t arg, uint8_t *buf, uint32_t len);
 SD_BOOL     SD_RecvDataBlock (uint8_t *buf, uint32_t len);
 SD_BOOL     SD_SendDataBlock (const uint8_t *buf, uint8_t tkn, uint32_t len) ;
+SD_BOOL     SD_SendDataBlockStart (const uint8_t *buf, uint8_t tkn, uint32_t len);
 SD_BOOL     SD_WaitForReady (void);
+SD_BOOL     SD_WaitForDataToken (void);
+SD_BOOL     SD_CheckDataResponse (uint8_t resp);
+static SD_BOOL SD_ReadSectorOnce (uint32_t sect, uint8_t *buf, uint32_t cnt);
+static SD_BOOL SD_WriteSectorOnce (uint32_t sect, const uint8_t *buf, uint32_t cnt);
+static void SD_ClockStepDown (void);
+static uint8_t SD_CRC7 (const uint8_t *buf, uint32_t len);
+#if SD_USE_DMA
+static void SD_DMA_Start (uint8_t *rx, const uint8_t *tx, uint32_t len, uint8_t op, SD_Callback cb);
+static SD_BOOL SD_DMA_Wait (void);
+static void SD_DMA_IRQ (uint8_t ch);
+#endif
 
 /*-----------------------------------------------------------------------*/
 /* Device timer function  (Platform dependent)                           */
@@ -95,6 +139,12 @@ void SPI_Init(void){
     Chip_SSP_SetBitRate(SSPdev, SPI_CLOCKRATE_LOW);
     Chip_SSP_SetFormat(SSPdev, SSP_BITS_8, SSP_FRAMEFORMAT_SPI, SSP_CLOCK_CPHA0_CPOL0);
     Chip_SSP_Enable(SSPdev);
+#if SD_USE_DMA
+    /* Enable GPDMA controller and SSP DMA requests */
+    wsBoard_DMA_Init(SD_DMA_CH_RX, SD_DMA_IRQ);
+    wsBoard_DMA_Init(SD_DMA_CH_TX, SD_DMA_IRQ);
+    Chip_SSP_DMA_Enable(SSPdev);
+#endif
 }
 
 uint8_t SPI_SendByte(uint8_t data)
@@ -194,6 +244,13 @@ SD_BOOL SD_Init (void)
             CardType = CARDTYPE_UNKNOWN;
     }
 
+#if SD_USE_CRC
+    /* Let the card check the CRC of commands and written data blocks */
+    if (CardType != CARDTYPE_UNKNOWN &&
+        SD_SendCommand (CRC_ON_OFF, 1, NULL, 0) != R1_NO_ERROR)
+        CardType = CARDTYPE_UNKNOWN;
+#endif
+
 init_end:
    SD_DeSelect();
 
@@ -203,7 +260,8 @@ init_end:
     }
     else     /* Init OK. use high speed during data transaction stage. */
     {
-        Chip_SSP_SetBitRate(SSPdev, SPI_CLOCKRATE_HIGH);
+        SpiClock = SPI_CLOCKRATE_HIGH;
+        Chip_SSP_SetBitRate(SSPdev, SpiClock);
         return (SD_TRUE);
     }
 }
@@ -242,7 +300,7 @@ SD_BOOL SD_WaitForReady (void)
 uint8_t SD_SendCommand (uint8_t cmd, uint32_t arg, uint8_t *buf, uint32_t len)
 {
     uint32_t r1,i;
-    uint8_t crc_stop;
+    uint8_t frame[6];
 
     /* The CS signal must be kept low during a transaction */
     SD_Select();
@@ -250,19 +308,18 @@ uint8_t SD_SendCommand (uint8_t cmd, uint32_t arg, uint8_t *buf, uint32_t len)
     /* Wait until the card is ready to read (DI signal is High) */
     if (SD_WaitForReady() == SD_FALSE) return 0x81;
 
-    /* Prepare CRC7 + stop bit. For cmd GO_IDLE_STATE and SEND_IF_COND,
-    the CRC7 should be valid, otherwise, the CRC7 will be ignored. */
-    if      (cmd == GO_IDLE_STATE)  crc_stop = 0x95; /* valid CRC7 + stop bit */
-    else if (cmd == SEND_IF_COND)   crc_stop = 0x87; /* valid CRC7 + stop bit */
-    else                            crc_stop = 0x01; /* dummy CRC7 + Stop bit */
+    /* Prepare command with CRC7 + stop bit. The CRC7 must be valid for
+    GO_IDLE_STATE and SEND_IF_COND, and for all commands once CRC checking
+    has been switched on with CRC_ON_OFF. */
+    frame[0] = cmd | 0x40;
+    frame[1] = arg >> 24;
+    frame[2] = arg >> 16;
+    frame[3] = arg >> 8;
+    frame[4] = arg;
+    frame[5] = (SD_CRC7 (frame, 5) << 1) | 0x01;
 
     /* Send 6-byte command with CRC. */
-    SPI_SendByte (cmd | 0x40);
-    SPI_SendByte (arg >> 24);
-    SPI_SendByte (arg >> 16);
-    SPI_SendByte (arg >> 8);
-    SPI_SendByte (arg);
-    SPI_SendByte (crc_stop); /* Valid or dummy CRC plus stop bit */
+    for (i = 0; i < 6; i++) SPI_SendByte (frame[i]);
 
 
     /* The command response time (Ncr) is 0 to 8 bytes for SDC,
@@ -273,6 +330,7 @@ uint8_t SD_SendCommand (uint8_t cmd, uint32_t arg, uint8_t *buf, uint32_t len)
         if (r1 != 0xFF) break;   /* received valid response */
     }
     if (i == 0)  return (0x82); /* command response time out error */
+    if (r1 & R1_COM_CRC_ERROR) CrcError = SD_TRUE;
 
     /* Read remaining bytes after R1 response */
     if (buf && len)
@@ -318,8 +376,36 @@ uint8_t SD_SendACommand (uint8_t cmd, uint32_t arg, uint8_t *buf, uint32_t len)
   * @param  buf:  Pointer to byte array to store the data
   * @param  cnt:  Specifies the count of sectors to read
   * @retval SD_TRUE or SD_FALSE.
+  *
+  * Note: Retried after a CRC error (see SD_USE_CRC).
   */
 SD_BOOL SD_ReadSector (uint32_t sect, uint8_t *buf, uint32_t cnt)
+{
+    uint32_t retry;
+
+    /* Card is busy with a write stream or an asynchronous transfer */
+    if (StreamOpen || SD_Busy()) return SD_FALSE;
+
+    for (retry = 0; ; retry++)
+    {
+        CrcError = SD_FALSE;
+        if (SD_ReadSectorOnce (sect, buf, cnt)) return SD_TRUE;
+
+        /* Only CRC errors are retried, from the second retry on at a lower clock */
+        if (!CrcError || retry >= SD_CRC_RETRY) return SD_FALSE;
+        if (retry) SD_ClockStepDown ();
+    }
+}
+
+/**
+  * @brief  Read single or multiple sector(s) from memory card, no retry.
+  *
+  * @param  sect: Specifies the starting sector index to read
+  * @param  buf:  Pointer to byte array to store the data
+  * @param  cnt:  Specifies the count of sectors to read
+  * @retval SD_TRUE or SD_FALSE (CrcError is set on a CRC error).
+  */
+static SD_BOOL SD_ReadSectorOnce (uint32_t sect, uint8_t *buf, uint32_t cnt)
 {
     SD_BOOL flag;
 
@@ -364,8 +450,36 @@ SD_BOOL SD_ReadSector (uint32_t sect, uint8_t *buf, uint32_t cnt)
   * @param  buf: Pointer to the data array to be written
   * @param  cnt: Specifies the number sectors to be written
   * @retval SD_TRUE or SD_FALSE
+  *
+  * Note: Retried after the card reported a CRC error (see SD_USE_CRC).
   */
 SD_BOOL SD_WriteSector (uint32_t sect, const uint8_t *buf, uint32_t cnt)
+{
+    uint32_t retry;
+
+    /* Card is busy with a write stream or an asynchronous transfer */
+    if (StreamOpen || SD_Busy()) return SD_FALSE;
+
+    for (retry = 0; ; retry++)
+    {
+        CrcError = SD_FALSE;
+        if (SD_WriteSectorOnce (sect, buf, cnt)) return SD_TRUE;
+
+        /* Only CRC errors are retried, from the second retry on at a lower clock */
+        if (!CrcError || retry >= SD_CRC_RETRY) return SD_FALSE;
+        if (retry) SD_ClockStepDown ();
+    }
+}
+
+/**
+  * @brief  Write single or multiple sectors to SD/MMC, no retry.
+  *
+  * @param  sect: Specifies the starting sector index to write
+  * @param  buf: Pointer to the data array to be written
+  * @param  cnt: Specifies the number sectors to be written
+  * @retval SD_TRUE or SD_FALSE (CrcError is set on a CRC error).
+  */
+static SD_BOOL SD_WriteSectorOnce (uint32_t sect, const uint8_t *buf, uint32_t cnt)
 {
     SD_BOOL flag;
 
@@ -375,6 +489,9 @@ SD_BOOL SD_WriteSector (uint32_t sect, const uint8_t *buf, uint32_t cnt)
     flag = SD_FALSE;
     if (cnt > 1)  /* write multiple block */
     {
+        /* Pre-erase the blocks to be written (SD cards only, a hint that may be ignored) */
+        if (CardType != CARDTYPE_MMC) SD_SendACommand (SET_WR_BLK_ERASE_COUNT, cnt, NULL, 0);
+
         if (SD_SendCommand (WRITE_MULTIPLE_BLOCK, sect, NULL, 0) == R1_NO_ERROR)
         {
             do {
@@ -403,6 +520,203 @@ SD_BOOL SD_WriteSector (uint32_t sect, const uint8_t *buf, uint32_t cnt)
     return (flag);
 }
 
+/**
+  * @brief  Open a multiple block write transaction for streaming data to the card.
+  *
+  * @param  sect: Specifies the starting sector index to write
+  * @param  pre_erase: Number of sectors that will be written (0 if unknown).
+  *                    SD cards pre-erase this many blocks (ACMD23) so that
+  *                    the blocks are programmed without erase delays.
+  * @retval SD_TRUE or SD_FALSE
+  *
+  * Note: The card stays selected until SD_WriteStreamClose(). Sectors are
+  *       written with SD_WriteStreamBlock(). SD_ReadSector() and
+  *       SD_WriteSector() fail while the stream is open.
+  */
+SD_BOOL SD_WriteStreamOpen (uint32_t sect, uint32_t pre_erase)
+{
+    if (StreamOpen || SD_Busy()) return SD_FALSE;
+
+    /* Convert sector-based address to byte-based address for non SDHC */
+    if (CardType != CARDTYPE_SDV2_HC) sect <<= 9;
+
+    /* Pre-erase the blocks to be written (SD cards only, 23-bit count) */
+    if (pre_erase && CardType != CARDTYPE_MMC)
+    {
+        if (pre_erase > 0x7FFFFF) pre_erase = 0x7FFFFF;
+        SD_SendACommand (SET_WR_BLK_ERASE_COUNT, pre_erase, NULL, 0);
+    }
+
+    if (SD_SendCommand (WRITE_MULTIPLE_BLOCK, sect, NULL, 0) != R1_NO_ERROR)
+    {
+        SD_DeSelect();
+        return SD_FALSE;
+    }
+
+    StreamOpen = SD_TRUE;
+#if SD_USE_DMA
+    DmaOk = SD_TRUE;    /* No block sent yet */
+#endif
+    return SD_TRUE;
+}
+
+/**
+  * @brief  Write the next sector of an open write stream.
+  *
+  * @param  buf: Pointer to the 512 bytes to be written
+  * @retval SD_TRUE or SD_FALSE
+  *
+  * Note: Only waits for the card to finish programming the previous block,
+  *       not this one, so the next block can be prepared in the meantime
+  *       (see SD_WriteStreamReady()).
+  */
+SD_BOOL SD_WriteStreamBlock (const uint8_t *buf)
+{
+    if (!StreamOpen) return SD_FALSE;
+
+#if SD_USE_DMA
+    /* Wait for previous asynchronous block to be sent */
+    if (SD_DMA_Wait() == SD_FALSE) return SD_FALSE;
+#endif
+
+    /* Wait for previous block to be programmed */
+    if (SD_WaitForReady() == SD_FALSE) return SD_FALSE;
+
+    return SD_SendDataBlockStart (buf, 0xFC, SECTOR_SIZE);
+}
+
+/**
+  * @brief  Check if the card has finished programming the last streamed block.
+  *
+  * @param  None
+  * @retval SD_TRUE: SD_WriteStreamBlock() will not have to wait.
+  *         SD_FALSE: Card is busy (or no stream is open).
+  */
+SD_BOOL SD_WriteStreamReady (void)
+{
+    if (!StreamOpen || SD_Busy()) return SD_FALSE;
+
+    return (SPI_RecvByte () == 0xFF) ? SD_TRUE : SD_FALSE;
+}
+
+/**
+  * @brief  Close the write stream with a Stop Transmission token.
+  *
+  * @param  None
+  * @retval SD_TRUE: All blocks have been programmed.
+  *         SD_FALSE: Card did not become ready (or no stream is open).
+  */
+SD_BOOL SD_WriteStreamClose (void)
+{
+    SD_BOOL flag;
+
+    if (!StreamOpen) return SD_FALSE;
+    StreamOpen = SD_FALSE;
+
+#if SD_USE_DMA
+    /* Wait for last asynchronous block to be sent */
+    flag = SD_DMA_Wait();
+#else
+    flag = SD_TRUE;
+#endif
+
+    /* Wait for last block to be programmed */
+    if (SD_WaitForReady() == SD_FALSE) flag = SD_FALSE;
+
+    /* Send Stop Transmission Token. */
+    SPI_SendByte (0xFD);
+
+    /* Wait for complete */
+    if (SD_WaitForReady() == SD_FALSE) flag = SD_FALSE;
+
+    /* De-select the card */
+    SD_DeSelect();
+
+    return (flag);
+}
+
+#if SD_USE_DMA
+/**
+  * @brief  Start reading a single sector from memory card by DMA.
+  *
+  * @param  sect: Specifies the sector index to read
+  * @param  buf:  Pointer to 512 byte array to store the data
+  * @param  cb:   Called from the DMA interrupt when the sector has been
+  *               read and the card deselected (may be NULL)
+  * @retval SD_TRUE: Transfer started, cb will be called.
+  *         SD_FALSE: Card is busy or did not respond (cb is not called).
+  *
+  * Note: Waits for the card to send the start block token (typically well
+  *       below 1ms); the 512 data bytes are then moved at SPI clock rate
+  *       without the CPU. The buffer must not be used until cb is called.
+  *       A CRC error is reported to cb and not retried.
+  */
+SD_BOOL SD_ReadSectorAsync (uint32_t sect, uint8_t *buf, SD_Callback cb)
+{
+    /* Card is busy with a write stream or an asynchronous transfer */
+    if (StreamOpen || DmaBusy) return SD_FALSE;
+
+    /* Convert sector-based address to byte-based address for non SDHC */
+    if (CardType != CARDTYPE_SDV2_HC) sect <<= 9;
+
+    if ((SD_SendCommand(READ_SINGLE_BLOCK, sect, NULL, 0) != R1_NO_ERROR) ||
+        SD_WaitForDataToken() == SD_FALSE)
+    {
+        SD_DeSelect();
+        return SD_FALSE;
+    }
+
+    SD_DMA_Start (buf, NULL, SECTOR_SIZE, DMA_OP_READ, cb);
+    return SD_TRUE;
+}
+
+/**
+  * @brief  Start sending the next sector of an open write stream by DMA.
+  *
+  * @param  buf: Pointer to the 512 bytes to be written
+  * @param  cb:  Called from the DMA interrupt when the card has accepted
+  *              (ok = SD_TRUE) or rejected the block (may be NULL)
+  * @retval SD_TRUE: Transfer started, cb will be called.
+  *         SD_FALSE: No stream is open, previous block failed or card timeout.
+  *
+  * Note: Like SD_WriteStreamBlock(), first waits for the card to finish
+  *       programming the previous block. The buffer must not be modified
+  *       until cb is called.
+  */
+SD_BOOL SD_WriteStreamBlockAsync (const uint8_t *buf, SD_Callback cb)
+{
+    if (!StreamOpen) return SD_FALSE;
+
+    /* Wait for previous asynchronous block to be sent */
+    if (SD_DMA_Wait() == SD_FALSE) return SD_FALSE;
+
+    /* Wait for previous block to be programmed */
+    if (SD_WaitForReady() == SD_FALSE) return SD_FALSE;
+
+    /* Send Start Block Token; CRC and data response are handled by SD_DMA_IRQ() */
+    DmaCrc = crc16_ccitt_calc(0, buf, SECTOR_SIZE);
+    SPI_SendByte (0xFC);
+    SD_DMA_Start (NULL, buf, SECTOR_SIZE, DMA_OP_WRITE, cb);
+    return SD_TRUE;
+}
+#endif
+
+/**
+  * @brief  Check if an asynchronous transfer is in progress.
+  *
+  * @param  None
+  * @retval SD_TRUE: DMA transfer in progress, other card access will fail.
+  *         SD_FALSE: Idle.
+  */
+SD_BOOL SD_Busy (void)
+{
+#if SD_USE_DMA
+    return DmaBusy;
+#else
+    return SD_FALSE;
+#endif
+}
+
 /**
   * @brief  Read card configuration and fill structure CardConfig.
   *
@@ -411,8 +725,10 @@ SD_BOOL SD_WriteSector (uint32_t sect, const uint8_t *buf, uint32_t cnt)
   */
 SD_BOOL SD_ReadConfiguration ()
 {
-    uint8_t buf[16];
-    uint32_t i, c_size, c_size_mult, read_bl_len;
+    static const uint32_t tran_unit[4] = {10000, 100000, 1000000, 10000000};    /* TRAN_SPEED unit / 10 */
+    static const uint8_t tran_value[16] = {0, 10, 12, 13, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60, 70, 80};
+    uint8_t buf[64];
+    uint32_t c_size, c_size_mult, read_bl_len, rate;
     SD_BOOL retv;
 
     retv = SD_FALSE;
@@ -428,6 +744,17 @@ SD_BOOL SD_ReadConfiguration ()
     if ((SD_SendCommand(SEND_CSD, 0, NULL, 0) != R1_NO_ERROR) ||
         SD_RecvDataBlock (CardConfig.csd, 16)==SD_FALSE) goto end;
 
+    /* Limit the data transfer clock to the maximum of the card (TRAN_SPEED) */
+    if ((CardConfig.csd[3] & 0x7) < 4)
+    {
+        rate = tran_unit[CardConfig.csd[3] & 0x7] * tran_value[(CardConfig.csd[3] >> 3) & 0xF];
+        if (rate && rate < SpiClock)
+        {
+            SpiClock = rate;
+            Chip_SSP_SetBitRate(SSPdev, SpiClock);
+        }
+    }
+
     /* sector size */
     CardConfig.sectorsize = 512;
 
@@ -458,8 +785,7 @@ SD_BOOL SD_ReadConfiguration ()
         case CARDTYPE_SDV2_SC:
         case CARDTYPE_SDV2_HC:
             if ((SD_SendACommand (SD_STATUS, 0, buf, 1) !=  R1_NO_ERROR) ||
-                SD_RecvDataBlock(buf, 16) == SD_FALSE) goto end;      /* Read partial block */
-            for (i=64-16;i;i--) SPI_RecvByte();  /* Purge trailing data */
+                SD_RecvDataBlock(buf, 64) == SD_FALSE) goto end;      /* Read whole block (CRC16 covers all 64 bytes) */
             CardConfig.blocksize = 16UL << (buf[10] >> 4); /* Calculate block size based on AU size */
             break;
         case CARDTYPE_MMC:
@@ -489,29 +815,63 @@ end:
   */
 SD_BOOL SD_RecvDataBlock (uint8_t *buf, uint32_t len)
 {
-    uint8_t datatoken;
+    uint16_t crc;
+#if !SD_USE_DMA
     uint32_t i;
+#endif
 
     /* Read data token (0xFE) */
-	Timer1 = 10;   /* Data Read Timerout: 100ms */
-	do {
-		datatoken = SPI_RecvByte ();
-        if (datatoken == 0xFE) break;
-	} while (Timer1);
-	if(datatoken != 0xFE) return (SD_FALSE);	/* data read timeout */
+    if (SD_WaitForDataToken() == SD_FALSE) return (SD_FALSE);	/* data read timeout */
 
     /* Read data block */
+#if SD_USE_DMA
+    SD_DMA_Start (buf, NULL, len, DMA_OP_NONE, NULL);
+    if (SD_DMA_Wait() == SD_FALSE) return (SD_FALSE);
+#else
     for (i = 0; i < len; i++) {
         buf[i] = SPI_RecvByte ();
     }
+#endif
+
+    /* Read 2 bytes CRC (MSB first) */
+    crc  = SPI_RecvByte () << 8;
+    crc |= SPI_RecvByte ();
 
-    /* 2 bytes CRC will be discarded. */
-    SPI_RecvByte ();
-    SPI_RecvByte ();
+#if SD_USE_CRC
+    /* Check CRC16 (CCITT, preset 0) of data block */
+    if (crc16_ccitt_calc(0, buf, len) != crc)
+    {
+        CrcError = SD_TRUE;
+        CrcErrors++;
+        return (SD_FALSE);
+    }
+#else
+    (void)crc;
+#endif
 
     return (SD_TRUE);
 }
 
+/**
+  * @brief  Wait for the start block token of a data block from SD/MMC.
+  *
+  * @param  None
+  * @retval SD_TRUE: Token received, data block follows.
+  *         SD_FALSE: Data read timeout (100ms) or error token.
+  */
+SD_BOOL SD_WaitForDataToken (void)
+{
+    uint8_t datatoken;
+
+	Timer1 = 10;   /* Data Read Timerout: 100ms */
+	do {
+		datatoken = SPI_RecvByte ();
+        if (datatoken == 0xFE) break;
+	} while (Timer1);
+
+    return (datatoken == 0xFE) ? SD_TRUE : SD_FALSE;
+}
+
 /**
   * @brief  Send a data block with specified length to SD/MMC.
   *
@@ -524,33 +884,282 @@ SD_BOOL SD_RecvDataBlock (uint8_t *buf, uint32_t len)
 SD_BOOL SD_SendDataBlock (const uint8_t *buf, uint8_t tkn, uint32_t len)
 {
     uint8_t recv;
+
+    /* Send data block and check that it has been accepted */
+    if (SD_SendDataBlockStart (buf, tkn, len) == SD_FALSE)
+        return (SD_FALSE);
+
+    /* Wait for wirte complete. */
+    Timer1 = 20;  // 200ms
+    do {
+        recv = SPI_RecvByte();
+        if (recv == 0xFF) break;
+    } while (Timer1);
+
+    if (recv == 0xFF) return SD_TRUE;       /* write complete */
+    else              return (SD_FALSE);    /* write time out */
+
+}
+
+/**
+  * @brief  Send a data block without waiting for the card to program it.
+  *
+  * @param  buf: Pointer to the data array to be sent
+  * @param  tkn: Specifies the token to send before the data block
+  * @param  len: Specifies the length (in byte) to send.
+  * @retval SD_TRUE: Data block accepted (card is busy programming it)
+  *         SD_FALSE: Data block rejected
+  */
+SD_BOOL SD_SendDataBlockStart (const uint8_t *buf, uint8_t tkn, uint32_t len)
+{
+    uint16_t crc;
+#if !SD_USE_DMA
     uint32_t i;
+#endif
+
+    /* Data block CRC16 (CCITT, preset 0). Ignored by the card unless CRC
+    checking has been enabled with CRC_ON_OFF. */
+    crc = crc16_ccitt_calc(0, buf, len);
 
     /* Send Start Block Token */
     SPI_SendByte (tkn);
 
     /* Send data block */
+#if SD_USE_DMA
+    SD_DMA_Start (NULL, buf, len, DMA_OP_NONE, NULL);
+    if (SD_DMA_Wait() == SD_FALSE) return (SD_FALSE);
+#else
     for (i = 0; i < len; i++)
     {
       SPI_SendByte (buf[i]);
     }
+#endif
 
-    /* Send 2 bytes dummy CRC */
-    SPI_SendByte (0xFF);
-    SPI_SendByte (0xFF);
+    /* Send 2 bytes CRC (MSB first) */
+    SPI_SendByte (crc >> 8);
+    SPI_SendByte (crc);
 
     /* Read data response to check if the data block has been accepted. */
-    if (( (SPI_RecvByte ()) & 0x0F) != 0x05)
-        return (SD_FALSE); /* write error */
+    return SD_CheckDataResponse (SPI_RecvByte ());
+}
 
-    /* Wait for wirte complete. */
-    Timer1 = 20;  // 200ms
-    do {
-        recv = SPI_RecvByte();
-        if (recv == 0xFF) break;
-    } while (Timer1);
+/**
+  * @brief  Check the data response token of a written data block.
+  *
+  * @param  resp: Data response token
+  * @retval SD_TRUE: Data accepted.
+  *         SD_FALSE: Data rejected (CrcError is set if due to a CRC error).
+  */
+SD_BOOL SD_CheckDataResponse (uint8_t resp)
+{
+    switch (resp & 0x1F)
+    {
+        case 0x05:                  /* Data accepted */
+            return (SD_TRUE);
+        case 0x0B:                  /* Data rejected due to a CRC error */
+            CrcError = SD_TRUE;
+            CrcErrors++;
+            return (SD_FALSE);
+        default:                    /* Data rejected due to a write error */
+            return (SD_FALSE);
+    }
+}
 
-    if (recv == 0xFF) return SD_TRUE;       /* write complete */
-    else              return (SD_FALSE);    /* write time out */
+/**
+  * @brief  Halve the data transfer clock after repeated CRC errors.
+  *
+  * @param  None
+  * @retval None
+  */
+static void SD_ClockStepDown (void)
+{
+    if (SpiClock / 2 < SPI_CLOCKRATE_MIN) return;
+
+    SpiClock /= 2;
+    Chip_SSP_SetBitRate(SSPdev, SpiClock);
+}
+
+/**
+  * @brief  Calculate the CRC7 of a command frame.
+  *
+  * @param  buf: Command index and argument
+  * @param  len: Number of bytes (5)
+  * @retval CRC7 (polynomial x^7 + x^3 + 1), without stop bit
+  */
+static uint8_t SD_CRC7 (const uint8_t *buf, uint32_t len)
+{
+    uint8_t crc = 0, data, bit;
+
+    while (len--)
+    {
+        data = *buf++;
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc <<= 1;
+            if ((data ^ crc) & 0x80) crc ^= 0x09;
+            data <<= 1;
+        }
+    }
+    return (crc & 0x7F);
+}
+
+/**
+  * @brief  Get the current data transfer clock.
+  *
+  * @param  None
+  * @retval SPI clock rate (Hz) requested for data transfers
+  */
+uint32_t SD_GetClockRate (void)
+{
+    return SpiClock;
+}
+
+/**
+  * @brief  Get the number of CRC errors since power up.
+  *
+  * @param  None
+  * @retval Number of received blocks with a bad CRC16 plus blocks rejected
+  *         by the card due to a CRC error
+  */
+uint32_t SD_GetCrcErrors (void)
+{
+    return CrcErrors;
+}
+
+#if SD_USE_DMA
+/**
+  * @brief  Start a DMA transfer of the data phase of a block.
+  *
+  * @param  rx:  Buffer for received bytes (NULL: discard, i.e. transmit only)
+  * @param  tx:  Bytes to transmit (NULL: send 0xFF, i.e. receive only)
+  * @param  len: Number of bytes (1 to 4095)
+  * @param  op:  DMA_OP_xxx, what SD_DMA_IRQ() does when the transfer is done
+  * @param  cb:  Completion callback of asynchronous operation (may be NULL)
+  * @retval None
+  */
+static void SD_DMA_Start (uint8_t *rx, const uint8_t *tx, uint32_t len, uint8_t op, SD_Callback cb)
+{
+    DmaBusy     = SD_TRUE;
+    DmaOk       = SD_TRUE;
+    DmaOp       = op;
+    DmaCallback = cb;
+    DmaRxBuf    = rx;
+
+    /* Clear stale interrupt flags of both channels */
+    LPC_GPDMA->INTTCCLEAR = SD_DMA_CH_MASK;
+    LPC_GPDMA->INTERRCLR  = SD_DMA_CH_MASK;
+
+    /* Receive channel: SSP to memory (terminal count interrupt when done) */
+    LPC_GPDMA->CH[SD_DMA_CH_RX].SRCADDR  = (uint32_t)&SSPdev->DR;
+    LPC_GPDMA->CH[SD_DMA_CH_RX].DESTADDR = (rx != NULL) ? (uint32_t)rx : (uint32_t)&DmaSink;
+    LPC_GPDMA->CH[SD_DMA_CH_RX].LLI      = 0;
+    LPC_GPDMA->CH[SD_DMA_CH_RX].CONTROL  = GPDMA_DMACCxControl_TransferSize(len)
+                                         | GPDMA_DMACCxControl_SBSize(GPDMA_BSIZE_4)
+                                         | GPDMA_DMACCxControl_DBSize(GPDMA_BSIZE_4)
+                                         | GPDMA_DMACCxControl_SWidth(GPDMA_WIDTH_BYTE)
+                                         | GPDMA_DMACCxControl_DWidth(GPDMA_WIDTH_BYTE)
+                                         | ((rx != NULL) ? GPDMA_DMACCxControl_DI : 0)
+                                         | GPDMA_DMACCxControl_I;
+    LPC_GPDMA->CH[SD_DMA_CH_RX].CONFIG   = GPDMA_DMACCxConfig_E
+                                         | GPDMA_DMACCxConfig_SrcPeripheral(SD_DMA_REQ_RX)
+                                         | GPDMA_DMACCxConfig_TransferType(GPDMA_TRANSFERTYPE_P2M_CONTROLLER_DMA)
+                                         | GPDMA_DMACCxConfig_IE
+                                         | GPDMA_DMACCxConfig_ITC;
+
+    /* Transmit channel: memory to SSP (started last so that no byte is missed) */
+    LPC_GPDMA->CH[SD_DMA_CH_TX].SRCADDR  = (tx != NULL) ? (uint32_t)tx : (uint32_t)&DmaFill;
+    LPC_GPDMA->CH[SD_DMA_CH_TX].DESTADDR = (uint32_t)&SSPdev->DR;
+    LPC_GPDMA->CH[SD_DMA_CH_TX].LLI      = 0;
+    LPC_GPDMA->CH[SD_DMA_CH_TX].CONTROL  = GPDMA_DMACCxControl_TransferSize(len)
+                                         | GPDMA_DMACCxControl_SBSize(GPDMA_BSIZE_4)
+                                         | GPDMA_DMACCxControl_DBSize(GPDMA_BSIZE_4)
+                                         | GPDMA_DMACCxControl_SWidth(GPDMA_WIDTH_BYTE)
+                                         | GPDMA_DMACCxControl_DWidth(GPDMA_WIDTH_BYTE)
+                                         | ((tx != NULL) ? GPDMA_DMACCxControl_SI : 0);
+    LPC_GPDMA->CH[SD_DMA_CH_TX].CONFIG   = GPDMA_DMACCxConfig_E
+                                         | GPDMA_DMACCxConfig_DestPeripheral(SD_DMA_REQ_TX)
+                                         | GPDMA_DMACCxConfig_TransferType(GPDMA_TRANSFERTYPE_M2P_CONTROLLER_DMA)
+                                         | GPDMA_DMACCxConfig_IE;
+}
+
+/**
+  * @brief  Wait until the DMA transfer has finished.
+  *
+  * @param  None
+  * @retval SD_TRUE or SD_FALSE (DMA error or block rejected by the card)
+  */
+static SD_BOOL SD_DMA_Wait (void)
+{
+    while (DmaBusy);
+
+    return DmaOk;
+}
+
+/**
+  * @brief  GPDMA interrupt handler of both channels (installed with wsBoard_DMA_Init()).
+  *
+  * @param  ch: Channel with pending interrupt (both channels are handled together)
+  * @retval None
+  */
+static void SD_DMA_IRQ (uint8_t ch)
+{
+    uint32_t stat_tc  = LPC_GPDMA->INTTCSTAT  & SD_DMA_CH_MASK;
+    uint32_t stat_err = LPC_GPDMA->INTERRSTAT & SD_DMA_CH_MASK;
+    uint16_t crc;
+    SD_Callback cb;
+
+    (void)ch;
+
+    /* Clear interrupt flags */
+    LPC_GPDMA->INTTCCLEAR = stat_tc;
+    LPC_GPDMA->INTERRCLR  = stat_err;
+
+    if (stat_err)
+    {
+        /* Abort transfer */
+        LPC_GPDMA->CH[SD_DMA_CH_RX].CONFIG = 0;
+        LPC_GPDMA->CH[SD_DMA_CH_TX].CONFIG = 0;
+        DmaOk = SD_FALSE;
+    }
+    else if ((stat_tc & (1 << SD_DMA_CH_RX)) == 0)
+    {
+        return;     /* Last byte has not been received yet */
+    }
+
+    switch (DmaOp)
+    {
+        case DMA_OP_READ:
+            /* Read 2 bytes CRC (MSB first) */
+            crc  = SPI_RecvByte () << 8;
+            crc |= SPI_RecvByte ();
+            SD_DeSelect();
+#if SD_USE_CRC
+            if (DmaOk && crc16_ccitt_calc(0, DmaRxBuf, SECTOR_SIZE) != crc)
+            {
+                CrcErrors++;
+                DmaOk = SD_FALSE;
+            }
+#else
+            (void)crc;
+#endif
+            break;
+        case DMA_OP_WRITE:
+            if (DmaOk)
+            {
+                /* Send 2 bytes CRC (MSB first) and check data response */
+                SPI_SendByte (DmaCrc >> 8);
+                SPI_SendByte (DmaCrc);
+                if (SD_CheckDataResponse (SPI_RecvByte ()) == SD_FALSE) DmaOk = SD_FALSE;
+            }
+            break;
+        default:
+            break;
+    }
+
+    /* Transfer finished (a new one may be started from the callback) */
+    cb = (DmaOp != DMA_OP_NONE) ? DmaCallback : NULL;
+    DmaBusy = SD_FALSE;
 
+    if (cb) cb (DmaOk);
 }
+#endif